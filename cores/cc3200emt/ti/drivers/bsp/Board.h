@@ -159,6 +159,17 @@ extern void Board_init(void);
  */
 extern I2C_Handle Board_openI2C(UInt i2cPortIndex, I2C_Params *i2cParams);
 
+/*!
+ *  @brief  Board specific I2C pin initialization
+ *
+ *  This function configures the port specific I2C pins without opening
+ *  the I2C driver, for users that drive the peripheral directly, such as
+ *  the Wire slave mode.
+ *
+ *  @return FALSE if the board has no I2C port i2cPortIndex
+ */
+extern Bool Board_initI2CPins(UInt i2cPortIndex);
+
 /*!
  *  @brief  Board specific SPI open function
  *
@@ -0,0 +1,399 @@
+/*
+  BusLock.cpp - priority inheriting, instrumented locks for shared buses
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+#include "Energia.h"
+#include "BusLock.h"
+#include "RtosTrace.h"
+
+#include <string.h>
+
+/*
+ * The kernel is built without GateMutexPri, so the inheritance is done
+ * here the same way: the lock's state only changes with the scheduler
+ * disabled, each waiter blocks on a semaphore of its own, and release()
+ * picks the next owner itself instead of letting the waiters race.
+ */
+
+BusLock *BusLock::_first;
+
+BusLock::BusLock(const char *name)
+{
+    /* no kernel calls: the locks of the global bus objects are built before main() */
+    _name = name;
+    _owner = NULL;
+    _ownerPri = 0;
+    _depth = 0;
+    _acquired = 0;
+    _waiters = NULL;
+    memset(&_stats, 0, sizeof(_stats));
+
+    _next = _first;
+    _first = this;
+}
+
+bool BusLock::acquire(unsigned long timeout)
+{
+    Task_Handle self;
+    Semaphore_Params params;
+    Waiter waiter, **tail;
+    unsigned long start;
+    UInt key;
+
+    if (BIOS_getThreadType() != BIOS_ThreadType_Task) {
+        return (true);
+    }
+    self = Task_self();
+
+    key = Task_disable();
+
+    if (_owner == self) {
+        _depth++;
+        Task_restore(key);
+        return (true);
+    }
+    if (_owner == NULL) {
+        take(self);
+        RtosTrace.event(RTOSTRACE_LOCK_TAKEN, _name);
+        _stats.acquires++;
+        record(_stats.wait, &_stats.maxWaitUs, 0);
+        Task_restore(key);
+        return (true);
+    }
+    if (timeout == 0) {
+        _stats.timeouts++;
+        Task_restore(key);
+        return (false);
+    }
+    if (wouldDeadlock(self)) {
+        _stats.deadlocks++;
+        Task_restore(key);
+        return (false);
+    }
+
+    Semaphore_Params_init(&params);
+    params.mode = Semaphore_Mode_BINARY;
+    Semaphore_construct(&waiter.granted, 0, &params);
+    waiter.next = NULL;
+    waiter.task = self;
+    waiter.given = false;
+    for (tail = &_waiters; *tail != NULL; tail = &(*tail)->next) {
+    }
+    *tail = &waiter;
+
+    _stats.contended++;
+    inherit(0);
+    RtosTrace.event(RTOSTRACE_LOCK_WAIT, _name);
+    start = micros();
+
+    Task_restore(key);
+
+    Semaphore_pend(Semaphore_handle(&waiter.granted), timeout);
+
+    key = Task_disable();
+
+    /* release() may have handed the bus over just as the wait timed out */
+    if (!waiter.given) {
+        unlink(&waiter);
+        settle(_owner, _ownerPri);
+        _stats.timeouts++;
+    }
+    else {
+        RtosTrace.event(RTOSTRACE_LOCK_TAKEN, _name);
+        _stats.acquires++;
+        record(_stats.wait, &_stats.maxWaitUs, micros() - start);
+    }
+
+    Task_restore(key);
+
+    Semaphore_destruct(&waiter.granted);
+
+    return (waiter.given);
+}
+
+void BusLock::release(void)
+{
+    Task_Handle self;
+    Waiter *waiter;
+    Int pri;
+    UInt key;
+
+    if (BIOS_getThreadType() != BIOS_ThreadType_Task) {
+        return;
+    }
+    self = Task_self();
+
+    key = Task_disable();
+
+    if (_owner != self || --_depth > 0) {
+        Task_restore(key);
+        return;
+    }
+
+    record(_stats.hold, &_stats.maxHoldUs, micros() - _acquired);
+    RtosTrace.event(RTOSTRACE_LOCK_RELEASE, _name);
+    pri = _ownerPri;
+
+    waiter = topWaiter();
+    if (waiter != NULL) {
+        unlink(waiter);
+        take(waiter->task);
+        waiter->given = true;
+        inherit(0);
+        Semaphore_post(Semaphore_handle(&waiter->granted));
+    }
+    else {
+        _owner = NULL;
+    }
+
+    /* drop what this bus's waiters lent us; the switch happens on Task_restore() */
+    settle(self, pri);
+
+    Task_restore(key);
+}
+
+bool BusLock::owned(void)
+{
+    if (BIOS_getThreadType() != BIOS_ThreadType_Task) {
+        return (false);
+    }
+    return (_owner == Task_self());
+}
+
+unsigned long BusLock::heldFor(void)
+{
+    unsigned long us = 0;
+    UInt key;
+
+    key = Task_disable();
+    if (_owner != NULL) {
+        us = micros() - _acquired;
+    }
+    Task_restore(key);
+
+    return (us);
+}
+
+void BusLock::stats(BusLockStats &stats, bool reset)
+{
+    UInt key;
+
+    key = Task_disable();
+    stats = _stats;
+    if (reset) {
+        memset(&_stats, 0, sizeof(_stats));
+        _stats.since = millis();
+    }
+    Task_restore(key);
+}
+
+void BusLock::report(Print &out)
+{
+    BusLockStats stats;
+    BusLock *lock;
+    int i;
+
+    for (lock = _first; lock != NULL; lock = lock->_next) {
+        lock->stats(stats);
+        if (stats.acquires == 0 && stats.timeouts == 0 && stats.deadlocks == 0) {
+            continue;
+        }
+
+        out.print(lock->_name);
+        out.print(": ");
+        out.print(stats.acquires);
+        out.print(" acquired, ");
+        out.print(stats.contended);
+        out.print(" waited, ");
+        out.print(stats.timeouts);
+        out.print(" timed out, ");
+        out.print(stats.deadlocks);
+        out.print(" deadlocks, ");
+        out.print(stats.inherited);
+        out.println(" inherited");
+
+        out.print("  wait us max ");
+        out.print(stats.maxWaitUs);
+        out.print(":");
+        for (i = 0; i < BUSLOCK_BUCKETS; i++) {
+            out.print(' ');
+            out.print(stats.wait[i]);
+        }
+        out.println();
+
+        out.print("  hold us max ");
+        out.print(stats.maxHoldUs);
+        out.print(":");
+        for (i = 0; i < BUSLOCK_BUCKETS; i++) {
+            out.print(' ');
+            out.print(stats.hold[i]);
+        }
+        out.println();
+    }
+}
+
+/*
+ * Private Methods, all called with the scheduler disabled
+ */
+void BusLock::take(Task_Handle task)
+{
+    _ownerPri = basePri(task);
+    _owner = task;
+    _depth = 1;
+    _acquired = micros();
+}
+
+/*
+ * A task holding another bus may be running at a priority lent by that
+ * bus's waiters: its own is the one saved when it took its first bus.
+ * Only an owner inherits, so a task holding none runs at its own.
+ */
+Int BusLock::basePri(Task_Handle task)
+{
+    BusLock *lock;
+
+    for (lock = _first; lock != NULL; lock = lock->_next) {
+        if (lock->_owner == task) {
+            return (lock->_ownerPri);
+        }
+    }
+    return (Task_getPri(task));
+}
+
+void BusLock::unlink(Waiter *waiter)
+{
+    Waiter **link;
+
+    for (link = &_waiters; *link != NULL; link = &(*link)->next) {
+        if (*link == waiter) {
+            *link = waiter->next;
+            return;
+        }
+    }
+}
+
+/* the highest priority waiter, the earliest among equals */
+BusLock::Waiter *BusLock::topWaiter(void)
+{
+    Waiter *waiter, *top = NULL;
+    Int pri = -1;
+
+    for (waiter = _waiters; waiter != NULL; waiter = waiter->next) {
+        if (Task_getPri(waiter->task) > pri) {
+            pri = Task_getPri(waiter->task);
+            top = waiter;
+        }
+    }
+    return (top);
+}
+
+/*
+ * Raises the owner to its top waiter's priority, and so on down the
+ * chain if the owner is itself waiting for another bus
+ */
+void BusLock::inherit(int depth)
+{
+    Waiter *top = topWaiter();
+    BusLock *next;
+
+    if (top == NULL || Task_getPri(top->task) <= Task_getPri(_owner)) {
+        return;
+    }
+    Task_setPri(_owner, Task_getPri(top->task));
+    _stats.inherited++;
+
+    next = waitedOnBy(_owner);
+    if (next != NULL && depth < BUSLOCK_MAX_CHAIN) {
+        next->inherit(depth + 1);
+    }
+}
+
+/*
+ * Sets task to base, or to the priority of the highest waiter on a bus
+ * it still holds
+ */
+void BusLock::settle(Task_Handle task, Int base)
+{
+    BusLock *lock;
+    Waiter *top;
+    Int pri = base;
+
+    for (lock = _first; lock != NULL; lock = lock->_next) {
+        if (lock->_owner != task) {
+            continue;
+        }
+        top = lock->topWaiter();
+        if (top != NULL && Task_getPri(top->task) > pri) {
+            pri = Task_getPri(top->task);
+        }
+    }
+    if (Task_getPri(task) != pri) {
+        Task_setPri(task, pri);
+    }
+}
+
+/*
+ * Follows owner -> bus it waits for -> that bus's owner; reaching self
+ * means the wait would never end
+ */
+bool BusLock::wouldDeadlock(Task_Handle self)
+{
+    Task_Handle task = _owner;
+    BusLock *lock;
+    int i;
+
+    for (i = 0; i < BUSLOCK_MAX_CHAIN && task != NULL; i++) {
+        if (task == self) {
+            return (true);
+        }
+        lock = waitedOnBy(task);
+        if (lock == NULL) {
+            return (false);
+        }
+        task = lock->_owner;
+    }
+    return (false);
+}
+
+BusLock *BusLock::waitedOnBy(Task_Handle task)
+{
+    BusLock *lock;
+    Waiter *waiter;
+
+    for (lock = _first; lock != NULL; lock = lock->_next) {
+        for (waiter = lock->_waiters; waiter != NULL; waiter = waiter->next) {
+            if (waiter->task == task && !waiter->given) {
+                return (lock);
+            }
+        }
+    }
+    return (NULL);
+}
+
+void BusLock::record(unsigned long *histogram, unsigned long *max, unsigned long us)
+{
+    unsigned long bound = BUSLOCK_BUCKET0_US;
+    int i;
+
+    for (i = 0; i < BUSLOCK_BUCKETS - 1 && us >= bound; i++) {
+        bound <<= 2;
+    }
+    histogram[i]++;
+    if (us > *max) {
+        *max = us;
+    }
+}
@@ -0,0 +1,141 @@
+/*
+  BusLock.h - priority inheriting, instrumented locks for shared buses
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+#ifndef BusLock_h
+#define BusLock_h
+
+#include <inttypes.h>
+#include "Print.h"
+
+#include <ti/sysbios/BIOS.h>
+#include <ti/sysbios/knl/Task.h>
+#include <ti/sysbios/knl/Semaphore.h>
+
+#define BUSLOCK_FOREVER     BIOS_WAIT_FOREVER
+#define BUSLOCK_BUCKETS     8       // histogram buckets, a factor of 4 apart
+#define BUSLOCK_BUCKET0_US  16      // upper bound of the first bucket
+#define BUSLOCK_MAX_CHAIN   8       // owners followed when looking for a deadlock
+
+/*
+ * Bucket i of wait[] and hold[] counts times below
+ * BUSLOCK_BUCKET0_US << 2i microseconds, the last bucket everything
+ * longer: 16 us, 64 us, 256 us, 1 ms, 4 ms, 16 ms, 64 ms and more.
+ */
+typedef struct BusLockStats {
+    unsigned long acquires;     // outermost acquire() calls that got the bus
+    unsigned long contended;    // ...of which had to wait for it
+    unsigned long timeouts;
+    unsigned long deadlocks;    // acquire() calls refused because they would never return
+    unsigned long inherited;    // owners raised to a waiter's priority
+    unsigned long maxWaitUs;
+    unsigned long maxHoldUs;
+    unsigned long wait[BUSLOCK_BUCKETS];
+    unsigned long hold[BUSLOCK_BUCKETS];
+    unsigned long since;        // millis() when the counters were reset
+} BusLockStats;
+
+/*
+ * A mutex for a bus shared by several tasks, such as SPI, Wire or Serial.
+ *
+ * While a task waits for the bus, the task holding it runs at the
+ * waiter's priority if that is higher, so a low priority logger in the
+ * middle of a transfer cannot be held off by medium priority work while
+ * a control loop waits behind it. When the bus is released it goes to
+ * the highest priority waiter, first come first served among equals.
+ * Unlike Task_disable(), the lock blocks nobody but the bus's users.
+ *
+ * acquire() nests within one task, each call matched by a release().
+ * It fails, rather than hang, when its timeout expires or when waiting
+ * would close a cycle of tasks each holding a bus the next one wants.
+ * Outside a task, in main() before the kernel starts or in an interrupt,
+ * nothing can wait, and acquire() succeeds without taking the lock.
+ *
+ * Every lock keeps histograms of how long tasks waited for it and held
+ * it; report() prints those of all the locks.
+ */
+class BusLock
+{
+    public:
+        BusLock(const char *name);
+
+        bool acquire(unsigned long timeout = BUSLOCK_FOREVER);  // ms
+        void release(void);
+
+        bool owned(void);                           // by the calling task
+        Task_Handle owner(void) { return (_owner); }
+        unsigned long heldFor(void);                // us, 0 while the bus is free
+        const char *name(void) { return (_name); }
+        void stats(BusLockStats &stats, bool reset = false);
+
+        static BusLock *first(void) { return (_first); }
+        BusLock *next(void) { return (_next); }
+        static void report(Print &out);
+
+    private:
+        typedef struct Waiter {
+            struct Waiter *next;
+            Task_Handle task;
+            Semaphore_Struct granted;
+            bool given;
+        } Waiter;
+
+        void take(Task_Handle task);
+        void unlink(Waiter *waiter);
+        Waiter *topWaiter(void);
+        void inherit(int depth);
+        bool wouldDeadlock(Task_Handle self);
+        static BusLock *waitedOnBy(Task_Handle task);
+        static Int basePri(Task_Handle task);
+        static void settle(Task_Handle task, Int base);
+        static void record(unsigned long *histogram, unsigned long *max, unsigned long us);
+
+        const char *_name;
+        BusLock *_next;
+        static BusLock *_first;
+
+        Task_Handle _owner;
+        Int _ownerPri;              // its own priority, without what it inherited
+        unsigned int _depth;
+        unsigned long _acquired;    // micros() when it took the bus
+        Waiter *_waiters;           // in arrival order
+
+        BusLockStats _stats;
+};
+
+/*
+ * Holds a lock for the scope it is declared in:
+ *
+ *   {
+ *       BusTransaction bus(SPI.lock());
+ *       ...
+ *   }
+ */
+class BusTransaction
+{
+    public:
+        BusTransaction(BusLock &lock, unsigned long timeout = BUSLOCK_FOREVER) :
+            _lock(lock) { _held = lock.acquire(timeout); }
+        ~BusTransaction() { if (_held) _lock.release(); }
+        operator bool() { return (_held); }
+
+    private:
+        BusLock &_lock;
+        bool _held;
+};
+
+#endif
@@ -143,6 +143,11 @@ unsigned long millis();
 
 void setDelayResolution(uint32_t milliseconds);
 
+/* implemented in wiring_alloc.c: malloc(), calloc() and realloc() calls so far */
+uint32_t allocationCount(void);
+/* non-zero if the link counts them, see compiler.alloc_count.flags in platform.txt */
+int allocationCounting(void);
+
 /* our interrupt APIs take pin numbers */
 #define digitalPinToInterrupt(pin) pin
 
@@ -38,21 +38,32 @@
 
 #include "wiring_private.h"
 #include "HardwareSerial.h"
+#include "RtosTrace.h"
 
 #define RX_BUFFER_EMPTY   (rxReadIndex == rxWriteIndex)
 #define RX_BUFFER_FULL    (((rxWriteIndex + 1) % SERIAL_BUFFER_SIZE) == rxReadIndex)
 
-HardwareSerial::HardwareSerial(void)
+#define SLIP_END          0xC0
+#define SLIP_ESC          0xDB
+#define SLIP_ESC_END      0xDC
+#define SLIP_ESC_ESC      0xDD
+
+#define FRAME_CRC_SIZE    2
+
+HardwareSerial::HardwareSerial(void) :
+    busLock("Serial")
 {
     init(0, NULL);
 }
 
-HardwareSerial::HardwareSerial(unsigned long module)
+HardwareSerial::HardwareSerial(unsigned long module) :
+    busLock(module ? "Serial1" : "Serial")
 {
     init(module, NULL);
 }
 
-HardwareSerial::HardwareSerial(unsigned long module, UART_Callback callback)
+HardwareSerial::HardwareSerial(unsigned long module, UART_Callback callback) :
+    busLock(module ? "Serial1" : "Serial")
 {
     init(module, callback);
 }
@@ -69,6 +80,22 @@ void HardwareSerial::init(unsigned long module, UART_Callback callback)
 
     uartModule = module;
     begun = false;
+
+    frameMode = SERIAL_FRAME_COBS;
+    frameReset();
+    stageRead = 0;
+    stageFill = 0;
+    memset(&stats, 0, sizeof(stats));
+}
+
+/* drop the frame being decoded */
+void HardwareSerial::frameReset(void)
+{
+    frameEscape = false;
+    frameDiscard = false;
+    frameCode = 0;
+    frameRun = 0;
+    frameLength = 0;
 }
 
 void HardwareSerial::flushAll(void)
@@ -106,7 +133,6 @@ void HardwareSerial::begin(unsigned long baud)
     uart = Board_openUART(uartModule, &uartParams);
 
     if (uart != NULL) {
-        GateMutex_construct(&gate, NULL);
         if (rxCallback != NULL) {
             /* start the read process */
             UART_read(uart, &rxBuffer[rxWriteIndex], 1);
@@ -128,12 +154,12 @@ void HardwareSerial::setPins(unsigned long pins)
 
 void HardwareSerial::acquire(void)
 {
-    GateMutex_enter(GateMutex_handle(&gate));
+    busLock.acquire();
 }
 
 void HardwareSerial::release(void)
 {
-    GateMutex_leave(GateMutex_handle(&gate), 0);
+    busLock.release();
 }
 
 void HardwareSerial::end(void)
@@ -141,6 +167,10 @@ void HardwareSerial::end(void)
     begun = false;
     UART_close(uart);
     uart = NULL;
+
+    frameReset();
+    stageRead = 0;
+    stageFill = 0;
 }
 
 int HardwareSerial::available(void)
@@ -240,6 +270,62 @@ int HardwareSerial::read(void)
     }
 }
 
+/*
+ * Expose the received characters that are contiguous in the ring buffer,
+ * the remainder (if the data wraps) is returned by the next call after
+ * consume(). Only callback mode buffers input in rxBuffer.
+ */
+int HardwareSerial::peekBuffer(const uint8_t **buffer)
+{
+    unsigned int hwiKey;
+    unsigned long readIndex, writeIndex;
+
+    if (uart == NULL || rxCallback == NULL) {
+        return (-1);
+    }
+
+    if (available() == 0) {
+        return (0);
+    }
+
+    hwiKey = Hwi_disable();
+    readIndex = rxReadIndex;
+    writeIndex = rxWriteIndex;
+    Hwi_restore(hwiKey);
+
+    *buffer = &rxBuffer[readIndex];
+
+    if (writeIndex >= readIndex) {
+        return (writeIndex - readIndex);
+    }
+    else {
+        return (SERIAL_BUFFER_SIZE - readIndex);
+    }
+}
+
+void HardwareSerial::consume(size_t size)
+{
+    unsigned int hwiKey;
+    unsigned long numChars;
+
+    if (uart == NULL || rxCallback == NULL) {
+        return;
+    }
+
+    hwiKey = Hwi_disable();
+
+    numChars = (rxWriteIndex >= rxReadIndex) ?
+        (rxWriteIndex - rxReadIndex)
+        : SERIAL_BUFFER_SIZE - (rxReadIndex - rxWriteIndex);
+    if (size > numChars) {
+        size = numChars;
+    }
+
+    rxReadIndex = (rxReadIndex + size) % SERIAL_BUFFER_SIZE;
+
+    Hwi_restore(hwiKey);
+}
+
 void HardwareSerial::flush()
 {
 }
@@ -252,38 +338,68 @@ HardwareSerial::operator bool()
 
 size_t HardwareSerial::write(uint8_t c)
 {
-    IArg key;
-
     if (uart == NULL) {
         return (0);
     }
 
-    key = GateMutex_enter(GateMutex_handle(&gate));
+    busLock.acquire();
 
+    RtosTrace.event(RTOSTRACE_UART_BEGIN, busLock.name(), 1);
     UART_write(uart, (char *)&c, 1);
+    RtosTrace.event(RTOSTRACE_UART_END, busLock.name());
 
-    GateMutex_leave(GateMutex_handle(&gate), key);
+    busLock.release();
 
     return (1);
 }
 
 size_t HardwareSerial::write(const uint8_t *buffer, size_t size)
 {
-    IArg key;
-    
     if (uart == NULL) {
         return (0);
     }
 
-    key = GateMutex_enter(GateMutex_handle(&gate));
+    busLock.acquire();
 
+    RtosTrace.event(RTOSTRACE_UART_BEGIN, busLock.name(), size);
     UART_write(uart, (char *)buffer, size);
+    RtosTrace.event(RTOSTRACE_UART_END, busLock.name());
 
-    GateMutex_leave(GateMutex_handle(&gate), key);
+    busLock.release();
 
     return (size);
 }
 
+/*
+ * Hand out txStage for the caller to fill. The port is held from here to
+ * commit(), so another task can neither reuse the space nor write in
+ * between.
+ */
+int HardwareSerial::writeBuffer(uint8_t **buffer)
+{
+    if (uart == NULL) {
+        return (0);
+    }
+    if (!busLock.acquire()) {
+        return (-1);
+    }
+
+    *buffer = txStage;
+    return (sizeof(txStage));
+}
+
+void HardwareSerial::commit(size_t size)
+{
+    if (size > sizeof(txStage)) {
+        size = sizeof(txStage);
+    }
+    if (size > 0) {
+        write(txStage, size);
+    }
+
+    busLock.release();
+}
+
 void HardwareSerial::readCallback(UART_Handle uart, void *buf, size_t count)
 {
     uint8_t volatile full = RX_BUFFER_FULL;
@@ -297,6 +413,317 @@ void HardwareSerial::readCallback(UART_Handle uart, void *buf, size_t count)
     Semaphore_post(Semaphore_handle(&rxSemaphore));
 }
 
+/*
+ * Frames
+ */
+
+/* CRC-16/CCITT (0x1021, from 0xFFFF), a nibble at a time */
+static const uint16_t crcNibble[16] = {
+    0x0000, 0x1021, 0x2042, 0x3063, 0x4084, 0x50a5, 0x60c6, 0x70e7,
+    0x8108, 0x9129, 0xa14a, 0xb16b, 0xc18c, 0xd1ad, 0xe1ce, 0xf1ef
+};
+
+static uint16_t frameCrc(const uint8_t *data, size_t size)
+{
+    uint16_t crc = 0xffff;
+
+    while (size--) {
+        crc = (crc << 4) ^ crcNibble[(crc >> 12) ^ (*data >> 4)];
+        crc = (crc << 4) ^ crcNibble[(crc >> 12) ^ (*data++ & 0x0f)];
+    }
+    return (crc);
+}
+
+/*
+ * Encoded bytes are gathered in a chunk on the stack, so a frame costs
+ * one UART_write() per SERIAL_FRAME_CHUNK bytes whatever its encoding
+ */
+typedef struct FrameChunk {
+    UART_Handle uart;
+    size_t fill;
+    uint8_t data[SERIAL_FRAME_CHUNK];
+} FrameChunk;
+
+static inline void chunkPut(FrameChunk *chunk, uint8_t c)
+{
+    chunk->data[chunk->fill++] = c;
+    if (chunk->fill == SERIAL_FRAME_CHUNK) {
+        UART_write(chunk->uart, chunk->data, SERIAL_FRAME_CHUNK);
+        chunk->fill = 0;
+    }
+}
+
+static void chunkFlush(FrameChunk *chunk)
+{
+    if (chunk->fill > 0) {
+        UART_write(chunk->uart, chunk->data, chunk->fill);
+        chunk->fill = 0;
+    }
+}
+
+void HardwareSerial::setFraming(uint8_t mode)
+{
+    frameMode = mode;
+    frameReset();
+}
+
+/*
+ * Sends frame as one packet, CRC included. The port is held for the
+ * whole frame so frames from several tasks do not interleave.
+ */
+size_t HardwareSerial::writeFrame(const uint8_t *frame, size_t size)
+{
+    FrameChunk chunk;
+    uint8_t crc[FRAME_CRC_SIZE];
+    uint16_t value;
+    size_t total, i, run, end;
+
+    if (uart == NULL) {
+        return (0);
+    }
+
+    value = frameCrc(frame, size);
+    crc[0] = value & 0xff;
+    crc[1] = value >> 8;
+    total = size + FRAME_CRC_SIZE;
+
+    /* payload then CRC, encoded as one sequence */
+#define FRAME_BYTE(i) ((i) < size ? frame[i] : crc[(i) - size])
+
+    chunk.uart = uart;
+    chunk.fill = 0;
+
+    busLock.acquire();
+
+    if (frameMode == SERIAL_FRAME_SLIP) {
+        /* a leading END flushes any line noise at the receiver */
+        chunkPut(&chunk, SLIP_END);
+        for (i = 0; i < total; i++) {
+            uint8_t c = FRAME_BYTE(i);
+            if (c == SLIP_END) {
+                chunkPut(&chunk, SLIP_ESC);
+                chunkPut(&chunk, SLIP_ESC_END);
+            }
+            else if (c == SLIP_ESC) {
+                chunkPut(&chunk, SLIP_ESC);
+                chunkPut(&chunk, SLIP_ESC_ESC);
+            }
+            else {
+                chunkPut(&chunk, c);
+            }
+        }
+        chunkPut(&chunk, SLIP_END);
+    }
+    else {
+        /*
+         * Each block is a code byte, then code - 1 non-zero bytes that
+         * stand for themselves followed by a zero, except for code 0xFF
+         * which has no zero. The run is measured before the code byte
+         * goes out, so nothing has to be patched afterwards.
+         */
+        i = 0;
+        while (1) {
+            for (run = 0; i + run < total && FRAME_BYTE(i + run) != 0 && run < 254; run++) {
+            }
+            chunkPut(&chunk, run + 1);
+            end = i + run;
+            for (; i < end; i++) {
+                chunkPut(&chunk, FRAME_BYTE(i));
+            }
+            if (i == total) {
+                break;
+            }
+            if (run < 254) {
+                /* the zero that ended the run */
+                i++;
+                if (i == total) {
+                    /* a trailing zero is an empty last block */
+                    chunkPut(&chunk, 1);
+                    break;
+                }
+            }
+        }
+        chunkPut(&chunk, 0);
+    }
+#undef FRAME_BYTE
+
+    chunkFlush(&chunk);
+    stats.txFrames++;
+
+    busLock.release();
+
+    return (size);
+}
+
+/*
+ * Decodes data into frame[frameLength..] until the end of a frame.
+ * Returns how much of data was used; *length is set to the payload
+ * length of a good frame, -1 otherwise.
+ */
+size_t HardwareSerial::frameDecode(const uint8_t *data, size_t count,
+    uint8_t *frame, size_t size, int *length)
+{
+    size_t used = 0;
+    bool end = false;
+    uint8_t c;
+
+    *length = -1;
+
+    while (used < count && !end) {
+        c = data[used++];
+
+        if (frameMode == SERIAL_FRAME_SLIP) {
+            if (c == SLIP_END) {
+                /* back to back ENDs are empty frames */
+                end = (frameLength > 0 || frameDiscard);
+                continue;
+            }
+            if (frameEscape) {
+                frameEscape = false;
+                if (c == SLIP_ESC_END) {
+                    c = SLIP_END;
+                }
+                else if (c == SLIP_ESC_ESC) {
+                    c = SLIP_ESC;
+                }
+                else {
+                    frameDiscard = true;
+                }
+            }
+            else if (c == SLIP_ESC) {
+                frameEscape = true;
+                continue;
+            }
+        }
+        else {
+            if (c == 0) {
+                /* a block cut short is an error, back to back zeros are not */
+                end = (frameCode != 0 || frameDiscard);
+                frameDiscard |= (frameRun != 0);
+                continue;
+            }
+            if (frameRun == 0) {
+                /* code byte: the previous block ended with a zero unless it was full */
+                bool zero = (frameCode != 0 && frameCode != 0xff);
+                frameCode = c;
+                frameRun = c - 1;
+                if (!zero) {
+                    continue;
+                }
+                c = 0;
+            }
+            else {
+                frameRun--;
+            }
+        }
+
+        if (frameLength < size) {
+            frame[frameLength++] = c;
+        }
+        else {
+            frameDiscard = true;
+        }
+    }
+
+    if (end) {
+        if (frameDiscard || frameLength < FRAME_CRC_SIZE) {
+            stats.framingErrors++;
+        }
+        else {
+            size_t payload = frameLength - FRAME_CRC_SIZE;
+            uint16_t crc = frame[payload] | (frame[payload + 1] << 8);
+
+            if (frameCrc(frame, payload) == crc) {
+                stats.rxFrames++;
+                *length = payload;
+            }
+            else {
+                stats.crcErrors++;
+            }
+        }
+        frameReset();
+    }
+
+    return (used);
+}
+
+/*
+ * Returns the payload length of the next good frame, or -1 until one has
+ * arrived. The frame is decoded in place as its bytes come in, so the
+ * same buffer, with room for the payload and the 2 CRC bytes, must be
+ * passed until a frame is returned. Bad frames are counted and dropped.
+ */
+int HardwareSerial::readFrame(uint8_t *frame, size_t size)
+{
+    const uint8_t *data;
+    size_t used;
+    int count, length;
+
+    if (uart == NULL) {
+        return (-1);
+    }
+
+    while (1) {
+        /* bytes read ahead of the end of the last frame */
+        if (stageRead < stageFill) {
+            used = frameDecode(&frameStage[stageRead], stageFill - stageRead,
+                frame, size, &length);
+            stageRead += used;
+            if (length >= 0) {
+                return (length);
+            }
+            continue;
+        }
+
+        if (rxCallback != NULL) {
+            /* straight out of the receive ring */
+            count = peekBuffer(&data);
+            if (count <= 0) {
+                return (-1);
+            }
+            used = frameDecode(data, count, frame, size, &length);
+            consume(used);
+        }
+        else {
+            /*
+             * the driver keeps the ring, one read takes what it holds;
+             * whatever follows the end of a frame waits in frameStage
+             */
+            count = available();
+            if (count <= 0) {
+                return (-1);
+            }
+            if (count > SERIAL_BUFFER_SIZE) {
+                count = SERIAL_BUFFER_SIZE;
+            }
+            count = UART_read(uart, frameStage, count);
+            if (count <= 0) {
+                return (-1);
+            }
+            stageFill = count;
+            stageRead = 0;
+            continue;
+        }
+
+        if (length >= 0) {
+            return (length);
+        }
+    }
+}
+
+void HardwareSerial::frameStats(SerialFrameStats &frameStats, bool reset)
+{
+    unsigned int hwiKey;
+
+    hwiKey = Hwi_disable();
+    frameStats = stats;
+    if (reset) {
+        memset(&stats, 0, sizeof(stats));
+        stats.since = millis();
+    }
+    Hwi_restore(hwiKey);
+}
+
 void serialEvent() __attribute__((weak));
 void serialEvent() { }
 
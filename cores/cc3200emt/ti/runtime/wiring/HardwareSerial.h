@@ -39,10 +39,31 @@
 #include <ti/drivers/UART.h>
 
 #include <ti/sysbios/knl/Semaphore.h>
-#include <ti/sysbios/gates/GateMutex.h>
+#include "BusLock.h"
 
 #define SERIAL_BUFFER_SIZE  32
 
+/*
+ * Packet framing for writeFrame()/readFrame(). Each frame carries a
+ * CRC-16/CCITT of its payload, low byte first, and is encoded with
+ *  SERIAL_FRAME_COBS: Consistent Overhead Byte Stuffing, ended by 0x00
+ *  SERIAL_FRAME_SLIP: RFC 1055, between 0xC0 bytes
+ * extras/serialframe has the matching decoder for a Linux host.
+ */
+#define SERIAL_FRAME_COBS   0
+#define SERIAL_FRAME_SLIP   1
+
+/* bytes encoded on the stack per UART_write() */
+#define SERIAL_FRAME_CHUNK  64
+
+typedef struct SerialFrameStats {
+    unsigned long txFrames;
+    unsigned long rxFrames;
+    unsigned long crcErrors;
+    unsigned long framingErrors;  /* bad encoding, or too long for the buffer */
+    unsigned long since;          /* millis() when the counters were reset */
+} SerialFrameStats;
+
 class HardwareSerial : public Stream
 {
 
@@ -56,9 +77,23 @@ class HardwareSerial : public Stream
         UART_Handle uart;
         UART_Callback rxCallback; 
         Semaphore_Struct rxSemaphore;
-        GateMutex_Struct gate;
+        BusLock busLock;
+        uint8_t frameMode;
+        bool frameEscape;
+        bool frameDiscard;
+        uint8_t frameCode;
+        uint8_t frameRun;
+        size_t frameLength;
+        unsigned char frameStage[SERIAL_BUFFER_SIZE];
+        unsigned char txStage[SERIAL_BUFFER_SIZE];  /* space handed out by writeBuffer() */
+        uint8_t stageRead;
+        uint8_t stageFill;
+        SerialFrameStats stats;
         void init(unsigned long module, UART_Callback callback);
         void flushAll(void);
+        void frameReset(void);
+        size_t frameDecode(const uint8_t *data, size_t count,
+            uint8_t *frame, size_t size, int *length);
 
     public:
         operator bool();// Arduino compatibility (see StringLength example)
@@ -70,15 +105,24 @@ class HardwareSerial : public Stream
         void setPins(unsigned long);
         void acquire(void);  /* acquire serial port for this thread */
         void release(void);  /* release serial port */
+        BusLock &lock(void) { return (busLock); }
         void end(void);
         virtual int available(void);
         virtual int peek(void);
         virtual int read(void);
+        virtual int peekBuffer(const uint8_t **buffer);
+        virtual void consume(size_t size);
         virtual void flush(void);
         void readCallback(UART_Handle uart, void *buf, size_t count);
         virtual size_t write(uint8_t c);
         virtual size_t write(const uint8_t *buffer, size_t size);
+        virtual int writeBuffer(uint8_t **buffer);
+        virtual void commit(size_t size);
         using Print::write; // pull in write(str) from Print
+        void setFraming(uint8_t mode);
+        size_t writeFrame(const uint8_t *frame, size_t size);
+        int readFrame(uint8_t *frame, size_t size);
+        void frameStats(SerialFrameStats &frameStats, bool reset = false);
 };
 
 extern HardwareSerial Serial;
@@ -0,0 +1,177 @@
+/*
+  NetBuffers.cpp - a pool of buffers shared by the networking libraries
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+#include "Energia.h"
+#include "NetBuffers.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+/* heap buffers keep their size in front, 8 bytes to stay aligned */
+#define HEAP_HEADER 8
+
+NetBufferPool NetBuffers;
+
+NetBufferPool::NetBufferPool()
+{
+    _arena = NULL;
+    _arenaEnd = NULL;
+    _free = NULL;
+    memset(&_stats, 0, sizeof(_stats));
+}
+
+bool NetBufferPool::begin(size_t blockSize, uint16_t blocks)
+{
+    uint8_t *arena, *old;
+    UInt key;
+
+    /* whole words, so that each block can hold the free list link */
+    blockSize = (blockSize + 3) & ~3;
+    if (blockSize == 0 || blocks == 0) {
+        return false;
+    }
+
+    /* malloc() may block, so it's called with task switching enabled */
+    arena = (uint8_t *)malloc(blockSize * blocks);
+    if (arena == NULL) {
+        return false;
+    }
+
+    key = Task_disable();
+    if (_stats.inUse != 0) {
+        Task_restore(key);
+        free(arena);
+        return false;
+    }
+    old = _arena;
+    _arena = arena;
+    _arenaEnd = arena + blockSize * blocks;
+    _free = NULL;
+    for (uint16_t i = blocks; i > 0; i--) {
+        void **block = (void **)(arena + (i - 1) * blockSize);
+        *block = _free;
+        _free = block;
+    }
+    _stats.blockSize = blockSize;
+    _stats.blocks = blocks;
+    _stats.peak = 0;
+    Task_restore(key);
+
+    free(old);
+    return true;
+}
+
+void *NetBufferPool::acquire(size_t size)
+{
+    void *buffer = NULL;
+    UInt key;
+
+    if (_arena == NULL) {
+        /* another task may win the race, then this arena is dropped */
+        begin();
+    }
+
+    if (size > _stats.blockSize) {
+        uint8_t *heap = (uint8_t *)malloc(size + HEAP_HEADER);
+
+        key = Task_disable();
+        if (heap == NULL) {
+            _stats.failures++;
+        }
+        else {
+            *(size_t *)heap = size;
+            buffer = heap + HEAP_HEADER;
+            _stats.heapInUse++;
+            _stats.heapBytes += size;
+            _stats.acquired++;
+        }
+        Task_restore(key);
+        return buffer;
+    }
+
+    key = Task_disable();
+    if (_free == NULL) {
+        _stats.failures++;
+    }
+    else {
+        buffer = _free;
+        _free = *(void **)buffer;
+        if (++_stats.inUse > _stats.peak) {
+            _stats.peak = _stats.inUse;
+        }
+        _stats.acquired++;
+    }
+    Task_restore(key);
+    return buffer;
+}
+
+void NetBufferPool::release(void *buffer)
+{
+    uint8_t *p = (uint8_t *)buffer;
+    UInt key;
+
+    if (p == NULL) {
+        return;
+    }
+
+    key = Task_disable();
+    if (p >= _arena && p < _arenaEnd) {
+        *(void **)p = _free;
+        _free = p;
+        _stats.inUse--;
+        Task_restore(key);
+        return;
+    }
+    p -= HEAP_HEADER;
+    _stats.heapInUse--;
+    _stats.heapBytes -= *(size_t *)p;
+    Task_restore(key);
+    free(p);
+}
+
+size_t NetBufferPool::blockSize(void)
+{
+    if (_arena == NULL) {
+        begin();
+    }
+    return _stats.blockSize;
+}
+
+void NetBufferPool::stats(NetBufferStats &stats)
+{
+    UInt key = Task_disable();
+    stats = _stats;
+    Task_restore(key);
+}
+
+void NetBufferPool::resetPeak(void)
+{
+    UInt key = Task_disable();
+    _stats.peak = _stats.inUse;
+    Task_restore(key);
+}
+
+extern "C" void *net_buffer_acquire(size_t size)
+{
+    return NetBuffers.acquire(size);
+}
+
+extern "C" void net_buffer_release(void *buffer)
+{
+    NetBuffers.release(buffer);
+}
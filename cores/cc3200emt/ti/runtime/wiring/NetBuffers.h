@@ -0,0 +1,88 @@
+/*
+  NetBuffers.h - a pool of buffers shared by the networking libraries
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+#ifndef NetBuffers_h
+#define NetBuffers_h
+
+#include <stdint.h>
+#include <stddef.h>
+
+#define NET_BUFFER_SIZE     256     // default block size
+#define NET_BUFFER_COUNT    8       // default number of blocks
+
+typedef struct {
+    size_t blockSize;
+    uint16_t blocks;        // blocks in the pool
+    uint16_t inUse;         // blocks handed out now
+    uint16_t peak;          // most blocks handed out at once
+    uint16_t heapInUse;     // buffers larger than a block, taken from the heap
+    size_t heapBytes;       // bytes of those
+    uint32_t acquired;      // successful acquire() calls
+    uint32_t failures;      // acquire() calls that found no memory
+} NetBufferStats;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* for C code, the same as NetBuffers.acquire() and NetBuffers.release() */
+extern void *net_buffer_acquire(size_t size);
+extern void net_buffer_release(void *buffer);
+
+#ifdef __cplusplus
+}
+
+/*
+ * The receive and transmit buffers of WiFiClient, WiFiUDP, PubSubClient
+ * and the aJson parser are taken from this pool while they hold data and
+ * given back once it is consumed, so idle sockets cost no buffer memory.
+ *
+ * The pool is one block of memory allocated on first use, blocks of
+ * NET_BUFFER_COUNT x NET_BUFFER_SIZE bytes unless begin() was called
+ * before. A request up to the block size gets a block; a larger one,
+ * asked for with an object's setBufferSize(), comes from the heap. When
+ * all blocks are out, acquire() fails rather than grow the heap and the
+ * object waits (or drops the packet, for UDP) until one is given back.
+ */
+class NetBufferPool
+{
+    public:
+        NetBufferPool();
+
+        /* sizes the pool; fails while any block is handed out */
+        bool begin(size_t blockSize = NET_BUFFER_SIZE, uint16_t blocks = NET_BUFFER_COUNT);
+
+        void *acquire(size_t size);     // NULL if no memory
+        void release(void *buffer);     // NULL is ignored
+
+        size_t blockSize(void);
+        void stats(NetBufferStats &stats);
+        void resetPeak(void);
+
+    private:
+        uint8_t *_arena;
+        uint8_t *_arenaEnd;
+        void *_free;                    // free blocks, linked through their first word
+        NetBufferStats _stats;
+};
+
+extern NetBufferPool NetBuffers;
+
+#endif
+
+#endif
@@ -19,21 +19,155 @@
 
 #include "PString.h"
 
+static const char hexDigits[] = "0123456789ABCDEF";
+
 void PString::begin()
 {
     _cur = _buf;
+    _truncated = false;
     if (_size > 0) {
       _buf[0] = '\0';
     }
 }
 
+size_t PString::spill()
+{
+    size_t n = 0;
+
+    if (_spill != NULL && _cur > _buf) {
+        n = _spill->write((const uint8_t *)_buf, _cur - _buf);
+        _cur = _buf;
+        *_cur = '\0';
+    }
+    return n;
+}
+
+/* copies what fits of str, keeping the 0 terminator, spilling as it fills */
+size_t PString::append(const char *str, size_t len)
+{
+    size_t done = 0, room, n;
+
+    for (;;) {
+        room = _size > 0 ? _buf + _size - _cur - 1 : 0;
+        n = len - done < room ? len - done : room;
+        if (n > 0) {
+            memcpy(_cur, str + done, n);
+            _cur += n;
+            *_cur = '\0';
+            done += n;
+        }
+        if (done == len) {
+            return done;
+        }
+        if (_spill == NULL || _cur == _buf) {
+            _truncated = true;
+            return done;
+        }
+        spill();
+    }
+}
+
 size_t PString::write(uint8_t b)
 {
+    if (_cur + 1 >= _buf + _size) {
+        spill();
+    }
     if (_cur + 1 < _buf + _size) {
         *_cur++ = (char)b;
         *_cur = '\0';
 	return 1;
     }
 
+    _truncated = true;
     return 0;
 }
+
+size_t PString::write(const uint8_t *buffer, size_t size)
+{
+    return append((const char *)buffer, size);
+}
+
+int PString::writeBuffer(uint8_t **buffer)
+{
+    if (_cur + 1 >= _buf + _size) {
+        spill();
+    }
+    *buffer = (uint8_t *)_cur;
+    return _size > 0 ? _buf + _size - _cur - 1 : 0;
+}
+
+void PString::commit(size_t size)
+{
+    if (_size == 0) {
+        return;
+    }
+    if (size > (size_t)(_buf + _size - _cur - 1)) {
+        size = _buf + _size - _cur - 1;
+        _truncated = true;
+    }
+    _cur += size;
+    *_cur = '\0';
+}
+
+/*
+ * Both encoders copy each run of characters that need no escape at once
+ */
+size_t PString::printJson(const char *str)
+{
+    char esc[6] = { '\\', 'u', '0', '0' };
+    size_t n = append("\"", 1);
+    size_t run;
+    uint8_t c;
+
+    while (*str != 0) {
+        for (run = 0; (c = str[run]) >= 0x20 && c != '"' && c != '\\'; run++) {
+        }
+        n += append(str, run);
+        str += run;
+        if (c == 0) {
+            break;
+        }
+
+        switch (c) {
+            case '"':  n += append("\\\"", 2); break;
+            case '\\': n += append("\\\\", 2); break;
+            case '\n': n += append("\\n", 2); break;
+            case '\r': n += append("\\r", 2); break;
+            case '\t': n += append("\\t", 2); break;
+            default:
+                esc[4] = hexDigits[c >> 4];
+                esc[5] = hexDigits[c & 0x0f];
+                n += append(esc, 6);
+                break;
+        }
+        str++;
+    }
+    return n + append("\"", 1);
+}
+
+size_t PString::printUrl(const char *str, const char *safe)
+{
+    char esc[3] = { '%' };
+    size_t n = 0, run;
+    uint8_t c;
+
+    while (*str != 0) {
+        for (run = 0; (c = str[run]) != 0; run++) {
+            if (!((c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9') ||
+                  c == '-' || c == '_' || c == '.' || c == '~' || strchr(safe, c) != NULL)) {
+                break;
+            }
+        }
+        n += append(str, run);
+        str += run;
+        if (c == 0) {
+            break;
+        }
+
+        esc[1] = hexDigits[c >> 4];
+        esc[2] = hexDigits[c & 0x0f];
+        n += append(esc, 3);
+        str++;
+    }
+    return n;
+}
@@ -30,20 +30,27 @@ class PString : public Print
 private:
     char *_buf, *_cur;
     size_t _size;
+    bool _truncated;
+    Print *_spill;
+
+    size_t append(const char *str, size_t len);
 
 public:
     using Print::write; // lift all default implementations of write()
-    virtual size_t write(uint8_t); // override just write(uint8_t)
+    virtual size_t write(uint8_t);
+    virtual size_t write(const uint8_t *buffer, size_t size); // one copy, not a call per byte
+    virtual int writeBuffer(uint8_t **buffer); // free space before the 0 terminator
+    virtual void commit(size_t size);
 
     // Basic constructor requires a preallocated buffer
-    PString(char *buf, size_t size) : _buf(buf), _size(size)
+    PString(char *buf, size_t size) : _buf(buf), _size(size), _spill(NULL)
     { begin(); }
 
     // templated constructors allow inline renderings of this type: PString(buf, size, myfloat[, modifier]);
-    template<class T> PString(char *buf, size_t size, T arg) : _buf(buf), _size(size) 
+    template<class T> PString(char *buf, size_t size, T arg) : _buf(buf), _size(size), _spill(NULL)
     { begin(); print(arg); }
   
-    template<class T> PString(char *buf, size_t size, T arg, int modifier) : _buf(buf), _size(size) 
+    template<class T> PString(char *buf, size_t size, T arg, int modifier) : _buf(buf), _size(size), _spill(NULL)
     { begin(); print(arg, modifier); }
 
     // returns the length of the current string, not counting the 0 terminator
@@ -62,9 +69,31 @@ public:
     bool operator==(const char *str) 
     { return _size > 0 && !strcmp(_buf, str); }
 
+    // true once something did not fit; the string keeps what did, until begin()
+    inline bool truncated()
+    { return _truncated; }
+
     // call this to re-use an existing string
     void begin();
 
+    // Instead of truncating, a full string writes what it holds to out
+    // and starts over, e.g. to build a request that goes out in one write
+    // when it fits and in buffer-sized writes when it does not; spill()
+    // writes the rest. format() output that does not fit is still truncated.
+    inline void spillTo(Print *out)
+    { _spill = out; }
+
+    // writes the string to the spillTo() output and empties it
+    size_t spill();
+
+    // Appends str as a JSON string, quotes included, escaping '"', '\\' and
+    // control characters, e.g. to build a request body in a stack buffer
+    size_t printJson(const char *str);
+
+    // Appends str percent-encoded as RFC 3986 asks for a URL path or query:
+    // letters, digits and "-_.~" stay as they are, and so do the characters in safe
+    size_t printUrl(const char *str, const char *safe = "");
+
     // This function allows assignment to an arbitrary scalar value like str = myfloat;
     template<class T> inline PString &operator =(T arg) 
     { begin(); print(arg); return *this; }
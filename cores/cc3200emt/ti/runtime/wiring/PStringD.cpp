@@ -30,6 +30,9 @@ int PString::format(char *str, ...)
     va_start(argptr, str); 
     int ret = System_vsnprintf(_cur, _size - (_cur - _buf), str, argptr);
     if (_size) {
+        if (ret >= (int)(_size - (_cur - _buf))) {
+            _truncated = true;
+        }
         while (*_cur) {
             ++_cur;
         }
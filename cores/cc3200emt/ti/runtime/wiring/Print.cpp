@@ -104,9 +104,7 @@ size_t Print::print(const Printable& x)
 
 size_t Print::println(void)
 {
-    size_t n = print('\r');
-    n += print('\n');
-    return (n);
+    return (write("\r\n"));
 }
 
 size_t Print::println(const String &s)
@@ -204,40 +202,60 @@ size_t Print::printNumber(unsigned long n, uint8_t base)
 
 size_t Print::printFloat(float number, uint8_t digits)
 {
+    char buf[32];   // sign, 10 integer digits and the point fit, long fractions go in pieces
+    char *p = buf, *first, *last;
     size_t n = 0;
 
     // Handle negative numbers
-    if (number < 0.0)
+    if (number < 0.0f)
     {
-        n += print('-');
+        *p++ = '-';
         number = -number;
     }
 
     // Round correctly so that print(1.999, 2) prints as "2.00"
-    float rounding = 0.5;
-    for (uint8_t i=0; i<digits; ++i)
+    float rounding = 0.5f;
+    for (uint8_t i = 0; i < digits; ++i)
         rounding /= 10.0f;
 
     number += rounding;
 
-    // Extract the integer part of the number and print it
+    // Extract the integer part of the number, its digits come out last first
     unsigned long int_part = (unsigned long)number;
     float remainder = number - (float)int_part;
-    n += print(int_part);
+    first = p;
+    do {
+        *p++ = '0' + int_part % 10;
+        int_part /= 10;
+    } while (int_part);
+    for (last = p - 1; first < last; first++, last--) {
+        char c = *first;
+        *first = *last;
+        *last = c;
+    }
 
-    // Print the decimal point, but only if there are digits beyond
+    // Add the decimal point, but only if there are digits beyond
     if (digits > 0) {
-        n += print(".");
+        *p++ = '.';
     }
 
     // Extract digits from the remainder one at a time
     while (digits-- > 0)
     {
-        remainder *= 10.0;
+        if (p == buf + sizeof(buf)) {
+            n += write((const uint8_t *)buf, p - buf);
+            p = buf;
+        }
+        remainder *= 10.0f;
         int toPrint = int(remainder);
-        n += print(toPrint);
+        if (toPrint > 9) {
+            toPrint = 9;
+        }
+        *p++ = '0' + toPrint;
         remainder -= toPrint;
     }
 
+    // one write, so a client or a UART sees the number whole
+    n += write((const uint8_t *)buf, p - buf);
     return (n);
 }
@@ -59,6 +59,12 @@ class Print
         virtual size_t write(const uint8_t *buffer, size_t size);
         size_t write(const char *str) { return write((const uint8_t *)str, strlen(str)); }
 
+        virtual int writeBuffer(uint8_t **buffer) { return -1; } // points buffer at free space inside the output
+        // returns the number of bytes that fit, or -1 if the output does not expose its buffer
+
+        virtual void commit(size_t size) {} // appends size bytes placed in the space returned by writeBuffer
+        // a writeBuffer() that returned space is followed by a commit(), commit(0) if it went unused
+
         size_t print(const String &);
         size_t print(const char[]);
         size_t print(char);
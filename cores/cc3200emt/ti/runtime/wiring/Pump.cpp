@@ -0,0 +1,277 @@
+/*
+  Pump.cpp - moves data from a Stream to a Print, in the foreground or as a task
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+#include "Energia.h"
+#include "Pump.h"
+
+#include <xdc/runtime/Error.h>
+
+Pump::Pump(Stream &src, Print &dst) : _src(src), _dst(dst)
+{
+    _limit = PUMP_NO_LIMIT;
+    _rate = PUMP_NO_LIMIT;
+    _idle = PUMP_DEFAULT_IDLE;
+    _task = NULL;
+    Semaphore_construct(&_finished, 0, NULL);
+    reset();
+}
+
+Pump::~Pump()
+{
+    stop();
+    Semaphore_destruct(&_finished);
+}
+
+void Pump::setLimit(size_t bytes)
+{
+    _limit = bytes;
+}
+
+void Pump::setRate(unsigned long bytesPerSec)
+{
+    _rate = bytesPerSec;
+    _credit = 0;
+    _last = millis();
+}
+
+void Pump::setIdleTimeout(unsigned long ms)
+{
+    _idle = ms;
+}
+
+void Pump::reset(void)
+{
+    _count = 0;
+    _done = false;
+    _stopping = false;
+    _credit = 0;
+    _last = millis();
+}
+
+/*
+ * Number of bytes the rate limit lets through now
+ */
+size_t Pump::allowance(void)
+{
+    unsigned long now, elapsed, burst;
+
+    if (_rate == PUMP_NO_LIMIT) {
+        return ((size_t)-1);
+    }
+
+    now = millis();
+    elapsed = now - _last;
+    _last = now;
+    if (elapsed > PUMP_BURST_MS) {
+        elapsed = PUMP_BURST_MS;
+    }
+
+    burst = _rate * PUMP_BURST_MS;
+    if (burst < PUMP_BLOCK_SIZE * 1000UL) {
+        burst = PUMP_BLOCK_SIZE * 1000UL;
+    }
+
+    _credit += elapsed * _rate;
+    if (_credit > burst) {
+        _credit = burst;
+    }
+
+    return (_credit / 1000);
+}
+
+/*
+ * Move one span or block of at most max bytes
+ */
+size_t Pump::move(size_t max)
+{
+    const uint8_t *data;
+    uint8_t *space;
+    int len, room, n;
+
+    room = _dst.writeBuffer(&space);
+    if (room == 0) {
+        _done = true;
+        return (0);
+    }
+
+    len = _src.peekBuffer(&data);
+    if (len == 0) {
+        if (room > 0) {
+            _dst.commit(0);
+        }
+        return (0);
+    }
+
+    if (len > 0) {
+        if ((size_t)len > max) {
+            len = max;
+        }
+        if (room > 0) {
+            /* both sides expose their buffers: a single copy */
+            if (len > room) {
+                len = room;
+            }
+            memcpy(space, data, len);
+            _dst.commit(len);
+            n = len;
+        }
+        else {
+            n = _dst.write(data, len);
+        }
+        _src.consume(n);
+    }
+    else if (room > 0) {
+        /* read straight into the destination */
+        if ((size_t)room > max) {
+            room = max;
+        }
+        n = _src.read(space, room);
+        if (n <= 0) {
+            _dst.commit(0);
+            return (0);
+        }
+        _dst.commit(n);
+        len = n;
+    }
+    else {
+        if (max > PUMP_BLOCK_SIZE) {
+            max = PUMP_BLOCK_SIZE;
+        }
+        len = _src.read(_block, max);
+        if (len <= 0) {
+            return (0);
+        }
+        n = _dst.write(_block, len);
+    }
+
+    if (n < len) {
+        /* dst is full or gone */
+        _done = true;
+    }
+    return (n > 0 ? n : 0);
+}
+
+size_t Pump::poll(void)
+{
+    size_t total = 0;
+    size_t max, n;
+
+    while (!_done && !_stopping) {
+        max = allowance();
+        if (_limit != PUMP_NO_LIMIT) {
+            if (_count >= _limit) {
+                _done = true;
+                break;
+            }
+            if (max > _limit - _count) {
+                max = _limit - _count;
+            }
+        }
+        if (max == 0) {
+            break;
+        }
+
+        n = move(max);
+        if (n == 0) {
+            break;
+        }
+        if (_rate != PUMP_NO_LIMIT) {
+            _credit -= n * 1000;
+        }
+        _count += n;
+        total += n;
+    }
+
+    if (_limit != PUMP_NO_LIMIT && _count >= _limit) {
+        _done = true;
+    }
+    return (total);
+}
+
+size_t Pump::run(void)
+{
+    unsigned long idleStart = millis();
+
+    while (!_done && !_stopping) {
+        if (poll() > 0) {
+            idleStart = millis();
+        }
+        else if (millis() - idleStart >= _idle) {
+            break;
+        }
+        else {
+            delay(1);
+        }
+    }
+    return (_count);
+}
+
+void Pump::taskFxn(UArg arg0, UArg arg1)
+{
+    Pump *pump = (Pump *)arg0;
+
+    pump->run();
+    Semaphore_post(Semaphore_handle(&pump->_finished));
+}
+
+bool Pump::start(int priority, size_t stackSize)
+{
+    Task_Params taskParams;
+    Error_Block eb;
+
+    if (_task != NULL) {
+        return (false);
+    }
+
+    _stopping = false;
+    Error_init(&eb);
+    Task_Params_init(&taskParams);
+    taskParams.arg0 = (UArg)this;
+    taskParams.priority = priority;
+    taskParams.stackSize = stackSize;
+    _task = Task_create(taskFxn, &taskParams, &eb);
+
+    return (_task != NULL);
+}
+
+bool Pump::wait(unsigned long timeout)
+{
+    if (_task == NULL) {
+        return (true);
+    }
+    if (!Semaphore_pend(Semaphore_handle(&_finished), timeout)) {
+        return (false);
+    }
+    Task_delete(&_task);
+    return (true);
+}
+
+void Pump::stop(void)
+{
+    _stopping = true;
+    wait();
+}
+
+size_t pump(Stream &src, Print &dst, size_t limit, unsigned long idle)
+{
+    Pump p(src, dst);
+
+    p.setLimit(limit);
+    p.setIdleTimeout(idle);
+    return (p.run());
+}
@@ -0,0 +1,101 @@
+/*
+  Pump.h - moves data from a Stream to a Print, in the foreground or as a task
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+#ifndef Pump_h
+#define Pump_h
+
+#include <inttypes.h>
+#include "Stream.h"
+
+#include <ti/sysbios/BIOS.h>
+#include <ti/sysbios/knl/Task.h>
+#include <ti/sysbios/knl/Semaphore.h>
+
+#define PUMP_BLOCK_SIZE     128     // intermediate copy used when the source has no buffer
+#define PUMP_BURST_MS       100     // a rate limited pump may catch up on this much idle time
+#define PUMP_STACK_SIZE     0x400
+#define PUMP_NO_LIMIT       0       // setLimit()/setRate() value: unlimited
+#define PUMP_DEFAULT_IDLE   1000    // ms without data before run() returns
+
+/*
+ * Moves bytes from src to dst in blocks instead of one read()/write()
+ * pair per byte:
+ *
+ *  - if src exposes its input (Stream::peekBuffer) and dst exposes free
+ *    space (Print::writeBuffer), the bytes are copied once between them
+ *  - if only src exposes its input, that span is handed to dst.write()
+ *  - otherwise one block is read with Stream::read(buf, size), straight
+ *    into dst's space if it has some, or into the pump's own block
+ *
+ * PString, HardwareSerial and WiFiClient expose free space; WiFiClient's
+ * comes from NetBuffers, so when the pool is out the pump falls back to
+ * its own block.
+ *
+ * The pump stops once the byte limit is reached, dst refuses data, or no
+ * data arrived for the idle timeout. It can run in the calling task or in
+ * a task of its own; while that task runs, src and dst belong to it.
+ */
+class Pump
+{
+    public:
+        Pump(Stream &src, Print &dst);
+        ~Pump();
+
+        void setLimit(size_t bytes);            // stop after this many bytes, PUMP_NO_LIMIT by default
+        void setRate(unsigned long bytesPerSec); // throttle, PUMP_NO_LIMIT by default
+        void setIdleTimeout(unsigned long ms);  // PUMP_DEFAULT_IDLE by default
+
+        size_t poll(void);  // moves what is available now without waiting, returns the bytes moved
+        size_t run(void);   // moves data until the pump stops, returns the total count
+
+        bool start(int priority = 1, size_t stackSize = PUMP_STACK_SIZE); // run() in a new task
+        bool wait(unsigned long timeout = BIOS_WAIT_FOREVER); // true once the task has finished
+        void stop(void);    // asks the task to finish and waits for it
+
+        size_t count(void) { return _count; }  // bytes moved since construction or reset()
+        bool done(void) { return _done; }      // limit reached or dst refused data
+        void reset(void);
+
+    private:
+        static void taskFxn(UArg arg0, UArg arg1);
+        size_t move(size_t max);
+        size_t allowance(void);
+
+        Stream &_src;
+        Print &_dst;
+        size_t _limit;
+        unsigned long _rate;
+        unsigned long _idle;
+        unsigned long _credit;      // rate limit budget in 1/1000 bytes
+        unsigned long _last;
+        volatile size_t _count;
+        volatile bool _done;
+        volatile bool _stopping;
+        Task_Handle _task;
+        Semaphore_Struct _finished;
+        uint8_t _block[PUMP_BLOCK_SIZE];
+};
+
+/*
+ * Pumps src into dst in the calling task until limit bytes were moved or
+ * no data arrived for idle milliseconds, returns the number of bytes moved
+ */
+size_t pump(Stream &src, Print &dst, size_t limit = PUMP_NO_LIMIT,
+            unsigned long idle = PUMP_DEFAULT_IDLE);
+
+#endif
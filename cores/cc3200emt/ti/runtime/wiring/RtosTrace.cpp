@@ -0,0 +1,218 @@
+/*
+  RtosTrace.cpp - binary event trace of tasks, interrupts and driver calls
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+#include "Energia.h"
+#include "RtosTrace.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#include <ti/sysbios/hal/Hwi.h>
+
+EventTrace RtosTrace;
+
+/* the active exception, 0 in thread mode */
+static inline uint8_t exceptionNumber(void)
+{
+#if defined(__GNUC__) && defined(__arm__)
+    uint32_t ipsr;
+
+    asm volatile ("mrs %0, ipsr" : "=r" (ipsr));
+    return ((uint8_t)ipsr);
+#else
+    return (0);
+#endif
+}
+
+EventTrace::EventTrace()
+{
+    _ring = NULL;
+    _mask = 0;
+    _head = 0;
+    _on = false;
+}
+
+bool EventTrace::begin(uint16_t events)
+{
+    uint32_t size = 1;
+
+    if (_ring != NULL) {
+        start();
+        return (true);
+    }
+
+    while (size * 2 <= events) {
+        size *= 2;
+    }
+
+    /* the clock starts outside the hooks, which may run in an interrupt */
+    SysTime.begin();
+
+    _ring = (RtosTraceEvent *)malloc(size * sizeof(RtosTraceEvent));
+    if (_ring == NULL) {
+        return (false);
+    }
+    memset(_ring, 0, size * sizeof(RtosTraceEvent));
+    _mask = size - 1;
+    _head = 0;
+    _on = true;
+    return (true);
+}
+
+/*
+ * A writer preempted in record() has either filled its slot or not yet
+ * looked at _ring, so the ring can go once it is unhooked
+ */
+void EventTrace::end(void)
+{
+    RtosTraceEvent *ring;
+    UInt key;
+
+    key = Hwi_disable();
+    _on = false;
+    ring = _ring;
+    _ring = NULL;
+    Hwi_restore(key);
+
+    free(ring);
+}
+
+void EventTrace::record(uint8_t type, const void *object, uint16_t arg)
+{
+    RtosTraceEvent *e;
+    UInt key;
+
+    key = Hwi_disable();
+    if (_ring != NULL) {
+        e = &_ring[_head & _mask];
+        _head++;
+
+        e->time = (uint32_t)(SysTime.cycles() >> RTOSTRACE_SHIFT);
+        e->type = type;
+        e->context = exceptionNumber();
+        e->arg = arg;
+        e->task = (uint32_t)(uintptr_t)Task_self();
+        e->object = (uint32_t)(uintptr_t)object;
+    }
+    Hwi_restore(key);
+}
+
+static size_t writeU32(Print &out, uint32_t value)
+{
+    uint8_t b[4];
+
+    b[0] = value;
+    b[1] = value >> 8;
+    b[2] = value >> 16;
+    b[3] = value >> 24;
+    return (out.write(b, 4));
+}
+
+/*
+ * header:  magic, version (u16), event size (u16), cpu Hz, shift,
+ *          events recorded in all, events in the dump, labels
+ * labels:  address (u32), length (u8), characters
+ * events:  RtosTraceEvent, oldest first
+ * all little endian
+ */
+size_t EventTrace::dump(Print &out)
+{
+    const char *names[RTOSTRACE_NAMES];
+    uint32_t head, count, first, i, j, numNames = 0;
+    SysTimeStats clock;
+    RtosTraceEvent *e;
+    bool was = _on;
+    size_t bytes = 0;
+    uint8_t len;
+
+    if (_ring == NULL) {
+        return (0);
+    }
+    _on = false;
+
+    head = _head;
+    count = head > _mask + 1 ? _mask + 1 : head;
+    first = head - count;
+
+    /* the labels the events refer to, as far as they fit */
+    for (i = 0; i < count; i++) {
+        e = &_ring[(first + i) & _mask];
+        if (!RTOSTRACE_NAMED(e->type) || e->object == 0) {
+            continue;
+        }
+        for (j = 0; j < numNames && (uint32_t)(uintptr_t)names[j] != e->object; j++) {
+        }
+        if (j == numNames && numNames < RTOSTRACE_NAMES) {
+            names[numNames++] = (const char *)(uintptr_t)e->object;
+        }
+    }
+
+    SysTime.stats(clock);
+
+    bytes += writeU32(out, RTOSTRACE_MAGIC);
+    bytes += writeU32(out, RTOSTRACE_VERSION | (sizeof(RtosTraceEvent) << 16));
+    bytes += writeU32(out, clock.cpuHz);
+    bytes += writeU32(out, RTOSTRACE_SHIFT);
+    bytes += writeU32(out, head);
+    bytes += writeU32(out, count);
+    bytes += writeU32(out, numNames);
+
+    for (i = 0; i < numNames; i++) {
+        for (len = 0; len < RTOSTRACE_NAME_MAX && names[i][len] != 0; len++) {
+        }
+        bytes += writeU32(out, (uint32_t)(uintptr_t)names[i]);
+        bytes += out.write(len);
+        bytes += out.write((const uint8_t *)names[i], len);
+    }
+
+    /* the ring is stored little endian already */
+    for (i = 0; i < count; i++) {
+        bytes += out.write((const uint8_t *)&_ring[(first + i) & _mask], sizeof(RtosTraceEvent));
+    }
+
+    _on = was;
+    return (bytes);
+}
+
+/*
+ * Hook set functions
+ */
+void rtosTraceTaskSwitch(Task_Handle prev, Task_Handle next)
+{
+    RtosTrace.event(RTOSTRACE_TASK_SWITCH, next);
+}
+
+void rtosTraceSwiBegin(void *swi)
+{
+    RtosTrace.event(RTOSTRACE_SWI_BEGIN, swi);
+}
+
+void rtosTraceSwiEnd(void *swi)
+{
+    RtosTrace.event(RTOSTRACE_SWI_END, swi);
+}
+
+void rtosTraceHwiBegin(void *hwi)
+{
+    RtosTrace.event(RTOSTRACE_HWI_BEGIN, hwi);
+}
+
+void rtosTraceHwiEnd(void *hwi)
+{
+    RtosTrace.event(RTOSTRACE_HWI_END, hwi);
+}
@@ -0,0 +1,169 @@
+/*
+  RtosTrace.h - binary event trace of tasks, interrupts and driver calls
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+#ifndef RtosTrace_h
+#define RtosTrace_h
+
+#include <stdint.h>
+#include <stddef.h>
+
+#include "Print.h"
+#include "SysTime.h"
+
+#include <ti/sysbios/knl/Task.h>
+
+#define RTOSTRACE_EVENTS    512         // default ring size, rounded down to a power of 2
+#define RTOSTRACE_SHIFT     4           // a timestamp tick is 2^4 cycles, 200 ns at 80 MHz
+#define RTOSTRACE_NAMES     32          // distinct labels a dump() names
+#define RTOSTRACE_NAME_MAX  31
+
+/* dump() format, see extras/rtostrace */
+#define RTOSTRACE_MAGIC     0x43525452  // "RTRC" in little endian
+#define RTOSTRACE_VERSION   1
+
+/*
+ * Event types. object is a handle for the kernel's events and a label
+ * (a string that lives for the whole program) for the others; a _BEGIN
+ * and the _END one above it make a span on the host's timeline.
+ */
+#define RTOSTRACE_TASK_SWITCH   1       // object: the task switched to
+#define RTOSTRACE_SWI_BEGIN     2       // object: the Swi
+#define RTOSTRACE_SWI_END       3
+#define RTOSTRACE_HWI_BEGIN     4       // object: the Hwi
+#define RTOSTRACE_HWI_END       5
+#define RTOSTRACE_MARK          8       // arg: any value
+#define RTOSTRACE_BEGIN         9       // spans of the sketch's own
+#define RTOSTRACE_END           10
+#define RTOSTRACE_LOCK_WAIT     11      // a BusLock; waiting for it, until LOCK_TAKEN
+#define RTOSTRACE_LOCK_TAKEN    12
+#define RTOSTRACE_LOCK_RELEASE  13
+#define RTOSTRACE_SPI_BEGIN     14      // arg: bytes
+#define RTOSTRACE_SPI_END       15
+#define RTOSTRACE_I2C_BEGIN     16      // arg: slave address
+#define RTOSTRACE_I2C_END       17      // arg: endTransmission() result
+#define RTOSTRACE_UART_BEGIN    18      // arg: bytes
+#define RTOSTRACE_UART_END      19
+#define RTOSTRACE_SOCKET_BEGIN  20      // object: the call, arg: socket
+#define RTOSTRACE_SOCKET_END    21      // arg: its result, clipped to 16 bits
+#define RTOSTRACE_NAMED(type)   ((type) >= RTOSTRACE_MARK)
+
+typedef struct {
+    uint32_t time;          // SysTime.cycles() >> RTOSTRACE_SHIFT
+    uint8_t type;
+    uint8_t context;        // 0 in a task, the exception number in a Swi or Hwi
+    uint16_t arg;
+    uint32_t task;          // the running, or interrupted, task
+    uint32_t object;
+} RtosTraceEvent;
+
+/*
+ * A ring of 16 byte events, cheap enough to leave in a production
+ * build: while stopped an event is one load and a branch, while
+ * recording it is the cycle counter and a few stores into the next
+ * slot, made with interrupts disabled, so it can be called from
+ * interrupts and end() can free the ring under a preempted writer.
+ *
+ * SPI, Wire, Serial, BusLock and WiFi sockets record their calls. The
+ * sketch adds marks and spans of its own:
+ *
+ *   RtosTrace.begin();
+ *   ...
+ *   RtosTrace.enter("filter");
+ *   ...
+ *   RtosTrace.leave("filter");
+ *   if (late) {
+ *       RtosTrace.stop();       // keep the events that led up to it
+ *       RtosTrace.dump(Serial);
+ *   }
+ *
+ * dump() writes the ring to a Print, a serial port or a WiFiClient;
+ * extras/rtostrace turns it into a Chrome trace (chrome://tracing or
+ * ui.perfetto.dev) and lists the longest spans.
+ *
+ * Task switches and interrupts are recorded by the hook functions
+ * below, which have the signatures of SYS/BIOS hook sets. The kernel
+ * shipped with the core is configured without them; a kernel built
+ * from a configuration with
+ *
+ *   Task.addHookSet({switchFxn: '&rtosTraceTaskSwitch'});
+ *   Swi.addHookSet({beginFxn: '&rtosTraceSwiBegin', endFxn: '&rtosTraceSwiEnd'});
+ *   Hwi.addHookSet({beginFxn: '&rtosTraceHwiBegin', endFxn: '&rtosTraceHwiEnd'});
+ *
+ * records them too. Without them, each event still carries the task
+ * that made it.
+ */
+class EventTrace
+{
+    public:
+        EventTrace();
+
+        bool begin(uint16_t events = RTOSTRACE_EVENTS);  // allocates the ring and starts recording
+        void end(void);     // stops recording and frees the ring, stop() just pauses
+
+        void start(void) { _on = (_ring != NULL); }
+        void stop(void) { _on = false; }
+        bool recording(void) { return _on; }
+
+        inline void event(uint8_t type, const void *object = NULL, uint16_t arg = 0)
+        {
+            if (_on) {
+                record(type, object, arg);
+            }
+        }
+
+        void mark(const char *label, uint16_t value = 0) { event(RTOSTRACE_MARK, label, value); }
+        void enter(const char *label) { event(RTOSTRACE_BEGIN, label); }
+        void leave(const char *label) { event(RTOSTRACE_END, label); }
+
+        uint32_t recorded(void) { return _head; }   // events since begin()
+        uint32_t capacity(void) { return _ring != NULL ? _mask + 1 : 0; }
+
+        /*
+         * Writes the events in the ring, oldest first, and the labels
+         * they refer to; recording pauses meanwhile. Returns the bytes
+         * written.
+         */
+        size_t dump(Print &out);
+
+    private:
+        void record(uint8_t type, const void *object, uint16_t arg);
+
+        RtosTraceEvent *_ring;
+        uint32_t _mask;
+        volatile uint32_t _head;    // slots filled, the next one is _head & _mask
+        volatile bool _on;
+};
+
+extern EventTrace RtosTrace;
+
+/* hook set functions, for a kernel configured with them */
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+extern void rtosTraceTaskSwitch(Task_Handle prev, Task_Handle next);
+extern void rtosTraceSwiBegin(void *swi);
+extern void rtosTraceSwiEnd(void *swi);
+extern void rtosTraceHwiBegin(void *hwi);
+extern void rtosTraceHwiEnd(void *hwi);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
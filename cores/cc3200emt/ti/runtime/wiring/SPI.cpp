@@ -34,15 +34,18 @@
 
 #include "wiring_private.h"
 #include "SPI.h"
+#include "RtosTrace.h"
 
 void spiTransferCallback(SPI_Handle handle,
                                         SPI_Transaction * transaction);
-SPIClass::SPIClass(void)
+SPIClass::SPIClass(void) :
+    busLock("SPI")
 {
     init(0);
 }
 
-SPIClass::SPIClass(unsigned long module)
+SPIClass::SPIClass(unsigned long module) :
+    busLock(module ? "SPI1" : "SPI")
 {
     init(module);
 }
@@ -82,7 +85,6 @@ void SPIClass::begin(uint8_t ssPin)
     if (spi != NULL) {
 	/* 6/18/2015 no support for pin profiles, just save for now */
         slaveSelect = ssPin;
-        GateMutex_construct(&gate, NULL);
         begun = TRUE;
     }
 }
@@ -121,9 +123,7 @@ void SPIClass::setDataMode(uint8_t mode)
     dataMode = mode;
 
     if (begun == TRUE) {
-        SPI_close(spi);
-        params.frameFormat = (SPI_FrameFormat) dataMode;
-        spi = SPI_open(spiModule, &params);
+        reopen();
     }
 }
 
@@ -132,12 +132,58 @@ void SPIClass::setClockDivider(uint8_t divider)
     clockDivider = divider;
 
     if (begun == TRUE) {
-        SPI_close(spi);
-        params.bitRate = SPI_CLOCK_MAX / clockDivider;
-        spi = SPI_open(spiModule, &params);
+        reopen();
     }
 }
 
+/* the driver takes the frame format and bit rate only when it is opened */
+void SPIClass::reopen(void)
+{
+    busLock.acquire();
+
+    SPI_close(spi);
+    params.frameFormat = (SPI_FrameFormat) dataMode;
+    params.bitRate = SPI_CLOCK_MAX / clockDivider;
+    spi = SPI_open(spiModule, &params);
+
+    busLock.release();
+}
+
+bool SPIClass::beginTransaction(SPISettings settings)
+{
+    uint32_t divider;
+
+    if (!busLock.acquire()) {
+        return (false);
+    }
+
+    /* the slowest clock not faster than asked for */
+    divider = (SPI_CLOCK_MAX + settings.clock - 1) / settings.clock;
+    if (divider < 1) {
+        divider = 1;
+    }
+    else if (divider > 255) {
+        divider = 255;
+    }
+
+    setBitOrder(settings.bitOrder);
+
+    /* only a change of mode or clock costs a close and open */
+    if (settings.dataMode != dataMode || divider != clockDivider) {
+        dataMode = settings.dataMode;
+        clockDivider = divider;
+        if (begun == TRUE) {
+            reopen();
+        }
+    }
+    return (true);
+}
+
+void SPIClass::endTransaction(void)
+{
+    busLock.release();
+}
+
 uint8_t SPIClass::reverseBits(uint8_t rxtxData)
 {
 #if (defined(xdc_target__isaCompatible_v7M) || defined(xdc_target__isaCompatible_v7A))  \
@@ -145,7 +191,7 @@ uint8_t SPIClass::reverseBits(uint8_t rxtxData)
 	rxtxData = __rbit(rxtxData);
         rxtxData = __rev(rxtxData);
 #elif (defined(xdc_target__isaCompatible_v7M) || defined(xdc_target__isaCompatible_v7A))  \
-     && defined(__GNUC__)
+     && defined(__GNUC__) && defined(__arm__)
         /* reverse order of 32 bits */
         asm("rbit %0, %1" : "=r" (rxtxData) : "r" (rxtxData));
         /* reverse order of bytes to get original bits into lowest byte */
@@ -160,8 +206,8 @@ uint8_t SPIClass::reverseBits(uint8_t rxtxData)
 
     uint8_t b = 0;
 
-    b  = reverse_data[x & 0xF] << 4;
-    b |= reverse_data[(x & 0xF0) >> 4];
+    b  = reverse_data[rxtxData & 0xF] << 4;
+    b |= reverse_data[(rxtxData & 0xF0) >> 4];
     rxtxData = b;
 #endif
     return (rxtxData);
@@ -169,15 +215,20 @@ uint8_t SPIClass::reverseBits(uint8_t rxtxData)
 
 uint8_t *SPIClass::transfer(uint8_t *buffer, size_t size)
 {
-    uint32_t taskKey, hwiKey;
+    uint32_t hwiKey;
     uint8_t i;
 
     if (spi == NULL) {
         return (0);
     }
     
-    /* protect single 'transaction' content from re-rentrancy */
-    taskKey = Task_disable();
+    /*
+     * protect single 'transaction' content from re-rentrancy; unlike
+     * Task_disable(), tasks that don't use this bus keep running
+     */
+    if (!busLock.acquire()) {
+        return (0);
+    }
 
     hwiKey = Hwi_disable();
 
@@ -199,6 +250,8 @@ uint8_t *SPIClass::transfer(uint8_t *buffer, size_t size)
     transaction.count = size;
     transferComplete = 0;
 
+    RtosTrace.event(RTOSTRACE_SPI_BEGIN, busLock.name(), size);
+
     /* kick off the SPI transaction */
     SPI_transfer(spi, &transaction);
 
@@ -207,6 +260,8 @@ uint8_t *SPIClass::transfer(uint8_t *buffer, size_t size)
         ;
     }
 
+    RtosTrace.event(RTOSTRACE_SPI_END, busLock.name());
+
     /* now that the transaction is finished, allow other threads to pre-empt */
 
     hwiKey = Hwi_disable();
@@ -224,7 +279,7 @@ uint8_t *SPIClass::transfer(uint8_t *buffer, size_t size)
         }
     }
 
-    Task_restore(taskKey);
+    busLock.release();
 
     return (buffer);
 }
@@ -233,7 +288,7 @@ uint8_t SPIClass::transfer(uint8_t ssPin, uint8_t data_out, uint8_t transferMode
 {
     uint8_t data_in;
     uint8_t i;
-    uint32_t taskKey, hwiKey;
+    uint32_t hwiKey;
 
     if (spi == NULL) {
         return (0);
@@ -244,7 +299,9 @@ uint8_t SPIClass::transfer(uint8_t ssPin, uint8_t data_out, uint8_t transferMode
     }
 
     /* protect single 'transaction' content from re-rentrancy */
-    taskKey = Task_disable();
+    if (!busLock.acquire()) {
+        return (0);
+    }
 
     hwiKey = Hwi_disable();
 
@@ -265,6 +322,8 @@ uint8_t SPIClass::transfer(uint8_t ssPin, uint8_t data_out, uint8_t transferMode
     transaction.count = 1;
     transferComplete = 0;
 
+    RtosTrace.event(RTOSTRACE_SPI_BEGIN, busLock.name(), 1);
+
     /* kick off the SPI transaction */
     SPI_transfer(spi, &transaction);
 
@@ -273,6 +332,8 @@ uint8_t SPIClass::transfer(uint8_t ssPin, uint8_t data_out, uint8_t transferMode
         ;
     }
 
+    RtosTrace.event(RTOSTRACE_SPI_END, busLock.name());
+
     /* deselect SPI peripheral if ssPin was provided */
     if (transferMode == SPI_LAST && ssPin != 0) {
         digitalWrite(ssPin, HIGH);
@@ -289,7 +350,7 @@ uint8_t SPIClass::transfer(uint8_t ssPin, uint8_t data_out, uint8_t transferMode
 
     Hwi_restore(hwiKey);
 
-    Task_restore(taskKey);
+    busLock.release();
 
     if (bitOrder == LSBFIRST) {
         data_in = reverseBits(data_in);
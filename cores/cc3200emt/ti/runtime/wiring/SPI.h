@@ -36,7 +36,7 @@
 #include <inttypes.h>
 
 #include <ti/drivers/SPI.h>
-#include <ti/sysbios/gates/GateMutex.h>
+#include "BusLock.h"
 
 #define SPI_MODE0 SPI_POL0_PHA0
 #define SPI_MODE1 SPI_POL0_PHA1
@@ -56,6 +56,20 @@
 
 #define MAX_USING_INTERRUPTS 16
 
+/* Arduino's transaction settings: clock in Hz, bit order and data mode */
+class SPISettings
+{
+    public:
+        SPISettings(void) :
+            clock(4000000), bitOrder(MSBFIRST), dataMode(SPI_MODE0) {}
+        SPISettings(uint32_t clock, uint8_t bitOrder, uint8_t dataMode) :
+            clock(clock), bitOrder(bitOrder), dataMode(dataMode) {}
+
+        uint32_t clock;
+        uint8_t bitOrder;
+        uint8_t dataMode;
+};
+
 class SPIClass
 {
     private:
@@ -72,8 +86,9 @@ class SPIClass
         SPI_Handle spi;
         SPI_Params params;
         SPI_Transaction transaction;
-        GateMutex_Struct gate;
+        BusLock busLock;
         void init(unsigned long);
+        void reopen(void);
         uint8_t reverseBits(uint8_t);
 
     public:
@@ -97,6 +112,15 @@ class SPIClass
         uint8_t transfer(uint8_t, uint8_t, uint8_t);
         uint8_t *transfer(uint8_t *, size_t);
 
+        /*
+         * Holds the bus, with these settings, until endTransaction(), so
+         * the transfers of one device are not interleaved with those of
+         * another task. Fails only if waiting would deadlock.
+         */
+        bool beginTransaction(SPISettings);
+        void endTransaction(void);
+        BusLock &lock(void) { return (busLock); }
+
         void setModule(uint8_t);
         void usingInterrupt(uint8_t);
 };
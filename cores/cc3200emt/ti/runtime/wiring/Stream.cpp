@@ -250,6 +250,23 @@ size_t Stream::readBytes(char *buffer, size_t length)
 }
 
 
+// default bulk read: may be overridden by streams that can copy whole blocks
+int Stream::read(uint8_t *buffer, size_t size)
+{
+    int n = available();
+    int index = 0;
+
+    if (n <= 0) return 0;
+    if ((size_t)n > size) n = size;
+
+    while (index < n) {
+        int c = read();
+        if (c < 0) break;
+        buffer[index++] = (uint8_t)c;
+    }
+    return index;
+}
+
 // as readBytes with terminator character
 // terminates if length characters have been read, timeout, or if the terminator character  detected
 // returns the number of characters placed in the buffer (0 means no valid data found)
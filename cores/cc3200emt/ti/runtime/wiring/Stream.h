@@ -52,6 +52,14 @@ class Stream : public Print
 
         Stream() {_timeout=1000;}
 
+        virtual int peekBuffer(const uint8_t **buffer) { return -1; } // points buffer at input already held in memory
+        // returns the number of bytes held, or -1 if the stream does not expose its buffer
+
+        virtual void consume(size_t size) {} // discards size bytes previously returned by peekBuffer
+
+        virtual int read(uint8_t *buffer, size_t size); // reads up to size bytes that are available without waiting
+        // returns the number of bytes placed in the buffer
+
         // parsing methods
 
         void setTimeout(unsigned long timeout);  // sets maximum milliseconds to wait for stream data, default is 1 second
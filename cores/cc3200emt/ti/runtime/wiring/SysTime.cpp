@@ -0,0 +1,244 @@
+/*
+  SysTime.cpp - 64 bit monotonic and UTC timestamps from the cycle counter
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+#include "Energia.h"
+#include "SysTime.h"
+
+#include <string.h>
+
+#include <xdc/runtime/Types.h>
+#include <ti/sysbios/hal/Hwi.h>
+#include <ti/sysbios/hal/Seconds.h>
+
+/* Cortex-M4 debug registers enabling the cycle counter */
+#define DEMCR               (*(volatile uint32_t *)0xE000EDFC)
+#define DEMCR_TRCENA        0x01000000
+#define DWT_CTRL            (*(volatile uint32_t *)0xE0001000)
+#define DWT_CTRL_CYCCNTENA  0x00000001
+
+/* a quarter of the frequency error each adjust() reveals is corrected */
+#define FREQ_GAIN           4
+/* shorter adjust() intervals say more about network jitter than frequency */
+#define FREQ_MIN_INTERVAL   16000000ULL
+
+TimestampClock SysTime;
+
+TimestampClock::TimestampClock()
+{
+    _started = false;
+    _gen = 0;
+    _cycLo = 0;
+    _cycBase = 0;
+    _monoBase = 0;
+    _monoFrac = 0;
+    _monoMult = 0;
+    _utcBase = 0;
+    _utcFrac = 0;
+    _utcMult = 0;
+    _freqDelta = 0;
+    _slewDelta = 0;
+    _slewLeft = 0;
+    _lastAdjust = 0;
+    _set = false;
+    memset(&_stats, 0, sizeof(_stats));
+}
+
+bool TimestampClock::begin(void)
+{
+    Types_FreqHz freq;
+    Seconds_Time rtc;
+    Clock_Params params;
+    UInt key;
+
+    key = Task_disable();
+    if (_started) {
+        Task_restore(key);
+        return true;
+    }
+
+    BIOS_getCpuFreq(&freq);
+    _stats.cpuHz = freq.lo;
+    _monoMult = (uint32_t)((1000000ULL << 32) / freq.lo);
+    _utcMult = _monoMult;
+
+    /* time of day from the RTC, if it was ever set */
+    Seconds_getTime(&rtc);
+    if (rtc.secs >= SYSTIME_VALID_UTC) {
+        _utcBase = (uint64_t)rtc.secs * 1000000 + rtc.nsecs / 1000;
+        _set = true;
+    }
+
+    DEMCR |= DEMCR_TRCENA;
+    DWT_CTRL |= DWT_CTRL_CYCCNTENA;
+    _cycLo = SYSTIME_CYCCNT;
+
+    /* one tick is a millisecond, as for millis() */
+    Clock_Params_init(&params);
+    params.period = SYSTIME_REBASE_MS;
+    params.startFlag = TRUE;
+    params.arg = (UArg)this;
+    Clock_construct(&_clock, rebaseFxn, SYSTIME_REBASE_MS, &params);
+
+    _started = true;
+    Task_restore(key);
+    return true;
+}
+
+/*
+ * Moves the bases of the conversions up to now, so that the cycles since
+ * the last rebase never overflow 32 bits. Called with interrupts disabled.
+ */
+void TimestampClock::rebase(void)
+{
+    uint32_t lo = SYSTIME_CYCCNT;
+    uint32_t elapsed = lo - _cycLo;
+    uint64_t t;
+
+    _cycBase += elapsed;
+    t = (uint64_t)elapsed * _monoMult + _monoFrac;
+    _monoBase += t >> 32;
+    _monoFrac = (uint32_t)t;
+    t = (uint64_t)elapsed * _utcMult + _utcFrac;
+    _utcBase += t >> 32;
+    _utcFrac = (uint32_t)t;
+    _slewLeft -= (int64_t)elapsed * _slewDelta;
+    _cycLo = lo;
+    _gen++;
+}
+
+/*
+ * Picks the slew rate that takes what is left of the offset away by the
+ * next rebase, within SYSTIME_MAX_PPM. A rebase that comes late overshoots
+ * by a few nanoseconds, which the next period slews back.
+ */
+void TimestampClock::setRate(void)
+{
+    int64_t period = (int64_t)_stats.cpuHz * SYSTIME_REBASE_MS / 1000;
+    int64_t max = (int64_t)_monoMult * SYSTIME_MAX_PPM / 1000000;
+
+    _slewDelta = _slewLeft / period;
+    if (_slewDelta > max) {
+        _slewDelta = max;
+    }
+    else if (_slewDelta < -max) {
+        _slewDelta = -max;
+    }
+    _utcMult = (uint32_t)(_monoMult + _freqDelta + _slewDelta);
+}
+
+void TimestampClock::rebaseFxn(UArg arg)
+{
+    TimestampClock *clock = (TimestampClock *)arg;
+    UInt key = Hwi_disable();
+
+    clock->rebase();
+    clock->setRate();
+    Hwi_restore(key);
+}
+
+uint32_t TimestampClock::utc(void)
+{
+    return (uint32_t)(utcMicros() / 1000000);
+}
+
+void TimestampClock::setUTC(uint64_t utcMicros)
+{
+    UInt key;
+
+    if (!_started) {
+        begin();
+    }
+
+    key = Hwi_disable();
+    rebase();
+    _utcBase = utcMicros;
+    _utcFrac = 0;
+    _slewLeft = 0;
+    setRate();
+    Hwi_restore(key);
+
+    _set = true;
+    _lastAdjust = 0;
+    _stats.steps++;
+    Seconds_set((UInt32)(utcMicros / 1000000));
+}
+
+int TimestampClock::adjust(int64_t offset)
+{
+    uint64_t now;
+    int64_t left;
+    UInt key;
+
+    if (!_started) {
+        begin();
+    }
+    _stats.adjusts++;
+    _stats.lastOffset = offset;
+
+    if (!_set || offset > SYSTIME_STEP_US || offset < -SYSTIME_STEP_US) {
+        setUTC(utcMicros() + offset);
+        return SYSTIME_STEPPED;
+    }
+
+    /*
+     * Whatever the last adjust() left to slew is still expected, the rest
+     * of the offset is the clock running fast or slow since then
+     */
+    now = micros();
+    key = Hwi_disable();
+    rebase();
+    left = _slewLeft / ((int64_t)1 << 32);
+    Hwi_restore(key);
+    if (_lastAdjust != 0 && now - _lastAdjust >= FREQ_MIN_INTERVAL) {
+        int64_t ppb = (offset - left) * 1000000000LL / (int64_t)(now - _lastAdjust);
+
+        ppb = _stats.freqPpb + ppb / FREQ_GAIN;
+        if (ppb > SYSTIME_MAX_PPM * 1000L) {
+            ppb = SYSTIME_MAX_PPM * 1000L;
+        }
+        else if (ppb < -SYSTIME_MAX_PPM * 1000L) {
+            ppb = -SYSTIME_MAX_PPM * 1000L;
+        }
+        _stats.freqPpb = (int32_t)ppb;
+    }
+    _lastAdjust = now;
+
+    key = Hwi_disable();
+    rebase();
+    _freqDelta = (int64_t)_monoMult * _stats.freqPpb / 1000000000LL;
+    _slewLeft = offset * ((int64_t)1 << 32);
+    setRate();
+    Hwi_restore(key);
+
+    /* keep the RTC within a second or so, for the next reset */
+    now = utc();
+    if (Seconds_get() + 1 < now || Seconds_get() > now + 1) {
+        Seconds_set((UInt32)now);
+    }
+    return SYSTIME_SLEWING;
+}
+
+void TimestampClock::stats(SysTimeStats &stats)
+{
+    UInt key = Hwi_disable();
+
+    stats = _stats;
+    stats.slewPpb = (int32_t)(_slewDelta * 1000000000LL / _monoMult);
+    stats.slewLeft = _slewLeft / ((int64_t)1 << 32);
+    Hwi_restore(key);
+}
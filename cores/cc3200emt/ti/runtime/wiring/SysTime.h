@@ -0,0 +1,173 @@
+/*
+  SysTime.h - 64 bit monotonic and UTC timestamps from the cycle counter
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+#ifndef SysTime_h
+#define SysTime_h
+
+#include <stdint.h>
+
+#include <ti/sysbios/knl/Clock.h>
+
+#define SYSTIME_REBASE_MS   10000       // well inside the 53 s the 32 bit cycle counter wraps in at 80 MHz
+#define SYSTIME_MAX_PPM     500         // largest frequency correction, and largest slew rate
+#define SYSTIME_STEP_US     128000      // adjust() steps offsets beyond this, slews smaller ones
+#define SYSTIME_VALID_UTC   1451606400UL // 2016-01-01: an RTC before this was never set
+
+/* adjust() results */
+#define SYSTIME_SLEWING     0
+#define SYSTIME_STEPPED     1
+
+/* Cortex-M4 DWT cycle counter */
+#define SYSTIME_CYCCNT      (*(volatile uint32_t *)0xE0001004)
+
+/*
+ * Keeps the compiler from moving the reads of the (non-volatile) bases
+ * across the reads of _gen that check them
+ */
+#define SYSTIME_BARRIER()   __asm__ volatile("" ::: "memory")
+
+typedef struct {
+    uint32_t cpuHz;
+    int32_t freqPpb;        // frequency correction learnt by adjust(), parts per billion
+    int32_t slewPpb;        // rate at which the remaining offset is slewed away
+    int64_t slewLeft;       // offset still to slew, us
+    int64_t lastOffset;     // as given to the last adjust(), us
+    uint32_t adjusts;       // adjust() calls
+    uint32_t steps;         // ...of which stepped the clock
+} SysTimeStats;
+
+/*
+ * Timestamps cheap enough to stamp every sample of a fast sensor: a read
+ * is the cycle counter, a few loads and one 32 x 32 bit multiply, with no
+ * lock and no division.
+ *
+ * The 32 bit cycle counter is extended to 64 bits by a Clock function that
+ * rebases the conversions every SYSTIME_REBASE_MS. A read that a rebase
+ * interrupted sees the generation change and simply reads again.
+ *
+ *  - cycles() counts CPU cycles since begin()
+ *  - micros() is monotonic, at the nominal CPU frequency: never stepped,
+ *    never slewed, like CLOCK_MONOTONIC_RAW
+ *  - utcMicros() is microseconds since 1970. It starts from the RTC (the
+ *    ti.sysbios.hal.Seconds module), is set by setUTC(), and is steered
+ *    by adjust() with the offsets an SNTP client measures: small offsets
+ *    are slewed away at up to SYSTIME_MAX_PPM, so the time never jumps or
+ *    runs backwards, and the frequency error they reveal is corrected.
+ *
+ * The service starts on first use; make that from a task or setup(), not
+ * from an interrupt, or call begin() early.
+ */
+class TimestampClock
+{
+    public:
+        TimestampClock();
+
+        bool begin(void);
+
+        inline uint64_t cycles(void)
+        {
+            uint32_t gen, lo;
+            uint64_t t;
+
+            if (!_started) {
+                begin();
+            }
+            do {
+                gen = _gen;
+                SYSTIME_BARRIER();
+                lo = SYSTIME_CYCCNT - _cycLo;
+                t = _cycBase + lo;
+                SYSTIME_BARRIER();
+            } while (gen != _gen);
+            return t;
+        }
+
+        inline uint64_t micros(void)
+        {
+            uint32_t gen, lo;
+            uint64_t t;
+
+            if (!_started) {
+                begin();
+            }
+            do {
+                gen = _gen;
+                SYSTIME_BARRIER();
+                lo = SYSTIME_CYCCNT - _cycLo;
+                t = _monoBase + (((uint64_t)lo * _monoMult + _monoFrac) >> 32);
+                SYSTIME_BARRIER();
+            } while (gen != _gen);
+            return t;
+        }
+
+        inline uint64_t utcMicros(void)
+        {
+            uint32_t gen, lo;
+            uint64_t t;
+
+            if (!_started) {
+                begin();
+            }
+            do {
+                gen = _gen;
+                SYSTIME_BARRIER();
+                lo = SYSTIME_CYCCNT - _cycLo;
+                t = _utcBase + (((uint64_t)lo * _utcMult + _utcFrac) >> 32);
+                SYSTIME_BARRIER();
+            } while (gen != _gen);
+            return t;
+        }
+
+        uint32_t utc(void);             // seconds since 1970
+        bool isSet(void) { return _set; } // false until the RTC, setUTC() or adjust() gave the time
+
+        void setUTC(uint64_t utcMicros); // steps the clock, and sets the RTC
+        int adjust(int64_t offset);     // offset (us) of the true time from utcMicros()
+
+        void stats(SysTimeStats &stats);
+
+    private:
+        static void rebaseFxn(UArg arg);
+        void rebase(void);
+        void setRate(void);
+
+        volatile bool _started;
+        volatile uint32_t _gen;         // changes with every rebase
+
+        /* the state a read converts from, as of the last rebase */
+        uint32_t _cycLo;                // cycle counter
+        uint64_t _cycBase;              // ...extended
+        uint64_t _monoBase;             // micros()
+        uint32_t _monoFrac;             // ...and its fraction, 1/2^32 us
+        uint32_t _monoMult;             // nominal 1/2^32 us per cycle
+        uint64_t _utcBase;              // utcMicros()
+        uint32_t _utcFrac;
+        uint32_t _utcMult;              // _monoMult with the frequency and slew corrections
+
+        int64_t _freqDelta;             // frequency correction of _utcMult
+        int64_t _slewDelta;             // slew of _utcMult
+        int64_t _slewLeft;              // offset still to slew, 1/2^32 us
+        uint64_t _lastAdjust;           // micros() at the last adjust(), 0 after a step
+        bool _set;
+        SysTimeStats _stats;
+        Clock_Struct _clock;
+};
+
+extern TimestampClock SysTime;
+
+#endif
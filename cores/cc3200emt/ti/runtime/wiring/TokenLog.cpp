@@ -0,0 +1,284 @@
+/*
+  TokenLog.cpp - deferred logging, formatted on the host instead of the device
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+#include "Energia.h"
+#include "TokenLog.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#include <xdc/runtime/Error.h>
+
+/*
+ * packet:  magic (u16), version (u8), records (u8), tick Hz (u32),
+ *          sequence number of the first record (u32), records dropped
+ *          since begin() (u32)
+ * record:  format address (u32), time (u32), argument count (u8),
+ *          the arguments (u32 each)
+ * all little endian
+ */
+#define PACKET_HEADER_SIZE  16
+#define RECORD_MAX_SIZE     (9 + 4 * TOKENLOG_ARGS)
+
+DeferredLog TokenLog;
+
+DeferredLog::DeferredLog()
+{
+    _ring = NULL;
+    _mask = 0;
+    _tickHz = 0;
+    _head = 0;
+    _tail = 0;
+    _dropped = 0;
+    memset(&_stats, 0, sizeof(_stats));
+    _sink = NULL;
+    _arg = NULL;
+    _task = NULL;
+    _stopping = false;
+}
+
+void DeferredLog::frameSink(const uint8_t *packet, size_t size, void *arg)
+{
+    ((HardwareSerial *)arg)->writeFrame(packet, size);
+}
+
+bool DeferredLog::begin(HardwareSerial &port, uint16_t records, int priority)
+{
+    if (!begin(frameSink, &port, records, priority)) {
+        return (false);
+    }
+    /* ends whatever the line carried before, so the first COBS frame isn't lost to it */
+    port.write((uint8_t)0);
+    return (true);
+}
+
+bool DeferredLog::begin(TokenLogSink sink, void *arg, uint16_t records, int priority)
+{
+    TokenLogRecord *ring;
+    SysTimeStats clock;
+    Semaphore_Params semParams;
+    Task_Params taskParams;
+    Error_Block eb;
+    uint32_t size = 1;
+
+    if (_ring != NULL || sink == NULL) {
+        return (false);
+    }
+
+    while (size * 2 <= records) {
+        size *= 2;
+    }
+
+    /* the clock starts here rather than in a log call from an interrupt */
+    SysTime.begin();
+    SysTime.stats(clock);
+
+    ring = (TokenLogRecord *)malloc(size * sizeof(TokenLogRecord));
+    if (ring == NULL) {
+        return (false);
+    }
+    memset(ring, 0, size * sizeof(TokenLogRecord));
+
+    _sink = sink;
+    _arg = arg;
+    _tickHz = clock.cpuHz >> TOKENLOG_SHIFT;
+    _mask = size - 1;
+    _head = 0;
+    _tail = 0;
+    _dropped = 0;
+    memset(&_stats, 0, sizeof(_stats));
+
+    if (priority != TOKENLOG_NO_TASK) {
+        Semaphore_Params_init(&semParams);
+        semParams.mode = Semaphore_Mode_BINARY;
+        Semaphore_construct(&_finished, 0, &semParams);
+
+        _stopping = false;
+        Error_init(&eb);
+        Task_Params_init(&taskParams);
+        taskParams.arg0 = (UArg)this;
+        taskParams.priority = priority;
+        taskParams.stackSize = TOKENLOG_STACK_SIZE;
+        _task = Task_create(taskFxn, &taskParams, &eb);
+        if (_task == NULL) {
+            Semaphore_destruct(&_finished);
+            free(ring);
+            return (false);
+        }
+    }
+
+    /* logging starts with this store */
+    _ring = ring;
+    return (true);
+}
+
+/* call it once nothing logs any more: a log call may still be writing */
+void DeferredLog::end(void)
+{
+    TokenLogRecord *ring = _ring;
+
+    if (ring == NULL) {
+        return;
+    }
+
+    if (_task != NULL) {
+        _stopping = true;
+        Semaphore_pend(Semaphore_handle(&_finished), BIOS_WAIT_FOREVER);
+        Task_delete(&_task);
+        Semaphore_destruct(&_finished);
+    }
+    else {
+        poll();
+    }
+
+    _ring = NULL;
+    free(ring);
+}
+
+void DeferredLog::write(const char *format, const uint32_t *args, uint8_t count)
+{
+    TokenLogRecord *ring = _ring, *r;
+    uint32_t head;
+    uint8_t i;
+
+    if (count > TOKENLOG_ARGS) {
+        count = TOKENLOG_ARGS;
+    }
+
+    do {
+        head = _head;
+        if (head - _tail > _mask) {
+            __sync_fetch_and_add(&_dropped, 1);
+            return;
+        }
+    } while (!__sync_bool_compare_and_swap(&_head, head, head + 1));
+
+    r = &ring[head & _mask];
+    r->format = format;
+    r->time = (uint32_t)(SysTime.cycles() >> TOKENLOG_SHIFT);
+    r->count = count;
+    for (i = 0; i < count; i++) {
+        r->args[i] = args[i];
+    }
+
+    /* the drain takes the record once its stamp is in */
+    __sync_synchronize();
+    r->stamp = head + 1;
+}
+
+static uint8_t *putU32(uint8_t *p, uint32_t value)
+{
+    p[0] = value;
+    p[1] = value >> 8;
+    p[2] = value >> 16;
+    p[3] = value >> 24;
+    return (p + 4);
+}
+
+/*
+ * The only reader of the ring: the drain task, or the sketch when there
+ * is none. A record claimed but not written yet ends the packet; a
+ * writer interrupted in between holds back the ones after it until the
+ * next poll().
+ */
+size_t DeferredLog::poll(void)
+{
+    uint8_t packet[TOKENLOG_PACKET];
+    TokenLogRecord *ring = _ring, *r;
+    uint32_t first, tail, waiting;
+    uint8_t *p;
+    size_t sent = 0;
+    int count;
+    uint8_t i;
+
+    if (ring == NULL) {
+        return (0);
+    }
+
+    waiting = _head - _tail;
+    if (waiting > _stats.highWater) {
+        _stats.highWater = waiting;
+    }
+
+    for (;;) {
+        first = tail = _tail;
+        p = packet + PACKET_HEADER_SIZE;
+        count = 0;
+
+        while (tail != _head && count < 255
+               && p + RECORD_MAX_SIZE <= packet + TOKENLOG_PACKET) {
+            r = &ring[tail & _mask];
+            if (r->stamp != tail + 1) {
+                break;
+            }
+            __sync_synchronize();
+            p = putU32(p, (uint32_t)(uintptr_t)r->format);
+            p = putU32(p, r->time);
+            *p++ = r->count;
+            for (i = 0; i < r->count; i++) {
+                p = putU32(p, r->args[i]);
+            }
+            tail++;
+            count++;
+        }
+        if (count == 0) {
+            break;
+        }
+
+        /* the slots are free again before the packet goes out */
+        __sync_synchronize();
+        _tail = tail;
+
+        packet[0] = TOKENLOG_MAGIC & 0xff;
+        packet[1] = TOKENLOG_MAGIC >> 8;
+        packet[2] = TOKENLOG_VERSION;
+        packet[3] = count;
+        putU32(packet + 4, _tickHz);
+        putU32(packet + 8, first);
+        putU32(packet + 12, _dropped);
+
+        _sink(packet, p - packet, _arg);
+        _stats.packets++;
+        sent += count;
+    }
+    return (sent);
+}
+
+void DeferredLog::taskFxn(UArg arg0, UArg arg1)
+{
+    DeferredLog *log = (DeferredLog *)arg0;
+
+    while (!log->_stopping) {
+        if (log->poll() == 0) {
+            Task_sleep(TOKENLOG_PERIOD_MS);
+        }
+    }
+    log->poll();
+    Semaphore_post(Semaphore_handle(&log->_finished));
+}
+
+void DeferredLog::stats(TokenLogStats &stats, bool reset)
+{
+    stats = _stats;
+    stats.logged = _head;
+    stats.dropped = _dropped;
+    if (reset) {
+        _stats.packets = 0;
+        _stats.highWater = 0;
+    }
+}
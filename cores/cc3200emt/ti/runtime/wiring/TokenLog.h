@@ -0,0 +1,193 @@
+/*
+  TokenLog.h - deferred logging, formatted on the host instead of the device
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+#ifndef TokenLog_h
+#define TokenLog_h
+
+#include <stdint.h>
+#include <stddef.h>
+
+#include "SysTime.h"
+#include "HardwareSerial.h"
+
+#include <ti/sysbios/BIOS.h>
+#include <ti/sysbios/knl/Task.h>
+#include <ti/sysbios/knl/Semaphore.h>
+
+#define TOKENLOG_RECORDS    128         // default ring size, rounded down to a power of 2
+#define TOKENLOG_ARGS       4           // arguments a record holds
+#define TOKENLOG_SHIFT      4           // a timestamp tick is 2^4 cycles, 200 ns at 80 MHz
+#define TOKENLOG_PACKET     256         // bytes the drain sends at once
+#define TOKENLOG_PERIOD_MS  20          // drain task's sleep while the ring is empty
+#define TOKENLOG_STACK_SIZE 0x400
+#define TOKENLOG_NO_TASK    0           // begin() priority: the sketch calls poll() itself
+
+/* packet format, see extras/tokenlog */
+#define TOKENLOG_MAGIC      0x4c54      // "TL" in little endian
+#define TOKENLOG_VERSION    1
+
+/*
+ * Logs a message without formatting it:
+ *
+ *   TOKENLOG("socket %d died: sl_Recv() failed (%d)", sd, ret);
+ *
+ * The format must be a string literal; its address in flash is the
+ * message's token. Up to TOKENLOG_ARGS arguments, each an integer,
+ * float, double (kept as a float), char or pointer of 32 bits at most.
+ * A %s argument is kept as its address: the host prints constant
+ * strings, which are in the firmware image, and only the address of
+ * strings in RAM.
+ */
+#define TOKENLOG(format, ...) TokenLog.log("" format, ##__VA_ARGS__)
+
+typedef void (*TokenLogSink)(const uint8_t *packet, size_t size, void *arg);
+
+typedef struct {
+    uint32_t logged;        // records taken
+    uint32_t dropped;       // records lost to a full ring
+    uint32_t packets;       // packets the drain sent
+    uint32_t highWater;     // most records the drain found waiting
+} TokenLogStats;
+
+typedef struct {
+    volatile uint32_t stamp;    // its sequence number + 1, once written
+    const char *format;
+    uint32_t time;              // SysTime.cycles() >> TOKENLOG_SHIFT
+    uint8_t count;
+    uint8_t unused[3];
+    uint32_t args[TOKENLOG_ARGS];
+} TokenLogRecord;
+
+/* the 32 bits an argument is recorded as */
+static inline uint32_t tokenLogArg(int value) { return ((uint32_t)value); }
+static inline uint32_t tokenLogArg(unsigned int value) { return (value); }
+static inline uint32_t tokenLogArg(long value) { return ((uint32_t)value); }
+static inline uint32_t tokenLogArg(unsigned long value) { return ((uint32_t)value); }
+static inline uint32_t tokenLogArg(const void *value) { return ((uint32_t)(uintptr_t)value); }
+static inline uint32_t tokenLogArg(float value)
+{
+    union { float f; uint32_t u; } bits;
+
+    bits.f = value;
+    return (bits.u);
+}
+static inline uint32_t tokenLogArg(double value) { return (tokenLogArg((float)value)); }
+
+/*
+ * Each log call claims a slot of a RAM ring with a compare and swap and
+ * stores the format's address, a timestamp and the raw arguments: a few
+ * tens of cycles, no lock, callable from interrupts. Nothing is formatted
+ * and nothing waits for the UART; a record that finds the ring full is
+ * counted and dropped.
+ *
+ * A drain task at a low priority packs the records into packets and
+ * hands them to a sink, or sends them on a serial port as
+ * writeFrame() frames:
+ *
+ *   TokenLog.begin(Serial1);
+ *   ...
+ *   TOKENLOG("adc %u over limit at %u ms", value, millis());
+ *
+ * extras/tokenlog reads the frames, or UDP packets from a sink that sends
+ * them, and prints the messages using the sketch's .elf file, built along
+ * with the firmware, as its table of formats. The port carries frames only
+ * once it is given to begin(); text printed on it spoils the next frame.
+ *
+ * Until begin(), a log call is one load and a branch.
+ */
+class DeferredLog
+{
+    public:
+        DeferredLog();
+
+        /* allocates the ring and starts the drain task */
+        bool begin(HardwareSerial &port, uint16_t records = TOKENLOG_RECORDS,
+                   int priority = 1);
+        bool begin(TokenLogSink sink, void *arg, uint16_t records = TOKENLOG_RECORDS,
+                   int priority = 1);
+        void end(void);     // drains the ring, stops the task and frees the ring
+
+        size_t poll(void);  // sends what is waiting now, returns the records sent
+
+        void stats(TokenLogStats &stats, bool reset = false); // reset clears packets and highWater
+
+        inline void log(const char *format)
+        {
+            if (_ring != NULL) {
+                write(format, NULL, 0);
+            }
+        }
+
+        template <typename A>
+        inline void log(const char *format, A a)
+        {
+            if (_ring != NULL) {
+                uint32_t args[1] = { tokenLogArg(a) };
+                write(format, args, 1);
+            }
+        }
+
+        template <typename A, typename B>
+        inline void log(const char *format, A a, B b)
+        {
+            if (_ring != NULL) {
+                uint32_t args[2] = { tokenLogArg(a), tokenLogArg(b) };
+                write(format, args, 2);
+            }
+        }
+
+        template <typename A, typename B, typename C>
+        inline void log(const char *format, A a, B b, C c)
+        {
+            if (_ring != NULL) {
+                uint32_t args[3] = { tokenLogArg(a), tokenLogArg(b), tokenLogArg(c) };
+                write(format, args, 3);
+            }
+        }
+
+        template <typename A, typename B, typename C, typename D>
+        inline void log(const char *format, A a, B b, C c, D d)
+        {
+            if (_ring != NULL) {
+                uint32_t args[4] = { tokenLogArg(a), tokenLogArg(b), tokenLogArg(c), tokenLogArg(d) };
+                write(format, args, 4);
+            }
+        }
+
+    private:
+        static void taskFxn(UArg arg0, UArg arg1);
+        static void frameSink(const uint8_t *packet, size_t size, void *arg);
+        void write(const char *format, const uint32_t *args, uint8_t count);
+
+        TokenLogRecord *volatile _ring;
+        uint32_t _mask;
+        uint32_t _tickHz;
+        volatile uint32_t _head;    // slots claimed
+        volatile uint32_t _tail;    // slots sent, only the drain moves it
+        volatile uint32_t _dropped;
+        TokenLogStats _stats;       // what the drain counts
+        TokenLogSink _sink;
+        void *_arg;
+        Task_Handle _task;
+        Semaphore_Struct _finished;
+        volatile bool _stopping;
+};
+
+extern DeferredLog TokenLog;
+
+#endif
@@ -34,11 +34,23 @@
 #include <string.h>
 #include "wiring_private.h"
 #include "Wire.h"
+#include "RtosTrace.h"
 
 #include <xdc/runtime/Memory.h>
 
 #include <ti/sysbios/knl/Task.h>
 
+#include <ti/drivers/Power.h>
+#include <ti/drivers/power/PowerCC3200.h>
+#include <ti/drivers/i2c/I2CCC3200.h>
+
+#include <inc/hw_types.h>
+#include <driverlib/rom.h>
+#include <driverlib/rom_map.h>
+#include <driverlib/i2c.h>
+
+extern "C" const I2C_Config I2C_config[];
+
 
 #define TX_BUFFER_EMPTY    (wc->txReadIndex == wc->txWriteIndex)
 #define TX_BUFFER_FULL     (((wc->txWriteIndex + 1) % BUFFER_LENGTH) == wc->txReadIndex)
@@ -51,12 +63,19 @@
 #define STOP_BIT    0x4
 #define ACK_BIT     0x8
 
-TwoWire::TwoWire()
+#define SLAVE_INTS  (I2C_SLAVE_INT_DATA | I2C_SLAVE_INT_START | I2C_SLAVE_INT_STOP)
+
+/* what the master reads in place of bytes we do not have */
+#define SLAVE_FILL  0xff
+
+TwoWire::TwoWire() :
+    busLock("Wire")
 {
     init(0);
 }
 
-TwoWire::TwoWire(unsigned long module)
+TwoWire::TwoWire(unsigned long module) :
+    busLock(module ? "Wire1" : "Wire")
 {
     init(module);
 }
@@ -68,6 +87,16 @@ void TwoWire::init(unsigned long module)
 {
     i2cModule = module;
     begun = FALSE;
+
+    user_onRequest = NULL;
+    user_onReceive = NULL;
+
+    slaveAddress = 0;
+    slaveState = IDLE;
+    regMap = NULL;
+    regMapSize = 0;
+    regMapWritable = 0;
+    regPointer = 0;
 }
 
 WireContext *TwoWire::getWireContext(void)
@@ -80,6 +109,7 @@ WireContext *TwoWire::getWireContext(void)
         wc = (WireContext *)Memory_alloc(NULL, sizeof(WireContext), 4, NULL);
 
         wc->idle = true;
+        wc->locked = false;
 
         wc->rxReadIndex = 0;
         wc->rxWriteIndex = 0;
@@ -123,20 +153,50 @@ void TwoWire::begin(void)
     i2c = Board_openI2C(i2cModule, &params);
 
     if (i2c != NULL) {
-        GateMutex_construct(&gate, NULL);
-        gateEnterCount = 0;
         begun = TRUE;
     }
 }
 
-//Save slave address for use in I2C_Transaction
+// Initialize as a slave
+//
+// The I2C driver only does master transfers, so the peripheral is
+// driven directly: slaveIsr() moves every byte, and serves reads of the
+// register map without calling back into the sketch
 void TwoWire::begin(uint8_t address)
 {
-    WireContext *wc = getWireContext();
+    I2CCC3200_HWAttrs const *hwAttrs;
+    Hwi_Params hwiParams;
+
+    /* return if I2C already started */
+    if (begun == TRUE) return;
 
-    wc->i2cTransaction.slaveAddress = address;
+    if (!Board_initI2CPins(i2cModule)) {
+        return;
+    }
 
-    begin();
+    hwAttrs = (I2CCC3200_HWAttrs const *)I2C_config[i2cModule].hwAttrs;
+    slaveBase = hwAttrs->baseAddr;
+    slaveAddress = address;
+    slaveState = IDLE;
+    slaveRxReadIndex = slaveRxWriteIndex = 0;
+    slaveTxReadIndex = slaveTxWriteIndex = 0;
+    slaveTxSent = false;
+
+    /* a master may address us at any time, so stay clocked and awake */
+    Power_setDependency(PowerCC3200_PERIPH_I2CA0);
+    Power_setConstraint(PowerCC3200_DISALLOW_LPDS);
+
+    MAP_I2CSlaveInit(slaveBase, address);
+    MAP_I2CSlaveIntClearEx(slaveBase, SLAVE_INTS);
+
+    Hwi_Params_init(&hwiParams);
+    hwiParams.arg = (UArg)this;
+    hwiParams.priority = hwAttrs->intPriority;
+    Hwi_construct(&slaveHwi, hwAttrs->intNum, slaveIsr, &hwiParams, NULL);
+
+    MAP_I2CSlaveIntEnableEx(slaveBase, SLAVE_INTS);
+
+    begun = TRUE;
 }
 
 void TwoWire::begin(int address)
@@ -146,6 +206,19 @@ void TwoWire::begin(int address)
 
 void TwoWire::end()
 {
+    if (slaveAddress != 0) {
+        if (begun) {
+            MAP_I2CSlaveIntDisableEx(slaveBase, SLAVE_INTS);
+            MAP_I2CSlaveDisable(slaveBase);
+            Hwi_destruct(&slaveHwi);
+            Power_releaseConstraint(PowerCC3200_DISALLOW_LPDS);
+            Power_releaseDependency(PowerCC3200_PERIPH_I2CA0);
+        }
+        slaveAddress = 0;
+        begun = false;
+        return;
+    }
+
     begun = false;
     I2C_close(i2c);
 }
@@ -154,8 +227,13 @@ void TwoWire::beginTransmission(uint8_t address)
 {
     WireContext *wc = getWireContext();
 
-    GateMutex_enter(GateMutex_handle(&gate));
-    gateEnterCount++;
+    /*
+     * the bus is held until a stop, so a repeated start can't be
+     * interleaved with another task's transfer
+     */
+    if (!wc->locked) {
+        wc->locked = busLock.acquire();
+    }
 
     if (wc->idle) {
         wc->i2cTransaction.slaveAddress = address;
@@ -176,8 +254,22 @@ uint8_t TwoWire::endTransmission(uint8_t sendStop)
     if (i2c == NULL) {
         return (4); /* 4 = 'other error' */
     }
+
+    /* without beginTransmission(), or it would have deadlocked */
+    if (!wc->locked) {
+        wc->locked = busLock.acquire();
+        if (!wc->locked) {
+            wc->txWriteIndex = 0;
+            wc->i2cTransaction.writeCount = 0;
+            wc->i2cTransaction.readCount = 0;
+            wc->idle = true;
+            return (4);
+        }
+    }
     
+    RtosTrace.event(RTOSTRACE_I2C_BEGIN, busLock.name(), wc->i2cTransaction.slaveAddress);
     ret = I2C_transfer(i2c, &(wc->i2cTransaction));
+    RtosTrace.event(RTOSTRACE_I2C_END, busLock.name(), ret ? 0 : 4);
 
     wc->txWriteIndex = 0;
 
@@ -189,10 +281,8 @@ uint8_t TwoWire::endTransmission(uint8_t sendStop)
 
     if (sendStop) {
         wc->idle = true;
-    }
-
-    if (gateEnterCount) {
-        GateMutex_leave(GateMutex_handle(&gate), --gateEnterCount);
+        wc->locked = false;
+        busLock.release();
     }
 
     /* success = 0; 4 = other error */
@@ -243,6 +333,26 @@ uint8_t TwoWire::requestFrom(int address, int quantity, int sendStop)
 // or after beginTransmission(address)
 size_t TwoWire::write(uint8_t data)
 {
+    if (slaveAddress != 0) {
+        UInt key = Hwi_disable();
+
+        /* the first write after a master read replaces that response */
+        if (slaveTxSent) {
+            slaveTxSent = false;
+            slaveTxReadIndex = 0;
+            slaveTxWriteIndex = 0;
+        }
+        if (slaveTxWriteIndex >= BUFFER_LENGTH) {
+            Hwi_restore(key);
+            setWriteError();
+            return 0;
+        }
+        slaveTxBuffer[slaveTxWriteIndex++] = data;
+
+        Hwi_restore(key);
+        return (1);
+    }
+
     WireContext *wc = getWireContext();
 
     // if(transmitting){
@@ -277,6 +387,14 @@ size_t TwoWire::write(const uint8_t *data, size_t quantity)
 // or after requestFrom(address, numBytes)
 int TwoWire::available(void)
 {
+    if (slaveAddress != 0) {
+        UInt key = Hwi_disable();
+        int count = slaveRxWriteIndex - slaveRxReadIndex;
+
+        Hwi_restore(key);
+        return (count);
+    }
+
     WireContext *wc = getWireContext();
 
     return ((wc->rxWriteIndex >= wc->rxReadIndex) ?
@@ -289,6 +407,18 @@ int TwoWire::available(void)
 int TwoWire::read(void)
 {
     int value;
+
+    if (slaveAddress != 0) {
+        UInt key = Hwi_disable();
+
+        value = -1;
+        if (slaveRxReadIndex < slaveRxWriteIndex) {
+            value = slaveRxBuffer[slaveRxReadIndex++];
+        }
+        Hwi_restore(key);
+        return (value);
+    }
+
     WireContext *wc = getWireContext();
 
     if (RX_BUFFER_EMPTY) {
@@ -307,6 +437,17 @@ int TwoWire::read(void)
 int TwoWire::peek(void)
 {
     int value = -1;
+
+    if (slaveAddress != 0) {
+        UInt key = Hwi_disable();
+
+        if (slaveRxReadIndex < slaveRxWriteIndex) {
+            value = slaveRxBuffer[slaveRxReadIndex];
+        }
+        Hwi_restore(key);
+        return (value);
+    }
+
     WireContext *wc = getWireContext();
 
     if(!RX_BUFFER_EMPTY){
@@ -317,6 +458,14 @@ int TwoWire::peek(void)
 }
 void TwoWire::flush(void)
 {
+    if (slaveAddress != 0) {
+        UInt key = Hwi_disable();
+
+        slaveRxReadIndex = slaveRxWriteIndex;
+        Hwi_restore(key);
+        return;
+    }
+
     WireContext *wc = getWireContext();
 
     wc->txWriteIndex = 0;
@@ -336,15 +485,168 @@ void TwoWire::onRequest( void (*function)(void) )
     user_onRequest = function;
 }
 
-void TwoWire::setModule(unsigned long _i2cModule)
+// serves master reads and writes from map instead of the callbacks
+//
+// The first byte of a write sets the register pointer, further bytes
+// are stored at the pointer; a read returns the bytes from the pointer
+// on. The pointer auto-increments and wraps at the end of the map.
+// Only the first writable registers can be changed by the master.
+// onReceive(), if set, still gets each write, register number first.
+// The interrupt accesses map, so update values wider than a byte with
+// interrupts disabled.
+void TwoWire::setRegisterMap(volatile uint8_t *map, uint8_t size, uint8_t writable)
 {
-    WireContext *wc = getWireContext();
+    UInt key = Hwi_disable();
+
+    regMap = (size != 0) ? map : NULL;
+    regMapSize = size;
+    regMapWritable = (writable < size) ? writable : size;
+    regPointer = 0;
+
+    Hwi_restore(key);
+}
+
+void TwoWire::setRegisterMap(volatile uint8_t *map, uint8_t size)
+{
+    setRegisterMap(map, size, size);
+}
 
+void TwoWire::setModule(unsigned long _i2cModule)
+{
     i2cModule = _i2cModule;
-    if (wc->i2cTransaction.slaveAddress != 0) {
-        begin(wc->i2cTransaction.slaveAddress);
+    if (slaveAddress != 0) {
+        begin(slaveAddress);
     }
     else {
         begin();
     }
 }
+
+/*
+ * Slave mode, called from slaveIsr()
+ */
+
+// the master sent us data, first is the first byte after our address
+void TwoWire::slaveReceive(uint8_t data, bool first)
+{
+    if (first || slaveState != SLAVE_RX) {
+        slaveEndReceive();
+        slaveRxReadIndex = 0;
+        slaveRxWriteIndex = 0;
+        slaveState = SLAVE_RX;
+        first = true;
+    }
+
+    if (slaveRxWriteIndex < BUFFER_LENGTH) {
+        slaveRxBuffer[slaveRxWriteIndex++] = data;
+    }
+
+    if (regMap == NULL) {
+        return;
+    }
+    if (first) {
+        regPointer = data;
+        return;
+    }
+    if (regPointer < regMapWritable) {
+        regMap[regPointer] = data;
+    }
+    if (++regPointer == regMapSize) {
+        regPointer = 0;
+    }
+}
+
+// the master reads a byte from us
+uint8_t TwoWire::slaveTransmit(void)
+{
+    uint8_t data;
+
+    if (slaveState != SLAVE_TX) {
+        slaveEndReceive();
+        slaveState = SLAVE_TX;
+        if (regMap == NULL) {
+            onRequestService();
+        }
+    }
+
+    if (regMap != NULL) {
+        data = (regPointer < regMapSize) ? regMap[regPointer] : SLAVE_FILL;
+        if (++regPointer == regMapSize) {
+            regPointer = 0;
+        }
+        return (data);
+    }
+
+    if (slaveTxReadIndex >= slaveTxWriteIndex) {
+        return (SLAVE_FILL);
+    }
+    return (slaveTxBuffer[slaveTxReadIndex++]);
+}
+
+// a start or stop ends the transfer under way
+void TwoWire::slaveEndReceive(void)
+{
+    uint8_t state = slaveState;
+
+    slaveState = IDLE;
+
+    /*
+     * in register map mode a lone register number, as sent ahead of a
+     * read, changes nothing worth a callback
+     */
+    if (state == SLAVE_RX && (regMap == NULL || slaveRxWriteIndex > 1)) {
+        onReceiveService(slaveRxWriteIndex);
+    }
+}
+
+void TwoWire::onReceiveService(int numBytes)
+{
+    if (user_onReceive != NULL) {
+        slaveRxReadIndex = 0;
+        user_onReceive(numBytes);
+    }
+}
+
+// without an onRequest() callback every read gets the response the sketch
+// last wrote; its next write() starts a new one
+void TwoWire::onRequestService(void)
+{
+    slaveTxReadIndex = 0;
+    if (user_onRequest != NULL) {
+        slaveTxSent = false;
+        slaveTxWriteIndex = 0;
+        user_onRequest();
+    }
+    else {
+        slaveTxSent = true;
+    }
+}
+
+void TwoWire::slaveIsr(UArg arg)
+{
+    TwoWire *wire = (TwoWire *)arg;
+    uint32_t status;
+    uint32_t action;
+
+    status = MAP_I2CSlaveIntStatusEx(wire->slaveBase, true);
+    MAP_I2CSlaveIntClearEx(wire->slaveBase, status);
+
+    if (status & I2C_SLAVE_INT_START) {
+        wire->slaveEndReceive();
+    }
+
+    if (status & I2C_SLAVE_INT_DATA) {
+        action = MAP_I2CSlaveStatus(wire->slaveBase);
+        if (action & I2C_SLAVE_ACT_TREQ) {
+            MAP_I2CSlaveDataPut(wire->slaveBase, wire->slaveTransmit());
+        }
+        else if (action & I2C_SLAVE_ACT_RREQ) {
+            wire->slaveReceive(MAP_I2CSlaveDataGet(wire->slaveBase),
+                (action & I2C_SLAVE_ACT_RREQ_FBR) == I2C_SLAVE_ACT_RREQ_FBR);
+        }
+    }
+
+    if (status & I2C_SLAVE_INT_STOP) {
+        wire->slaveEndReceive();
+    }
+}
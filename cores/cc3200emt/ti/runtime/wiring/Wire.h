@@ -37,7 +37,8 @@
 #include "Stream.h"
 
 #include <ti/drivers/I2C.h>
-#include <ti/sysbios/gates/GateMutex.h>
+#include <ti/sysbios/hal/Hwi.h>
+#include "BusLock.h"
 
 #define BUFFER_LENGTH     64
 
@@ -45,6 +46,7 @@
 #define MASTER_TX 1
 #define MASTER_RX 2
 #define SLAVE_RX 3
+#define SLAVE_TX 4
 
 #define BOOST_PACK_WIRE 0
 
@@ -59,6 +61,7 @@ typedef struct WireContext {
     uint8_t txWriteIndex;
 
     bool idle;
+    bool locked;    /* holds the bus from beginTransmission() to a stop */
 } WireContext;
 
 class TwoWire : public Stream
@@ -69,14 +72,38 @@ class TwoWire : public Stream
         uint8_t i2cModule;
         I2C_Handle i2c;
 
-        GateMutex_Struct gate;
-        uint8_t gateEnterCount;
+        BusLock busLock;
 
         void (*user_onRequest)(void);
         void (*user_onReceive)(int);
         void onRequestService(void);
-        void onReceiveService(uint8_t*, int);
+        void onReceiveService(int);
         void init(unsigned long);
+
+        /* slave mode, driven by slaveIsr() */
+        uint8_t slaveAddress;
+        uint32_t slaveBase;
+        Hwi_Struct slaveHwi;
+        volatile uint8_t slaveState;
+
+        uint8_t slaveRxBuffer[BUFFER_LENGTH];
+        volatile uint8_t slaveRxReadIndex;
+        volatile uint8_t slaveRxWriteIndex;
+
+        uint8_t slaveTxBuffer[BUFFER_LENGTH];
+        volatile uint8_t slaveTxReadIndex;
+        volatile uint8_t slaveTxWriteIndex;
+        volatile bool slaveTxSent;      /* next write() starts a new response */
+
+        volatile uint8_t *regMap;
+        uint8_t regMapSize;
+        uint8_t regMapWritable;
+        volatile uint8_t regPointer;
+
+        static void slaveIsr(UArg);
+        void slaveReceive(uint8_t, bool);
+        uint8_t slaveTransmit(void);
+        void slaveEndReceive(void);
         void forceStop(void);
         WireContext *getWireContext(void);
 
@@ -103,6 +130,8 @@ class TwoWire : public Stream
         virtual void flush(void);
         void onReceive( void (*)(int) );
         void onRequest( void (*)(void) );
+        void setRegisterMap(volatile uint8_t *, uint8_t);
+        void setRegisterMap(volatile uint8_t *, uint8_t, uint8_t);
 
         inline size_t write(unsigned long n) { return write((uint8_t)n); }
         inline size_t write(long n) { return write((uint8_t)n); }
@@ -112,6 +141,7 @@ class TwoWire : public Stream
         using Print::write;
 
         void setModule(unsigned long);
+        BusLock &lock(void) { return (busLock); }
 
 };
 
@@ -0,0 +1,441 @@
+/*
+  WorkerPool.cpp - a few tasks that run blocking calls for the others
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+#include "Energia.h"
+#include "WorkerPool.h"
+
+#include <string.h>
+
+#include <xdc/runtime/Error.h>
+
+#define SLOT_FREE   0xff    // else the slot's state is its job's status
+
+WorkerPool Workers;
+
+WorkerPool::WorkerPool(uint8_t workers, size_t stackSize, int priority)
+{
+    int i;
+
+    _workers = workers > WORKER_TASKS_MAX ? WORKER_TASKS_MAX : workers;
+    _created = 0;
+    _started = false;
+    _starting = false;
+    _stackSize = stackSize;
+    /* from 1 to the highest task priority */
+    if (priority < 1) {
+        priority = 1;
+    }
+    else if (priority > Task_numPriorities - 1) {
+        priority = Task_numPriorities - 1;
+    }
+    _priority = priority;
+    _order = 0;
+    memset(&_stats, 0, sizeof(_stats));
+
+    for (i = 0; i < WORKER_JOBS; i++) {
+        _slots[i].state = SLOT_FREE;
+        _slots[i].tag = 0;
+    }
+}
+
+/*
+ * Constructs the semaphores and creates the tasks on first use
+ */
+bool WorkerPool::begin(void)
+{
+    Semaphore_Params semParams;
+    Task_Params taskParams;
+    Error_Block eb;
+    bool first;
+    int i;
+    UInt key;
+
+    key = Task_disable();
+
+    /* another task is creating the workers: wait until they are there */
+    while (_starting) {
+        Task_restore(key);
+        Task_sleep(1);
+        key = Task_disable();
+    }
+    first = !_started;
+    if (first) {
+        Semaphore_Params_init(&semParams);
+        Semaphore_construct(&_queued, 0, &semParams);
+        semParams.mode = Semaphore_Mode_BINARY;
+        for (i = 0; i < WORKER_JOBS; i++) {
+            Semaphore_construct(&_slots[i].finished, 0, &semParams);
+        }
+        _stats.since = millis();
+        _starting = true;
+    }
+    Task_restore(key);
+
+    if (first) {
+        Error_init(&eb);
+        Task_Params_init(&taskParams);
+        taskParams.arg0 = (UArg)this;
+        taskParams.priority = _priority;
+        taskParams.stackSize = _stackSize;
+        for (i = 0; i < _workers; i++) {
+            if (Task_create(taskFxn, &taskParams, &eb) != NULL) {
+                _created++;
+            }
+        }
+
+        /* published only now, so no submit() finds a pool without workers */
+        key = Task_disable();
+        _started = true;
+        _starting = false;
+        Task_restore(key);
+    }
+    return (_created > 0);
+}
+
+WorkerJob WorkerPool::submit(WorkerFxn fxn, void *arg, uint8_t priorityClass,
+                             WorkerCallback callback, void *callbackArg)
+{
+    Slot *slot = NULL;
+    int i;
+    UInt key;
+
+    if (fxn == NULL || !begin()) {
+        return (WorkerJob());
+    }
+    if (priorityClass >= WORKER_CLASSES) {
+        priorityClass = WORKER_BULK;
+    }
+
+    key = Task_disable();
+
+    /* a free slot, or the one finished longest ago */
+    for (i = 0; i < WORKER_JOBS; i++) {
+        if (_slots[i].state == SLOT_FREE) {
+            slot = &_slots[i];
+            break;
+        }
+        if ((_slots[i].state == WORKER_DONE || _slots[i].state == WORKER_CANCELLED) &&
+            (slot == NULL || (int32_t)(_slots[i].order - slot->order) < 0)) {
+            slot = &_slots[i];
+        }
+    }
+    if (slot == NULL) {
+        _stats.rejected++;
+        Task_restore(key);
+        return (WorkerJob());
+    }
+
+    slot->fxn = fxn;
+    slot->arg = arg;
+    slot->callback = callback;
+    slot->callbackArg = callbackArg;
+    slot->worker = NULL;
+    slot->queuedAt = micros();
+    slot->order = _order++;
+    slot->result = 0;
+    slot->priorityClass = priorityClass;
+    slot->cancel = false;
+    slot->tag++;
+    slot->state = WORKER_QUEUED;
+    Semaphore_reset(Semaphore_handle(&slot->finished), 0);
+
+    _stats.submitted++;
+    if (++_stats.depth > _stats.maxDepth) {
+        _stats.maxDepth = _stats.depth;
+    }
+
+    WorkerJob job(slot - _slots, slot->tag);
+    Task_restore(key);
+
+    Semaphore_post(Semaphore_handle(&_queued));
+    return (job);
+}
+
+int WorkerPool::status(WorkerJob job, int *result)
+{
+    Slot *slot;
+    int status;
+    UInt key;
+
+    if (!job.valid() || job.slot >= WORKER_JOBS || !_started) {
+        return (WORKER_INVALID);
+    }
+    slot = &_slots[job.slot];
+
+    key = Task_disable();
+    if (slot->tag != job.tag || slot->state == SLOT_FREE) {
+        status = WORKER_INVALID;
+    }
+    else {
+        status = slot->state;
+        if (result != NULL && (status == WORKER_DONE || status == WORKER_CANCELLED)) {
+            *result = slot->result;
+        }
+    }
+    Task_restore(key);
+    return (status);
+}
+
+int WorkerPool::wait(WorkerJob job, int *result, unsigned long timeout)
+{
+    unsigned long start = millis();
+    unsigned long waited;
+    Semaphore_Handle finished;
+    UInt ticks;
+    int status;
+
+    for (;;) {
+        status = this->status(job, result);
+        if (status != WORKER_QUEUED && status != WORKER_RUNNING) {
+            return (status);
+        }
+
+        waited = millis() - start;
+        ticks = BIOS_WAIT_FOREVER;
+        if (timeout != WORKER_WAIT_FOREVER) {
+            if (waited >= timeout) {
+                return (WORKER_TIMEOUT);
+            }
+            ticks = timeout - waited;
+        }
+
+        /*
+         * the semaphore stays posted while the job is finished, so every
+         * task waiting for it passes in turn
+         */
+        finished = Semaphore_handle(&_slots[job.slot].finished);
+        if (Semaphore_pend(finished, ticks)) {
+            Semaphore_post(finished);
+        }
+    }
+}
+
+bool WorkerPool::cancel(WorkerJob job)
+{
+    Slot *slot;
+    bool dequeued = false;
+    UInt key;
+
+    if (!job.valid() || job.slot >= WORKER_JOBS || !_started) {
+        return (false);
+    }
+    slot = &_slots[job.slot];
+
+    key = Task_disable();
+    if (slot->tag == job.tag) {
+        if (slot->state == WORKER_QUEUED) {
+            /*
+             * out of the queue and not yet reusable until finish(); its
+             * count in _queued stays, the worker it wakes finds nothing
+             */
+            slot->state = WORKER_RUNNING;
+            _stats.depth--;
+            _stats.cancelled++;
+            dequeued = true;
+        }
+        else if (slot->state == WORKER_RUNNING) {
+            slot->cancel = true;
+        }
+    }
+    Task_restore(key);
+
+    if (dequeued) {
+        finish(slot, WORKER_CANCELLED);
+    }
+    return (dequeued);
+}
+
+bool WorkerPool::cancelling(void)
+{
+    Task_Handle self = Task_self();
+    int i;
+
+    for (i = 0; i < WORKER_JOBS; i++) {
+        if (_slots[i].state == WORKER_RUNNING && _slots[i].worker == self) {
+            return (_slots[i].cancel);
+        }
+    }
+    return (false);
+}
+
+void WorkerPool::stats(WorkerPoolStats &stats, bool reset)
+{
+    UInt key;
+
+    key = Task_disable();
+    stats = _stats;
+    if (reset) {
+        /* depth and busy are the present state, not counts */
+        _stats.submitted = 0;
+        _stats.completed = 0;
+        _stats.cancelled = 0;
+        _stats.rejected = 0;
+        _stats.maxDepth = _stats.depth;
+        _stats.totalWaitUs = 0;
+        _stats.maxWaitUs = 0;
+        _stats.totalRunUs = 0;
+        _stats.maxRunUs = 0;
+        _stats.since = millis();
+    }
+    Task_restore(key);
+}
+
+void WorkerPool::report(Print &out)
+{
+    WorkerPoolStats stats;
+
+    this->stats(stats);
+
+    out.print("workers: ");
+    out.print(_created);
+    out.print(" tasks, ");
+    out.print(stats.busy);
+    out.print(" busy, ");
+    out.print(stats.depth);
+    out.print(" queued (max ");
+    out.print(stats.maxDepth);
+    out.println(")");
+
+    out.print("  ");
+    out.print(stats.submitted);
+    out.print(" submitted, ");
+    out.print(stats.completed);
+    out.print(" completed, ");
+    out.print(stats.cancelled);
+    out.print(" cancelled, ");
+    out.print(stats.rejected);
+    out.println(" rejected");
+
+    out.print("  wait us mean ");
+    out.print(stats.completed ? stats.totalWaitUs / stats.completed : 0);
+    out.print(" max ");
+    out.print(stats.maxWaitUs);
+    out.print(", run us mean ");
+    out.print(stats.completed ? stats.totalRunUs / stats.completed : 0);
+    out.print(" max ");
+    out.println(stats.maxRunUs);
+}
+
+/*
+ * Private Methods
+ */
+void WorkerPool::taskFxn(UArg arg0, UArg arg1)
+{
+    WorkerPool *pool = (WorkerPool *)arg0;
+
+    for (;;) {
+        Semaphore_pend(Semaphore_handle(&pool->_queued), BIOS_WAIT_FOREVER);
+        pool->run();
+    }
+}
+
+/* runs the first job of the highest class queued, if any is left */
+void WorkerPool::run(void)
+{
+    Task_Handle self = Task_self();
+    Slot *slot = NULL;
+    unsigned long start, waited, ran;
+    int i, pri, status;
+    UInt key;
+
+    key = Task_disable();
+    for (i = 0; i < WORKER_JOBS; i++) {
+        if (_slots[i].state != WORKER_QUEUED) {
+            continue;
+        }
+        if (slot == NULL || _slots[i].priorityClass < slot->priorityClass ||
+            (_slots[i].priorityClass == slot->priorityClass &&
+             (int32_t)(_slots[i].order - slot->order) < 0)) {
+            slot = &_slots[i];
+        }
+    }
+    if (slot == NULL) {
+        Task_restore(key);
+        return;
+    }
+    start = micros();
+    waited = start - slot->queuedAt;
+    slot->state = WORKER_RUNNING;
+    slot->worker = self;
+    _stats.depth--;
+    _stats.busy++;
+    Task_restore(key);
+
+    pri = _priority + WORKER_NORMAL - slot->priorityClass;
+    if (pri < 1) {
+        pri = 1;
+    }
+    else if (pri > Task_numPriorities - 1) {
+        pri = Task_numPriorities - 1;
+    }
+    if (pri != _priority) {
+        Task_setPri(self, pri);
+    }
+
+    /* the job can't be reused while it runs */
+    slot->result = slot->fxn(slot->arg);
+
+    if (pri != _priority) {
+        Task_setPri(self, _priority);
+    }
+
+    ran = micros() - start;
+
+    key = Task_disable();
+    _stats.busy--;
+    _stats.completed++;
+    _stats.totalWaitUs += waited;
+    _stats.totalRunUs += ran;
+    if (waited > _stats.maxWaitUs) {
+        _stats.maxWaitUs = waited;
+    }
+    if (ran > _stats.maxRunUs) {
+        _stats.maxRunUs = ran;
+    }
+    status = slot->cancel ? WORKER_CANCELLED : WORKER_DONE;
+    if (status == WORKER_CANCELLED) {
+        _stats.cancelled++;
+    }
+    Task_restore(key);
+
+    finish(slot, status);
+}
+
+/* the job's final status, then its callback */
+void WorkerPool::finish(Slot *slot, int status)
+{
+    WorkerCallback callback;
+    void *callbackArg;
+    int result;
+    UInt key;
+
+    key = Task_disable();
+    WorkerJob job(slot - _slots, slot->tag);
+    callback = slot->callback;
+    callbackArg = slot->callbackArg;
+    result = slot->result;
+    slot->worker = NULL;
+    slot->order = _order++;
+    slot->state = status;
+    Task_restore(key);
+
+    Semaphore_post(Semaphore_handle(&slot->finished));
+    if (callback != NULL) {
+        callback(job, status, result, callbackArg);
+    }
+}
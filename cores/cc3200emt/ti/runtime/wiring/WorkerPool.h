@@ -0,0 +1,181 @@
+/*
+  WorkerPool.h - a few tasks that run blocking calls for the others
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+#ifndef WorkerPool_h
+#define WorkerPool_h
+
+#include <stdint.h>
+#include <stddef.h>
+
+#include "Print.h"
+
+#include <ti/sysbios/BIOS.h>
+#include <ti/sysbios/knl/Task.h>
+#include <ti/sysbios/knl/Semaphore.h>
+
+#define WORKER_TASKS        2       // Workers' tasks
+#define WORKER_TASKS_MAX    8
+#define WORKER_JOBS         16      // jobs queued, running or holding a result at once
+#define WORKER_STACK_SIZE   0x800
+#define WORKER_PRIORITY     2       // of a task running a WORKER_NORMAL job
+#define WORKER_WAIT_FOREVER (~0UL)
+
+/*
+ * Priority classes. The queue hands out the highest class first, in
+ * submission order within a class, and a worker runs an urgent job one
+ * task priority above its own and a bulk job one below, within the
+ * task priorities.
+ */
+#define WORKER_URGENT       0
+#define WORKER_NORMAL       1
+#define WORKER_BULK         2
+#define WORKER_CLASSES      3
+
+/* status of a job */
+#define WORKER_QUEUED       0
+#define WORKER_RUNNING      1
+#define WORKER_DONE         2       // its function returned
+#define WORKER_CANCELLED    3       // cancelled before it ran, or while it ran
+#define WORKER_INVALID      -1      // no such job, or its slot was reused
+#define WORKER_TIMEOUT      -2      // wait() gave up
+
+/* a job given to submit(), copied around by value */
+class WorkerJob
+{
+    public:
+        WorkerJob() : slot(-1), tag(0) {}
+        WorkerJob(int8_t slot, uint8_t tag) : slot(slot), tag(tag) {}
+
+        bool valid(void) const { return slot >= 0; }   // false if submit() refused it
+
+        int8_t slot;
+        uint8_t tag;
+};
+
+/* the work: runs in a worker, returns the job's result */
+typedef int (*WorkerFxn)(void *arg);
+
+/*
+ * Called once per job with its final status, WORKER_DONE or
+ * WORKER_CANCELLED: from the worker that ran it, or from cancel() for a
+ * job that never ran.
+ */
+typedef void (*WorkerCallback)(WorkerJob job, int status, int result, void *arg);
+
+typedef struct {
+    unsigned long submitted;
+    unsigned long completed;        // ran to the end, cancelled or not
+    unsigned long cancelled;        // ...plus those cancelled before they ran
+    unsigned long rejected;         // submit() found every slot taken
+    unsigned long depth;            // jobs queued now
+    unsigned long maxDepth;
+    unsigned long busy;             // workers running a job now
+    unsigned long totalWaitUs;      // submitted to started, over the completed jobs
+    unsigned long maxWaitUs;
+    unsigned long totalRunUs;       // started to finished
+    unsigned long maxRunUs;
+    unsigned long since;            // millis() at the last reset
+} WorkerPoolStats;
+
+/*
+ * A fixed number of tasks sharing a bounded queue, so that a sketch can
+ * hand over WiFi.begin(), an SLFS write, a TLS connect or a display
+ * flush without a task and stack per activity:
+ *
+ *   int connect(void *arg) { return WiFi.begin((char *)arg); }
+ *   ...
+ *   WorkerJob job = Workers.submit(connect, (void *)"energia");
+ *   ...
+ *   if (Workers.status(job, &ret) == WORKER_DONE) { ... }
+ *
+ * A job's slot keeps its result until it is needed for a new job; a
+ * handle carries the slot's tag at the time, so a handle to a reused
+ * slot is recognized and reported WORKER_INVALID. Like WiFiClass
+ * lookups, a result stays available for the next WORKER_JOBS - 1 jobs
+ * at least.
+ *
+ * The tasks are created on the first submit(), or by begin(). A job must
+ * not wait() for a job submitted after it: with every worker doing so,
+ * nothing would run it.
+ */
+class WorkerPool
+{
+    public:
+        /* no kernel calls: pools may be globals */
+        WorkerPool(uint8_t workers = WORKER_TASKS, size_t stackSize = WORKER_STACK_SIZE,
+                   int priority = WORKER_PRIORITY);
+
+        bool begin(void);   // creates the tasks, false if none could be
+
+        /* job, not valid() if every slot is taken */
+        WorkerJob submit(WorkerFxn fxn, void *arg, uint8_t priorityClass = WORKER_NORMAL,
+                         WorkerCallback callback = NULL, void *callbackArg = NULL);
+
+        /* the job's status, with its result in *result once it has one */
+        int status(WorkerJob job, int *result = NULL);
+
+        /* as status(), once the job has finished or WORKER_TIMEOUT after timeout ms */
+        int wait(WorkerJob job, int *result = NULL, unsigned long timeout = WORKER_WAIT_FOREVER);
+
+        /*
+         * Takes a queued job off the queue, true then. A running job is
+         * only asked to stop: its function sees cancelling() true, and
+         * its status is WORKER_CANCELLED once it returns.
+         */
+        bool cancel(WorkerJob job);
+        bool cancelling(void);  // called from a job: true once cancel() was called for it
+
+        void stats(WorkerPoolStats &stats, bool reset = false);
+        void report(Print &out);
+
+    private:
+        typedef struct {
+            WorkerFxn fxn;
+            void *arg;
+            WorkerCallback callback;
+            void *callbackArg;
+            Task_Handle worker;         // running it
+            unsigned long queuedAt;     // micros()
+            uint32_t order;             // queued, then finished, order
+            int result;
+            uint8_t state;
+            uint8_t tag;
+            uint8_t priorityClass;
+            volatile bool cancel;
+            Semaphore_Struct finished;  // posted, and left posted, once it has finished
+        } Slot;
+
+        static void taskFxn(UArg arg0, UArg arg1);
+        void run(void);
+        void finish(Slot *slot, int status);
+
+        Slot _slots[WORKER_JOBS];
+        Semaphore_Struct _queued;       // counts the queued jobs
+        uint8_t _workers;
+        uint8_t _created;
+        bool _started;
+        bool _starting;                 // begin() is creating the tasks
+        size_t _stackSize;
+        int _priority;
+        uint32_t _order;
+        WorkerPoolStats _stats;
+};
+
+extern WorkerPool Workers;
+
+#endif
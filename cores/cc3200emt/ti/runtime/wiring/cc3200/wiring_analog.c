@@ -58,19 +58,6 @@
 extern PWM_Config PWM_config[];
 extern PWMTimerCC3200_HWAttrsV1 pwmCC3200HWAttrs[];
 
-extern const GPIOCC3200_Config GPIOCC3200_config;
-
-/*
- * Table of port bases address. 
- * Indexed by GPIO port number (0-3).
- *
- * This should be driverlib call!!!
- */
-static const uint32_t gpioBaseAddresses[] = {
-    GPIOA0_BASE, GPIOA1_BASE,
-    GPIOA2_BASE, GPIOA3_BASE
-};
-
 /* Carefully selected hal Timer IDs for tone and servo */
 uint32_t toneTimerId = (~0);  /* use Timer_ANY for tone timer */
 uint32_t servoTimerId = (~0); /* use Timer_ANY for servo timer */
@@ -93,13 +80,10 @@ void analogWrite(uint8_t pin, int val)
 {
     uint8_t timer, pwmIndex, timerId, pwmBaseIndex;
     uint32_t hwiKey;
-    uint16_t pinId;
-    uint_fast8_t port;
-    uint_fast16_t pinMask;
 
     hwiKey = Hwi_disable();
 
-    pwmIndex = timer = digital_pin_to_timer[pin];
+    pwmIndex = timer = digitalPinToTimer(pin);
 
     /* re-configure pin if necessary */
     if (digital_pin_to_pin_function[pin] != PIN_FUNC_ANALOG_OUTPUT) {
@@ -110,7 +94,7 @@ void analogWrite(uint8_t pin, int val)
             return;
         }
 
-        uint32_t pnum = digital_pin_to_pin_num[pin];
+        uint32_t pnum = digitalPinToPinNum(pin);
         uint32_t timerAvailMask;
         bool weOwnTheTimer = false;
 
@@ -134,9 +118,6 @@ void analogWrite(uint8_t pin, int val)
             }
         }
 
-        pinId = GPIOCC3200_config.pinConfigs[pin] & 0xffff;
-        port = pinId >> 8;
-        pinMask = pinId & 0xff;
         PWM_Params_init(&pwmParams);
 
         /* Open the PWM port */
@@ -146,8 +127,8 @@ void analogWrite(uint8_t pin, int val)
 
         /* override default pin definition in HwAttrs */
         pwmCC3200HWAttrs[pwmIndex].pinId = pnum;
-        pwmCC3200HWAttrs[pwmIndex].gpioBaseAddr = gpioBaseAddresses[port];
-        pwmCC3200HWAttrs[pwmIndex].gpioPinIndex = pinMask;
+        pwmCC3200HWAttrs[pwmIndex].gpioBaseAddr = (uint32_t)(uintptr_t)portBASERegister(digitalPinToPort(pin));
+        pwmCC3200HWAttrs[pwmIndex].gpioPinIndex = digitalPinToBitMask(pin);
 
         pwmHandles[timer] = PWM_open(timer, &pwmParams);
 
@@ -182,7 +163,7 @@ void analogWrite(uint8_t pin, int val)
  */
 void stopAnalogWrite(uint8_t pin)
 {
-    uint16_t pwmIndex = digital_pin_to_timer[pin];
+    uint16_t pwmIndex = digitalPinToTimer(pin);
     uint8_t timerId, pwmBaseIndex;
     bool timerFree;
 
@@ -226,15 +207,11 @@ uint16_t analogRead(uint8_t pin)
 {
     uint8_t sampleCount = 0;
     uint16_t channel, val;
-    uint16_t pinNum = digital_pin_to_pin_num[pin];
     uint32_t hwiKey;
 
-    switch (pinNum) {
-        case PIN_57: {channel = ADC_CH_0;} break;
-        case PIN_58: {channel = ADC_CH_1;} break;
-        case PIN_59: {channel = ADC_CH_2;} break;
-        case PIN_60: {channel = ADC_CH_3;} break;
-        default: return 0;
+    channel = digitalPinToADCChannel(pin);
+    if (channel == NOT_ON_ADC) {
+        return 0;
     }
 
     hwiKey = Hwi_disable();
@@ -242,7 +219,7 @@ uint16_t analogRead(uint8_t pin)
     /* re-configure pin if necessary */
     if (digital_pin_to_pin_function[pin] != PIN_FUNC_ANALOG_INPUT) {
         // Pinmux the pin to be analog
-        MAP_PinTypeADC(digital_pin_to_pin_num[pin], 0xff);
+        MAP_PinTypeADC(digitalPinToPinNum(pin), 0xff);
         digital_pin_to_pin_function[pin] = PIN_FUNC_ANALOG_INPUT;
     }
 
@@ -39,23 +39,7 @@
 extern "C" {
 #endif
 
-#define NOT_ON_TIMER    128
-
-/* These timer definitions map directly to PWM indexes */
-#define TIMERA0A 0
-#define TIMERA0B 1
-#define TIMERA1A 2
-#define TIMERA1B 3
-#define TIMERA2A 4
-#define TIMERA2B 5
-#define TIMERA3A 6
-#define TIMERA3B 7
-
-#define NOT_A_PIN       0
-#define NOT_ON_ADC      0xff
-
-extern const uint8_t digital_pin_to_timer[];
-extern const uint16_t digital_pin_to_pin_num[];
+/* pin and timer definitions live in wiring_pins.h */
 
 #ifdef __cplusplus
 } // extern "C"
@@ -0,0 +1,208 @@
+/*
+  wiring_pins.h - compile time resolution of the CC3200 pin maps
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+/*
+ * Included at the end of each variant's pins_energia.h, once the variant
+ * has defined PIN_MAP(X).
+ *
+ * The same map is expanded twice: into the runtime tables of pins.c and
+ * Board_init.c, and into static const copies below. The accessors read
+ * the static copy when the pin number is a compile time constant, so the
+ * compiler folds the lookup into an immediate and drops the copy; any
+ * other pin number goes through the runtime tables.
+ */
+
+#ifndef WiringPins_h
+#define WiringPins_h
+
+#include <stdint.h>
+
+/*
+ * driverlib/pin.h needs tBoolean from inc/hw_types.h, which would also
+ * define true and false for every sketch
+ */
+#ifndef __HW_TYPES_H__
+#define tBoolean unsigned char
+#include <driverlib/pin.h>
+#undef tBoolean
+#else
+#include <driverlib/pin.h>
+#endif
+
+#include <ti/drivers/gpio/GPIOCC3200.h>
+#include <inc/hw_memmap.h>
+#include <inc/hw_gpio.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define PIN_FUNC_UNUSED             0
+#define PIN_FUNC_DIGITAL_OUTPUT     1
+#define PIN_FUNC_DIGITAL_INPUT      2
+#define PIN_FUNC_ANALOG_OUTPUT      3
+#define PIN_FUNC_ANALOG_INPUT       4
+#define PIN_FUNC_INVALID            5
+
+#define NOT_ON_TIMER    128
+
+/* These timer definitions map directly to PWM indexes */
+#define TIMERA0A 0
+#define TIMERA0B 1
+#define TIMERA1A 2
+#define TIMERA1B 3
+#define TIMERA2A 4
+#define TIMERA2B 5
+#define TIMERA3A 6
+#define TIMERA3B 7
+
+#define NOT_A_PIN       0
+#define NOT_ON_ADC      0xff
+
+extern uint8_t digital_pin_to_pin_function[];
+extern const uint8_t digital_pin_to_timer[];
+extern const uint16_t digital_pin_to_pin_num[];
+extern const GPIOCC3200_Config GPIOCC3200_config;
+
+/* PIN_MAP(X) expanders for the tables */
+#define PIN_MAP_PIN_NUM(pin, gpio, timer)       pin,
+#define PIN_MAP_GPIO(pin, gpio, timer)          gpio,
+#define PIN_MAP_GPIO_CONFIG(pin, gpio, timer)   gpio | GPIO_DO_NOT_CONFIG,
+#define PIN_MAP_TIMER(pin, gpio, timer)         timer,
+
+static const uint16_t pin_map_pin_num[] __attribute__((unused)) = {
+    PIN_MAP(PIN_MAP_PIN_NUM)
+};
+static const uint16_t pin_map_gpio[] __attribute__((unused)) = {
+    PIN_MAP(PIN_MAP_GPIO)
+};
+static const uint8_t pin_map_timer[] __attribute__((unused)) = {
+    PIN_MAP(PIN_MAP_TIMER)
+};
+
+#define PIN_MAP_SIZE (sizeof(pin_map_pin_num) / sizeof(pin_map_pin_num[0]))
+
+/* true if pin is known at compile time and has an entry in the map */
+#define PIN_MAP_CONSTANT(pin) (__builtin_constant_p(pin) && (pin) < PIN_MAP_SIZE)
+
+#define PIN_MAP_INLINE static inline __attribute__((always_inline))
+
+/* package pin (PIN_01 .. PIN_64) of an Energia pin */
+PIN_MAP_INLINE uint16_t digitalPinToPinNum(uint8_t pin)
+{
+    if (PIN_MAP_CONSTANT(pin)) {
+        return (pin_map_pin_num[pin]);
+    }
+    return (digital_pin_to_pin_num[pin]);
+}
+
+/* PWM index (TIMERA0A .. TIMERA3B) or NOT_ON_TIMER */
+PIN_MAP_INLINE uint8_t digitalPinToTimer(uint8_t pin)
+{
+    if (PIN_MAP_CONSTANT(pin)) {
+        return (pin_map_timer[pin]);
+    }
+    return (digital_pin_to_timer[pin]);
+}
+
+/* GPIOCC3200_GPIO_xx value: port in the high byte, bit mask in the low */
+PIN_MAP_INLINE uint16_t digitalPinToGPIO(uint8_t pin)
+{
+    if (PIN_MAP_CONSTANT(pin)) {
+        return (pin_map_gpio[pin]);
+    }
+    return (GPIOCC3200_config.pinConfigs[pin] & 0xffff);
+}
+
+PIN_MAP_INLINE uint8_t digitalPinToPort(uint8_t pin)
+{
+    return (digitalPinToGPIO(pin) >> 8);
+}
+
+PIN_MAP_INLINE uint8_t digitalPinToBitMask(uint8_t pin)
+{
+    return (digitalPinToGPIO(pin) & 0xff);
+}
+
+/* GPIOA0_BASE .. GPIOA3_BASE are 4K apart */
+PIN_MAP_INLINE volatile uint32_t *portBASERegister(uint8_t port)
+{
+    return ((volatile uint32_t *)(uintptr_t)(GPIOA0_BASE + ((uint32_t)port << 12)));
+}
+
+/*
+ * The DATA register is bit-masked by address bits 9:2, so reads and
+ * writes through this address only touch the bits in mask
+ */
+PIN_MAP_INLINE volatile uint32_t *portDATARegister(uint8_t port, uint8_t mask)
+{
+    return ((volatile uint32_t *)(uintptr_t)(GPIOA0_BASE + ((uint32_t)port << 12)
+        + GPIO_O_GPIO_DATA + ((uint32_t)mask << 2)));
+}
+
+/* ADC_CH_0 .. ADC_CH_3 for PIN_57 .. PIN_60, NOT_ON_ADC otherwise */
+PIN_MAP_INLINE uint8_t digitalPinToADCChannel(uint8_t pin)
+{
+    uint16_t pinNum = digitalPinToPinNum(pin);
+
+    if (pinNum < PIN_57 || pinNum > PIN_60) {
+        return (NOT_ON_ADC);
+    }
+    return ((pinNum - PIN_57) << 3);
+}
+
+#ifdef __cplusplus
+} // extern "C"
+
+/*
+ * digitalWrite()/digitalRead() with a constant pin that is already
+ * configured for that direction become a single access to the masked
+ * DATA register. Everything else, including taking the address of the
+ * functions, uses the out of line versions in wiring_digital.c, which
+ * are reached through the aliases below.
+ */
+extern "C" {
+
+extern void wiring_digitalWrite(uint8_t pin, uint8_t val) __asm__("digitalWrite");
+extern int wiring_digitalRead(uint8_t pin) __asm__("digitalRead");
+
+inline __attribute__((gnu_inline, always_inline)) void digitalWrite(uint8_t pin, uint8_t val)
+{
+    if (PIN_MAP_CONSTANT(pin) && pin_map_gpio[pin] != GPIOCC3200_EMPTY_PIN
+        && digital_pin_to_pin_function[pin] == PIN_FUNC_DIGITAL_OUTPUT) {
+        uint8_t mask = pin_map_gpio[pin] & 0xff;
+        *portDATARegister(pin_map_gpio[pin] >> 8, mask) = val ? mask : 0;
+        return;
+    }
+    wiring_digitalWrite(pin, val);
+}
+
+inline __attribute__((gnu_inline, always_inline)) int digitalRead(uint8_t pin)
+{
+    if (PIN_MAP_CONSTANT(pin) && pin_map_gpio[pin] != GPIOCC3200_EMPTY_PIN
+        && digital_pin_to_pin_function[pin] == PIN_FUNC_DIGITAL_INPUT) {
+        uint8_t mask = pin_map_gpio[pin] & 0xff;
+        return (*portDATARegister(pin_map_gpio[pin] >> 8, mask) ? 1 : 0);
+    }
+    return (wiring_digitalRead(pin));
+}
+
+} // extern "C"
+#endif
+
+#endif
@@ -0,0 +1,65 @@
+/*
+  wiring_alloc.c - counts heap allocations
+
+  When the link wraps malloc(), calloc() and realloc() (-Wl,--wrap, set
+  with compiler.alloc_count.flags in platform.local.txt), every call the
+  sketch, the core and the libraries make, operator new included, passes
+  through here on its way to the C library. allocationCount() lets the
+  Benchmark library report allocations per call. The count is not
+  locked: a task preempted in the increment can lose one.
+
+  Without the wrap nothing calls the wrappers, and the weak references
+  to the __real_ functions stay unresolved, which allocationCounting()
+  reports.
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+#include <stddef.h>
+#include <stdint.h>
+
+extern void *__real_malloc(size_t size) __attribute__((weak));
+extern void *__real_calloc(size_t count, size_t size) __attribute__((weak));
+extern void *__real_realloc(void *ptr, size_t size) __attribute__((weak));
+
+static volatile uint32_t allocations;
+
+uint32_t allocationCount(void)
+{
+    return (allocations);
+}
+
+int allocationCounting(void)
+{
+    return (__real_malloc != NULL);
+}
+
+void *__wrap_malloc(size_t size)
+{
+    allocations++;
+    return (__real_malloc(size));
+}
+
+void *__wrap_calloc(size_t count, size_t size)
+{
+    allocations++;
+    return (__real_calloc(count, size));
+}
+
+void *__wrap_realloc(void *ptr, size_t size)
+{
+    allocations++;
+    return (__real_realloc(ptr, size));
+}
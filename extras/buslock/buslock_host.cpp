@@ -0,0 +1,258 @@
+/*
+ buslock_host.cpp - checks BusLock's priority inheritance on a host
+
+ Builds BusLock.cpp against stand-ins for the kernel calls it makes.
+ Tasks are plain priorities; a task waiting for a bus runs a scenario
+ step, in which other tasks take and release buses, and then either
+ gets the bus or times out. From the repository root:
+
+   W=cores/cc3200emt/ti/runtime/wiring
+   c++ -w -I$W -Icores/cc3200emt -Isystem -Isystem/inc -Isystem/driverlib \
+       -Ivariants/CC3200_LAUNCHXL -Dxdc_target_types__=gnu/targets/arm/std.h \
+       -Dxdc_target_name__=M4F -Dxdc__nolocalstring=1 -DARDUINO=101 \
+       -o buslock_host extras/buslock/buslock_host.cpp $W/BusLock.cpp \
+       $W/Print.cpp $W/PrintD.cpp $W/WString.cpp $W/itoa.c
+   ./buslock_host
+ */
+
+#include <stdio.h>
+
+#include "BusLock.h"
+#include "RtosTrace.h"
+
+/* the stand-in kernel */
+typedef struct {
+    const char *name;
+    Int pri;
+} FakeTask;
+
+static FakeTask low = { "low", 1 }, mid = { "mid", 2 }, high = { "high", 3 };
+static FakeTask *current = &low;
+static void (*whileWaiting)(void);
+static int failures;
+
+#define SEMAPHORES 8
+
+static struct {
+    Semaphore_Handle handle;
+    int count;
+} semaphores[SEMAPHORES];
+
+static int *semaphoreCount(Semaphore_Handle handle)
+{
+    int i, free = -1;
+
+    for (i = 0; i < SEMAPHORES; i++) {
+        if (semaphores[i].handle == handle) {
+            return (&semaphores[i].count);
+        }
+        if (semaphores[i].handle == NULL && free < 0) {
+            free = i;
+        }
+    }
+    semaphores[free].handle = handle;
+    semaphores[free].count = 0;
+    return (&semaphores[free].count);
+}
+
+extern "C" {
+
+ti_sysbios_BIOS_ThreadType ti_sysbios_BIOS_getThreadType__E(void)
+{
+    return (BIOS_ThreadType_Task);
+}
+
+xdc_UInt ti_sysbios_knl_Task_disable__E(void) { return (0); }
+xdc_Void ti_sysbios_knl_Task_restore__E(xdc_UInt key) {}
+
+ti_sysbios_knl_Task_Handle ti_sysbios_knl_Task_self__E(void)
+{
+    return ((Task_Handle)current);
+}
+
+xdc_Int ti_sysbios_knl_Task_getPri__E(ti_sysbios_knl_Task_Handle task)
+{
+    return (((FakeTask *)task)->pri);
+}
+
+xdc_UInt ti_sysbios_knl_Task_setPri__E(ti_sysbios_knl_Task_Handle task, xdc_Int pri)
+{
+    Int old = ((FakeTask *)task)->pri;
+
+    ((FakeTask *)task)->pri = pri;
+    return (old);
+}
+
+xdc_Void ti_sysbios_knl_Semaphore_Params__init__S(xdc_Ptr dst, const xdc_Void *src,
+                                                  xdc_SizeT psz, xdc_SizeT isz)
+{
+}
+
+void ti_sysbios_knl_Semaphore_construct(ti_sysbios_knl_Semaphore_Struct *obj, xdc_Int count,
+                                        const ti_sysbios_knl_Semaphore_Params *params)
+{
+    *semaphoreCount(Semaphore_handle(obj)) = count;
+}
+
+void ti_sysbios_knl_Semaphore_destruct(ti_sysbios_knl_Semaphore_Struct *obj)
+{
+    int i;
+
+    for (i = 0; i < SEMAPHORES; i++) {
+        if (semaphores[i].handle == Semaphore_handle(obj)) {
+            semaphores[i].handle = NULL;
+        }
+    }
+}
+
+/* the waiting task runs the pending step, then has the semaphore or times out */
+xdc_Bool ti_sysbios_knl_Semaphore_pend__E(ti_sysbios_knl_Semaphore_Handle sem, xdc_UInt32 timeout)
+{
+    void (*step)(void) = whileWaiting;
+    FakeTask *self = current;
+    int *count;
+
+    whileWaiting = NULL;
+    if (step != NULL) {
+        step();
+    }
+    current = self;
+
+    count = semaphoreCount(sem);
+    if (*count > 0) {
+        (*count)--;
+        return (true);
+    }
+    return (false);
+}
+
+xdc_Void ti_sysbios_knl_Semaphore_post__E(ti_sysbios_knl_Semaphore_Handle sem)
+{
+    *semaphoreCount(sem) = 1;
+}
+
+unsigned long micros(void) { return (0); }
+unsigned long millis(void) { return (0); }
+
+}
+
+/* never begun: its zero-initialized state records nothing */
+EventTrace::EventTrace() {}
+EventTrace RtosTrace;
+void EventTrace::record(uint8_t type, const void *object, uint16_t arg) {}
+
+static BusLock wire("wire"), serial("serial");
+
+static void expect(const char *what, bool ok)
+{
+    printf("%-56s %s\n", what, ok ? "ok" : "FAIL");
+    if (!ok) {
+        failures++;
+    }
+}
+
+static void run(FakeTask *task) { current = task; }
+
+/*
+ * high waits for wire held by low, which takes serial at the lent
+ * priority and then releases wire before serial
+ */
+static void outOfOrderStep(void)
+{
+    expect("low inherits high's priority through wire", low.pri == 3);
+    run(&low);
+    serial.acquire();
+    wire.release();
+    expect("low drops to its own priority once wire is given", low.pri == 1);
+}
+
+static void outOfOrder(void)
+{
+    run(&low);
+    wire.acquire();
+
+    run(&high);
+    whileWaiting = outOfOrderStep;
+    expect("high gets wire", wire.acquire(100));
+
+    run(&low);
+    serial.release();
+    expect("low stays at its own priority after serial", low.pri == 1);
+
+    run(&high);
+    wire.release();
+}
+
+/* as above, but high's wait times out instead */
+static void timeoutStep(void)
+{
+    run(&low);
+    serial.acquire();
+}
+
+static void timeout(void)
+{
+    run(&low);
+    wire.acquire();
+
+    run(&high);
+    whileWaiting = timeoutStep;
+    expect("high times out waiting for wire", !wire.acquire(10));
+    expect("low drops to its own priority after the timeout", low.pri == 1);
+
+    run(&low);
+    wire.release();
+    serial.release();
+    expect("low stays at its own priority after serial", low.pri == 1);
+}
+
+/*
+ * mid holds serial, lent high's priority by high waiting for it, and
+ * is handed wire by low: wire must not take the lent priority for mid's own
+ */
+static void handOffStep2(void)
+{
+    expect("low inherits high's priority down the chain", low.pri == 3);
+    run(&low);
+    wire.release();
+    expect("low drops to its own priority once wire is given", low.pri == 1);
+}
+
+static void handOffStep1(void)
+{
+    expect("mid inherits high's priority through serial", mid.pri == 3);
+    run(&mid);
+    whileWaiting = handOffStep2;
+    expect("mid gets wire", wire.acquire(100));
+    expect("mid keeps high's priority while high waits", mid.pri == 3);
+    serial.release();
+    expect("mid drops to its own priority once serial is given", mid.pri == 2);
+    wire.release();
+    expect("mid stays at its own priority after wire", mid.pri == 2);
+}
+
+static void handOff(void)
+{
+    run(&mid);
+    serial.acquire();
+    run(&low);
+    wire.acquire();
+
+    run(&high);
+    whileWaiting = handOffStep1;
+    expect("high gets serial", serial.acquire(100));
+    serial.release();
+}
+
+int main(void)
+{
+    outOfOrder();
+    timeout();
+    handOff();
+
+    expect("every bus is free", wire.owner() == NULL && serial.owner() == NULL);
+    expect("every task is back at its own priority",
+           low.pri == 1 && mid.pri == 2 && high.pri == 3);
+
+    return (failures != 0);
+}
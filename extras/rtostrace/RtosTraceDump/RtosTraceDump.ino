@@ -0,0 +1,50 @@
+/*
+  RtosTraceDump
+
+  Traces a few SPI transfers and a sketch span of its own, then writes
+  the ring on Serial once, for
+
+    rtostrace -b 115200 /dev/ttyACM0 > trace.json
+
+  Open trace.json in chrome://tracing or ui.perfetto.dev. Nothing else
+  may be printed on Serial once the dump starts.
+*/
+
+#include <SPI.h>
+#include <ti/runtime/wiring/RtosTrace.h>
+
+#define RUNS  20
+
+uint8_t buffer[32];
+int runs = 0;
+
+void setup() {
+  Serial.begin(115200);
+  SPI.begin();
+
+  RtosTrace.begin(256);
+}
+
+void loop() {
+  if (runs == RUNS) {
+    return;
+  }
+
+  RtosTrace.enter("fill");
+  for (unsigned i = 0; i < sizeof(buffer); i++) {
+    buffer[i] = runs + i;
+  }
+  RtosTrace.leave("fill");
+
+  SPI.beginTransaction(SPISettings(4000000, MSBFIRST, SPI_MODE0));
+  SPI.transfer(buffer, sizeof(buffer));
+  SPI.endTransaction();
+
+  RtosTrace.mark("run", runs);
+
+  if (++runs == RUNS) {
+    RtosTrace.stop();
+    RtosTrace.dump(Serial);
+  }
+  delay(10);
+}
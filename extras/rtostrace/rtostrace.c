@@ -0,0 +1,517 @@
+/*
+  rtostrace.c - host side decoder for RtosTrace.dump()
+
+  Reads a trace dump from a serial port on a Linux host, or from a
+  capture of one (a file, or a socket's output saved with nc), and
+  writes it as a Chrome trace: open the JSON in chrome://tracing or
+  ui.perfetto.dev to see tasks, interrupts, bus locks and driver calls
+  on one timeline. The longest spans of each kind are listed on stderr,
+  which is usually where a latency outlier shows first.
+
+    cc -O2 -o rtostrace rtostrace.c
+    ./rtostrace -b 921600 /dev/ttyACM0 > trace.json
+    nc 192.168.1.20 5000 > dump.bin; ./rtostrace dump.bin > trace.json
+
+  Options
+    -b baud   line speed, 115200 by default
+    -n count  spans listed per kind, 3 by default
+    -q        no list
+
+  RtosTraceDump/RtosTraceDump.ino records a few drivers and dumps the
+  ring on Serial.
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <termios.h>
+#include <unistd.h>
+
+/* same values as RtosTrace.h */
+#define RTOSTRACE_MAGIC         0x43525452
+#define RTOSTRACE_VERSION       1
+#define RTOSTRACE_EVENT_SIZE    16
+
+#define RTOSTRACE_TASK_SWITCH   1
+#define RTOSTRACE_SWI_BEGIN     2
+#define RTOSTRACE_SWI_END       3
+#define RTOSTRACE_HWI_BEGIN     4
+#define RTOSTRACE_HWI_END       5
+#define RTOSTRACE_MARK          8
+#define RTOSTRACE_BEGIN         9
+#define RTOSTRACE_END           10
+#define RTOSTRACE_LOCK_WAIT     11
+#define RTOSTRACE_LOCK_TAKEN    12
+#define RTOSTRACE_LOCK_RELEASE  13
+#define RTOSTRACE_SPI_BEGIN     14
+#define RTOSTRACE_I2C_BEGIN     16
+#define RTOSTRACE_UART_BEGIN    18
+#define RTOSTRACE_SOCKET_BEGIN  20
+#define RTOSTRACE_SOCKET_END    21
+
+/* Cortex-M exception numbers a Swi and an Hwi run in */
+#define EXC_PENDSV              14
+#define EXC_IRQ0                16
+
+#define MAX_NAMES               256
+#define MAX_OPEN                256
+#define MAX_KINDS               64
+#define KIND_NAME               64
+
+struct event {
+    double us;
+    int type;
+    int context;
+    unsigned arg;
+    uint32_t task;
+    uint32_t object;
+};
+
+struct label {
+    uint32_t address;
+    char text[32];
+};
+
+/* a _BEGIN waiting for its _END */
+struct span {
+    char name[KIND_NAME];
+    char thread[32];
+    uint32_t object;
+    double start;
+    unsigned arg;
+};
+
+/* the longest spans of one kind */
+struct kind {
+    char name[KIND_NAME];
+    unsigned long count;
+    double total;
+    double longest[16];
+    double at[16];
+};
+
+static struct label labels[MAX_NAMES];
+static int numLabels;
+static struct span pending[MAX_OPEN];
+static int numOpen;
+static struct kind kinds[MAX_KINDS];
+static int numKinds;
+static int listed = 3;
+static int firstJson = 1;
+
+static uint32_t u32(const uint8_t *p)
+{
+    return (p[0] | (p[1] << 8) | (p[2] << 16) | ((uint32_t)p[3] << 24));
+}
+
+static int readFully(int fd, void *buffer, size_t size)
+{
+    uint8_t *p = buffer;
+    ssize_t n;
+
+    while (size > 0) {
+        n = read(fd, p, size);
+        if (n <= 0) {
+            return (-1);
+        }
+        p += n;
+        size -= n;
+    }
+    return (0);
+}
+
+/* skips whatever the sketch printed before the dump */
+static int findMagic(int fd)
+{
+    uint32_t window = 0;
+    uint8_t b;
+
+    while (read(fd, &b, 1) == 1) {
+        window = (window >> 8) | ((uint32_t)b << 24);
+        if (window == RTOSTRACE_MAGIC) {
+            return (0);
+        }
+    }
+    return (-1);
+}
+
+static const char *labelOf(uint32_t address)
+{
+    static char hex[16];
+    int i;
+
+    for (i = 0; i < numLabels; i++) {
+        if (labels[i].address == address) {
+            return (labels[i].text);
+        }
+    }
+    snprintf(hex, sizeof(hex), "0x%08x", address);
+    return (hex);
+}
+
+static void threadOf(const struct event *e, char *thread, size_t size)
+{
+    if (e->context == 0) {
+        snprintf(thread, size, "task 0x%08x", e->task);
+    }
+    else if (e->context == EXC_PENDSV) {
+        snprintf(thread, size, "swi");
+    }
+    else if (e->context >= EXC_IRQ0) {
+        snprintf(thread, size, "irq %d", e->context - EXC_IRQ0);
+    }
+    else {
+        snprintf(thread, size, "exception %d", e->context);
+    }
+}
+
+static void jsonEvent(const char *name, const char *thread, double start, double duration,
+                      const char *args)
+{
+    printf("%s\n{\"name\":\"%s\",\"tid\":\"%s\",\"pid\":0,\"ts\":%.3f", firstJson ? "" : ",",
+           name, thread, start);
+    if (duration >= 0) {
+        printf(",\"ph\":\"X\",\"dur\":%.3f", duration);
+    }
+    else {
+        printf(",\"ph\":\"i\",\"s\":\"t\"");
+    }
+    if (args != NULL) {
+        printf(",\"args\":{%s}", args);
+    }
+    printf("}");
+    firstJson = 0;
+}
+
+static void account(const char *name, double start, double duration)
+{
+    struct kind *k;
+    int i, j;
+
+    for (i = 0; i < numKinds && strcmp(kinds[i].name, name) != 0; i++) {
+    }
+    if (i == numKinds) {
+        if (numKinds == MAX_KINDS) {
+            return;
+        }
+        memset(&kinds[i], 0, sizeof(kinds[i]));
+        snprintf(kinds[i].name, KIND_NAME, "%s", name);
+        numKinds++;
+    }
+    k = &kinds[i];
+    k->count++;
+    k->total += duration;
+
+    /* insertion into the few longest */
+    for (i = 0; i < listed && k->longest[i] >= duration; i++) {
+    }
+    if (i < listed) {
+        for (j = listed - 1; j > i; j--) {
+            k->longest[j] = k->longest[j - 1];
+            k->at[j] = k->at[j - 1];
+        }
+        k->longest[i] = duration;
+        k->at[i] = start;
+    }
+}
+
+static void spanBegin(const char *name, const char *thread, uint32_t object, double us, unsigned arg)
+{
+    if (numOpen == MAX_OPEN) {
+        return;
+    }
+    snprintf(pending[numOpen].name, KIND_NAME, "%s", name);
+    snprintf(pending[numOpen].thread, sizeof(pending[numOpen].thread), "%s", thread);
+    pending[numOpen].object = object;
+    pending[numOpen].start = us;
+    pending[numOpen].arg = arg;
+    numOpen++;
+}
+
+/* the latest matching begin, which makes nested spans of one kind pair up right */
+static void spanEnd(const char *name, const char *thread, uint32_t object, double us,
+                    const char *argName, int endArg)
+{
+    char args[96];
+    int i;
+
+    for (i = numOpen - 1; i >= 0; i--) {
+        if (pending[i].object == object && strcmp(pending[i].name, name) == 0 &&
+            strcmp(pending[i].thread, thread) == 0) {
+            break;
+        }
+    }
+    if (i < 0) {
+        return;     /* its begin was overwritten in the ring */
+    }
+
+    if (argName != NULL) {
+        snprintf(args, sizeof(args), "\"%s\":%u,\"result\":%d", argName, pending[i].arg, endArg);
+    }
+    jsonEvent(name, thread, pending[i].start, us - pending[i].start, argName != NULL ? args : NULL);
+    account(name, pending[i].start, us - pending[i].start);
+
+    numOpen--;
+    memmove(&pending[i], &pending[i + 1], (numOpen - i) * sizeof(pending[0]));
+}
+
+static void decodeEvent(const struct event *e)
+{
+    static uint32_t runningTask;
+    static double runningSince = -1;
+    char thread[32], name[KIND_NAME], args[64];
+    const char *label = labelOf(e->object);
+    int endArg = (int16_t)e->arg;
+
+    threadOf(e, thread, sizeof(thread));
+
+    switch (e->type) {
+        case RTOSTRACE_TASK_SWITCH:
+            if (runningSince >= 0) {
+                snprintf(thread, sizeof(thread), "task 0x%08x", runningTask);
+                jsonEvent("running", thread, runningSince, e->us - runningSince, NULL);
+            }
+            runningTask = e->object;
+            runningSince = e->us;
+            break;
+
+        case RTOSTRACE_SWI_BEGIN:
+        case RTOSTRACE_HWI_BEGIN:
+            snprintf(name, sizeof(name), "%s 0x%08x",
+                     e->type == RTOSTRACE_SWI_BEGIN ? "swi" : "hwi", e->object);
+            spanBegin(name, thread, e->object, e->us, 0);
+            break;
+
+        case RTOSTRACE_SWI_END:
+        case RTOSTRACE_HWI_END:
+            snprintf(name, sizeof(name), "%s 0x%08x",
+                     e->type == RTOSTRACE_SWI_END ? "swi" : "hwi", e->object);
+            spanEnd(name, thread, e->object, e->us, NULL, 0);
+            break;
+
+        case RTOSTRACE_MARK:
+            snprintf(args, sizeof(args), "\"value\":%u", e->arg);
+            jsonEvent(label, thread, e->us, -1, args);
+            break;
+
+        case RTOSTRACE_BEGIN:
+            spanBegin(label, thread, e->object, e->us, 0);
+            break;
+
+        case RTOSTRACE_END:
+            spanEnd(label, thread, e->object, e->us, NULL, 0);
+            break;
+
+        case RTOSTRACE_LOCK_WAIT:
+            snprintf(name, sizeof(name), "wait %s", label);
+            spanBegin(name, thread, e->object, e->us, 0);
+            break;
+
+        case RTOSTRACE_LOCK_TAKEN:
+            snprintf(name, sizeof(name), "wait %s", label);
+            spanEnd(name, thread, e->object, e->us, NULL, 0);
+            snprintf(name, sizeof(name), "hold %s", label);
+            spanBegin(name, thread, e->object, e->us, 0);
+            break;
+
+        case RTOSTRACE_LOCK_RELEASE:
+            snprintf(name, sizeof(name), "hold %s", label);
+            spanEnd(name, thread, e->object, e->us, NULL, 0);
+            break;
+
+        case RTOSTRACE_SPI_BEGIN:
+        case RTOSTRACE_I2C_BEGIN:
+        case RTOSTRACE_UART_BEGIN:
+            snprintf(name, sizeof(name), "%s transfer", label);
+            spanBegin(name, thread, e->object, e->us, e->arg);
+            break;
+
+        case RTOSTRACE_SPI_BEGIN + 1:
+        case RTOSTRACE_UART_BEGIN + 1:
+            snprintf(name, sizeof(name), "%s transfer", label);
+            spanEnd(name, thread, e->object, e->us, "bytes", endArg);
+            break;
+
+        case RTOSTRACE_I2C_BEGIN + 1:
+            snprintf(name, sizeof(name), "%s transfer", label);
+            spanEnd(name, thread, e->object, e->us, "address", endArg);
+            break;
+
+        case RTOSTRACE_SOCKET_BEGIN:
+            spanBegin(label, thread, e->object, e->us, e->arg);
+            break;
+
+        case RTOSTRACE_SOCKET_END:
+            spanEnd(label, thread, e->object, e->us, "socket", endArg);
+            break;
+
+        default:
+            break;
+    }
+}
+
+static speed_t baudConstant(long baud)
+{
+    switch (baud) {
+        case 115200:  return (B115200);
+        case 230400:  return (B230400);
+        case 460800:  return (B460800);
+        case 921600:  return (B921600);
+        case 1000000: return (B1000000);
+        case 1500000: return (B1500000);
+        case 2000000: return (B2000000);
+        case 3000000: return (B3000000);
+        default:      return (0);
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    uint8_t header[24], record[RTOSTRACE_EVENT_SIZE], len;
+    uint32_t cpuHz, shift, recorded, count, names, i, ticks, lastTicks = 0;
+    struct termios tio;
+    struct event e;
+    double usPerTick, us = 0;
+    long baud = 115200;
+    int fd, opt, quiet = 0, k, j;
+    speed_t speed;
+
+    while ((opt = getopt(argc, argv, "b:n:q")) != -1) {
+        switch (opt) {
+            case 'b': baud = strtol(optarg, NULL, 10); break;
+            case 'n': listed = atoi(optarg); break;
+            case 'q': quiet = 1; break;
+            default:
+                fprintf(stderr, "usage: %s [-b baud] [-n count] [-q] device|file\n", argv[0]);
+                return (2);
+        }
+    }
+    if (optind >= argc) {
+        fprintf(stderr, "usage: %s [-b baud] [-n count] [-q] device|file\n", argv[0]);
+        return (2);
+    }
+    if (listed < 1 || listed > 16) {
+        listed = 16;
+    }
+    speed = baudConstant(baud);
+    if (speed == 0) {
+        fprintf(stderr, "unsupported baud rate %ld\n", baud);
+        return (2);
+    }
+
+    fd = open(argv[optind], O_RDONLY | O_NOCTTY);
+    if (fd < 0) {
+        fprintf(stderr, "%s: %s\n", argv[optind], strerror(errno));
+        return (1);
+    }
+    /* a capture file is decoded as it is */
+    if (isatty(fd)) {
+        if (tcgetattr(fd, &tio) != 0) {
+            fprintf(stderr, "%s: %s\n", argv[optind], strerror(errno));
+            return (1);
+        }
+        cfmakeraw(&tio);
+        cfsetispeed(&tio, speed);
+        cfsetospeed(&tio, speed);
+        tio.c_cflag |= CLOCAL | CREAD;
+        tio.c_cc[VMIN] = 1;
+        tio.c_cc[VTIME] = 0;
+        tcsetattr(fd, TCSANOW, &tio);
+    }
+
+    if (findMagic(fd) != 0 || readFully(fd, header, sizeof(header)) != 0) {
+        fprintf(stderr, "no trace dump found\n");
+        return (1);
+    }
+    if ((u32(header) & 0xffff) != RTOSTRACE_VERSION || (u32(header) >> 16) != RTOSTRACE_EVENT_SIZE) {
+        fprintf(stderr, "trace version %u, event size %u not supported\n",
+                u32(header) & 0xffff, u32(header) >> 16);
+        return (1);
+    }
+    cpuHz = u32(header + 4);
+    shift = u32(header + 8);
+    recorded = u32(header + 12);
+    count = u32(header + 16);
+    names = u32(header + 20);
+    if (cpuHz == 0) {
+        fprintf(stderr, "bad header\n");
+        return (1);
+    }
+    usPerTick = (double)(1UL << shift) * 1e6 / cpuHz;
+
+    for (i = 0; i < names; i++) {
+        struct label l;
+
+        if (readFully(fd, header, 4) != 0 || readFully(fd, &len, 1) != 0 ||
+            len >= sizeof(l.text) || readFully(fd, l.text, len) != 0) {
+            fprintf(stderr, "truncated labels\n");
+            return (1);
+        }
+        l.address = u32(header);
+        l.text[len] = 0;
+        if (numLabels < MAX_NAMES) {
+            labels[numLabels++] = l;
+        }
+    }
+
+    printf("{\"displayTimeUnit\":\"ns\",\"traceEvents\":[");
+
+    for (i = 0; i < count; i++) {
+        if (readFully(fd, record, sizeof(record)) != 0) {
+            fprintf(stderr, "truncated after %u of %u events\n", i, count);
+            break;
+        }
+        ticks = u32(record);
+
+        /*
+         * slots are claimed before the time is read, so neighbours may be
+         * slightly out of order: the signed difference keeps them apart
+         */
+        if (i > 0) {
+            us += (int32_t)(ticks - lastTicks) * usPerTick;
+        }
+        lastTicks = ticks;
+
+        e.us = us;
+        e.type = record[4];
+        e.context = record[5];
+        e.arg = record[6] | (record[7] << 8);
+        e.task = u32(record + 8);
+        e.object = u32(record + 12);
+        decodeEvent(&e);
+    }
+
+    printf("\n]}\n");
+    close(fd);
+
+    fprintf(stderr, "%u events of %u recorded, %.3f ms, %.3f us per tick\n",
+            count, recorded, us / 1000, usPerTick);
+    if (!quiet) {
+        for (k = 0; k < numKinds; k++) {
+            fprintf(stderr, "%-24s %6lu  mean %10.3f us  longest", kinds[k].name, kinds[k].count,
+                    kinds[k].total / kinds[k].count);
+            for (j = 0; j < listed && j < (int)kinds[k].count; j++) {
+                fprintf(stderr, "  %.3f us at %.3f ms", kinds[k].longest[j], kinds[k].at[j] / 1000);
+            }
+            fprintf(stderr, "\n");
+        }
+    }
+    return (0);
+}
@@ -0,0 +1,32 @@
+/*
+  SerialFrameBench
+
+  Sends numbered frames on Serial as fast as the port takes them, to
+  measure a host link with
+
+    serialframe -q -b 921600 /dev/ttyACM0
+
+  Each payload starts with a 32-bit little endian sequence number, so
+  the host counts the frames that went missing.
+*/
+
+#define BAUD_RATE     921600
+#define PAYLOAD_SIZE  64
+
+uint8_t payload[PAYLOAD_SIZE];
+uint32_t sequence = 0;
+
+void setup() {
+  Serial.begin(BAUD_RATE);
+  Serial.setFraming(SERIAL_FRAME_COBS);
+
+  for (int i = 4; i < PAYLOAD_SIZE; i++) {
+    payload[i] = i;
+  }
+}
+
+void loop() {
+  memcpy(payload, &sequence, 4);
+  Serial.writeFrame(payload, PAYLOAD_SIZE);
+  sequence++;
+}
@@ -0,0 +1,316 @@
+/*
+  serialframe.c - host side decoder for HardwareSerial::writeFrame()
+
+  Reads frames from a serial port on a Linux host, or from a capture of
+  one, checks their CRC and prints once a second how many frames and
+  bytes went through, so the throughput of a link can be measured end
+  to end.
+
+    cc -O2 -o serialframe serialframe.c
+    ./serialframe -b 921600 /dev/ttyACM0
+
+  Options
+    -b baud   line speed, 921600 by default
+    -s        SLIP frames instead of COBS (Serial.setFraming(SERIAL_FRAME_SLIP))
+    -q        payloads start with a 32-bit little endian sequence number,
+              count the frames missing from it
+    -v        dump each payload in hex
+
+  SerialFrameBench/SerialFrameBench.ino sends numbered frames as fast as
+  the port takes them.
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <termios.h>
+#include <time.h>
+#include <unistd.h>
+
+#define FRAME_MAX       4096
+#define FRAME_CRC_SIZE  2
+
+#define SLIP_END        0xC0
+#define SLIP_ESC        0xDB
+#define SLIP_ESC_END    0xDC
+#define SLIP_ESC_ESC    0xDD
+
+struct decoder {
+    int slip;
+    int escape;
+    int discard;
+    uint8_t code;
+    uint8_t run;
+    size_t length;
+    uint8_t frame[FRAME_MAX];
+};
+
+struct counters {
+    unsigned long frames;
+    unsigned long payload;
+    unsigned long line;
+    unsigned long crcErrors;
+    unsigned long framingErrors;
+    unsigned long lost;
+};
+
+static int sequenced;
+static int verbose;
+static uint32_t nextSequence;
+static int haveSequence;
+
+/* same CRC-16/CCITT as HardwareSerial.cpp */
+static uint16_t frameCrc(const uint8_t *data, size_t size)
+{
+    uint16_t crc = 0xffff;
+    int bit;
+
+    while (size--) {
+        crc ^= (uint16_t)*data++ << 8;
+        for (bit = 0; bit < 8; bit++) {
+            crc = (crc & 0x8000) ? (crc << 1) ^ 0x1021 : crc << 1;
+        }
+    }
+    return (crc);
+}
+
+static void frameDone(struct decoder *d, struct counters *c)
+{
+    size_t payload, i;
+    uint32_t sequence;
+
+    if (d->discard || d->length < FRAME_CRC_SIZE) {
+        c->framingErrors++;
+        return;
+    }
+    payload = d->length - FRAME_CRC_SIZE;
+    if (frameCrc(d->frame, payload) !=
+        (d->frame[payload] | (d->frame[payload + 1] << 8))) {
+        c->crcErrors++;
+        return;
+    }
+
+    c->frames++;
+    c->payload += payload;
+
+    if (sequenced && payload >= 4) {
+        sequence = d->frame[0] | (d->frame[1] << 8) | (d->frame[2] << 16)
+            | ((uint32_t)d->frame[3] << 24);
+        if (haveSequence && sequence != nextSequence) {
+            c->lost += sequence - nextSequence;
+        }
+        nextSequence = sequence + 1;
+        haveSequence = 1;
+    }
+
+    if (verbose) {
+        printf("%4zu:", payload);
+        for (i = 0; i < payload; i++) {
+            printf(" %02x", d->frame[i]);
+        }
+        printf("\n");
+    }
+}
+
+static void frameReset(struct decoder *d)
+{
+    d->escape = 0;
+    d->discard = 0;
+    d->code = 0;
+    d->run = 0;
+    d->length = 0;
+}
+
+static void decode(struct decoder *d, struct counters *c, const uint8_t *data, size_t count)
+{
+    uint8_t b;
+    int end;
+
+    while (count--) {
+        b = *data++;
+        end = 0;
+
+        if (d->slip) {
+            if (b == SLIP_END) {
+                /* back to back ENDs are empty frames */
+                end = (d->length > 0 || d->discard);
+                if (!end) {
+                    continue;
+                }
+            }
+            else if (d->escape) {
+                d->escape = 0;
+                if (b == SLIP_ESC_END) {
+                    b = SLIP_END;
+                }
+                else if (b == SLIP_ESC_ESC) {
+                    b = SLIP_ESC;
+                }
+                else {
+                    d->discard = 1;
+                }
+            }
+            else if (b == SLIP_ESC) {
+                d->escape = 1;
+                continue;
+            }
+        }
+        else {
+            if (b == 0) {
+                end = (d->code != 0 || d->discard);
+                d->discard |= (d->run != 0);
+                if (!end) {
+                    continue;
+                }
+            }
+            else if (d->run == 0) {
+                int zero = (d->code != 0 && d->code != 0xff);
+                d->code = b;
+                d->run = b - 1;
+                if (!zero) {
+                    continue;
+                }
+                b = 0;
+            }
+            else {
+                d->run--;
+            }
+        }
+
+        if (end) {
+            frameDone(d, c);
+            frameReset(d);
+            continue;
+        }
+        if (d->length < FRAME_MAX) {
+            d->frame[d->length++] = b;
+        }
+        else {
+            d->discard = 1;
+        }
+    }
+}
+
+static speed_t baudConstant(long baud)
+{
+    switch (baud) {
+        case 115200:  return (B115200);
+        case 230400:  return (B230400);
+        case 460800:  return (B460800);
+        case 921600:  return (B921600);
+        case 1000000: return (B1000000);
+        case 1500000: return (B1500000);
+        case 2000000: return (B2000000);
+        case 3000000: return (B3000000);
+        default:      return (0);
+    }
+}
+
+static double now(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (ts.tv_sec + ts.tv_nsec / 1e9);
+}
+
+int main(int argc, char *argv[])
+{
+    static struct decoder d;
+    struct counters c, last;
+    struct termios tio;
+    uint8_t buffer[4096];
+    long baud = 921600;
+    double start, tick, t;
+    speed_t speed;
+    ssize_t n;
+    int fd, opt;
+
+    while ((opt = getopt(argc, argv, "b:sqv")) != -1) {
+        switch (opt) {
+            case 'b': baud = strtol(optarg, NULL, 10); break;
+            case 's': d.slip = 1; break;
+            case 'q': sequenced = 1; break;
+            case 'v': verbose = 1; break;
+            default:
+                fprintf(stderr, "usage: %s [-b baud] [-s] [-q] [-v] device\n", argv[0]);
+                return (2);
+        }
+    }
+    if (optind >= argc) {
+        fprintf(stderr, "usage: %s [-b baud] [-s] [-q] [-v] device\n", argv[0]);
+        return (2);
+    }
+    speed = baudConstant(baud);
+    if (speed == 0) {
+        fprintf(stderr, "unsupported baud rate %ld\n", baud);
+        return (2);
+    }
+
+    fd = open(argv[optind], O_RDONLY | O_NOCTTY);
+    if (fd < 0) {
+        fprintf(stderr, "%s: %s\n", argv[optind], strerror(errno));
+        return (1);
+    }
+    /* a capture file is decoded as it is */
+    if (isatty(fd)) {
+        if (tcgetattr(fd, &tio) != 0) {
+            fprintf(stderr, "%s: %s\n", argv[optind], strerror(errno));
+            return (1);
+        }
+        cfmakeraw(&tio);
+        cfsetispeed(&tio, speed);
+        cfsetospeed(&tio, speed);
+        tio.c_cflag |= CLOCAL | CREAD;
+        tio.c_cc[VMIN] = 1;
+        tio.c_cc[VTIME] = 1;
+        tcsetattr(fd, TCSANOW, &tio);
+        tcflush(fd, TCIFLUSH);
+    }
+
+    frameReset(&d);
+    memset(&c, 0, sizeof(c));
+    last = c;
+    start = tick = now();
+
+    while ((n = read(fd, buffer, sizeof(buffer))) > 0) {
+        c.line += n;
+        decode(&d, &c, buffer, n);
+
+        t = now();
+        if (t - tick >= 1.0) {
+            printf("%8.0f frames/s %9.0f payload B/s %9.0f line B/s"
+                   "  crc %lu  framing %lu  lost %lu\n",
+                   (c.frames - last.frames) / (t - tick),
+                   (c.payload - last.payload) / (t - tick),
+                   (c.line - last.line) / (t - tick),
+                   c.crcErrors, c.framingErrors, c.lost);
+            fflush(stdout);
+            last = c;
+            tick = t;
+        }
+    }
+
+    t = now();
+    printf("%lu frames, %lu payload bytes in %.1f s, crc %lu  framing %lu  lost %lu\n",
+           c.frames, c.payload, t - start, c.crcErrors, c.framingErrors, c.lost);
+    close(fd);
+    return (0);
+}
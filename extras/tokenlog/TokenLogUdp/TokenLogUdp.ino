@@ -0,0 +1,77 @@
+/*
+  TokenLogUdp
+
+  Logs an analog input every 10 ms without formatting anything on the
+  device, and sends the log as UDP packets to a host running
+
+    tokenlog -e TokenLogUdp.cpp.elf -u 5514
+
+  The .elf file is in Energia's build folder; it must come from the same
+  build as the firmware that runs.
+*/
+
+#ifndef __CC3200R1M1RGC__
+// Do not include SPI for CC3200 LaunchPad
+#include <SPI.h>
+#endif
+#include <WiFi.h>
+#include <ti/runtime/wiring/TokenLog.h>
+
+// your network name also called SSID
+char ssid[] = "energia";
+// your network password
+char password[] = "supersecret";
+
+// the host running tokenlog
+IPAddress logHost(192, 168, 1, 10);
+unsigned int logPort = 5514;
+
+WiFiUDP Udp;
+unsigned long count = 0;
+
+// called by the drain task with each packet
+void sendPacket(const uint8_t *packet, size_t size, void *arg) {
+  Udp.beginPacket(logHost, logPort);
+  Udp.write(packet, size);
+  Udp.endPacket();
+}
+
+void setup() {
+  Serial.begin(115200);
+
+  Serial.print("Attempting to connect to Network named: ");
+  Serial.println(ssid);
+  WiFi.begin(ssid, password);
+  while (WiFi.status() != WL_CONNECTED) {
+    Serial.print(".");
+    delay(300);
+  }
+  while (WiFi.localIP() == INADDR_NONE) {
+    Serial.print(".");
+    delay(300);
+  }
+  Serial.println("\nConnected, logging to UDP");
+
+  Udp.begin(logPort);
+  TokenLog.begin(sendPacket, NULL);
+
+  TOKENLOG("started, sending to port %u", logPort);
+}
+
+void loop() {
+  int value = analogRead(A0);
+
+  TOKENLOG("sample %lu: %d (%f V)", count, value, value * 1.46f / 4095);
+  if (value > 3000) {
+    TOKENLOG("over limit at %lu ms", millis());
+  }
+  count++;
+
+  if (count % 1000 == 0) {
+    TokenLogStats stats;
+
+    TokenLog.stats(stats);
+    TOKENLOG("%u logged, %u dropped, %u packets", stats.logged, stats.dropped, stats.packets);
+  }
+  delay(10);
+}
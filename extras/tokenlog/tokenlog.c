@@ -0,0 +1,567 @@
+/*
+  tokenlog.c - host side decoder for TokenLog
+
+  Reads the packets a TokenLog drain sends, as writeFrame() frames from a
+  serial port on a Linux host or a capture of one, or as UDP datagrams,
+  and prints the messages. The device only sends the address of each
+  format string; the strings are read from the sketch's .elf file, which
+  must be the one the running firmware was built from. Energia leaves it
+  in its build folder (shown with verbose output during compilation).
+
+    cc -O2 -o tokenlog tokenlog.c
+    ./tokenlog -e Sketch.cpp.elf -b 921600 /dev/ttyACM0
+    ./tokenlog -e Sketch.cpp.elf -u 5514
+
+  Options
+    -e elf    the firmware's .elf file, required
+    -b baud   line speed, 115200 by default
+    -s        SLIP frames instead of COBS (Serial.setFraming(SERIAL_FRAME_SLIP))
+    -u port   listen for UDP packets on port instead of reading a device
+
+  Each line is the time in seconds since the first message, then the
+  message. Records the device dropped for a full ring, and records lost
+  on the way (UDP), are reported where they happened.
+
+  TokenLogUdp/TokenLogUdp.ino sends its log over UDP.
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <termios.h>
+#include <unistd.h>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+
+#define FRAME_MAX       4096
+#define FRAME_CRC_SIZE  2
+
+#define SLIP_END        0xC0
+#define SLIP_ESC        0xDB
+#define SLIP_ESC_END    0xDC
+#define SLIP_ESC_ESC    0xDD
+
+/* as in TokenLog.h */
+#define TOKENLOG_MAGIC      0x4c54
+#define TOKENLOG_VERSION    1
+#define PACKET_HEADER_SIZE  16
+
+#define SHT_PROGBITS    1
+#define SHF_ALLOC       2
+
+struct section {
+    uint32_t addr;
+    uint32_t size;
+    const uint8_t *data;
+};
+
+struct decoder {
+    int slip;
+    int escape;
+    int discard;
+    uint8_t code;
+    uint8_t run;
+    size_t length;
+    uint8_t frame[FRAME_MAX];
+};
+
+static struct section *sections;
+static int numSections;
+static uint8_t *image;
+
+static uint32_t nextSequence;
+static uint32_t lastDropped;
+static uint32_t lastTime;
+static uint64_t elapsed;
+static int started;
+
+static unsigned long crcErrors;
+static unsigned long framingErrors;
+static unsigned long badPackets;
+
+static uint32_t getU16(const uint8_t *p)
+{
+    return (p[0] | (p[1] << 8));
+}
+
+static uint32_t getU32(const uint8_t *p)
+{
+    return (p[0] | (p[1] << 8) | (p[2] << 16) | ((uint32_t)p[3] << 24));
+}
+
+/* keeps the loaded sections of a little endian ELF32 file */
+static int loadElf(const char *path)
+{
+    const uint8_t *sh;
+    uint32_t shoff, offset, size;
+    uint16_t shentsize, shnum;
+    long length;
+    FILE *f;
+    int i;
+
+    f = fopen(path, "rb");
+    if (f == NULL) {
+        fprintf(stderr, "%s: %s\n", path, strerror(errno));
+        return (-1);
+    }
+    fseek(f, 0, SEEK_END);
+    length = ftell(f);
+    fseek(f, 0, SEEK_SET);
+    image = malloc(length);
+    if (image == NULL || fread(image, 1, length, f) != (size_t)length) {
+        fprintf(stderr, "%s: cannot read\n", path);
+        fclose(f);
+        return (-1);
+    }
+    fclose(f);
+
+    if (length < 52 || memcmp(image, "\177ELF", 4) != 0 || image[4] != 1 || image[5] != 1) {
+        fprintf(stderr, "%s: not a little endian 32-bit ELF file\n", path);
+        return (-1);
+    }
+    shoff = getU32(image + 0x20);
+    shentsize = getU16(image + 0x2e);
+    shnum = getU16(image + 0x30);
+    if (shentsize < 40 || (uint64_t)shoff + (uint64_t)shentsize * shnum > (uint64_t)length) {
+        fprintf(stderr, "%s: bad section headers\n", path);
+        return (-1);
+    }
+
+    sections = calloc(shnum, sizeof(struct section));
+    for (i = 0; i < shnum; i++) {
+        sh = image + shoff + i * shentsize;
+        offset = getU32(sh + 16);
+        size = getU32(sh + 20);
+        if (getU32(sh + 4) != SHT_PROGBITS || !(getU32(sh + 8) & SHF_ALLOC)
+            || (uint64_t)offset + size > (uint64_t)length) {
+            continue;
+        }
+        sections[numSections].addr = getU32(sh + 12);
+        sections[numSections].size = size;
+        sections[numSections].data = image + offset;
+        numSections++;
+    }
+    return (0);
+}
+
+/* the string at address in the firmware image, or NULL */
+static const char *imageString(uint32_t addr)
+{
+    const struct section *s;
+    uint32_t offset;
+    int i;
+
+    for (i = 0; i < numSections; i++) {
+        s = &sections[i];
+        if (addr < s->addr || addr - s->addr >= s->size) {
+            continue;
+        }
+        offset = addr - s->addr;
+        if (memchr(s->data + offset, 0, s->size - offset) == NULL) {
+            return (NULL);
+        }
+        return ((const char *)s->data + offset);
+    }
+    return (NULL);
+}
+
+/*
+ * Formats one record the way the device's printf would have: each
+ * conversion takes the next 32-bit argument, length modifiers are
+ * ignored, %f and friends take a float's bits, %s a string's address.
+ */
+static void printMessage(const char *format, const uint32_t *args, int count)
+{
+    char spec[32], *q;
+    const char *p, *s;
+    union { uint32_t u; float f; } bits;
+    uint32_t arg;
+    int next = 0;
+
+    for (p = format; *p != 0; p++) {
+        if (*p != '%') {
+            putchar(*p);
+            continue;
+        }
+        if (p[1] == '%') {
+            putchar('%');
+            p++;
+            continue;
+        }
+
+        q = spec;
+        *q++ = *p++;
+        while (*p != 0 && strchr("-+ #0123456789.", *p) != NULL && q < spec + sizeof(spec) - 2) {
+            *q++ = *p++;
+        }
+        while (*p != 0 && strchr("hlLqjzt", *p) != NULL) {
+            p++;
+        }
+        if (*p == 0) {
+            break;
+        }
+        if (next >= count) {
+            printf("<?>");
+            continue;
+        }
+        arg = args[next++];
+
+        switch (*p) {
+            case 'd': case 'i':
+                *q++ = 'd'; *q = 0;
+                printf(spec, (int)(int32_t)arg);
+                break;
+            case 'u': case 'o': case 'x': case 'X':
+                *q++ = *p; *q = 0;
+                printf(spec, (unsigned int)arg);
+                break;
+            case 'c':
+                *q++ = 'c'; *q = 0;
+                printf(spec, (int)arg);
+                break;
+            case 'f': case 'F': case 'e': case 'E': case 'g': case 'G': case 'a': case 'A':
+                bits.u = arg;
+                *q++ = *p; *q = 0;
+                printf(spec, (double)bits.f);
+                break;
+            case 's':
+                s = imageString(arg);
+                if (s != NULL) {
+                    *q++ = 's'; *q = 0;
+                    printf(spec, s);
+                }
+                else {
+                    printf("<0x%08x>", arg);
+                }
+                break;
+            case 'p':
+                printf("0x%08x", arg);
+                break;
+            default:
+                printf("<%%%c?>", *p);
+                break;
+        }
+    }
+    putchar('\n');
+}
+
+static void packetDone(const uint8_t *packet, size_t size)
+{
+    const uint8_t *p, *end = packet + size;
+    uint32_t tickHz, sequence, dropped, args[255];
+    uint32_t address, time;
+    const char *format;
+    int records, count, i;
+
+    if (size < PACKET_HEADER_SIZE || getU16(packet) != TOKENLOG_MAGIC
+        || packet[2] != TOKENLOG_VERSION) {
+        badPackets++;
+        return;
+    }
+    records = packet[3];
+    tickHz = getU32(packet + 4);
+    sequence = getU32(packet + 8);
+    dropped = getU32(packet + 12);
+
+    if (started && sequence != nextSequence) {
+        printf("-- %d records lost\n", (int32_t)(sequence - nextSequence));
+    }
+    if (dropped != lastDropped) {
+        printf("-- %u records dropped by the device\n", dropped - lastDropped);
+        lastDropped = dropped;
+    }
+    nextSequence = sequence + records;
+
+    p = packet + PACKET_HEADER_SIZE;
+    while (records-- > 0) {
+        if (p + 9 > end) {
+            badPackets++;
+            return;
+        }
+        address = getU32(p);
+        time = getU32(p + 4);
+        count = p[8];
+        p += 9;
+        if (p + 4 * count > end) {
+            badPackets++;
+            return;
+        }
+        for (i = 0; i < count; i++) {
+            args[i] = getU32(p + 4 * i);
+        }
+        p += 4 * count;
+
+        /* the tick counter wraps every few minutes; messages are closer than that */
+        if (started) {
+            elapsed += time - lastTime;
+        }
+        lastTime = time;
+        started = 1;
+
+        printf("%12.6f  ", tickHz ? (double)elapsed / tickHz : 0.0);
+        format = imageString(address);
+        if (format != NULL) {
+            printMessage(format, args, count);
+        }
+        else {
+            printf("<unknown format 0x%08x>", address);
+            for (i = 0; i < count; i++) {
+                printf(" 0x%08x", args[i]);
+            }
+            putchar('\n');
+        }
+    }
+    fflush(stdout);
+}
+
+/* same CRC-16/CCITT as HardwareSerial.cpp */
+static uint16_t frameCrc(const uint8_t *data, size_t size)
+{
+    uint16_t crc = 0xffff;
+    int bit;
+
+    while (size--) {
+        crc ^= (uint16_t)*data++ << 8;
+        for (bit = 0; bit < 8; bit++) {
+            crc = (crc & 0x8000) ? (crc << 1) ^ 0x1021 : crc << 1;
+        }
+    }
+    return (crc);
+}
+
+static void frameDone(struct decoder *d)
+{
+    size_t payload;
+
+    if (d->discard || d->length < FRAME_CRC_SIZE) {
+        framingErrors++;
+        return;
+    }
+    payload = d->length - FRAME_CRC_SIZE;
+    if (frameCrc(d->frame, payload) !=
+        (d->frame[payload] | (d->frame[payload + 1] << 8))) {
+        crcErrors++;
+        return;
+    }
+    packetDone(d->frame, payload);
+}
+
+static void frameReset(struct decoder *d)
+{
+    d->escape = 0;
+    d->discard = 0;
+    d->code = 0;
+    d->run = 0;
+    d->length = 0;
+}
+
+static void decode(struct decoder *d, const uint8_t *data, size_t count)
+{
+    uint8_t b;
+    int end;
+
+    while (count--) {
+        b = *data++;
+        end = 0;
+
+        if (d->slip) {
+            if (b == SLIP_END) {
+                /* back to back ENDs are empty frames */
+                end = (d->length > 0 || d->discard);
+                if (!end) {
+                    continue;
+                }
+            }
+            else if (d->escape) {
+                d->escape = 0;
+                if (b == SLIP_ESC_END) {
+                    b = SLIP_END;
+                }
+                else if (b == SLIP_ESC_ESC) {
+                    b = SLIP_ESC;
+                }
+                else {
+                    d->discard = 1;
+                }
+            }
+            else if (b == SLIP_ESC) {
+                d->escape = 1;
+                continue;
+            }
+        }
+        else {
+            if (b == 0) {
+                end = (d->code != 0 || d->discard);
+                d->discard |= (d->run != 0);
+                if (!end) {
+                    continue;
+                }
+            }
+            else if (d->run == 0) {
+                int zero = (d->code != 0 && d->code != 0xff);
+                d->code = b;
+                d->run = b - 1;
+                if (!zero) {
+                    continue;
+                }
+                b = 0;
+            }
+            else {
+                d->run--;
+            }
+        }
+
+        if (end) {
+            frameDone(d);
+            frameReset(d);
+            continue;
+        }
+        if (d->length < FRAME_MAX) {
+            d->frame[d->length++] = b;
+        }
+        else {
+            d->discard = 1;
+        }
+    }
+}
+
+static speed_t baudConstant(long baud)
+{
+    switch (baud) {
+        case 115200:  return (B115200);
+        case 230400:  return (B230400);
+        case 460800:  return (B460800);
+        case 921600:  return (B921600);
+        case 1000000: return (B1000000);
+        case 1500000: return (B1500000);
+        case 2000000: return (B2000000);
+        case 3000000: return (B3000000);
+        default:      return (0);
+    }
+}
+
+static int listenUdp(int port)
+{
+    uint8_t packet[FRAME_MAX];
+    struct sockaddr_in addr;
+    ssize_t n;
+    int fd;
+
+    fd = socket(AF_INET, SOCK_DGRAM, 0);
+    if (fd < 0) {
+        fprintf(stderr, "socket: %s\n", strerror(errno));
+        return (1);
+    }
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_ANY);
+    addr.sin_port = htons(port);
+    if (bind(fd, (struct sockaddr *)&addr, sizeof(addr)) != 0) {
+        fprintf(stderr, "port %d: %s\n", port, strerror(errno));
+        return (1);
+    }
+
+    while ((n = recv(fd, packet, sizeof(packet), 0)) >= 0) {
+        packetDone(packet, n);
+    }
+    close(fd);
+    return (0);
+}
+
+static void usage(const char *name)
+{
+    fprintf(stderr, "usage: %s -e elf [-b baud] [-s] device|file\n"
+                    "       %s -e elf -u port\n", name, name);
+}
+
+int main(int argc, char *argv[])
+{
+    static struct decoder d;
+    struct termios tio;
+    uint8_t buffer[4096];
+    const char *elf = NULL;
+    long baud = 115200;
+    int udpPort = 0;
+    speed_t speed;
+    ssize_t n;
+    int fd, opt;
+
+    while ((opt = getopt(argc, argv, "e:b:su:")) != -1) {
+        switch (opt) {
+            case 'e': elf = optarg; break;
+            case 'b': baud = strtol(optarg, NULL, 10); break;
+            case 's': d.slip = 1; break;
+            case 'u': udpPort = strtol(optarg, NULL, 10); break;
+            default:
+                usage(argv[0]);
+                return (2);
+        }
+    }
+    if (elf == NULL || (udpPort == 0 && optind >= argc)) {
+        usage(argv[0]);
+        return (2);
+    }
+    if (loadElf(elf) != 0) {
+        return (1);
+    }
+    if (udpPort != 0) {
+        return (listenUdp(udpPort));
+    }
+
+    speed = baudConstant(baud);
+    if (speed == 0) {
+        fprintf(stderr, "unsupported baud rate %ld\n", baud);
+        return (2);
+    }
+
+    fd = open(argv[optind], O_RDONLY | O_NOCTTY);
+    if (fd < 0) {
+        fprintf(stderr, "%s: %s\n", argv[optind], strerror(errno));
+        return (1);
+    }
+    /* a capture file is decoded as it is */
+    if (isatty(fd)) {
+        if (tcgetattr(fd, &tio) != 0) {
+            fprintf(stderr, "%s: %s\n", argv[optind], strerror(errno));
+            return (1);
+        }
+        cfmakeraw(&tio);
+        cfsetispeed(&tio, speed);
+        cfsetospeed(&tio, speed);
+        tio.c_cflag |= CLOCAL | CREAD;
+        tio.c_cc[VMIN] = 1;
+        tio.c_cc[VTIME] = 1;
+        tcsetattr(fd, TCSANOW, &tio);
+        tcflush(fd, TCIFLUSH);
+    }
+
+    frameReset(&d);
+    while ((n = read(fd, buffer, sizeof(buffer))) > 0) {
+        decode(&d, buffer, n);
+    }
+    close(fd);
+
+    if (crcErrors != 0 || framingErrors != 0 || badPackets != 0) {
+        fprintf(stderr, "crc %lu  framing %lu  bad packets %lu\n",
+                crcErrors, framingErrors, badPackets);
+    }
+    return (0);
+}
@@ -0,0 +1,81 @@
+/*
+ Benchmark.cpp - Micro-benchmark harness for Energia MT
+
+ This library is free software; you can redistribute it and/or
+ modify it under the terms of the GNU Lesser General Public
+ License as published by the Free Software Foundation; either
+ version 2.1 of the License, or (at your option) any later version.
+
+ This library is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ Lesser General Public License for more details.
+
+ You should have received a copy of the GNU Lesser General Public
+ License along with this library; if not, write to the Free Software
+ Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#include <xdc/runtime/Timestamp.h>
+#include <xdc/runtime/Types.h>
+#include "Benchmark.h"
+
+Benchmark::Benchmark(Print &out, unsigned long duration) : _out(out), _duration(duration)
+{
+    _opsPerSecond = 0;
+    _cyclesPerOp = 0;
+    _allocsPerOp = 0;
+}
+
+void Benchmark::run(const char *name, void (*fn)(void *), void *arg)
+{
+    Types_FreqHz freq;
+    Timestamp_getFreq(&freq);
+    uint64_t budget = (uint64_t)freq.lo * _duration / 1000;
+
+    //
+    // one call up front so lazy initialization and the first heap
+    // allocation of fn don't count against it
+    //
+    fn(arg);
+    uint32_t allocsBefore = allocationCount();
+
+    //
+    // calls are made in batches that double in size, so reading the
+    // timestamp costs next to nothing compared to what is measured,
+    // while a single batch stays well within the 32 bit timestamp
+    //
+    uint32_t batch = 1;
+    uint32_t calls = 0;
+    uint64_t cycles = 0;
+    while (cycles < budget) {
+        uint32_t start = Timestamp_get32();
+        for (uint32_t i = 0; i < batch; i++) {
+            fn(arg);
+        }
+        uint32_t elapsed = Timestamp_get32() - start;
+        cycles += elapsed;
+        calls += batch;
+        if (elapsed < budget / 16) {
+            batch <<= 1;
+        }
+    }
+
+    _allocsPerOp = allocationCounting() ?
+        (float)(allocationCount() - allocsBefore) / calls : -1;
+    _opsPerSecond = (uint64_t)calls * freq.lo / cycles;
+    _cyclesPerOp = (cycles * F_CPU / freq.lo + calls / 2) / calls;
+
+    _out.print(name);
+    _out.print(": ");
+    _out.print(_opsPerSecond);
+    _out.print(" ops/s, ");
+    _out.print(_cyclesPerOp);
+    _out.print(" cycles/op, ");
+    if (_allocsPerOp < 0) {
+        _out.println("allocs not counted");
+        return;
+    }
+    _out.print(_allocsPerOp, 2);
+    _out.println(" allocs/op");
+}
@@ -0,0 +1,73 @@
+/*
+ Benchmark.h - Micro-benchmark harness for Energia MT
+
+ Runs a function over and over for a fixed amount of time, timed with the
+ CPU cycle counter, and prints how many calls per second it managed, the
+ cycles each call took and how many heap allocations (malloc(), calloc(),
+ realloc() and operator new) each call made, if the link counts them:
+
+   void concat(void *arg) { String s("value="); s += 42; }
+
+   Benchmark bench(Serial);
+   bench.run("String concat", concat);
+
+ prints
+
+   String concat: 61512 ops/s, 1300 cycles/op, 3.00 allocs/op
+
+ Allocations are counted only when compiler.alloc_count.flags is set in
+ platform.local.txt (see platform.txt); otherwise the line ends with
+ "allocs not counted".
+
+ This library is free software; you can redistribute it and/or
+ modify it under the terms of the GNU Lesser General Public
+ License as published by the Free Software Foundation; either
+ version 2.1 of the License, or (at your option) any later version.
+
+ This library is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ Lesser General Public License for more details.
+
+ You should have received a copy of the GNU Lesser General Public
+ License along with this library; if not, write to the Free Software
+ Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#ifndef Benchmark_h
+#define Benchmark_h
+
+#include <Energia.h>
+
+#define BENCHMARK_DEFAULT_DURATION 1000   // ms spent on each run()
+
+class Benchmark {
+public:
+    Benchmark(Print &out, unsigned long duration = BENCHMARK_DEFAULT_DURATION);
+
+    /*
+     * Measure fn and print the result as a line on the output
+     *
+     * param name: label of the result line
+     * param fn: function to measure, called with arg
+     */
+    void run(const char *name, void (*fn)(void *), void *arg = NULL);
+
+    void setDuration(unsigned long duration) { _duration = duration; }
+
+    /*
+     * Results of the last run()
+     */
+    uint32_t opsPerSecond() { return _opsPerSecond; }
+    uint32_t cyclesPerOp() { return _cyclesPerOp; }
+    float allocsPerOp() { return _allocsPerOp; }   // -1 if not counted
+
+private:
+    Print &_out;
+    unsigned long _duration;
+    uint32_t _opsPerSecond;
+    uint32_t _cyclesPerOp;
+    float _allocsPerOp;
+};
+
+#endif
@@ -0,0 +1,166 @@
+/* Energia Benchmark example: CoreBenchmark
+ *
+ * Measures the hot paths of the Energia core on the board itself:
+ * String building, Print formatting, Stream parsing and the overhead
+ * of the pin, SPI and I2C driver wrappers. Each line reports calls per
+ * second, CPU cycles per call and heap allocations per call, so the
+ * output of two builds can be compared line by line.
+ *
+ * The I2C test reads the chip ID of the BMA222 accelerometer on the
+ * CC3200 LaunchPad; on other boards change BMA222_ADDR or drop the test.
+ *
+ * Complexity: low
+ */
+
+#include <Wire.h>
+#include <SPI.h>
+#include <PString.h>
+#include <Benchmark.h>
+
+#define BMA222_ADDR 0x18
+
+Benchmark bench(Serial);
+
+// A Stream reading the same text over and over, so parsing
+// never waits for the (timed) arrival of more input
+class TextStream : public Stream {
+public:
+  TextStream(const char *text) : _text(text), _pos(text) {}
+  void rewind() { _pos = _text; }
+  virtual int available() { return strlen(_pos); }
+  virtual int read() { return *_pos ? *_pos++ : -1; }
+  virtual int peek() { return *_pos ? *_pos : -1; }
+  virtual void flush() {}
+  virtual size_t write(uint8_t) { return 0; }
+private:
+  const char *_text;
+  const char *_pos;
+};
+
+TextStream sample("temp=23,hum=45.75;");
+char printBuffer[64];
+long counter;
+
+void stringConcat(void *arg)
+{
+  String s("temp=");
+  s += counter++;
+  s += ",hum=";
+  s += 45;
+  s += "%";
+}
+
+void stringReserved(void *arg)
+{
+  String s;
+  s.reserve(32);
+  s += "temp=";
+  s += counter++;
+  s += ",hum=";
+  s += 45;
+  s += "%";
+}
+
+void printInteger(void *arg)
+{
+  PString out(printBuffer, sizeof(printBuffer));
+  out.print(counter++);
+  out.print(',');
+  out.print(-1234567L);
+}
+
+void printHex(void *arg)
+{
+  PString out(printBuffer, sizeof(printBuffer));
+  out.print(0xDEADBEEFUL, HEX);
+}
+
+void printFloat(void *arg)
+{
+  PString out(printBuffer, sizeof(printBuffer));
+  out.print(3.14159f, 4);
+}
+
+void streamParseInt(void *arg)
+{
+  sample.rewind();
+  sample.parseInt();
+  sample.parseInt();
+}
+
+void streamParseFloat(void *arg)
+{
+  sample.rewind();
+  sample.parseFloat();
+  sample.parseFloat();
+}
+
+void pinWrite(void *arg)
+{
+  digitalWrite(RED_LED, counter++ & 1);
+}
+
+void pinRead(void *arg)
+{
+  digitalRead(PUSH1);
+}
+
+void adcRead(void *arg)
+{
+  analogRead(A0);
+}
+
+void spiTransfer(void *arg)
+{
+  SPI.transfer(0x55);
+}
+
+void i2cRead(void *arg)
+{
+  Wire.beginTransmission(BMA222_ADDR);
+  Wire.write(0x00);
+  Wire.endTransmission();
+  Wire.requestFrom(BMA222_ADDR, 1);
+  Wire.read();
+}
+
+void timeMillis(void *arg)
+{
+  millis();
+}
+
+void timeMicros(void *arg)
+{
+  micros();
+}
+
+void setup()
+{
+  Serial.begin(115200);
+  pinMode(RED_LED, OUTPUT);
+  pinMode(PUSH1, INPUT);
+  SPI.begin();
+  Wire.begin();
+  delay(1000);
+  Serial.println("Energia core benchmark");
+}
+
+void loop()
+{
+  bench.run("String concat", stringConcat);
+  bench.run("String concat, reserved", stringReserved);
+  bench.run("Print long", printInteger);
+  bench.run("Print HEX", printHex);
+  bench.run("Print float", printFloat);
+  bench.run("Stream parseInt", streamParseInt);
+  bench.run("Stream parseFloat", streamParseFloat);
+  bench.run("digitalWrite", pinWrite);
+  bench.run("digitalRead", pinRead);
+  bench.run("analogRead", adcRead);
+  bench.run("SPI.transfer", spiTransfer);
+  bench.run("Wire register read", i2cRead);
+  bench.run("millis", timeMillis);
+  bench.run("micros", timeMicros);
+  Serial.println();
+  delay(5000);
+}
@@ -0,0 +1,105 @@
+/*
+ benchmark_host.cpp - runs the CoreBenchmark sketch on a host
+
+ Builds Benchmark, the core String, Print and Stream code and the real
+ HardwareSerial, SPIClass, TwoWire, BusLock and pin code with the
+ sketch. Only the kernel and the TI drivers underneath are stand-ins,
+ in benchmark_host_ti.cpp, so the numbers can be tracked in CI.
+ Allocations are counted by wrapping malloc(), calloc() and realloc(),
+ as compiler.alloc_count.flags does for a board link. From the
+ repository root:
+
+   W=cores/cc3200emt/ti/runtime/wiring V=variants/CC3200_LAUNCHXL
+   B=libraries/Benchmark
+   c++ -I. -I$W -I$W/cc3200 -I$V -I$B -isystem cores/cc3200emt \
+       -isystem system -isystem system/inc -isystem system/driverlib \
+       -DBOARD_CC3200_LAUNCHXL -Dxdc_target_types__=gnu/targets/arm/std.h \
+       -Dxdc_target_name__=M4F -Dxdc__nolocalstring=1 -DARDUINO=101 \
+       -DF_CPU=1000000000 -Wl,--wrap=malloc,--wrap=calloc,--wrap=realloc \
+       -o benchmark_host $B/extras/benchmark_host.cpp \
+       $B/extras/benchmark_host_ti.cpp $B/Benchmark.cpp \
+       $W/HardwareSerial.cpp $W/SPI.cpp $W/Wire.cpp $W/BusLock.cpp \
+       $W/new.cpp $W/PString.cpp $W/Print.cpp $W/PrintD.cpp $W/Stream.cpp \
+       $W/WString.cpp $W/itoa.c $V/SerialObjects.cpp $V/SpiObjects.cpp \
+       $V/WireObjects.cpp -x c $W/wiring_alloc.c -x c $W/wiring_digital.c \
+       -x c $V/pins.c
+   ./benchmark_host
+
+ The TI and driverlib headers are -isystem, the rest builds without
+ warnings. Each C file needs its own -x c: c++ applies it to the next
+ file only. The timestamp counts nanoseconds and F_CPU is 1 GHz, so
+ cycles/op reads as ns/op. The driver tests time the core's wrappers
+ down to the driver calls, which return at once; analogRead() is a
+ stand-in as well.
+ */
+
+#include <stdio.h>
+#include <time.h>
+
+#include <xdc/runtime/Timestamp.h>
+#include <xdc/runtime/Types.h>
+
+#include <Energia.h>
+#include <Wire.h>
+#include "Benchmark.h"
+
+extern "C" {
+
+xdc_Bits32 xdc_runtime_Timestamp_get32__E(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ((xdc_Bits32)(ts.tv_sec * 1000000000ULL + ts.tv_nsec));
+}
+
+xdc_Void xdc_runtime_Timestamp_getFreq__E(xdc_runtime_Types_FreqHz *freq)
+{
+    freq->hi = 0;
+    freq->lo = 1000000000;
+}
+
+void delay(uint32_t milliseconds) {}
+unsigned long millis(void) { return (xdc_runtime_Timestamp_get32__E() / 1000000); }
+unsigned long micros(void) { return (xdc_runtime_Timestamp_get32__E() / 1000); }
+
+}
+
+#include "../examples/CoreBenchmark/CoreBenchmark.ino"
+
+static int failures;
+
+static void expect(const char *what, bool ok)
+{
+    printf("%-56s %s\n", what, ok ? "ok" : "FAIL");
+    if (!ok) {
+        failures++;
+    }
+}
+
+int main(void)
+{
+    setup();
+    loop();
+
+    expect("the link counts allocations", allocationCounting());
+
+    /* the drivers got to the stand-ins */
+    digitalWrite(RED_LED, HIGH);
+    expect("digitalRead() reads what digitalWrite() wrote", digitalRead(RED_LED) == HIGH);
+    expect("SPI.transfer() returns the looped back byte", SPI.transfer(0xA5) == 0xA5);
+    Wire.beginTransmission(BMA222_ADDR);
+    Wire.write(0x00);
+    expect("Wire writes the register number", Wire.endTransmission() == 0);
+    expect("Wire reads one byte", Wire.requestFrom(BMA222_ADDR, 1) == 1);
+    expect("Wire reads the BMA222 chip ID", Wire.read() == 0xF8);
+
+    /* a short rerun of one test that allocates and one that must not */
+    bench.setDuration(100);
+    bench.run("String concat", stringConcat);
+    expect("String concat allocates", bench.allocsPerOp() >= 1);
+    bench.run("Print long", printInteger);
+    expect("Print into a PString does not allocate", bench.allocsPerOp() == 0);
+
+    return (failures != 0);
+}
@@ -0,0 +1,333 @@
+/*
+ benchmark_host_ti.cpp - the kernel and drivers under the host benchmark
+
+ Stand-ins for the TI-RTOS calls HardwareSerial, SPIClass, TwoWire,
+ BusLock and the pin code make, see benchmark_host.cpp. There is one
+ task and nothing ever waits: a semaphore is pended only once it has
+ been posted, an SPI transfer completes before it returns and an I2C
+ transfer is answered at once by a BMA222 whose chip ID register reads
+ 0xF8. The serial port writes to stdout.
+ */
+
+#include <stdio.h>
+#include <string.h>
+
+#include <ti/sysbios/BIOS.h>
+#include <ti/sysbios/knl/Task.h>
+#include <ti/sysbios/knl/Semaphore.h>
+#include <ti/sysbios/hal/Hwi.h>
+#include <xdc/runtime/Memory.h>
+
+#include <ti/drivers/bsp/Board.h>
+#include <ti/drivers/GPIO.h>
+#include <ti/drivers/Power.h>
+#include <ti/drivers/i2c/I2CCC3200.h>
+
+#include <inc/hw_types.h>
+#include <inc/hw_memmap.h>
+#include <inc/hw_ints.h>
+#include <driverlib/i2c.h>
+
+#include <RtosTrace.h>
+
+#define SEMAPHORES  8
+#define PINS        64
+#define BMA222_ADDR 0x18
+
+static int task;                /* Task_self() of the one task */
+static Ptr taskEnv;
+static Int taskPri = 1;
+
+static struct {
+    Semaphore_Handle handle;
+    int count;
+} semaphores[SEMAPHORES];
+
+static uint8_t memory[256];     /* Memory_alloc(), WireContext */
+static size_t memoryUsed;
+
+static unsigned int pins[PINS];
+
+static UART_Config uart;
+static SPI_Config spi;
+static SPI_Params spiParams;
+static I2C_Config i2c;
+static uint8_t i2cRegister;
+
+static const I2CCC3200_HWAttrs i2cHWAttrs = { I2CA0_BASE, INT_I2CA0, ~0U };
+
+static int *semaphoreCount(Semaphore_Handle handle)
+{
+    int i, free = -1;
+
+    for (i = 0; i < SEMAPHORES; i++) {
+        if (semaphores[i].handle == handle) {
+            return (&semaphores[i].count);
+        }
+        if (semaphores[i].handle == NULL && free < 0) {
+            free = i;
+        }
+    }
+    semaphores[free].handle = handle;
+    semaphores[free].count = 0;
+    return (&semaphores[free].count);
+}
+
+extern "C" {
+
+extern const I2C_Config I2C_config[];
+const I2C_Config I2C_config[] = {
+    { NULL, NULL, &i2cHWAttrs },
+    { NULL, NULL, NULL }
+};
+
+/* kernel */
+ti_sysbios_BIOS_ThreadType ti_sysbios_BIOS_getThreadType__E(void)
+{
+    return (BIOS_ThreadType_Task);
+}
+
+xdc_UInt ti_sysbios_family_arm_m3_Hwi_disableFxn__E(void) { return (0); }
+xdc_Void ti_sysbios_family_arm_m3_Hwi_restoreFxn__E(xdc_UInt key) {}
+
+xdc_Void ti_sysbios_hal_Hwi_Params__init__S(xdc_Ptr dst, const xdc_Void *src,
+                                            xdc_SizeT psz, xdc_SizeT isz)
+{
+}
+
+void ti_sysbios_hal_Hwi_construct(ti_sysbios_hal_Hwi_Struct *obj, xdc_Int intNum,
+                                  ti_sysbios_hal_Hwi_FuncPtr hwiFxn,
+                                  const ti_sysbios_hal_Hwi_Params *params,
+                                  xdc_runtime_Error_Block *eb)
+{
+}
+
+void ti_sysbios_hal_Hwi_destruct(ti_sysbios_hal_Hwi_Struct *obj) {}
+
+xdc_UInt ti_sysbios_knl_Task_disable__E(void) { return (0); }
+xdc_Void ti_sysbios_knl_Task_restore__E(xdc_UInt key) {}
+
+ti_sysbios_knl_Task_Handle ti_sysbios_knl_Task_self__E(void)
+{
+    return ((Task_Handle)&task);
+}
+
+xdc_Int ti_sysbios_knl_Task_getPri__E(ti_sysbios_knl_Task_Handle handle)
+{
+    return (taskPri);
+}
+
+xdc_UInt ti_sysbios_knl_Task_setPri__E(ti_sysbios_knl_Task_Handle handle, xdc_Int pri)
+{
+    Int old = taskPri;
+
+    taskPri = pri;
+    return (old);
+}
+
+xdc_Ptr ti_sysbios_knl_Task_getEnv__E(ti_sysbios_knl_Task_Handle handle)
+{
+    return (taskEnv);
+}
+
+xdc_Void ti_sysbios_knl_Task_setEnv__E(ti_sysbios_knl_Task_Handle handle, xdc_Ptr env)
+{
+    taskEnv = env;
+}
+
+xdc_Void ti_sysbios_knl_Semaphore_Params__init__S(xdc_Ptr dst, const xdc_Void *src,
+                                                  xdc_SizeT psz, xdc_SizeT isz)
+{
+}
+
+void ti_sysbios_knl_Semaphore_construct(ti_sysbios_knl_Semaphore_Struct *obj, xdc_Int count,
+                                        const ti_sysbios_knl_Semaphore_Params *params)
+{
+    *semaphoreCount(Semaphore_handle(obj)) = count;
+}
+
+void ti_sysbios_knl_Semaphore_destruct(ti_sysbios_knl_Semaphore_Struct *obj)
+{
+    int i;
+
+    for (i = 0; i < SEMAPHORES; i++) {
+        if (semaphores[i].handle == Semaphore_handle(obj)) {
+            semaphores[i].handle = NULL;
+        }
+    }
+}
+
+/* with a single task nobody else can post, so an empty semaphore times out */
+xdc_Bool ti_sysbios_knl_Semaphore_pend__E(ti_sysbios_knl_Semaphore_Handle sem, xdc_UInt32 timeout)
+{
+    int *count = semaphoreCount(sem);
+
+    if (*count > 0) {
+        (*count)--;
+        return (true);
+    }
+    return (false);
+}
+
+xdc_Void ti_sysbios_knl_Semaphore_post__E(ti_sysbios_knl_Semaphore_Handle sem)
+{
+    (*semaphoreCount(sem))++;
+}
+
+/* not the heap: the board's Memory_alloc() doesn't go through malloc() */
+xdc_Ptr xdc_runtime_Memory_alloc__E(xdc_runtime_IHeap_Handle heap, xdc_SizeT size,
+                                    xdc_SizeT align, xdc_runtime_Error_Block *eb)
+{
+    Ptr block;
+
+    memoryUsed = (memoryUsed + align - 1) & ~(align - 1);
+    if (memoryUsed + size > sizeof(memory)) {
+        return (NULL);
+    }
+    block = &memory[memoryUsed];
+    memoryUsed += size;
+    return (block);
+}
+
+/* power */
+void Power_setDependency(unsigned int resourceId) {}
+void Power_releaseDependency(unsigned int resourceId) {}
+void Power_setConstraint(unsigned int constraintId) {}
+void Power_releaseConstraint(unsigned int constraintId) {}
+
+/* UART */
+UART_Handle Board_openUART(UInt uartPortIndex, UART_Params *uartParams)
+{
+    return (&uart);
+}
+
+void UART_Params_init(UART_Params *params)
+{
+    memset(params, 0, sizeof(*params));
+}
+
+void UART_close(UART_Handle handle) {}
+
+int UART_write(UART_Handle handle, const void *buffer, size_t size)
+{
+    return (fwrite(buffer, 1, size, stdout));
+}
+
+int UART_read(UART_Handle handle, void *buffer, size_t size)
+{
+    return (0);
+}
+
+int UART_control(UART_Handle handle, unsigned int cmd, void *arg)
+{
+    if (cmd == UART_CMD_GETRXCOUNT) {
+        *(int *)arg = 0;
+        return (UART_STATUS_SUCCESS);
+    }
+    return (UART_STATUS_UNDEFINEDCMD);
+}
+
+/* SPI, looped back */
+SPI_Handle Board_openSPI(UInt spiPortIndex, SPI_Params *params)
+{
+    return (SPI_open(spiPortIndex, params));
+}
+
+SPI_Handle SPI_open(unsigned int index, SPI_Params *params)
+{
+    spiParams = *params;
+    return (&spi);
+}
+
+void SPI_Params_init(SPI_Params *params)
+{
+    memset(params, 0, sizeof(*params));
+}
+
+void SPI_close(SPI_Handle handle) {}
+
+bool SPI_transfer(SPI_Handle handle, SPI_Transaction *transaction)
+{
+    memmove(transaction->rxBuf, transaction->txBuf, transaction->count);
+    if (spiParams.transferCallbackFxn != NULL) {
+        spiParams.transferCallbackFxn(handle, transaction);
+    }
+    return (true);
+}
+
+/* I2C, with a BMA222 on the bus */
+I2C_Handle Board_openI2C(UInt i2cPortIndex, I2C_Params *i2cParams)
+{
+    return (&i2c);
+}
+
+Bool Board_initI2CPins(UInt i2cPortIndex)
+{
+    return (true);
+}
+
+void I2C_Params_init(I2C_Params *params)
+{
+    memset(params, 0, sizeof(*params));
+}
+
+void I2C_close(I2C_Handle handle) {}
+
+bool I2C_transfer(I2C_Handle handle, I2C_Transaction *transaction)
+{
+    uint8_t *rx = (uint8_t *)transaction->readBuf;
+    size_t i;
+
+    if (transaction->slaveAddress != BMA222_ADDR) {
+        return (false);
+    }
+    if (transaction->writeCount > 0) {
+        i2cRegister = ((uint8_t *)transaction->writeBuf)[0];
+    }
+    for (i = 0; i < transaction->readCount; i++) {
+        rx[i] = (i2cRegister + i == 0) ? 0xF8 : 0x00;
+    }
+    return (true);
+}
+
+/* the I2C slave registers TwoWire::begin(address) programs */
+void I2CSlaveInit(uint32_t ui32Base, uint8_t ui8SlaveAddr) {}
+void I2CSlaveDisable(uint32_t ui32Base) {}
+void I2CSlaveIntEnableEx(uint32_t ui32Base, uint32_t ui32IntFlags) {}
+void I2CSlaveIntDisableEx(uint32_t ui32Base, uint32_t ui32IntFlags) {}
+void I2CSlaveIntClearEx(uint32_t ui32Base, uint32_t ui32IntFlags) {}
+uint32_t I2CSlaveIntStatusEx(uint32_t ui32Base, bool bMasked) { return (0); }
+uint32_t I2CSlaveStatus(uint32_t ui32Base) { return (0); }
+uint32_t I2CSlaveDataGet(uint32_t ui32Base) { return (0); }
+void I2CSlaveDataPut(uint32_t ui32Base, uint8_t ui8Data) {}
+
+/* pins */
+void GPIO_setConfig(unsigned int index, GPIO_PinConfig pinConfig) {}
+
+unsigned int GPIO_read(unsigned int index)
+{
+    return (pins[index % PINS]);
+}
+
+void GPIO_write(unsigned int index, unsigned int value)
+{
+    pins[index % PINS] = value;
+}
+
+void disablePinInterrupt(uint8_t pin) {}
+void enablePinInterrupt(uint8_t pin) {}
+void stopAnalogWrite(uint8_t pin) {}
+void stopAnalogRead(uint8_t pin) {}
+
+/* the ADC driver isn't built: a reading is the pin's GPIO level */
+uint16_t analogRead(uint8_t pin)
+{
+    return (pins[pin % PINS]);
+}
+
+}
+
+/* never begun: its zero-initialized state records nothing */
+EventTrace::EventTrace() {}
+EventTrace RtosTrace;
+void EventTrace::record(uint8_t type, const void *object, uint16_t arg) {}
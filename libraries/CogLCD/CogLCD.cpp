@@ -31,6 +31,9 @@
 #define LCD_COMMAND 0
 #define LCD_DATA 1
 
+#define LCD_NO_ADDRESS 0xff	// the controller's address counter is unknown
+#define LCD_CLEAN 0xff		// _dirtyFrom when nothing changed
+
 CogLCD::CogLCD(uint8_t SI, uint8_t SCL, uint8_t RS, uint8_t CSB, uint8_t RST)
 {
 	this->SI = SI;
@@ -38,10 +41,37 @@ CogLCD::CogLCD(uint8_t SI, uint8_t SCL, uint8_t RS, uint8_t CSB, uint8_t RST)
 	this->RS = RS;
 	this->CSB = CSB;
 	this->RST = RST;
+
+	_displayfunction = 0;
+	_displaycontrol = 0;
+	_displaymode = 0;
+	_numlines = 2;
+	_currline = 0;
+
+	memset(_shadow, ' ', LCD_DDRAM_SIZE);
+	memset(_shown, ' ', LCD_DDRAM_SIZE);
+	_dirtyFrom = LCD_CLEAN;
+	_dirtyTo = 0;
+	_address = 0;
+	_lcdAddress = LCD_NO_ADDRESS;
+	_autoFlush = true;
+	_ready = 0;
 }
 
 void CogLCD::begin(uint8_t cols, uint8_t lines, uint8_t dotsize)
 {
+	/* each is given a millisecond, the power control ones need it */
+	static const uint8_t init[] = {
+		0x30, 0x30, 0x30,	/* Wakeup */
+		0x21,			/* Function Set: Instruction Table Select */
+		0x14,			/* Internal Oscillator Frequency */
+		0x56,			/* Power Control */
+		0x6D,			/* follower control */
+		0x70,			/* Contrast */
+		0x0c,			/* Auto-ident */
+		0x38			/* Function Set: 8bit/2lines */
+	};
+
 	if (lines > 1) {
 	_displayfunction |= LCD_2LINE;
 	}
@@ -64,31 +94,20 @@ void CogLCD::begin(uint8_t cols, uint8_t lines, uint8_t dotsize)
 	digitalWrite(RST, HIGH);
 	pinMode(RS, OUTPUT);
 
-	/* Wakeup */
-	send(LCD_COMMAND, 0x30);
-	delay(2);
-	send(LCD_COMMAND, 0x30);
-	send(LCD_COMMAND, 0x30);
-
-	/* Function Set: Instruction Table Select */
-	send(LCD_COMMAND, 0x21);
-	/* Internal Oscillator Frequency */
-	send(LCD_COMMAND, 0x14);
-	/* Power Control */
-	send(LCD_COMMAND, 0x56);
-	/* follower control */
-	send(LCD_COMMAND, 0x6D);
-	/* Contrast */
-	send(LCD_COMMAND, 0x70);
-	/* Auto-ident */
-	send(LCD_COMMAND, 0x0c);
-	/* Function Set: 8bit/2lines */
-	send(LCD_COMMAND, 0x38);
+	for (unsigned int i = 0; i < sizeof(init); i++) {
+		send(LCD_COMMAND, init[i]);
+		delay(i == 0 ? 3 : 1);
+	}
+	_displaycontrol = LCD_DISPLAYON;
 
 	/* Left to Right */
+	_displaymode = 0;
 	leftToRight();
-	/* Clear */
+	/* Clear, the display and the copy */
+	bool autoFlush = _autoFlush;
+	_autoFlush = true;
 	clear();
+	_autoFlush = autoFlush;
 	/* Display on */
 	display();
 	/* Line 1 column 0 */
@@ -97,27 +116,188 @@ void CogLCD::begin(uint8_t cols, uint8_t lines, uint8_t dotsize)
 
 void CogLCD::send(uint8_t mode, uint8_t data)
 {
+	wait();
 	digitalWrite(CSB, LOW);
 	digitalWrite(RS, mode);
 	SPI.transfer(data);
 	digitalWrite(CSB, HIGH);
-	delay(1);
+	_ready = micros() + LCD_EXEC_US;
+}
+
+// Waits until the controller has executed the last byte sent
+void CogLCD::wait()
+{
+	long left = (long)(_ready - micros());
+
+	if (left >= 1000) {
+		delay(left / 1000);	// other tasks run during a clear
+	}
+	while ((long)(_ready - micros()) > 0) {
+	}
+}
+
+// Position in the copy of a display RAM address, and back
+uint8_t CogLCD::index(uint8_t address)
+{
+	if (_numlines == 1) {
+		return address;
+	}
+	return (address & 0x40 ? 40 : 0) + (address & 0x3f);
+}
+
+uint8_t CogLCD::address(uint8_t index)
+{
+	if (_numlines == 1 || index < 40) {
+		return index;
+	}
+	return 0x40 + index - 40;
+}
+
+// The address after one written at address, wrapping like the controller
+uint8_t CogLCD::step(uint8_t address, bool increment)
+{
+	uint8_t i = index(address);
+
+	if (increment) {
+		i = i == LCD_DDRAM_SIZE - 1 ? 0 : i + 1;
+	} else {
+		i = i == 0 ? LCD_DDRAM_SIZE - 1 : i - 1;
+	}
+	return this->address(i);
+}
+
+// Writes value into the copy at the cursor and moves the cursor
+void CogLCD::put(uint8_t value)
+{
+	uint8_t i = index(_address);
+
+	_shadow[i] = value;
+	if (_dirtyFrom == LCD_CLEAN) {
+		_dirtyFrom = _dirtyTo = i;
+	} else if (i < _dirtyFrom) {
+		_dirtyFrom = i;
+	} else if (i > _dirtyTo) {
+		_dirtyTo = i;
+	}
+	_address = step(_address, _displaymode & LCD_ENTRYLEFT);
+}
+
+size_t CogLCD::write(uint8_t value) {
+	if (_displaymode & LCD_ENTRYSHIFTINCREMENT) {
+		// every character written shifts the display, none may be skipped
+		uint8_t i = index(_address);
+		if (_lcdAddress != _address) {
+			send(LCD_COMMAND, LCD_SETDDRAMADDR | _address);
+		}
+		send(LCD_DATA, value);
+		_shadow[i] = _shown[i] = value;
+		_address = _lcdAddress = step(_address, _displaymode & LCD_ENTRYLEFT);
+		return 1;
+	}
+
+	put(value);
+	if (_autoFlush) {
+		flush();
+	}
+	return 1;
+}
+
+size_t CogLCD::write(const uint8_t *buffer, size_t size) {
+	if (_displaymode & LCD_ENTRYSHIFTINCREMENT) {
+		return Print::write(buffer, size);
+	}
+
+	for (size_t n = 0; n < size; n++) {
+		put(buffer[n]);
+	}
+	if (_autoFlush) {
+		flush();
+	}
+	return size;
+}
+
+// Sends the characters that changed since the last flush, each run of
+// them after one set-address command
+void CogLCD::flush()
+{
+	bool reverse = !(_displaymode & LCD_ENTRYLEFT);
+
+	if (_dirtyFrom != LCD_CLEAN) {
+		// runs are sent left to right
+		if (reverse) {
+			send(LCD_COMMAND, LCD_ENTRYMODESET | _displaymode | LCD_ENTRYLEFT);
+		}
+		for (uint8_t i = _dirtyFrom; i <= _dirtyTo; i++) {
+			if (_shadow[i] == _shown[i]) {
+				continue;
+			}
+			uint8_t a = address(i);
+			if (_lcdAddress != a) {
+				send(LCD_COMMAND, LCD_SETDDRAMADDR | a);
+			}
+			send(LCD_DATA, _shadow[i]);
+			_shown[i] = _shadow[i];
+			_lcdAddress = step(a, true);
+		}
+		if (reverse) {
+			send(LCD_COMMAND, LCD_ENTRYMODESET | _displaymode);
+		}
+		_dirtyFrom = LCD_CLEAN;
+	}
+
+	// a visible cursor shows where the next character goes
+	if ((_displaycontrol & (LCD_CURSORON | LCD_BLINKON)) && _lcdAddress != _address) {
+		send(LCD_COMMAND, LCD_SETDDRAMADDR | _address);
+		_lcdAddress = _address;
+	}
+}
+
+void CogLCD::autoFlush()
+{
+	_autoFlush = true;
+	flush();
 }
 
-inline size_t CogLCD::write(uint8_t value) {
-	send(LCD_DATA, value);
+void CogLCD::noAutoFlush()
+{
+	_autoFlush = false;
+}
+
+void CogLCD::command(uint8_t value)
+{
+	send(LCD_COMMAND, value);
+	_lcdAddress = LCD_NO_ADDRESS;
 }
 
 void CogLCD::clear()
 {
+	memset(_shadow, ' ', LCD_DDRAM_SIZE);
+	_address = 0;
+
+	if (!_autoFlush && !(_displaymode & LCD_ENTRYSHIFTINCREMENT)) {
+		// the differences are sent by flush(), a scrolled display stays so
+		_dirtyFrom = 0;
+		_dirtyTo = LCD_DDRAM_SIZE - 1;
+		return;
+	}
+
 	send(LCD_COMMAND, LCD_CLEARDISPLAY);  // clear display, set cursor position to zero
-	delayMicroseconds(2000);  // this command takes a long time!
+	_ready = micros() + LCD_CLEAR_US;  // this command takes a long time!
+	memset(_shown, ' ', LCD_DDRAM_SIZE);
+	_dirtyFrom = LCD_CLEAN;
+	_lcdAddress = 0;
+
+	// clearing also sets left to right
+	if (!(_displaymode & LCD_ENTRYLEFT)) {
+		send(LCD_COMMAND, LCD_ENTRYMODESET | _displaymode);
+	}
 }
 
 void CogLCD::home()
 {
 	send(LCD_COMMAND, LCD_RETURNHOME);  // set cursor position to zero
-	delayMicroseconds(2000);  // this command takes a long time!
+	_ready = micros() + LCD_CLEAR_US;  // this command takes a long time!
+	_address = _lcdAddress = 0;
 }
 
 // Turn the display on/off (quickly)
@@ -139,6 +319,9 @@ void CogLCD::noCursor() {
 void CogLCD::cursor() {
 	_displaycontrol |= LCD_CURSORON;
 	send(LCD_COMMAND, LCD_DISPLAYCONTROL | _displaycontrol);
+	if (_autoFlush) {
+		flush();
+	}
 }
 
 // Turn on and off the blinking cursor
@@ -149,6 +332,9 @@ void CogLCD::noBlink() {
 void CogLCD::blink() {
 	_displaycontrol |= LCD_BLINKON;
 	send(LCD_COMMAND, LCD_DISPLAYCONTROL | _displaycontrol);
+	if (_autoFlush) {
+		flush();
+	}
 }
 
 // These commands scroll the display without changing the RAM
@@ -173,6 +359,8 @@ void CogLCD::rightToLeft(void) {
 
 // This will 'right justify' text from the cursor
 void CogLCD::autoscroll(void) {
+	// characters still in the copy are written before the display shifts
+	flush();
 	_displaymode |= LCD_ENTRYSHIFTINCREMENT;
 	send(LCD_COMMAND, LCD_ENTRYMODESET | _displaymode);
 }
@@ -189,7 +377,12 @@ void CogLCD::createChar(uint8_t location, uint8_t charmap[]) {
 	location &= 0x7; // we only have 8 locations 0-7
 	send(LCD_COMMAND, LCD_SETCGRAMADDR | (location << 3));
 	for (int i=0; i<8; i++) {
-		write(charmap[i]);
+		send(LCD_DATA, charmap[i]);
+	}
+	// the address counter now points into CGRAM
+	_lcdAddress = LCD_NO_ADDRESS;
+	if (_autoFlush) {
+		flush();
 	}
 }
 
@@ -199,7 +392,18 @@ void CogLCD::setCursor(uint8_t col, uint8_t row)
 	if ( row >= _numlines ) {
 		row = _numlines-1;    // we count rows starting w/0
 	}
+	if ( row > 3 ) {
+		row = 3;
+	}
 
-	send(LCD_COMMAND, LCD_SETDDRAMADDR | (col + row_offsets[row]));
+	// stay inside the line's display RAM
+	if (_numlines == 1) {
+		_address = col < LCD_DDRAM_SIZE ? col : LCD_DDRAM_SIZE - 1;
+	} else {
+		int at = (row_offsets[row] & 0x3f) + col;
+		_address = (row_offsets[row] & 0x40) + (at < 40 ? at : 39);
+	}
+	if (_autoFlush) {
+		flush();
+	}
 }
-
@@ -64,6 +64,25 @@
 #define LCD_5x10DOTS 0x04
 #define LCD_5x8DOTS 0x00
 
+// the controller's display data RAM: two lines of 40, or one of 80
+#define LCD_DDRAM_SIZE 80
+
+// execution times, from the ST7036 data sheet with some margin
+#define LCD_EXEC_US 30
+#define LCD_CLEAR_US 2000
+
+/*
+ * The characters written are kept in a copy of the display RAM and only
+ * the characters that differ from what the display shows are sent,
+ * starting each run of them with one set-address command. Each byte
+ * waits for the previous one's execution time instead of a fixed sleep.
+ *
+ * By default every print() is sent at once. After noAutoFlush(),
+ * print(), setCursor() and clear() only change the copy, and flush()
+ * sends the differences, so redrawing a screen whose text barely
+ * changes costs a few bytes and never flickers.
+ */
+
 class CogLCD : public Print {
 public:
 	CogLCD(uint8_t SI, uint8_t SCL, uint8_t RS, uint8_t CSB, uint8_t RST);
@@ -87,6 +106,11 @@ public:
 	void createChar(uint8_t, uint8_t[]);
 	void setCursor(uint8_t, uint8_t); 
 	virtual size_t write(uint8_t);
+	virtual size_t write(const uint8_t *buffer, size_t size);
+
+	void flush();
+	void autoFlush();
+	void noAutoFlush();
 
 	void command(uint8_t);
 
@@ -101,4 +125,18 @@ private:
 	uint8_t _displaycontrol;
 	uint8_t _displaymode;
 	uint8_t _numlines,_currline;
+
+	uint8_t _shadow[LCD_DDRAM_SIZE];	// what the display should show
+	uint8_t _shown[LCD_DDRAM_SIZE];		// what it shows
+	uint8_t _dirtyFrom, _dirtyTo;		// range of _shadow changed since the last flush
+	uint8_t _address;			// cursor, as a display RAM address
+	uint8_t _lcdAddress;			// the controller's address counter, or LCD_NO_ADDRESS
+	bool _autoFlush;
+	unsigned long _ready;			// micros() when the controller takes the next byte
+
+	void wait();
+	uint8_t index(uint8_t address);
+	uint8_t address(uint8_t index);
+	uint8_t step(uint8_t address, bool increment);
+	void put(uint8_t value);
 };
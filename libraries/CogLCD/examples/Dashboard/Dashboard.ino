@@ -0,0 +1,58 @@
+/*
+  CogLCD Library - Dashboard
+ 
+ Demonstrates buffered updates of a 16x2 display.
+ 
+ With noAutoFlush(), clear(), setCursor() and print() only change the
+ library's copy of the screen. flush() then sends just the characters
+ that differ from what the display shows, so the whole screen can be
+ redrawn on every pass without flicker, and typically only the few
+ digits that changed are sent. The time the flush took is shown on
+ the second line.
+ 
+ The circuit:
+ * LCD RS pin to digital pin 12
+ * LCD Enable pin to digital pin 13
+ * LCD Reset pin to digital pin 11
+ * LCD Data pin to digital pin 15
+ * LCD Clock pin to digital pin 7
+ 
+ This example code is in the public domain.
+ */
+#include <SPI.h>
+#include <CogLCD.h>
+
+#define LCD_CSB 13
+#define LCD_RS 12
+#define LCD_RST 11
+#define LCD_SI 15
+#define LCD_SCL 7
+
+// initialize the library with the numbers of the interface pins
+CogLCD lcd(LCD_SI, LCD_SCL, LCD_RS, LCD_CSB, LCD_RST);
+
+unsigned long flushTime = 0;
+
+void setup() {
+  // set up the LCD's number of columns and rows: 
+  lcd.begin(16, 2);
+  lcd.noAutoFlush();
+}
+
+void loop() {
+  // redraw everything, only the copy changes
+  lcd.clear();
+  lcd.print("Uptime ");
+  lcd.print(millis() / 1000);
+  lcd.print(" s");
+  lcd.setCursor(0, 1);
+  lcd.print("flush ");
+  lcd.print(flushTime);
+  lcd.print(" us");
+
+  unsigned long start = micros();
+  lcd.flush();
+  flushTime = micros() - start;
+
+  delay(100);
+}
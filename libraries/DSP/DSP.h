@@ -0,0 +1,186 @@
+/*
+ DSP.h - Fixed-point signal processing for Energia MT
+
+ Filters, FFT, statistics and trig on Q15 and Q31 data, for samples from
+ the ADC, I2S or sensors, without floating point:
+
+   q15_t coeffs[TAPS] = { ... };
+   q15_t state[TAPS + BLOCK - 1];
+   dsp_fir_q15_t fir;
+
+   dsp_fir_q15_init(&fir, TAPS, coeffs, state, BLOCK);
+   dsp_fir_q15(&fir, samples, filtered, BLOCK);
+
+ A Q15 is an int16_t holding a value in [-1, 1) scaled by 32768, a Q31 an
+ int32_t scaled by 2^31. DSP_Q15(0.5) and DSP_Q31(0.5) convert constants
+ at compile time. Results are saturated, not wrapped.
+
+ On the Cortex-M4 the kernels use its DSP instructions (SMLAD, SMLALD,
+ SHADD16, QADD16, SSAT, ...), two Q15 values at a time. Built for any
+ other target they fall back to plain C with the same results, so
+ extras/dsp_host.c can check the accuracy and speed on a host.
+
+ This library is free software; you can redistribute it and/or
+ modify it under the terms of the GNU Lesser General Public
+ License as published by the Free Software Foundation; either
+ version 2.1 of the License, or (at your option) any later version.
+
+ This library is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ Lesser General Public License for more details.
+
+ You should have received a copy of the GNU Lesser General Public
+ License along with this library; if not, write to the Free Software
+ Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#ifndef DSP_h
+#define DSP_h
+
+#include <stdint.h>
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef int16_t q15_t;
+typedef int32_t q31_t;
+
+#define DSP_Q15(x) ((q15_t)((x) >= 0.99997 ? 32767 : (x) * 32768.0 + ((x) >= 0 ? 0.5 : -0.5)))
+#define DSP_Q31(x) ((q31_t)((x) >= 0.9999999995 ? 0x7fffffff : (x) * 2147483648.0 + ((x) >= 0 ? 0.5 : -0.5)))
+
+/* largest FFT, also the resolution of the trig table */
+#define DSP_FFT_MAX_SIZE    1024
+
+/*
+ * FIR filters
+ *
+ * coeffs are in time reversed order, coeffs[taps - 1] applies to the
+ * newest sample. state holds taps + blockSize - 1 values and must be
+ * zeroed before the first block; dsp_fir_*_init() does so. Each call
+ * filters at most blockSize samples.
+ */
+typedef struct {
+    uint16_t taps;
+    uint16_t blockSize;
+    const q15_t *coeffs;
+    q15_t *state;
+} dsp_fir_q15_t;
+
+typedef struct {
+    uint16_t taps;
+    uint16_t blockSize;
+    const q31_t *coeffs;
+    q31_t *state;
+} dsp_fir_q31_t;
+
+void dsp_fir_q15_init(dsp_fir_q15_t *fir, uint16_t taps, const q15_t *coeffs,
+    q15_t *state, uint16_t blockSize);
+void dsp_fir_q15(dsp_fir_q15_t *fir, const q15_t *src, q15_t *dst, size_t count);
+
+void dsp_fir_q31_init(dsp_fir_q31_t *fir, uint16_t taps, const q31_t *coeffs,
+    q31_t *state, uint16_t blockSize);
+void dsp_fir_q31(dsp_fir_q31_t *fir, const q31_t *src, q31_t *dst, size_t count);
+
+/*
+ * Low pass filters count samples and keeps every factor-th output, the
+ * only ones computed. count must be a multiple of factor; dst receives
+ * count / factor samples.
+ */
+void dsp_fir_decimate_q15(dsp_fir_q15_t *fir, uint8_t factor,
+    const q15_t *src, q15_t *dst, size_t count);
+
+/*
+ * Biquad IIR filters, direct form 1, in cascaded stages
+ *
+ * Each stage has 5 coefficients { b0, b1, b2, a1, a2 } for
+ *   y[n] = b0 x[n] + b1 x[n-1] + b2 x[n-2] + a1 y[n-1] + a2 y[n-2]
+ * that is with a1 and a2 negated from the usual transfer function.
+ * Coefficients are scaled down by 2^postShift so that they fit, e.g.
+ * postShift = 1 for coefficients in [-2, 2). state holds 4 values a
+ * stage and must be zeroed before the first sample; init does so.
+ */
+typedef struct {
+    uint8_t stages;
+    uint8_t postShift;
+    const q15_t *coeffs;
+    q15_t *state;
+} dsp_biquad_q15_t;
+
+typedef struct {
+    uint8_t stages;
+    uint8_t postShift;
+    const q31_t *coeffs;
+    q31_t *state;
+} dsp_biquad_q31_t;
+
+void dsp_biquad_q15_init(dsp_biquad_q15_t *iir, uint8_t stages, const q15_t *coeffs,
+    q15_t *state, uint8_t postShift);
+void dsp_biquad_q15(dsp_biquad_q15_t *iir, const q15_t *src, q15_t *dst, size_t count);
+
+void dsp_biquad_q31_init(dsp_biquad_q31_t *iir, uint8_t stages, const q31_t *coeffs,
+    q31_t *state, uint8_t postShift);
+void dsp_biquad_q31(dsp_biquad_q31_t *iir, const q31_t *src, q31_t *dst, size_t count);
+
+/*
+ * Radix-4 FFT
+ *
+ * data holds size complex values, real then imaginary, and is transformed
+ * in place. size is 16, 64, 256 or 1024. Each of the log4(size) stages
+ * divides by 4 so nothing can overflow: the result is the DFT divided by
+ * size. Returns -1 for any other size.
+ */
+int dsp_cfft_q15(q15_t *data, uint16_t size);
+
+/* inverse of dsp_cfft_q15(), also divided by size */
+int dsp_cifft_q15(q15_t *data, uint16_t size);
+
+/* magnitudes of count complex values, dst may be src */
+void dsp_cmplx_mag_q15(const q15_t *src, q15_t *dst, size_t count);
+
+/*
+ * Statistics
+ */
+q15_t dsp_rms_q15(const q15_t *src, size_t count);
+q31_t dsp_rms_q31(const q31_t *src, size_t count);
+q15_t dsp_mean_q15(const q15_t *src, size_t count);
+
+/* largest absolute value, its position in *index if index is not NULL */
+q15_t dsp_peak_q15(const q15_t *src, size_t count, size_t *index);
+q31_t dsp_peak_q31(const q31_t *src, size_t count, size_t *index);
+
+/*
+ * Element wise dst = a * b and dst = a + b, saturated; dst may be a or b
+ */
+void dsp_mult_q15(const q15_t *a, const q15_t *b, q15_t *dst, size_t count);
+void dsp_add_q15(const q15_t *a, const q15_t *b, q15_t *dst, size_t count);
+
+/*
+ * Trig and square roots
+ *
+ * Angles are binary: a full turn is 65536, so a uint16_t angle wraps
+ * around by itself; DSP_ANGLE_DEG(90) is 16384.
+ */
+#define DSP_ANGLE_DEG(d)    ((uint16_t)(((d) * 65536L) / 360))
+
+q15_t dsp_sin_q15(uint16_t angle);
+q15_t dsp_cos_q15(uint16_t angle);
+
+/* angle of the vector (x, y), to within 0.1 degree */
+uint16_t dsp_atan2(int32_t y, int32_t x);
+
+/* square root of a positive Q15 or Q31, 0 for negative values */
+q15_t dsp_sqrt_q15(q15_t x);
+q31_t dsp_sqrt_q31(q31_t x);
+
+/* integer square roots, rounded down */
+uint16_t dsp_isqrt32(uint32_t x);
+uint32_t dsp_isqrt64(uint64_t x);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
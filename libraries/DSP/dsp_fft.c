@@ -0,0 +1,168 @@
+/*
+ dsp_fft.c - Radix-4 complex FFT on Q15 data
+
+ This library is free software; you can redistribute it and/or
+ modify it under the terms of the GNU Lesser General Public
+ License as published by the Free Software Foundation; either
+ version 2.1 of the License, or (at your option) any later version.
+
+ This library is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ Lesser General Public License for more details.
+
+ You should have received a copy of the GNU Lesser General Public
+ License along with this library; if not, write to the Free Software
+ Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#include "DSP.h"
+#include "dsp_simd.h"
+
+extern const q15_t dsp_sin_quarter[257];
+
+/*
+ * cos and sin of index / DSP_FFT_MAX_SIZE of a turn, index < 3/4 turn,
+ * packed as a complex value
+ */
+DSP_INLINE uint32_t twiddle(uint16_t index)
+{
+    int32_t c, s;
+
+    if (index < 256) {
+        c = dsp_sin_quarter[256 - index];
+        s = dsp_sin_quarter[index];
+    }
+    else if (index < 512) {
+        c = -dsp_sin_quarter[index - 256];
+        s = dsp_sin_quarter[512 - index];
+    }
+    else {
+        c = -dsp_sin_quarter[768 - index];
+        s = -dsp_sin_quarter[index - 512];
+    }
+    return (dsp_pack_q15x2(c, s));
+}
+
+/*
+ * y times e^-ja, w holding cos a and sin a:
+ *   re = yr cos a + yi sin a, im = yi cos a - yr sin a
+ */
+DSP_INLINE uint32_t rotate(uint32_t y, uint32_t w)
+{
+    return (dsp_pack_q15x2(dsp_ssat16(dsp_smuad(y, w) >> 15),
+                           dsp_ssat16(dsp_smusdx(w, y) >> 15)));
+}
+
+/* 4^bits */
+static int log4(uint16_t size)
+{
+    int bits = 0;
+
+    while (size > 1) {
+        if (size & 3) {
+            return (-1);
+        }
+        size >>= 2;
+        bits++;
+    }
+    return (bits);
+}
+
+/*
+ * Decimation in frequency. Every butterfly halves twice, with SHADD16
+ * and friends, so each stage divides by 4 and the values never grow.
+ * The result comes out in base 4 digit reversed order.
+ */
+int dsp_cfft_q15(q15_t *data, uint16_t size)
+{
+    uint32_t *x = (uint32_t *)data;
+    uint16_t stride, span, quarter, j, a, i, r, k;
+    int digits = log4(size);
+
+    if (size < 16 || size > DSP_FFT_MAX_SIZE || digits < 0) {
+        return (-1);
+    }
+
+    stride = DSP_FFT_MAX_SIZE / size;
+    for (span = size; span >= 4; span >>= 2, stride <<= 2) {
+        quarter = span >> 2;
+
+        for (j = 0; j < quarter; j++) {
+            uint32_t w1 = twiddle(j * stride);
+            uint32_t w2 = twiddle(2 * j * stride);
+            uint32_t w3 = twiddle(3 * j * stride);
+
+            for (a = j; a < size; a += span) {
+                uint32_t xa = x[a];
+                uint32_t xb = x[a + quarter];
+                uint32_t xc = x[a + 2 * quarter];
+                uint32_t xd = x[a + 3 * quarter];
+
+                uint32_t t0 = dsp_shadd16(xa, xc);
+                uint32_t t1 = dsp_shsub16(xa, xc);
+                uint32_t t2 = dsp_shadd16(xb, xd);
+                uint32_t t3 = dsp_shsub16(xb, xd);
+
+                x[a] = dsp_shadd16(t0, t2);
+                if (j == 0) {
+                    x[a + quarter] = dsp_shsax(t1, t3);
+                    x[a + 2 * quarter] = dsp_shsub16(t0, t2);
+                    x[a + 3 * quarter] = dsp_shasx(t1, t3);
+                }
+                else {
+                    x[a + quarter] = rotate(dsp_shsax(t1, t3), w1);
+                    x[a + 2 * quarter] = rotate(dsp_shsub16(t0, t2), w2);
+                    x[a + 3 * quarter] = rotate(dsp_shasx(t1, t3), w3);
+                }
+            }
+        }
+    }
+
+    /* back to natural order */
+    for (i = 1; i < size - 1; i++) {
+        for (r = 0, k = i, a = 0; a < digits; a++, k >>= 2) {
+            r = (r << 2) | (k & 3);
+        }
+        if (r > i) {
+            uint32_t t = x[i];
+            x[i] = x[r];
+            x[r] = t;
+        }
+    }
+    return (0);
+}
+
+/* conjugate, saturated as -(-1) does not fit */
+static void conjugate(q15_t *data, uint16_t size)
+{
+    uint16_t i;
+
+    for (i = 1; i < 2 * size; i += 2) {
+        data[i] = data[i] == -32768 ? 32767 : -data[i];
+    }
+}
+
+/* ifft(x) = conj(fft(conj(x))) */
+int dsp_cifft_q15(q15_t *data, uint16_t size)
+{
+    if (log4(size) < 0 || size < 16 || size > DSP_FFT_MAX_SIZE) {
+        return (-1);
+    }
+    conjugate(data, size);
+    dsp_cfft_q15(data, size);
+    conjugate(data, size);
+    return (0);
+}
+
+void dsp_cmplx_mag_q15(const q15_t *src, q15_t *dst, size_t count)
+{
+    size_t i;
+
+    for (i = 0; i < count; i++) {
+        uint32_t v = dsp_read_q15x2(src + 2 * i);
+        uint16_t mag = dsp_isqrt32((uint32_t)dsp_smuad(v, v));
+
+        dst[i] = mag > 32767 ? 32767 : mag;
+    }
+}
@@ -0,0 +1,269 @@
+/*
+ dsp_filter.c - FIR and biquad IIR filters
+
+ This library is free software; you can redistribute it and/or
+ modify it under the terms of the GNU Lesser General Public
+ License as published by the Free Software Foundation; either
+ version 2.1 of the License, or (at your option) any later version.
+
+ This library is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ Lesser General Public License for more details.
+
+ You should have received a copy of the GNU Lesser General Public
+ License along with this library; if not, write to the Free Software
+ Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#include "DSP.h"
+#include "dsp_simd.h"
+
+/* Q30 (or Q62) sum of products back to Q15 (Q31), rounded */
+#define ROUND_Q15(acc, shift) dsp_ssat16(dsp_ssat32(((acc) + (1 << ((shift) - 1))) >> (shift)))
+#define ROUND_Q31(acc, shift) dsp_ssat32(((acc) + ((int64_t)1 << ((shift) - 1))) >> (shift))
+
+/*
+ * FIR
+ *
+ * The newest samples are appended to the taps - 1 previous ones in
+ * state, so every output is one dot product over a contiguous window.
+ */
+
+void dsp_fir_q15_init(dsp_fir_q15_t *fir, uint16_t taps, const q15_t *coeffs,
+    q15_t *state, uint16_t blockSize)
+{
+    fir->taps = taps;
+    fir->blockSize = blockSize;
+    fir->coeffs = coeffs;
+    fir->state = state;
+    memset(state, 0, (taps + blockSize - 1) * sizeof(q15_t));
+}
+
+/* output for the window at x, two taps per SMLALD */
+DSP_INLINE q15_t fir_q15_dot(const q15_t *x, const q15_t *coeffs, uint16_t taps)
+{
+    int64_t acc = 0;
+    uint16_t k;
+
+    for (k = 0; k + 1 < taps; k += 2) {
+        acc = dsp_smlald(dsp_read_q15x2(x + k), dsp_read_q15x2(coeffs + k), acc);
+    }
+    if (k < taps) {
+        acc += (int32_t)x[k] * coeffs[k];
+    }
+    return (ROUND_Q15(acc, 15));
+}
+
+void dsp_fir_q15(dsp_fir_q15_t *fir, const q15_t *src, q15_t *dst, size_t count)
+{
+    const q15_t *coeffs = fir->coeffs;
+    q15_t *state = fir->state;
+    uint16_t taps = fir->taps;
+    size_t block, n;
+    uint16_t k;
+
+    while (count > 0) {
+        block = count < fir->blockSize ? count : fir->blockSize;
+        memcpy(state + taps - 1, src, block * sizeof(q15_t));
+
+        /*
+         * Two outputs at a time share each pair of coefficients, the
+         * second window being one sample further
+         */
+        for (n = 0; n + 1 < block; n += 2) {
+            const q15_t *x = state + n;
+            int64_t acc0 = 0, acc1 = 0;
+
+            for (k = 0; k + 1 < taps; k += 2) {
+                uint32_t c = dsp_read_q15x2(coeffs + k);
+                acc0 = dsp_smlald(dsp_read_q15x2(x + k), c, acc0);
+                acc1 = dsp_smlald(dsp_read_q15x2(x + k + 1), c, acc1);
+            }
+            if (k < taps) {
+                acc0 += (int32_t)x[k] * coeffs[k];
+                acc1 += (int32_t)x[k + 1] * coeffs[k];
+            }
+            dst[n] = ROUND_Q15(acc0, 15);
+            dst[n + 1] = ROUND_Q15(acc1, 15);
+        }
+        if (n < block) {
+            dst[n] = fir_q15_dot(state + n, coeffs, taps);
+        }
+
+        memmove(state, state + block, (taps - 1) * sizeof(q15_t));
+        src += block;
+        dst += block;
+        count -= block;
+    }
+}
+
+void dsp_fir_decimate_q15(dsp_fir_q15_t *fir, uint8_t factor,
+    const q15_t *src, q15_t *dst, size_t count)
+{
+    q15_t *state = fir->state;
+    uint16_t taps = fir->taps;
+    size_t block, n;
+
+    /* whole groups of factor samples in each block */
+    size_t blockSize = fir->blockSize - fir->blockSize % factor;
+
+    while (count >= factor) {
+        block = count < blockSize ? count - count % factor : blockSize;
+        memcpy(state + taps - 1, src, block * sizeof(q15_t));
+
+        /* the output at the newest sample of each group */
+        for (n = factor - 1; n < block; n += factor) {
+            *dst++ = fir_q15_dot(state + n, fir->coeffs, taps);
+        }
+
+        memmove(state, state + block, (taps - 1) * sizeof(q15_t));
+        src += block;
+        count -= block;
+    }
+}
+
+void dsp_fir_q31_init(dsp_fir_q31_t *fir, uint16_t taps, const q31_t *coeffs,
+    q31_t *state, uint16_t blockSize)
+{
+    fir->taps = taps;
+    fir->blockSize = blockSize;
+    fir->coeffs = coeffs;
+    fir->state = state;
+    memset(state, 0, (taps + blockSize - 1) * sizeof(q31_t));
+}
+
+void dsp_fir_q31(dsp_fir_q31_t *fir, const q31_t *src, q31_t *dst, size_t count)
+{
+    const q31_t *coeffs = fir->coeffs;
+    q31_t *state = fir->state;
+    uint16_t taps = fir->taps;
+    size_t block, n;
+    uint16_t k;
+
+    while (count > 0) {
+        block = count < fir->blockSize ? count : fir->blockSize;
+        memcpy(state + taps - 1, src, block * sizeof(q31_t));
+
+        for (n = 0; n < block; n++) {
+            const q31_t *x = state + n;
+            int64_t acc = 0;
+
+            /* SMLAL */
+            for (k = 0; k < taps; k++) {
+                acc += (int64_t)x[k] * coeffs[k];
+            }
+            dst[n] = ROUND_Q31(acc, 31);
+        }
+
+        memmove(state, state + block, (taps - 1) * sizeof(q31_t));
+        src += block;
+        dst += block;
+        count -= block;
+    }
+}
+
+/*
+ * Biquads
+ *
+ * Stage after stage over the whole block, so that a stage keeps its
+ * state in registers. dst holds the output of each stage in turn.
+ */
+
+void dsp_biquad_q15_init(dsp_biquad_q15_t *iir, uint8_t stages, const q15_t *coeffs,
+    q15_t *state, uint8_t postShift)
+{
+    iir->stages = stages;
+    iir->postShift = postShift;
+    iir->coeffs = coeffs;
+    iir->state = state;
+    memset(state, 0, 4 * stages * sizeof(q15_t));
+}
+
+void dsp_biquad_q15(dsp_biquad_q15_t *iir, const q15_t *src, q15_t *dst, size_t count)
+{
+    const q15_t *coeffs = iir->coeffs;
+    q15_t *state = iir->state;
+    uint8_t shift = 15 - iir->postShift;
+    uint8_t stage;
+    size_t n;
+
+    for (stage = 0; stage < iir->stages; stage++) {
+        int32_t b0 = coeffs[0];
+        uint32_t b12 = dsp_read_q15x2(coeffs + 1);
+        uint32_t a12 = dsp_read_q15x2(coeffs + 3);
+        uint32_t x12 = dsp_read_q15x2(state);
+        uint32_t y12 = dsp_read_q15x2(state + 2);
+
+        for (n = 0; n < count; n++) {
+            int32_t x0 = src[n];
+            int64_t acc = (int64_t)b0 * x0;
+            int32_t y0;
+
+            acc = dsp_smlald(x12, b12, acc);
+            acc = dsp_smlald(y12, a12, acc);
+            y0 = ROUND_Q15(acc, shift);
+
+            /* x[n-1] moves up to x[n-2], the new sample comes in below */
+            x12 = (x12 << 16) | (uint16_t)x0;
+            y12 = (y12 << 16) | (uint16_t)y0;
+            dst[n] = y0;
+        }
+
+        dsp_write_q15x2(state, x12);
+        dsp_write_q15x2(state + 2, y12);
+        coeffs += 5;
+        state += 4;
+        src = dst;
+    }
+}
+
+void dsp_biquad_q31_init(dsp_biquad_q31_t *iir, uint8_t stages, const q31_t *coeffs,
+    q31_t *state, uint8_t postShift)
+{
+    iir->stages = stages;
+    iir->postShift = postShift;
+    iir->coeffs = coeffs;
+    iir->state = state;
+    memset(state, 0, 4 * stages * sizeof(q31_t));
+}
+
+void dsp_biquad_q31(dsp_biquad_q31_t *iir, const q31_t *src, q31_t *dst, size_t count)
+{
+    const q31_t *coeffs = iir->coeffs;
+    q31_t *state = iir->state;
+    uint8_t shift = 31 - iir->postShift;
+    uint8_t stage;
+    size_t n;
+
+    for (stage = 0; stage < iir->stages; stage++) {
+        q31_t b0 = coeffs[0], b1 = coeffs[1], b2 = coeffs[2];
+        q31_t a1 = coeffs[3], a2 = coeffs[4];
+        q31_t x1 = state[0], x2 = state[1];
+        q31_t y1 = state[2], y2 = state[3];
+
+        for (n = 0; n < count; n++) {
+            q31_t x0 = src[n];
+            int64_t acc;
+            q31_t y0;
+
+            acc = (int64_t)b0 * x0 + (int64_t)b1 * x1 + (int64_t)b2 * x2
+                + (int64_t)a1 * y1 + (int64_t)a2 * y2;
+            y0 = ROUND_Q31(acc, shift);
+
+            x2 = x1;
+            x1 = x0;
+            y2 = y1;
+            y1 = y0;
+            dst[n] = y0;
+        }
+
+        state[0] = x1;
+        state[1] = x2;
+        state[2] = y1;
+        state[3] = y2;
+        coeffs += 5;
+        state += 4;
+        src = dst;
+    }
+}
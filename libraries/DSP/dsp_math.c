@@ -0,0 +1,194 @@
+/*
+ dsp_math.c - Trig and square roots without floating point
+
+ This library is free software; you can redistribute it and/or
+ modify it under the terms of the GNU Lesser General Public
+ License as published by the Free Software Foundation; either
+ version 2.1 of the License, or (at your option) any later version.
+
+ This library is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ Lesser General Public License for more details.
+
+ You should have received a copy of the GNU Lesser General Public
+ License along with this library; if not, write to the Free Software
+ Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#include "DSP.h"
+#include "dsp_simd.h"
+
+/*
+ * sin() over a quarter turn in 256 steps, also the FFT twiddles: a
+ * 1024 point FFT needs exactly these angles
+ */
+const q15_t dsp_sin_quarter[257] = {
+        0,   201,   402,   603,   804,  1005,  1206,  1407,
+     1608,  1809,  2009,  2210,  2411,  2611,  2811,  3012,
+     3212,  3412,  3612,  3812,  4011,  4211,  4410,  4609,
+     4808,  5007,  5205,  5404,  5602,  5800,  5998,  6195,
+     6393,  6590,  6787,  6983,  7180,  7376,  7571,  7767,
+     7962,  8157,  8351,  8546,  8740,  8933,  9127,  9319,
+     9512,  9704,  9896, 10088, 10279, 10469, 10660, 10850,
+    11039, 11228, 11417, 11605, 11793, 11980, 12167, 12354,
+    12540, 12725, 12910, 13095, 13279, 13463, 13646, 13828,
+    14010, 14192, 14373, 14553, 14733, 14912, 15091, 15269,
+    15447, 15624, 15800, 15976, 16151, 16326, 16500, 16673,
+    16846, 17018, 17190, 17361, 17531, 17700, 17869, 18037,
+    18205, 18372, 18538, 18703, 18868, 19032, 19195, 19358,
+    19520, 19681, 19841, 20001, 20160, 20318, 20475, 20632,
+    20788, 20943, 21097, 21251, 21403, 21555, 21706, 21856,
+    22006, 22154, 22302, 22449, 22595, 22740, 22884, 23028,
+    23170, 23312, 23453, 23593, 23732, 23870, 24008, 24144,
+    24279, 24414, 24548, 24680, 24812, 24943, 25073, 25202,
+    25330, 25457, 25583, 25708, 25833, 25956, 26078, 26199,
+    26320, 26439, 26557, 26674, 26791, 26906, 27020, 27133,
+    27246, 27357, 27467, 27576, 27684, 27791, 27897, 28002,
+    28106, 28209, 28311, 28411, 28511, 28610, 28707, 28803,
+    28899, 28993, 29086, 29178, 29269, 29359, 29448, 29535,
+    29622, 29707, 29792, 29875, 29957, 30038, 30118, 30196,
+    30274, 30350, 30425, 30499, 30572, 30644, 30715, 30784,
+    30853, 30920, 30986, 31050, 31114, 31177, 31238, 31298,
+    31357, 31415, 31471, 31527, 31581, 31634, 31686, 31737,
+    31786, 31834, 31881, 31927, 31972, 32015, 32058, 32099,
+    32138, 32177, 32214, 32251, 32286, 32319, 32352, 32383,
+    32413, 32442, 32470, 32496, 32522, 32546, 32568, 32590,
+    32610, 32629, 32647, 32664, 32679, 32693, 32706, 32718,
+    32729, 32738, 32746, 32753, 32758, 32762, 32766, 32767,
+    32767
+};
+
+/*
+ * 16384 angle units a quarter turn, 64 between table entries; linear
+ * interpolation keeps the error under one Q15 step
+ */
+q15_t dsp_sin_q15(uint16_t angle)
+{
+    uint16_t pos = angle & 0x3fff;
+    uint16_t index, frac;
+    int32_t v;
+
+    /* the second and fourth quarters run backwards through the table */
+    if (angle & 0x4000) {
+        pos = 0x4000 - pos;
+    }
+    index = pos >> 6;
+    frac = pos & 63;
+    v = dsp_sin_quarter[index];
+    if (frac != 0) {
+        v += ((dsp_sin_quarter[index + 1] - v) * frac + 32) >> 6;
+    }
+    return ((angle & 0x8000) ? -v : v);
+}
+
+q15_t dsp_cos_q15(uint16_t angle)
+{
+    return (dsp_sin_q15(angle + 0x4000));
+}
+
+/*
+ * atan(z) for z in [0, 1] as Q15, in angle units, from
+ *   atan(z) ~ pi/4 z + z (1 - z) (0.2447 + 0.0663 z)
+ * which is within 0.0015 rad
+ */
+static int32_t atanOctant(int32_t z)
+{
+    int32_t curve = (z * (32768 - z)) >> 15;
+
+    return ((z >> 2) + ((curve * (2552 + ((691 * z) >> 15))) >> 15));
+}
+
+uint16_t dsp_atan2(int32_t y, int32_t x)
+{
+    uint32_t ax = x < 0 ? -(uint32_t)x : (uint32_t)x;
+    uint32_t ay = y < 0 ? -(uint32_t)y : (uint32_t)y;
+    int32_t a;
+
+    if (ax == 0 && ay == 0) {
+        return (0);
+    }
+
+    /* down to 16 bits so the ratio is a 32-bit division */
+    while ((ax | ay) >= 0x10000) {
+        ax >>= 1;
+        ay >>= 1;
+    }
+
+    if (ay <= ax) {
+        a = atanOctant((ay << 15) / ax);
+    }
+    else {
+        a = 0x4000 - atanOctant((ax << 15) / ay);
+    }
+    if (x < 0) {
+        a = 0x8000 - a;
+    }
+    if (y < 0) {
+        a = -a;
+    }
+    return ((uint16_t)a);
+}
+
+/* one result bit per step, from the top */
+uint16_t dsp_isqrt32(uint32_t x)
+{
+    uint32_t r = 0;
+    uint32_t b = (uint32_t)1 << 30;
+
+    while (b > x) {
+        b >>= 2;
+    }
+    while (b != 0) {
+        if (x >= r + b) {
+            x -= r + b;
+            r = (r >> 1) + b;
+        }
+        else {
+            r >>= 1;
+        }
+        b >>= 2;
+    }
+    return ((uint16_t)r);
+}
+
+uint32_t dsp_isqrt64(uint64_t x)
+{
+    uint64_t r = 0;
+    uint64_t b = (uint64_t)1 << 62;
+
+    if (x <= 0xffffffff) {
+        return (dsp_isqrt32((uint32_t)x));
+    }
+    while (b > x) {
+        b >>= 2;
+    }
+    while (b != 0) {
+        if (x >= r + b) {
+            x -= r + b;
+            r = (r >> 1) + b;
+        }
+        else {
+            r >>= 1;
+        }
+        b >>= 2;
+    }
+    return ((uint32_t)r);
+}
+
+/* sqrt(x / 2^15) * 2^15 = sqrt(x * 2^15) */
+q15_t dsp_sqrt_q15(q15_t x)
+{
+    if (x <= 0) {
+        return (0);
+    }
+    return ((q15_t)dsp_isqrt32((uint32_t)x << 15));
+}
+
+q31_t dsp_sqrt_q31(q31_t x)
+{
+    if (x <= 0) {
+        return (0);
+    }
+    return ((q31_t)dsp_isqrt64((uint64_t)x << 31));
+}
@@ -0,0 +1,266 @@
+/*
+ dsp_simd.h - Cortex-M4 DSP instructions used by the DSP library
+
+ On a Cortex-M4 each helper is the single instruction of the same name.
+ Anywhere else, e.g. when the library is built on a host to check its
+ accuracy, the same operation is done in C, lane by lane.
+
+ Two Q15 values are packed in one 32-bit word, the first of the pair
+ (lower address, real part of a complex value) in the low half.
+
+ This library is free software; you can redistribute it and/or
+ modify it under the terms of the GNU Lesser General Public
+ License as published by the Free Software Foundation; either
+ version 2.1 of the License, or (at your option) any later version.
+
+ This library is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ Lesser General Public License for more details.
+
+ You should have received a copy of the GNU Lesser General Public
+ License along with this library; if not, write to the Free Software
+ Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#ifndef dsp_simd_h
+#define dsp_simd_h
+
+#include <stdint.h>
+#include <string.h>
+
+#if defined(__ARM_ARCH_7EM__)
+#define DSP_SIMD 1
+#else
+#define DSP_SIMD 0
+#endif
+
+#define DSP_INLINE static inline __attribute__((always_inline))
+
+#define DSP_Q31_MAX ((int32_t)0x7fffffff)
+#define DSP_Q31_MIN ((int32_t)0x80000000)
+
+/* two Q15 values from any, even unaligned, address */
+DSP_INLINE uint32_t dsp_read_q15x2(const int16_t *p)
+{
+    uint32_t v;
+
+    memcpy(&v, p, sizeof(v));
+    return (v);
+}
+
+DSP_INLINE void dsp_write_q15x2(int16_t *p, uint32_t v)
+{
+    memcpy(p, &v, sizeof(v));
+}
+
+DSP_INLINE uint32_t dsp_pack_q15x2(int32_t lo, int32_t hi)
+{
+    return (((uint32_t)lo & 0xffff) | ((uint32_t)hi << 16));
+}
+
+#define DSP_LO(x) ((int32_t)(int16_t)(x))
+#define DSP_HI(x) ((int32_t)(int16_t)((x) >> 16))
+
+#if DSP_SIMD
+
+/* acc + lo(x) * lo(y) + hi(x) * hi(y) */
+DSP_INLINE int32_t dsp_smlad(uint32_t x, uint32_t y, int32_t acc)
+{
+    int32_t r;
+
+    __asm__ ("smlad %0, %1, %2, %3" : "=r" (r) : "r" (x), "r" (y), "r" (acc));
+    return (r);
+}
+
+/* as dsp_smlad() into a 64-bit accumulator */
+DSP_INLINE int64_t dsp_smlald(uint32_t x, uint32_t y, int64_t acc)
+{
+    union {
+        int64_t v;
+        struct { uint32_t lo, hi; } w;
+    } u;
+
+    u.v = acc;
+    __asm__ ("smlald %0, %1, %2, %3" : "+r" (u.w.lo), "+r" (u.w.hi) : "r" (x), "r" (y));
+    return (u.v);
+}
+
+/* lo(x) * lo(y) + hi(x) * hi(y) */
+DSP_INLINE int32_t dsp_smuad(uint32_t x, uint32_t y)
+{
+    int32_t r;
+
+    __asm__ ("smuad %0, %1, %2" : "=r" (r) : "r" (x), "r" (y));
+    return (r);
+}
+
+/* lo(x) * hi(y) - hi(x) * lo(y) */
+DSP_INLINE int32_t dsp_smusdx(uint32_t x, uint32_t y)
+{
+    int32_t r;
+
+    __asm__ ("smusdx %0, %1, %2" : "=r" (r) : "r" (x), "r" (y));
+    return (r);
+}
+
+/* (x + y) / 2 in each half */
+DSP_INLINE uint32_t dsp_shadd16(uint32_t x, uint32_t y)
+{
+    uint32_t r;
+
+    __asm__ ("shadd16 %0, %1, %2" : "=r" (r) : "r" (x), "r" (y));
+    return (r);
+}
+
+/* (x - y) / 2 in each half */
+DSP_INLINE uint32_t dsp_shsub16(uint32_t x, uint32_t y)
+{
+    uint32_t r;
+
+    __asm__ ("shsub16 %0, %1, %2" : "=r" (r) : "r" (x), "r" (y));
+    return (r);
+}
+
+/* lo: (lo(x) - hi(y)) / 2, hi: (hi(x) + lo(y)) / 2, that is (x + jy) / 2 */
+DSP_INLINE uint32_t dsp_shasx(uint32_t x, uint32_t y)
+{
+    uint32_t r;
+
+    __asm__ ("shasx %0, %1, %2" : "=r" (r) : "r" (x), "r" (y));
+    return (r);
+}
+
+/* lo: (lo(x) + hi(y)) / 2, hi: (hi(x) - lo(y)) / 2, that is (x - jy) / 2 */
+DSP_INLINE uint32_t dsp_shsax(uint32_t x, uint32_t y)
+{
+    uint32_t r;
+
+    __asm__ ("shsax %0, %1, %2" : "=r" (r) : "r" (x), "r" (y));
+    return (r);
+}
+
+/* saturating x + y in each half */
+DSP_INLINE uint32_t dsp_qadd16(uint32_t x, uint32_t y)
+{
+    uint32_t r;
+
+    __asm__ ("qadd16 %0, %1, %2" : "=r" (r) : "r" (x), "r" (y));
+    return (r);
+}
+
+/* saturating x - y in each half */
+DSP_INLINE uint32_t dsp_qsub16(uint32_t x, uint32_t y)
+{
+    uint32_t r;
+
+    __asm__ ("qsub16 %0, %1, %2" : "=r" (r) : "r" (x), "r" (y));
+    return (r);
+}
+
+/* saturating 32-bit x + y */
+DSP_INLINE int32_t dsp_qadd(int32_t x, int32_t y)
+{
+    int32_t r;
+
+    __asm__ ("qadd %0, %1, %2" : "=r" (r) : "r" (x), "r" (y));
+    return (r);
+}
+
+/* x clipped to a Q15 */
+DSP_INLINE int32_t dsp_ssat16(int32_t x)
+{
+    int32_t r;
+
+    __asm__ ("ssat %0, #16, %1" : "=r" (r) : "r" (x));
+    return (r);
+}
+
+/* high word of the 64-bit product */
+DSP_INLINE int32_t dsp_smmul(int32_t x, int32_t y)
+{
+    int32_t r;
+
+    __asm__ ("smmul %0, %1, %2" : "=r" (r) : "r" (x), "r" (y));
+    return (r);
+}
+
+#else
+
+DSP_INLINE int32_t dsp_smlad(uint32_t x, uint32_t y, int32_t acc)
+{
+    return ((int32_t)((uint32_t)acc + (uint32_t)(DSP_LO(x) * DSP_LO(y))
+        + (uint32_t)(DSP_HI(x) * DSP_HI(y))));
+}
+
+DSP_INLINE int64_t dsp_smlald(uint32_t x, uint32_t y, int64_t acc)
+{
+    return (acc + (int64_t)DSP_LO(x) * DSP_LO(y) + (int64_t)DSP_HI(x) * DSP_HI(y));
+}
+
+DSP_INLINE int32_t dsp_smuad(uint32_t x, uint32_t y)
+{
+    return ((int32_t)((uint32_t)(DSP_LO(x) * DSP_LO(y)) + (uint32_t)(DSP_HI(x) * DSP_HI(y))));
+}
+
+DSP_INLINE int32_t dsp_smusdx(uint32_t x, uint32_t y)
+{
+    return (DSP_LO(x) * DSP_HI(y) - DSP_HI(x) * DSP_LO(y));
+}
+
+DSP_INLINE uint32_t dsp_shadd16(uint32_t x, uint32_t y)
+{
+    return (dsp_pack_q15x2((DSP_LO(x) + DSP_LO(y)) >> 1, (DSP_HI(x) + DSP_HI(y)) >> 1));
+}
+
+DSP_INLINE uint32_t dsp_shsub16(uint32_t x, uint32_t y)
+{
+    return (dsp_pack_q15x2((DSP_LO(x) - DSP_LO(y)) >> 1, (DSP_HI(x) - DSP_HI(y)) >> 1));
+}
+
+DSP_INLINE uint32_t dsp_shasx(uint32_t x, uint32_t y)
+{
+    return (dsp_pack_q15x2((DSP_LO(x) - DSP_HI(y)) >> 1, (DSP_HI(x) + DSP_LO(y)) >> 1));
+}
+
+DSP_INLINE uint32_t dsp_shsax(uint32_t x, uint32_t y)
+{
+    return (dsp_pack_q15x2((DSP_LO(x) + DSP_HI(y)) >> 1, (DSP_HI(x) - DSP_LO(y)) >> 1));
+}
+
+DSP_INLINE int32_t dsp_ssat16(int32_t x)
+{
+    return (x > 32767 ? 32767 : (x < -32768 ? -32768 : x));
+}
+
+DSP_INLINE uint32_t dsp_qadd16(uint32_t x, uint32_t y)
+{
+    return (dsp_pack_q15x2(dsp_ssat16(DSP_LO(x) + DSP_LO(y)), dsp_ssat16(DSP_HI(x) + DSP_HI(y))));
+}
+
+DSP_INLINE uint32_t dsp_qsub16(uint32_t x, uint32_t y)
+{
+    return (dsp_pack_q15x2(dsp_ssat16(DSP_LO(x) - DSP_LO(y)), dsp_ssat16(DSP_HI(x) - DSP_HI(y))));
+}
+
+DSP_INLINE int32_t dsp_qadd(int32_t x, int32_t y)
+{
+    int64_t r = (int64_t)x + y;
+
+    return (r > DSP_Q31_MAX ? DSP_Q31_MAX : (r < DSP_Q31_MIN ? DSP_Q31_MIN : (int32_t)r));
+}
+
+DSP_INLINE int32_t dsp_smmul(int32_t x, int32_t y)
+{
+    return ((int32_t)(((int64_t)x * y) >> 32));
+}
+
+#endif
+
+/* 64-bit value clipped to a Q31 */
+DSP_INLINE int32_t dsp_ssat32(int64_t x)
+{
+    return (x > DSP_Q31_MAX ? DSP_Q31_MAX : (x < DSP_Q31_MIN ? DSP_Q31_MIN : (int32_t)x));
+}
+
+#endif
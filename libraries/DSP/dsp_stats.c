@@ -0,0 +1,138 @@
+/*
+ dsp_stats.c - RMS, mean, peak and element wise kernels
+
+ This library is free software; you can redistribute it and/or
+ modify it under the terms of the GNU Lesser General Public
+ License as published by the Free Software Foundation; either
+ version 2.1 of the License, or (at your option) any later version.
+
+ This library is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ Lesser General Public License for more details.
+
+ You should have received a copy of the GNU Lesser General Public
+ License along with this library; if not, write to the Free Software
+ Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#include "DSP.h"
+#include "dsp_simd.h"
+
+q15_t dsp_rms_q15(const q15_t *src, size_t count)
+{
+    int64_t sum = 0;
+    uint32_t mean;
+    uint16_t rms;
+    size_t i;
+
+    if (count == 0) {
+        return (0);
+    }
+    for (i = 0; i + 1 < count; i += 2) {
+        uint32_t v = dsp_read_q15x2(src + i);
+        sum = dsp_smlald(v, v, sum);
+    }
+    if (i < count) {
+        sum += (int32_t)src[i] * src[i];
+    }
+
+    /* the mean square is a Q30, its root a Q15 */
+    mean = (uint32_t)(sum / count);
+    rms = dsp_isqrt32(mean);
+    return (rms > 32767 ? 32767 : rms);
+}
+
+q31_t dsp_rms_q31(const q31_t *src, size_t count)
+{
+    uint64_t sum = 0;
+    uint32_t rms;
+    size_t i;
+
+    if (count == 0) {
+        return (0);
+    }
+    for (i = 0; i < count; i++) {
+        sum += (uint64_t)((int64_t)src[i] * src[i]) >> 31;
+    }
+    rms = dsp_isqrt64((sum / count) << 31);
+    return (rms > (uint32_t)DSP_Q31_MAX ? DSP_Q31_MAX : (q31_t)rms);
+}
+
+q15_t dsp_mean_q15(const q15_t *src, size_t count)
+{
+    int64_t sum = 0;
+    size_t i;
+
+    if (count == 0) {
+        return (0);
+    }
+    /* SMLALD against 1, 1 adds a pair */
+    for (i = 0; i + 1 < count; i += 2) {
+        sum = dsp_smlald(dsp_read_q15x2(src + i), 0x00010001, sum);
+    }
+    if (i < count) {
+        sum += src[i];
+    }
+    return ((q15_t)(sum / (int64_t)count));
+}
+
+q15_t dsp_peak_q15(const q15_t *src, size_t count, size_t *index)
+{
+    int32_t peak = -1;
+    size_t i, at = 0;
+
+    for (i = 0; i < count; i++) {
+        int32_t v = src[i] < 0 ? -src[i] : src[i];
+
+        if (v > peak) {
+            peak = v;
+            at = i;
+        }
+    }
+    if (index != NULL) {
+        *index = at;
+    }
+    return (peak < 0 ? 0 : dsp_ssat16(peak));
+}
+
+q31_t dsp_peak_q31(const q31_t *src, size_t count, size_t *index)
+{
+    uint32_t peak = 0;
+    size_t i, at = 0;
+
+    for (i = 0; i < count; i++) {
+        uint32_t v = src[i] < 0 ? -(uint32_t)src[i] : (uint32_t)src[i];
+
+        if (v > peak) {
+            peak = v;
+            at = i;
+        }
+    }
+    if (index != NULL) {
+        *index = at;
+    }
+    return (peak > (uint32_t)DSP_Q31_MAX ? DSP_Q31_MAX : (q31_t)peak);
+}
+
+void dsp_mult_q15(const q15_t *a, const q15_t *b, q15_t *dst, size_t count)
+{
+    size_t i;
+
+    /* only -1 * -1 saturates */
+    for (i = 0; i < count; i++) {
+        dst[i] = dsp_ssat16(((int32_t)a[i] * b[i]) >> 15);
+    }
+}
+
+void dsp_add_q15(const q15_t *a, const q15_t *b, q15_t *dst, size_t count)
+{
+    size_t i;
+
+    for (i = 0; i + 1 < count; i += 2) {
+        dsp_write_q15x2(dst + i, dsp_qadd16(dsp_read_q15x2(a + i), dsp_read_q15x2(b + i)));
+    }
+    if (i < count) {
+        dst[i] = dsp_ssat16((int32_t)a[i] + b[i]);
+    }
+}
@@ -0,0 +1,148 @@
+/* Energia DSP example: DSPBenchmark
+ *
+ * Times the DSP kernels on the board: a 256 point FFT, a 32 tap FIR
+ * and a 4 stage biquad over a block of 256 samples, the RMS of that
+ * block and single sin and atan2 calls, next to the float versions of
+ * the same work for comparison. The spectrum of a test tone is printed
+ * first, its peak should be in bin 16.
+ *
+ * Complexity: low
+ */
+
+#include <DSP.h>
+#include <Benchmark.h>
+#include <math.h>
+
+#define BLOCK   256
+#define TAPS    32
+#define STAGES  4
+
+Benchmark bench(Serial);
+
+q15_t samples[BLOCK];
+q15_t filtered[BLOCK];
+q15_t spectrum[2 * BLOCK];
+float floats[BLOCK];
+
+q15_t firCoeffs[TAPS];
+q15_t firState[TAPS + BLOCK - 1];
+dsp_fir_q15_t fir;
+
+// 4 identical low pass stages, about 0.1 fs, coefficients halved
+const q15_t iirCoeffs[5 * STAGES] = {
+  DSP_Q15(0.0336), DSP_Q15(0.0672), DSP_Q15(0.0336), DSP_Q15(0.5711), DSP_Q15(-0.2055),
+  DSP_Q15(0.0336), DSP_Q15(0.0672), DSP_Q15(0.0336), DSP_Q15(0.5711), DSP_Q15(-0.2055),
+  DSP_Q15(0.0336), DSP_Q15(0.0672), DSP_Q15(0.0336), DSP_Q15(0.5711), DSP_Q15(-0.2055),
+  DSP_Q15(0.0336), DSP_Q15(0.0672), DSP_Q15(0.0336), DSP_Q15(0.5711), DSP_Q15(-0.2055),
+};
+q15_t iirState[4 * STAGES];
+dsp_biquad_q15_t iir;
+
+uint16_t angle;
+
+void fft256(void *arg)
+{
+  for (int i = 0; i < BLOCK; i++) {
+    spectrum[2 * i] = samples[i];
+    spectrum[2 * i + 1] = 0;
+  }
+  dsp_cfft_q15(spectrum, BLOCK);
+}
+
+void firBlock(void *arg)
+{
+  dsp_fir_q15(&fir, samples, filtered, BLOCK);
+}
+
+void firFloat(void *arg)
+{
+  for (int n = TAPS - 1; n < BLOCK; n++) {
+    float acc = 0;
+    for (int k = 0; k < TAPS; k++) {
+      acc += floats[n - k] * 0.03125f;
+    }
+    floats[n - TAPS + 1] = acc;
+  }
+}
+
+void biquadBlock(void *arg)
+{
+  dsp_biquad_q15(&iir, samples, filtered, BLOCK);
+}
+
+void rmsBlock(void *arg)
+{
+  dsp_rms_q15(samples, BLOCK);
+}
+
+void rmsFloat(void *arg)
+{
+  float sum = 0;
+  for (int i = 0; i < BLOCK; i++) {
+    sum += floats[i] * floats[i];
+  }
+  sqrtf(sum / BLOCK);
+}
+
+void sinFixed(void *arg)
+{
+  dsp_sin_q15(angle += 97);
+}
+
+void sinFloat(void *arg)
+{
+  sinf((angle += 97) * 9.5874e-5f);
+}
+
+void atan2Fixed(void *arg)
+{
+  dsp_atan2(angle += 97, 1000);
+}
+
+void atan2Float(void *arg)
+{
+  atan2f(angle += 97, 1000.0f);
+}
+
+void setup()
+{
+  Serial.begin(115200);
+  delay(1000);
+
+  // a tone in bin 16 at half scale
+  for (int i = 0; i < BLOCK; i++) {
+    samples[i] = dsp_sin_q15(i * (65536 / BLOCK) * 16) / 2;
+    floats[i] = samples[i] / 32768.0f;
+  }
+  for (int i = 0; i < TAPS; i++) {
+    firCoeffs[i] = DSP_Q15(1.0 / TAPS);
+  }
+  dsp_fir_q15_init(&fir, TAPS, firCoeffs, firState, BLOCK);
+  dsp_biquad_q15_init(&iir, STAGES, iirCoeffs, iirState, 1);
+
+  fft256(NULL);
+  dsp_cmplx_mag_q15(spectrum, spectrum, BLOCK / 2);
+  size_t bin;
+  q15_t peak = dsp_peak_q15(spectrum, BLOCK / 2, &bin);
+  Serial.print("FFT peak ");
+  Serial.print(peak);
+  Serial.print(" in bin ");
+  Serial.println(bin);
+  Serial.println("Energia DSP benchmark");
+}
+
+void loop()
+{
+  bench.run("FFT 256", fft256);
+  bench.run("FIR 32 taps x 256", firBlock);
+  bench.run("FIR 32 taps x 256, float", firFloat);
+  bench.run("Biquad 4 stages x 256", biquadBlock);
+  bench.run("RMS 256", rmsBlock);
+  bench.run("RMS 256, float", rmsFloat);
+  bench.run("sin", sinFixed);
+  bench.run("sinf", sinFloat);
+  bench.run("atan2", atan2Fixed);
+  bench.run("atan2f", atan2Float);
+  Serial.println();
+  delay(5000);
+}
@@ -0,0 +1,291 @@
+/*
+ dsp_host.c - checks the DSP library against double precision on a host
+
+ Builds the portable C versions of the kernels, compares their results
+ with the same computation in double and times them:
+
+   cc -O2 -I.. -o dsp_host dsp_host.c ../dsp_*.c -lm
+   ./dsp_host
+
+ Errors are in LSBs of the fixed-point result. On the board, time the
+ SIMD versions with examples/DSPBenchmark.
+ */
+
+#define _DEFAULT_SOURCE
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "DSP.h"
+
+#define BLOCK   1024
+#define TAPS    31
+
+static q15_t input[BLOCK];
+static double reference[2 * BLOCK];
+static int failures;
+
+static double now(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (ts.tv_sec + ts.tv_nsec * 1e-9);
+}
+
+static void report(const char *name, double error, double limit)
+{
+    printf("%-24s max error %8.2f %s\n", name, error, error <= limit ? "" : "FAIL");
+    if (error > limit) {
+        failures++;
+    }
+}
+
+#define TIME(name, runs, code) do { \
+        double start = now(); \
+        int run; \
+        for (run = 0; run < (runs); run++) { code; } \
+        printf("%-24s %10.0f ns\n", name, (now() - start) * 1e9 / (runs)); \
+    } while (0)
+
+static void checkFft(uint16_t size)
+{
+    static q15_t data[2 * BLOCK], saved[2 * BLOCK];
+    char name[32];
+    double error = 0;
+    int stages = 0, k, n;
+
+    for (n = size; n > 1; n >>= 2) {
+        stages++;
+    }
+
+    for (n = 0; n < size; n++) {
+        data[2 * n] = input[n] / 2;
+        data[2 * n + 1] = input[(n * 7) % BLOCK] / 2;
+    }
+    memcpy(saved, data, 4 * size);
+
+    for (k = 0; k < size; k++) {
+        double re = 0, im = 0;
+
+        for (n = 0; n < size; n++) {
+            double a = -2 * M_PI * ((double)k * n / size);
+            re += data[2 * n] * cos(a) - data[2 * n + 1] * sin(a);
+            im += data[2 * n] * sin(a) + data[2 * n + 1] * cos(a);
+        }
+        reference[2 * k] = re / size;
+        reference[2 * k + 1] = im / size;
+    }
+
+    dsp_cfft_q15(data, size);
+    for (k = 0; k < 2 * size; k++) {
+        error = fmax(error, fabs(data[k] - reference[k]));
+    }
+    sprintf(name, "cfft %u", size);
+    /* up to an LSB lost by each stage */
+    report(name, error, stages);
+
+    /* back again, scaled down by size once more */
+    memcpy(data, saved, 4 * size);
+    dsp_cfft_q15(data, size);
+    dsp_cifft_q15(data, size);
+    for (error = 0, k = 0; k < 2 * size; k++) {
+        error = fmax(error, fabs(data[k] - saved[k] / (double)size));
+    }
+    sprintf(name, "cifft(cfft) %u", size);
+    report(name, error, stages + 1);
+
+    sprintf(name, "cfft %u", size);
+    TIME(name, 2000, dsp_cfft_q15(data, size));
+}
+
+static void checkFir(void)
+{
+    static q15_t coeffs[TAPS], state[TAPS + 64 - 1], output[BLOCK];
+    dsp_fir_q15_t fir;
+    double error = 0;
+    int n, k;
+
+    for (k = 0; k < TAPS; k++) {
+        double t = k - (TAPS - 1) / 2.0;
+        double h = t == 0 ? 0.25 : sin(M_PI * 0.25 * t) / (M_PI * t);
+        coeffs[k] = DSP_Q15(h * (0.54 - 0.46 * cos(2 * M_PI * k / (TAPS - 1))));
+    }
+
+    dsp_fir_q15_init(&fir, TAPS, coeffs, state, 64);
+    dsp_fir_q15(&fir, input, output, 100);
+    dsp_fir_q15(&fir, input + 100, output + 100, BLOCK - 100);
+
+    for (n = 0; n < BLOCK; n++) {
+        double acc = 0;
+
+        for (k = 0; k < TAPS; k++) {
+            int i = n - (TAPS - 1) + k;
+            acc += i < 0 ? 0 : (double)input[i] * coeffs[k] / 32768;
+        }
+        error = fmax(error, fabs(output[n] - acc));
+    }
+    report("fir q15", error, 1);
+
+    dsp_fir_q15_init(&fir, TAPS, coeffs, state, 64);
+    dsp_fir_decimate_q15(&fir, 4, input, output, BLOCK);
+    for (error = 0, n = 0; n < BLOCK / 4; n++) {
+        double acc = 0;
+
+        for (k = 0; k < TAPS; k++) {
+            int i = 4 * n + 3 - (TAPS - 1) + k;
+            acc += i < 0 ? 0 : (double)input[i] * coeffs[k] / 32768;
+        }
+        error = fmax(error, fabs(output[n] - acc));
+    }
+    report("fir decimate q15", error, 1);
+
+    dsp_fir_q15_init(&fir, TAPS, coeffs, state, 64);
+    TIME("fir q15 31 x 64", 20000, dsp_fir_q15(&fir, input, output, 64));
+}
+
+static void checkBiquad(void)
+{
+    /* two low pass stages at 0.1 fs, halved */
+    static const double b[3] = { 0.0675, 0.1349, 0.0675 };
+    static const double a[2] = { 1.1430, -0.4128 };
+    q15_t coeffs[10], state[8];
+    q31_t coeffs31[10], state31[8], input31[BLOCK], output31[BLOCK];
+    q15_t output[BLOCK];
+    dsp_biquad_q15_t iir;
+    dsp_biquad_q31_t iir31;
+    double x1 = 0, x2 = 0, y1 = 0, y2 = 0, z1 = 0, z2 = 0;
+    double error = 0, error31 = 0;
+    int n, s, k;
+
+    for (s = 0; s < 2; s++) {
+        for (k = 0; k < 3; k++) {
+            coeffs[5 * s + k] = DSP_Q15(b[k] / 2);
+            coeffs31[5 * s + k] = DSP_Q31(b[k] / 2);
+        }
+        for (k = 0; k < 2; k++) {
+            coeffs[5 * s + 3 + k] = DSP_Q15(a[k] / 2);
+            coeffs31[5 * s + 3 + k] = DSP_Q31(a[k] / 2);
+        }
+    }
+    for (n = 0; n < BLOCK; n++) {
+        input31[n] = (q31_t)input[n] << 16;
+    }
+
+    dsp_biquad_q15_init(&iir, 2, coeffs, state, 1);
+    dsp_biquad_q15(&iir, input, output, BLOCK);
+    dsp_biquad_q31_init(&iir31, 2, coeffs31, state31, 1);
+    dsp_biquad_q31(&iir31, input31, output31, BLOCK);
+
+    for (n = 0; n < BLOCK; n++) {
+        double x0 = input[n];
+        double y0 = b[0] * x0 + b[1] * x1 + b[2] * x2 + a[0] * y1 + a[1] * y2;
+        double z0 = b[0] * y0 + b[1] * y1 + b[2] * y2 + a[0] * z1 + a[1] * z2;
+
+        x2 = x1; x1 = x0;
+        y2 = y1; y1 = y0;
+        z2 = z1; z1 = z0;
+        error = fmax(error, fabs(output[n] - z0));
+        error31 = fmax(error31, fabs(output31[n] / 65536.0 - z0));
+    }
+    report("biquad q15, 2 stages", error, 8);
+    report("biquad q31, 2 stages", error31, 1);
+
+    TIME("biquad q15 2 x 1024", 2000, dsp_biquad_q15(&iir, input, output, BLOCK));
+}
+
+static void checkStats(void)
+{
+    static q15_t sum[BLOCK], product[BLOCK];
+    double square = 0, mean = 0, peak = 0, error = 0;
+    size_t at, index = 0;
+    int n;
+
+    for (n = 0; n < BLOCK; n++) {
+        square += (double)input[n] * input[n];
+        mean += input[n];
+        if (abs(input[n]) > peak) {
+            peak = abs(input[n]);
+            index = n;
+        }
+    }
+    report("rms q15", fabs(dsp_rms_q15(input, BLOCK) - sqrt(square / BLOCK)), 1);
+    report("mean q15", fabs(dsp_mean_q15(input, BLOCK) - mean / BLOCK), 1);
+    report("peak q15", fabs(dsp_peak_q15(input, BLOCK, &at) - peak) + (at != index) * 100, 0);
+
+    dsp_add_q15(input, input + 1, sum, BLOCK - 1);
+    dsp_mult_q15(input, input + 1, product, BLOCK - 1);
+    for (n = 0; n < BLOCK - 1; n++) {
+        double s = input[n] + input[n + 1];
+
+        s = s > 32767 ? 32767 : (s < -32768 ? -32768 : s);
+        error = fmax(error, fabs(sum[n] - s));
+        error = fmax(error, fabs(product[n] - input[n] * (double)input[n + 1] / 32768));
+    }
+    report("add, mult q15", error, 1);
+
+    TIME("rms q15 1024", 20000, dsp_rms_q15(input, BLOCK));
+}
+
+static void checkMath(void)
+{
+    double error = 0, errorAtan = 0, errorSqrt = 0;
+    volatile q15_t sink;
+    uint32_t i;
+
+    for (i = 0; i < 65536; i++) {
+        double a = 2 * M_PI * i / 65536;
+        double atan, diff;
+
+        error = fmax(error, fabs(dsp_sin_q15(i) - fmin(32767, 32768 * sin(a))));
+        error = fmax(error, fabs(dsp_cos_q15(i) - fmin(32767, 32768 * cos(a))));
+
+        atan = atan2(sin(a) * 30000, cos(a) * 30000) * 65536 / (2 * M_PI);
+        diff = fmod(fabs(dsp_atan2(lrint(sin(a) * 30000), lrint(cos(a) * 30000)) - fmod(atan + 65536, 65536)), 65536);
+        errorAtan = fmax(errorAtan, fmin(diff, 65536 - diff));
+    }
+    report("sin, cos q15", error, 2);
+    report("atan2, 1/65536 turn", errorAtan, 65536 / 3600.0);
+
+    for (i = 0; i < 32768; i++) {
+        errorSqrt = fmax(errorSqrt, fabs(dsp_sqrt_q15(i) - sqrt(i / 32768.0) * 32768));
+    }
+    for (i = 0; i < 100000; i++) {
+        q31_t x = (q31_t)(((uint32_t)rand() << 16) ^ rand()) & 0x7fffffff;
+
+        errorSqrt = fmax(errorSqrt, fabs(dsp_sqrt_q31(x) - sqrt(x / 2147483648.0) * 2147483648.0) > 1 ? 1e9 : 0);
+    }
+    report("sqrt q15, q31", errorSqrt, 1);
+
+    TIME("sin q15", 1000000, sink = dsp_sin_q15(i += 97));
+    TIME("atan2", 1000000, sink = dsp_atan2(i += 97, 1000));
+    (void)sink;
+}
+
+int main(void)
+{
+    int n;
+
+    srand(1);
+    for (n = 0; n < BLOCK; n++) {
+        input[n] = 16000 * sin(2 * M_PI * n * 13 / BLOCK) + (rand() % 8000) - 4000;
+    }
+
+    checkFft(16);
+    checkFft(64);
+    checkFft(256);
+    checkFft(1024);
+    if (dsp_cfft_q15(input, 128) != -1) {
+        report("cfft 128 rejected", 1, 0);
+    }
+    checkFir();
+    checkBiquad();
+    checkStats();
+    checkMath();
+
+    printf("%s\n", failures ? "FAILED" : "passed");
+    return (failures != 0);
+}
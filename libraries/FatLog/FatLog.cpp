@@ -0,0 +1,430 @@
+/*
+ FatLog.cpp - High rate logging to a pre-allocated, contiguous FatFs file
+
+ This library is free software; you can redistribute it and/or
+ modify it under the terms of the GNU Lesser General Public
+ License as published by the Free Software Foundation; either
+ version 2.1 of the License, or (at your option) any later version.
+
+ This library is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ Lesser General Public License for more details.
+
+ You should have received a copy of the GNU Lesser General Public
+ License along with this library; if not, write to the Free Software
+ Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#include "FatLog.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#include <xdc/runtime/Error.h>
+#include <ti/mw/fatfs/diskio.h>
+
+/* FatFs internals the TI build exports; ff.h doesn't declare them */
+extern "C" {
+DWORD get_fat(FATFS *fs, DWORD clst);
+DWORD clust2sect(FATFS *fs, DWORD clst);
+}
+
+FatLog::FatLog()
+{
+    Semaphore_Params params;
+
+    _open = false;
+    _error = FR_OK;
+    _start = 0;
+    _capacity = 0;
+    _logged = 0;
+    _interval = FATLOG_CHECKPOINT_MS;
+    _lastCheckpoint = 0;
+    _bufferSectors = FATLOG_BUFFER_SECTORS;
+    _buffers[0] = _buffers[1] = NULL;
+    _active = 0;
+    _fill = 0;
+    _bufferSector = 0;
+    _flushed = 0;
+    _task = NULL;
+    _stopping = false;
+    _jobBuffer = NULL;
+    _jobSector = 0;
+    _jobCount = 0;
+    memset(&_stats, 0, sizeof(_stats));
+
+    Semaphore_Params_init(&params);
+    params.mode = Semaphore_Mode_BINARY;
+    Semaphore_construct(&_request, 0, &params);
+    Semaphore_construct(&_idle, 1, &params);
+    Semaphore_construct(&_finished, 0, &params);
+}
+
+FatLog::~FatLog()
+{
+    end();
+    Semaphore_destruct(&_request);
+    Semaphore_destruct(&_idle);
+    Semaphore_destruct(&_finished);
+}
+
+void FatLog::setBufferSectors(uint16_t sectors)
+{
+    if (!_open && sectors > 0) {
+        _bufferSectors = sectors;
+    }
+}
+
+/*
+ * Finds the first run of free clusters long enough for capacity and has
+ * FatFs allocate the file there: the cluster search of a growing file
+ * starts after fs->last_clust, so with that pointed just before the run,
+ * seeking to the end of the file chains the run's clusters in order.
+ * The chain is checked afterwards, in case another file took a cluster
+ * in between.
+ */
+int FatLog::allocate(uint32_t capacity)
+{
+    FATFS *fs = _file.fs;
+    DWORD clusterSize = (DWORD)FATLOG_SECTOR * fs->csize;
+    DWORD clusters = (capacity + clusterSize - 1) / clusterSize;
+    DWORD run = 0, first = 2, cl;
+    int rc;
+
+    if (clusters == 0) {
+        return FR_INVALID_PARAMETER;
+    }
+
+    if (!ff_req_grant(fs->sobj)) {
+        return FR_TIMEOUT;
+    }
+    for (cl = 2; run < clusters; cl++) {
+        DWORD next;
+
+        if (cl >= fs->n_fatent) {
+            ff_rel_grant(fs->sobj);
+            return FR_DENIED;
+        }
+        next = get_fat(fs, cl);
+        if (next == 1 || next == 0xFFFFFFFF) {
+            ff_rel_grant(fs->sobj);
+            return FR_DISK_ERR;
+        }
+        if (next != 0) {
+            run = 0;
+            first = cl + 1;
+        }
+        else {
+            run++;
+        }
+    }
+    fs->last_clust = first - 1;
+    ff_rel_grant(fs->sobj);
+
+    rc = f_lseek(&_file, clusters * clusterSize);
+    if (rc != FR_OK) {
+        return rc;
+    }
+    if (_file.fptr != clusters * clusterSize) {
+        return FR_DENIED;       // the drive filled up
+    }
+
+    if (!ff_req_grant(fs->sobj)) {
+        return FR_TIMEOUT;
+    }
+    cl = _file.sclust;
+    for (run = 1; run < clusters; run++) {
+        DWORD next = get_fat(fs, cl);
+        if (next != cl + 1) {
+            ff_rel_grant(fs->sobj);
+            return FR_DENIED;
+        }
+        cl = next;
+    }
+    _start = clust2sect(fs, _file.sclust);
+    ff_rel_grant(fs->sobj);
+
+    _capacity = clusters * clusterSize;
+    return FR_OK;
+}
+
+int FatLog::begin(const char *path, uint32_t capacity, bool background)
+{
+    size_t bufferSize = (size_t)_bufferSectors * FATLOG_SECTOR;
+    int rc;
+
+    if (_open) {
+        return FR_DENIED;
+    }
+
+    _buffers[0] = (uint8_t *)malloc(bufferSize);
+    _buffers[1] = (uint8_t *)malloc(bufferSize);
+    if (_buffers[0] == NULL || _buffers[1] == NULL) {
+        freeBuffers();
+        return FR_NOT_ENOUGH_CORE;
+    }
+
+    rc = f_open(&_file, path, FA_WRITE | FA_CREATE_ALWAYS);
+    if (rc != FR_OK) {
+        freeBuffers();
+        return rc;
+    }
+    rc = allocate(capacity);
+    if (rc != FR_OK) {
+        /* give back whatever the seek allocated */
+        f_lseek(&_file, 0);
+        f_truncate(&_file);
+        f_close(&_file);
+        freeBuffers();
+        return rc;
+    }
+
+    /* allocated, but empty as far as the directory entry goes */
+    _file.fsize = 0;
+    _file.flag |= FA__WRITTEN;
+    rc = f_sync(&_file);
+    if (rc != FR_OK) {
+        f_close(&_file);
+        freeBuffers();
+        return rc;
+    }
+
+    _open = true;
+    _error = FR_OK;
+    _logged = 0;
+    _active = 0;
+    _fill = 0;
+    _bufferSector = 0;
+    _flushed = 0;
+    _lastCheckpoint = millis();
+    memset(&_stats, 0, sizeof(_stats));
+    _stats.capacity = _capacity;
+    _stats.firstSector = _start;
+
+    if (background) {
+        Task_Params taskParams;
+        Error_Block eb;
+
+        _stopping = false;
+        Error_init(&eb);
+        Task_Params_init(&taskParams);
+        taskParams.arg0 = (UArg)this;
+        taskParams.priority = FATLOG_TASK_PRIORITY;
+        taskParams.stackSize = FATLOG_STACK_SIZE;
+        _task = Task_create(taskFxn, &taskParams, &eb);
+        /* without the task, the buffers are written in the foreground */
+    }
+    return FR_OK;
+}
+
+void FatLog::taskFxn(UArg arg0, UArg arg1)
+{
+    FatLog *log = (FatLog *)arg0;
+
+    for (;;) {
+        Semaphore_pend(Semaphore_handle(&log->_request), BIOS_WAIT_FOREVER);
+        if (log->_stopping) {
+            break;
+        }
+        log->rawWrite(log->_jobBuffer, log->_jobSector, log->_jobCount);
+        Semaphore_post(Semaphore_handle(&log->_idle));
+    }
+    Semaphore_post(Semaphore_handle(&log->_finished));
+}
+
+/*
+ * One multi-sector write into the extent, holding the volume's lock so
+ * that it doesn't interleave with FatFs calls on other files
+ */
+void FatLog::rawWrite(const uint8_t *buffer, uint32_t sector, uint32_t count)
+{
+    FATFS *fs = _file.fs;
+    unsigned long start, took;
+    DRESULT res;
+
+    if (_error != FR_OK) {
+        return;
+    }
+    if (!ff_req_grant(fs->sobj)) {
+        _error = FR_TIMEOUT;
+        return;
+    }
+    start = micros();
+    res = disk_write(fs->drv, buffer, _start + sector, count);
+    took = micros() - start;
+    ff_rel_grant(fs->sobj);
+
+    if (res != RES_OK) {
+        _error = FR_DISK_ERR;
+        return;
+    }
+    _stats.writes++;
+    _stats.sectors += count;
+    if (took > _stats.maxWriteUs) {
+        _stats.maxWriteUs = took;
+    }
+}
+
+/* waits until the task has written the buffer it has, if any */
+void FatLog::waitIdle(void)
+{
+    if (_task == NULL) {
+        return;
+    }
+    Semaphore_pend(Semaphore_handle(&_idle), BIOS_WAIT_FOREVER);
+    Semaphore_post(Semaphore_handle(&_idle));
+}
+
+void FatLog::submit(const uint8_t *buffer, uint32_t sector, uint32_t count)
+{
+    if (_task == NULL) {
+        rawWrite(buffer, sector, count);
+        return;
+    }
+    if (Semaphore_getCount(Semaphore_handle(&_idle)) == 0) {
+        _stats.stalls++;
+    }
+    Semaphore_pend(Semaphore_handle(&_idle), BIOS_WAIT_FOREVER);
+    _jobBuffer = buffer;
+    _jobSector = sector;
+    _jobCount = count;
+    Semaphore_post(Semaphore_handle(&_request));
+}
+
+size_t FatLog::write(const uint8_t *buffer, size_t size)
+{
+    size_t bufferSize = (size_t)_bufferSectors * FATLOG_SECTOR;
+    size_t done = 0;
+
+    if (!_open || _error != FR_OK) {
+        _stats.dropped += size;
+        return 0;
+    }
+    if (size > _capacity - _logged) {
+        _stats.dropped += size - (_capacity - _logged);
+        size = _capacity - _logged;
+    }
+
+    while (done < size) {
+        size_t n = bufferSize - _fill;
+
+        if (n > size - done) {
+            n = size - done;
+        }
+        memcpy(_buffers[_active] + _fill, buffer + done, n);
+        _fill += n;
+        done += n;
+
+        /*
+         * A full buffer goes to the disk from the first sector a checkpoint
+         * didn't write in full, and the other buffer takes over
+         */
+        if (_fill == bufferSize) {
+            submit(_buffers[_active] + _flushed * FATLOG_SECTOR, _bufferSector + _flushed,
+                   _bufferSectors - _flushed);
+            _active ^= 1;
+            _bufferSector += _bufferSectors;
+            _fill = 0;
+            _flushed = 0;
+        }
+    }
+    _logged += done;
+
+    if (_interval != 0 && millis() - _lastCheckpoint >= _interval) {
+        checkpoint();
+    }
+    return done;
+}
+
+int FatLog::checkpoint(void)
+{
+    unsigned long start = micros(), took;
+    uint32_t sectors;
+    int rc;
+
+    if (!_open) {
+        return FR_INVALID_OBJECT;
+    }
+    _lastCheckpoint = millis();
+
+    /*
+     * The buffer being filled is written up to its last byte, a partial
+     * sector included; once that sector fills, it is written again
+     */
+    waitIdle();
+    sectors = (_fill + FATLOG_SECTOR - 1) / FATLOG_SECTOR;
+    if (sectors > _flushed) {
+        rawWrite(_buffers[_active] + _flushed * FATLOG_SECTOR, _bufferSector + _flushed,
+                 sectors - _flushed);
+        _flushed = _fill / FATLOG_SECTOR;
+    }
+    if (_error != FR_OK) {
+        return _error;
+    }
+
+    _file.fsize = _logged;
+    _file.flag |= FA__WRITTEN;
+    rc = f_sync(&_file);
+    if (rc != FR_OK) {
+        _error = rc;
+        return rc;
+    }
+
+    _stats.durable = _logged;
+    _stats.checkpoints++;
+    took = micros() - start;
+    if (took > _stats.maxCheckpointUs) {
+        _stats.maxCheckpointUs = took;
+    }
+    return FR_OK;
+}
+
+int FatLog::end(void)
+{
+    int rc, rc2;
+
+    if (!_open) {
+        return FR_OK;
+    }
+    rc = checkpoint();
+
+    if (_task != NULL) {
+        waitIdle();
+        _stopping = true;
+        Semaphore_post(Semaphore_handle(&_request));
+        Semaphore_pend(Semaphore_handle(&_finished), BIOS_WAIT_FOREVER);
+        Task_delete(&_task);
+    }
+
+    /* the whole extent is the file again, so that truncating frees the rest */
+    _file.fsize = _capacity;
+    rc2 = f_lseek(&_file, _logged);
+    if (rc2 == FR_OK) {
+        rc2 = f_truncate(&_file);
+    }
+    if (rc == FR_OK) {
+        rc = rc2;
+    }
+    rc2 = f_close(&_file);
+    if (rc == FR_OK) {
+        rc = rc2;
+    }
+
+    _open = false;
+    freeBuffers();
+    return rc;
+}
+
+void FatLog::stats(FatLogStats &stats)
+{
+    stats = _stats;
+    stats.bytes = _logged;
+}
+
+void FatLog::freeBuffers(void)
+{
+    free(_buffers[0]);
+    free(_buffers[1]);
+    _buffers[0] = _buffers[1] = NULL;
+}
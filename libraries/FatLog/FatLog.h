@@ -0,0 +1,150 @@
+/*
+ FatLog.h - High rate logging to a pre-allocated, contiguous FatFs file
+
+ A normal FatFs append looks up or allocates a cluster, rewrites the FAT
+ and the directory entry as the file grows, and goes through the one
+ sector cache of the file object, so a sustained log stalls whenever a
+ cluster boundary comes up. FatLog allocates the whole file as one run of
+ clusters when it opens it, remembers the first sector, and from then on
+ writes the data straight to the disk, several sectors per disk_write()
+ call, from two buffers: one fills while the other is written by a task
+ of its own. The directory entry only changes at checkpoints.
+
+   FatLog log;
+
+   log.begin("0:/data.bin", 16UL * 1024 * 1024);
+   ...
+   log.write((uint8_t *)&sample, sizeof(sample));
+   ...
+   log.end();
+
+ Until end(), the file's size in the directory is what the last
+ checkpoint() found written, and the rest of the extent is allocated to
+ it. After a reset the data up to the last checkpoint is in the file; a
+ disk check finds the unused clusters beyond it, end() gives them back.
+
+ This library is free software; you can redistribute it and/or
+ modify it under the terms of the GNU Lesser General Public
+ License as published by the Free Software Foundation; either
+ version 2.1 of the License, or (at your option) any later version.
+
+ This library is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ Lesser General Public License for more details.
+
+ You should have received a copy of the GNU Lesser General Public
+ License along with this library; if not, write to the Free Software
+ Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#ifndef FatLog_h
+#define FatLog_h
+
+#include <Energia.h>
+#include <ti/mw/fatfs/ff.h>
+#include <ti/sysbios/knl/Semaphore.h>
+
+#define FATLOG_SECTOR           512
+#define FATLOG_BUFFER_SECTORS   8       // per buffer, two buffers
+#define FATLOG_CHECKPOINT_MS    1000    // 0 for explicit checkpoint() calls only
+#define FATLOG_TASK_PRIORITY    2
+#define FATLOG_STACK_SIZE       0x400
+
+typedef struct {
+    uint32_t bytes;         // accepted by write()
+    uint32_t durable;       // on the disk and in the directory entry
+    uint32_t capacity;      // size of the extent
+    uint32_t firstSector;   // of the extent, on the drive
+    uint32_t writes;        // disk_write() calls
+    uint32_t sectors;       // ...and the sectors they wrote
+    uint32_t maxWriteUs;    // longest disk_write()
+    uint32_t checkpoints;
+    uint32_t maxCheckpointUs;
+    uint32_t stalls;        // write() calls that waited for the disk
+    uint32_t dropped;       // bytes refused: the extent was full, or after an error
+} FatLogStats;
+
+class FatLog : public Print {
+public:
+    FatLog();
+    ~FatLog();
+
+    /*
+     * Sets the size of each of the two buffers, in sectors; call it
+     * before begin(). Larger buffers make fewer, longer writes.
+     */
+    void setBufferSectors(uint16_t sectors);
+    void setCheckpointInterval(unsigned long ms) { _interval = ms; }
+
+    /*
+     * Creates (or replaces) the file and allocates capacity bytes to it
+     * as contiguous clusters on its drive, which must be mounted.
+     *
+     * param background: write the buffers from a task, so that write()
+     *     only waits when the disk falls a whole buffer behind; false
+     *     writes them from the caller
+     * return: FR_OK, FR_DENIED if there is no free run of clusters that
+     *     long, FR_NOT_ENOUGH_CORE without memory for the buffers, or
+     *     another FatFs error
+     */
+    int begin(const char *path, uint32_t capacity, bool background = true);
+
+    virtual size_t write(uint8_t c) { return write(&c, 1); }
+    virtual size_t write(const uint8_t *buffer, size_t size);
+
+    /*
+     * Writes out what is buffered and records the size in the directory
+     * entry. write() calls it every setCheckpointInterval() ms.
+     */
+    int checkpoint(void);
+
+    /*
+     * Checkpoints, gives back the part of the extent that wasn't used,
+     * and closes the file
+     */
+    int end(void);
+
+    uint32_t size(void) { return _logged; }
+    uint32_t capacity(void) { return _capacity; }
+    int error(void) { return _error; }      // the first FatFs error, FR_OK if none
+    void stats(FatLogStats &stats);
+
+private:
+    static void taskFxn(UArg arg0, UArg arg1);
+    int allocate(uint32_t capacity);
+    void rawWrite(const uint8_t *buffer, uint32_t sector, uint32_t count);
+    void submit(const uint8_t *buffer, uint32_t sector, uint32_t count);
+    void waitIdle(void);
+    void freeBuffers(void);
+
+    FIL _file;
+    bool _open;
+    int _error;
+    uint32_t _start;            // first sector of the extent
+    uint32_t _capacity;
+    uint32_t _logged;
+    unsigned long _interval;
+    unsigned long _lastCheckpoint;
+
+    uint16_t _bufferSectors;
+    uint8_t *_buffers[2];
+    uint8_t _active;            // the buffer write() fills
+    uint32_t _fill;             // bytes in it
+    uint32_t _bufferSector;     // extent sector its first byte goes to
+    uint32_t _flushed;          // its sectors a checkpoint wrote; the last may be partial
+
+    /* the buffer the task is writing */
+    Task_Handle _task;
+    Semaphore_Struct _request;
+    Semaphore_Struct _idle;
+    Semaphore_Struct _finished;
+    volatile bool _stopping;
+    const uint8_t *_jobBuffer;
+    uint32_t _jobSector;
+    uint32_t _jobCount;
+
+    FatLogStats _stats;
+};
+
+#endif
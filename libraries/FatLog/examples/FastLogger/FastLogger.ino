@@ -0,0 +1,119 @@
+/* FastLogger.ino
+ *
+ * Logs 16 byte records to an SD card on the SPI bus as fast as the card
+ * takes them, then prints how long the slowest disk write took and how
+ * often the sketch had to wait for one.
+ *
+ * FatLog allocates the whole file up front as contiguous clusters and
+ * writes whole sectors straight to the card from a task of its own, so
+ * the cost of a write() is a copy into a buffer. The directory entry is
+ * updated once a second; after a reset the file holds the records up to
+ * the last of those checkpoints.
+ *
+ * The card is registered with the SDSPI driver below. The numbers are the
+ * CC3200's GSPI and GPIO registers (driverlib's GSPI_BASE, GPIOA0_BASE,
+ * ...): the chip select is GPIO 7, change csGPIOBase and csGPIOPin for
+ * your wiring.
+ *
+ * Complexity: medium
+ */
+
+#include <FatLog.h>
+#include <ti/drivers/SDSPI.h>
+#include <ti/drivers/sdspi/SDSPICC3200.h>
+
+#define LOG_SIZE    (4UL * 1024 * 1024)
+
+SDSPICC3200_Object sdspiObject;
+
+const SDSPICC3200_HWAttrs sdspiHWAttrs = {
+  0x41020000,   // GSPI_BASE
+  0x00000003,   // PRCM_GSPI
+  0x40004000,   // chip select: GPIOA0_BASE
+  0x00000080,   // ...GPIO_PIN_7
+  0x40006000,   // MOSI as a GPIO while the card starts: GPIOA2_BASE
+  0x00000001,   // ...GPIO_PIN_0
+  0,            // PIN_MODE_0
+  7,            // PIN_MODE_7, MOSI
+  0x00000006    // PIN_07
+};
+
+extern "C" const SDSPI_Config SDSPI_config[] = {
+  { &SDSPICC3200_fxnTable, &sdspiObject, &sdspiHWAttrs },
+  { NULL, NULL, NULL }
+};
+
+struct Record {
+  uint32_t micros;
+  uint32_t sequence;
+  uint16_t analog[4];
+};
+
+FatLog fatLog;
+SDSPI_Handle sdspi;
+uint32_t sequence;
+unsigned long started;
+
+void setup() {
+  SDSPI_Params params;
+
+  Serial.begin(115200);
+
+  SDSPI_init();
+  SDSPI_Params_init(&params);
+  sdspi = SDSPI_open(0, 0, &params);
+  if (sdspi == NULL) {
+    Serial.println("no SD card driver");
+    while (1);
+  }
+
+  int rc = fatLog.begin("0:/log.bin", LOG_SIZE);
+  if (rc != FR_OK) {
+    Serial.print("begin failed: ");
+    Serial.println(rc);
+    while (1);
+  }
+  started = millis();
+}
+
+void loop() {
+  Record record;
+
+  record.micros = micros();
+  record.sequence = sequence++;
+  for (int i = 0; i < 4; i++) {
+    record.analog[i] = analogRead(A0 + i);
+  }
+
+  if (fatLog.write((uint8_t *)&record, sizeof(record)) == sizeof(record)) {
+    return;
+  }
+
+  // the extent is full
+  unsigned long elapsed = millis() - started;
+  FatLogStats stats;
+
+  fatLog.end();
+  fatLog.stats(stats);
+
+  Serial.print(stats.bytes);
+  Serial.print(" bytes in ");
+  Serial.print(elapsed);
+  Serial.print(" ms, ");
+  Serial.print(stats.bytes / elapsed);
+  Serial.println(" kB/s");
+  Serial.print(stats.writes);
+  Serial.print(" writes of ");
+  Serial.print(stats.sectors);
+  Serial.print(" sectors, the longest ");
+  Serial.print(stats.maxWriteUs);
+  Serial.println(" us");
+  Serial.print(stats.stalls);
+  Serial.print(" stalls, ");
+  Serial.print(stats.checkpoints);
+  Serial.print(" checkpoints, the longest ");
+  Serial.print(stats.maxCheckpointUs);
+  Serial.println(" us");
+
+  while (1);
+}
@@ -27,6 +27,7 @@ LCD_screen::LCD_screen()
     _flagRead       = false;
     _flagStorage    = false;
     _touchTrim      = 0;
+    _touchMapOrientation = 0xff;
 }
 void LCD_screen::showInformation(uint16_t x0, uint16_t y0)
 {
@@ -391,26 +392,7 @@ bool LCD_screen::getTouch(uint16_t &x, uint16_t &y, uint16_t &z)
     _getRawTouch(x0, y0, z0);
     z = z0;
     if (z > _touchTrim) {
-        x0 = _check(x0, _touchXmin, _touchXmax);
-        y0 = _check(y0, _touchYmin, _touchYmax);
-        switch (_orientation) {
-            case 0:
-                x = map(x0, _touchXmin, _touchXmax, 0, _screenWidth);
-                y = map(y0, _touchYmin, _touchYmax, 0, _screenHeigth);
-                break;
-            case 1:
-                x = map(y0, _touchYmin, _touchYmax, 0, _screenHeigth);
-                y = map(x0, _touchXmin, _touchXmax, _screenWidth, 0);
-                break;
-            case 2:
-                x = map(x0, _touchXmin, _touchXmax, _screenWidth, 0);
-                y = map(y0, _touchYmin, _touchYmax, _screenHeigth, 0);
-                break;
-            case 3:
-                x = map(y0, _touchYmin, _touchYmax, _screenHeigth, 0);
-                y = map(x0, _touchXmin, _touchXmax, 0, _screenWidth);
-                break;
-        }
+        _mapTouch(x0, y0, x, y);
         return true;
     } else {
         return false;
@@ -455,6 +437,7 @@ void LCD_screen::calibrateTouch()
     _touchXmax = x1 + 10 * (x1-x0) / (_screenWidth -10-10);
     _touchYmin = y0 - 10 * (y1-y0) / (_screenHeigth-10-10);
     _touchYmax = y1 + 10 * (y1-y0) / (_screenHeigth-10-10);
+    _touchMapOrientation = 0xff;
     Serial.println("touch calibration");
     Serial.print("_touchXmin =");
     Serial.print(_touchXmin, DEC);
@@ -501,3 +484,34 @@ uint16_t LCD_screen::_check(uint16_t x0, uint16_t xmin, uint16_t xmax)
         else return x0;
     }
 }
+// Same mapping as map() over the calibration, with the slopes for the
+// current orientation kept in Q16 so a touch costs two multiplications
+void LCD_screen::_cacheTouchMap()
+{
+    uint16_t rawMin[2] = { _touchXmin, _touchYmin };
+    uint16_t rawMax[2] = { _touchXmax, _touchYmax };
+    uint16_t size[2]   = { _screenWidth, _screenHeigth };
+    bool     reverse[2];
+    uint8_t  axis;
+    _touchMapSwap = (_orientation & 1);
+    reverse[0] = (_orientation == 2) || (_orientation == 3);
+    reverse[1] = (_orientation == 1) || (_orientation == 2);
+    for (uint8_t i = 0; i < 2; i++) {
+        axis = _touchMapSwap ? 1 - i : i;
+        int32_t out = reverse[i] ? -(int32_t)size[axis] : size[axis];
+        int32_t in  = (int32_t)rawMax[axis] - rawMin[axis];
+        _touchMapRaw[i]   = rawMin[axis];
+        _touchMapStart[i] = reverse[i] ? size[axis] : 0;
+        _touchMapGain[i]  = (in != 0) ? (out << 16) / in : 0;
+    }
+    _touchMapOrientation = _orientation;
+}
+void LCD_screen::_mapTouch(uint16_t x0, uint16_t y0, uint16_t &x, uint16_t &y)
+{
+    if (_touchMapOrientation != _orientation) _cacheTouchMap();
+    x0 = _check(x0, _touchXmin, _touchXmax);
+    y0 = _check(y0, _touchYmin, _touchYmax);
+    if (_touchMapSwap) _swap(x0, y0);
+    x = _touchMapStart[0] + ((((int32_t)x0 - _touchMapRaw[0]) * _touchMapGain[0]) >> 16);
+    y = _touchMapStart[1] + ((((int32_t)y0 - _touchMapRaw[1]) * _touchMapGain[1]) >> 16);
+}
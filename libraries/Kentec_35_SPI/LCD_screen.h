@@ -103,6 +103,10 @@ protected:
     uint16_t     _screenWidth, _screenHeigth;
     uint8_t      _touchTrim;
     uint16_t     _touchXmin, _touchXmax, _touchYmin, _touchYmax;
+    uint8_t      _touchMapOrientation;
+    bool         _touchMapSwap;
+    uint16_t     _touchMapRaw[2], _touchMapStart[2];
+    int32_t      _touchMapGain[2];
     virtual void _fastFill(uint16_t x1, uint16_t y1, uint16_t x2, uint16_t y2, uint16_t colour) =0;
     virtual void _setPoint(uint16_t x1, uint16_t y1, uint16_t colour) =0;
     virtual void _getRawTouch(uint16_t &x0, uint16_t &y0, uint16_t &z0) =0;
@@ -113,6 +117,8 @@ protected:
     void         _swap(uint16_t &a, uint16_t &b);
     void         _swap(uint8_t &a, uint8_t &b);
     uint16_t     _check(uint16_t x0, uint16_t xmin, uint16_t xmax);
+    void         _cacheTouchMap();
+    void         _mapTouch(uint16_t x0, uint16_t y0, uint16_t &x, uint16_t &y);
     void         _triangleArea(uint16_t x1, uint16_t y1, uint16_t x2, uint16_t y2, uint16_t x3, uint16_t y3, uint16_t colour);
     bool         _inValue(int16_t value, int16_t valueLow, int16_t valueHigh);
     bool         _inSector(int16_t valueStart, int16_t valueEnd, int16_t sectorLow, int16_t sectorHigh,
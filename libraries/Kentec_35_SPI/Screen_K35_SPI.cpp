@@ -25,6 +25,18 @@
 #include "driverlib/sysctl.h"
 #endif
 
+#if defined(ENERGIA_ARCH_CC3200EMT)
+#include "inc/hw_types.h"
+#include "inc/hw_memmap.h"
+#include "driverlib/rom_map.h"
+#include "driverlib/pin.h"
+#include "driverlib/adc.h"
+#endif
+
+#if defined(ti_sysbios_BIOS___VERS)
+#include <xdc/runtime/Error.h>
+#endif
+
 ///
 /// @name	SSD2119 constants
 ///
@@ -100,7 +112,12 @@
 #define TOUCH_XP 23 // A7      ///< 23 PD_0  // must be an analog pin, use "An" notation!
 #define TOUCH_YP 24 // A6      ///< 24 PD_1  // must be an analog pin, use "An" notation!
 #define TOUCH_XN 11 // PA_2    ///< 11 can be a digital pin
-#define TOUCH_YN 31 // PF_4    ///< 31 can be a digital pin
+#define TOUCH_YN 31 // PF_4    ///< 31 can be a digital pin, pen-down interrupt
+
+#define TOUCH_SETTLE_US 200 ///< µs for the panel to settle after switching the plates
+#define TOUCH_SAMPLES   5   ///< samples per burst, the median is kept
+#define TOUCH_ADC_SKIP  4   ///< first conversions discarded by the CC3200 ADC
+#define TOUCH_IIR_SHIFT 2   ///< IIR weight of a new sample while the pen is down, 1/4
 
 /// @}
 
@@ -135,6 +152,9 @@ Screen_K35_SPI::Screen_K35_SPI()
     _pinScreenReset       = 32; // PD_7
     _pinScreenChipSelect  = 13; // PA_4
     _pinScreenBackLight   = 40; // PF_2 PWM, not connected
+#if defined(ti_sysbios_BIOS___VERS)
+    _touchService         = NULL;
+#endif
 }
 
 void Screen_K35_SPI::begin()
@@ -331,6 +351,7 @@ void Screen_K35_SPI::begin()
 #else
 #error Wrong
 #endif
+    _touchMapOrientation = 0xff;
     
     _penSolid  = false;
     _fontSolid = true;
@@ -505,8 +526,6 @@ void Screen_K35_SPI::_closeWindow()
     _setWindow(0, 0, screenSizeX()-1, screenSizeY()-1);
 }
 
-inline uint16_t absDiff(uint16_t a, uint16_t b) { return (a > b) ? a-b : b-a; }
-
 void Screen_K35_SPI::_fastFill(uint16_t x1, uint16_t y1, uint16_t x2, uint16_t y2, uint16_t colour)
 {
     if (x1 > x2) _swap(x1, x2);
@@ -522,15 +541,101 @@ void Screen_K35_SPI::_fastFill(uint16_t x1, uint16_t y1, uint16_t x2, uint16_t y
 }
 
 // Touch
+// Without the touch service, a poll while the panel is not touched costs
+// the pen detection setup (four pinMode() calls and a digitalWrite()), a
+// TOUCH_SETTLE_US busy wait and one GPIO read
 void Screen_K35_SPI::_getRawTouch(uint16_t &x0, uint16_t &y0, uint16_t &z0)
 {
-    // --- 2015-08-04 _getRawTouch revised entirely
-    // Tested against MSP432, F5529 and LM4F/TM4C
-    // However, the calibrateTouch() may throw wrong results
-    //
-    int16_t a, b, c, d;
-    bool flag;
+#if defined(ti_sysbios_BIOS___VERS)
+    if (_touchService != NULL) {
+        x0 = _touchX;
+        y0 = _touchY;
+        z0 = _touchZ;
+        return;
+    }
+#endif
     
+    if (!_penDown() || !_sampleTouch(x0, y0, z0)) {
+        x0 = 0;
+        y0 = 0;
+        z0 = 0;
+    }
+}
+
+// Pen detection
+// xn = ground
+// yn = pull-up, reads LOW when the plates touch
+// xp, yp = open
+void Screen_K35_SPI::_setPenDetect()
+{
+    pinMode(TOUCH_XP, INPUT);
+    pinMode(TOUCH_YP, INPUT);
+    pinMode(TOUCH_XN, OUTPUT);
+    digitalWrite(TOUCH_XN, LOW);
+    pinMode(TOUCH_YN, INPUT_PULLUP);
+}
+
+bool Screen_K35_SPI::_penDown()
+{
+    _setPenDetect();
+    delayMicroseconds(TOUCH_SETTLE_US);
+    return (digitalRead(TOUCH_YN) == LOW);
+}
+
+// Median of TOUCH_SAMPLES conversions taken back to back
+uint16_t Screen_K35_SPI::_burstRead(uint8_t pin)
+{
+    uint16_t sample[TOUCH_SAMPLES];
+    uint16_t value;
+    uint8_t i, j;
+    
+#if defined(ENERGIA_ARCH_CC3200EMT)
+    // analogRead() discards the first conversions of every call, so the
+    // ADC is driven here to pay for them once per burst. The value is
+    // kept at 12 bits, as the calibration expects.
+    uint8_t channel = digitalPinToADCChannel(pin);
+    
+    if (channel != NOT_ON_ADC) {
+        // analogRead() from another task would disable the ADC under us
+        uint32_t key = Task_disable();
+        
+        if (digital_pin_to_pin_function[pin] != PIN_FUNC_ANALOG_INPUT) {
+            MAP_PinTypeADC(digitalPinToPinNum(pin), 0xff);
+            digital_pin_to_pin_function[pin] = PIN_FUNC_ANALOG_INPUT;
+        }
+        MAP_ADCChannelEnable(ADC_BASE, channel);
+        MAP_ADCEnable(ADC_BASE);
+        for (i = 0; i < TOUCH_ADC_SKIP + TOUCH_SAMPLES; i++) {
+            while (!MAP_ADCFIFOLvlGet(ADC_BASE, channel)) {
+            }
+            value = (MAP_ADCFIFORead(ADC_BASE, channel) & 0x3ffc) >> 2;
+            if (i >= TOUCH_ADC_SKIP) sample[i - TOUCH_ADC_SKIP] = value;
+        }
+        MAP_ADCDisable(ADC_BASE);
+        MAP_ADCChannelDisable(ADC_BASE, channel);
+        
+        Task_restore(key);
+    } else
+#endif
+    {
+        for (i = 0; i < TOUCH_SAMPLES; i++) sample[i] = analogRead(pin);
+    }
+    
+    // Insertion sort, TOUCH_SAMPLES is small
+    for (i = 1; i < TOUCH_SAMPLES; i++) {
+        value = sample[i];
+        for (j = i; (j > 0) && (sample[j - 1] > value); j--) sample[j] = sample[j - 1];
+        sample[j] = value;
+    }
+    return sample[TOUCH_SAMPLES / 2];
+}
+
+// --- _getRawTouch revised for burst sampling
+// One settling delay per axis and the median of a burst replace the
+// retry loop on pairs of analogRead()
+// Returns true if the pressure is above the threshold
+bool Screen_K35_SPI::_sampleTouch(uint16_t &x0, uint16_t &y0, uint16_t &z0)
+{
 #if defined(__MSP432P401R__)
     pinMode(TOUCH_YP, OUTPUT);
     pinMode(TOUCH_YN, OUTPUT);
@@ -544,94 +649,222 @@ void Screen_K35_SPI::_getRawTouch(uint16_t &x0, uint16_t &y0, uint16_t &z0)
     delayMicroseconds(1000); // delay(1);
 #endif
     
-    do {
-        flag = false;
-        
-        // Read x
-        // xp = +Vref
-        // xn = ground
-        // yp = measure
-        // yn = open
+    // Read x
+    // xp = +Vref
+    // xn = ground
+    // yp = measure
+    // yn = open
 #ifndef ENERGIA
-        digitalWrite(TOUCH_YP, LOW);
-        digitalWrite(TOUCH_YN, LOW);
+    digitalWrite(TOUCH_YP, LOW);
+    digitalWrite(TOUCH_YN, LOW);
 #endif
-        pinMode(TOUCH_YP, INPUT);
-        pinMode(TOUCH_YN, INPUT);
-        
-        pinMode(TOUCH_XP, OUTPUT);
-        pinMode(TOUCH_XN, OUTPUT);
-        digitalWrite(TOUCH_XP, HIGH);
-        digitalWrite(TOUCH_XN, LOW);
-        
-        delayMicroseconds(1000); // delay(1);
-        a = analogRead(TOUCH_YP);
-        delayMicroseconds(1000); // delay(1);
-        b = analogRead(TOUCH_YP);
-        
-        flag |= (absDiff(a, b) > 8);
-        x0  = ANALOG_RESOLUTION - a;
-        
-        // Read y
-        // xp = measure
-        // xn = open
-        // yp = +Vref
-        // yn = ground
+    pinMode(TOUCH_YP, INPUT);
+    pinMode(TOUCH_YN, INPUT);
+    
+    pinMode(TOUCH_XP, OUTPUT);
+    pinMode(TOUCH_XN, OUTPUT);
+    digitalWrite(TOUCH_XP, HIGH);
+    digitalWrite(TOUCH_XN, LOW);
+    
+    delayMicroseconds(TOUCH_SETTLE_US);
+    x0 = ANALOG_RESOLUTION - _burstRead(TOUCH_YP);
+    
+    // Read y
+    // xp = measure
+    // xn = open
+    // yp = +Vref
+    // yn = ground
 #ifndef ENERGIA
-        digitalWrite(TOUCH_XP, LOW);
-        digitalWrite(TOUCH_XN, LOW);
+    digitalWrite(TOUCH_XP, LOW);
+    digitalWrite(TOUCH_XN, LOW);
 #endif
-        pinMode(TOUCH_XP, INPUT);
-        pinMode(TOUCH_XN, INPUT);
-        
-        pinMode(TOUCH_YP, OUTPUT);
-        pinMode(TOUCH_YN, OUTPUT);
-        digitalWrite(TOUCH_YP, HIGH);
-        digitalWrite(TOUCH_YN, LOW);
-        
-        delayMicroseconds(1000); // delay(1);
-        c = analogRead(TOUCH_XP);
-        delayMicroseconds(1000); // delay(1);
-        d = analogRead(TOUCH_XP);
-        
-        flag |= (absDiff(c, d) > 8);
-        y0  = ANALOG_RESOLUTION - c;
-        
-        // Read z
-        // xp = ground
-        // xn = measure
-        // yp = measure
-        // yn = +Vref
-        pinMode(TOUCH_XP, OUTPUT);
-        pinMode(TOUCH_YN, OUTPUT);
-        digitalWrite(TOUCH_XP, LOW);
-        digitalWrite(TOUCH_YN, HIGH);
-        
+    pinMode(TOUCH_XP, INPUT);
+    pinMode(TOUCH_XN, INPUT);
+    
+    pinMode(TOUCH_YP, OUTPUT);
+    pinMode(TOUCH_YN, OUTPUT);
+    digitalWrite(TOUCH_YP, HIGH);
+    digitalWrite(TOUCH_YN, LOW);
+    
+    delayMicroseconds(TOUCH_SETTLE_US);
+    y0 = ANALOG_RESOLUTION - _burstRead(TOUCH_XP);
+    
+    // Read z
+    // xp = ground
+    // xn = measure
+    // yp = measure
+    // yn = +Vref
+    pinMode(TOUCH_XP, OUTPUT);
+    pinMode(TOUCH_YN, OUTPUT);
+    digitalWrite(TOUCH_XP, LOW);
+    digitalWrite(TOUCH_YN, HIGH);
+    
 #ifndef ENERGIA
-        digitalWrite(TOUCH_XN, LOW);
-        digitalWrite(TOUCH_YP, LOW);
+    digitalWrite(TOUCH_XN, LOW);
+    digitalWrite(TOUCH_YP, LOW);
 #endif
-        pinMode(TOUCH_XN, INPUT);
-        pinMode(TOUCH_YP, INPUT);
+    pinMode(TOUCH_XN, INPUT);
+    pinMode(TOUCH_YP, INPUT);
+    
+    delayMicroseconds(TOUCH_SETTLE_US);
+    // Because TOUCH_XN is not analog, only TOUCH_YP is read
+    z0 = ANALOG_RESOLUTION - _burstRead(TOUCH_YP);
+    
+    return (z0 > _touchTrim);
+}
+
+#if defined(ti_sysbios_BIOS___VERS)
+// attachInterrupt() takes no argument, one screen has the touch service
+static Screen_K35_SPI *touchScreen = NULL;
+
+bool Screen_K35_SPI::beginTouchService(uint8_t priority)
+{
+    Semaphore_Params semParams;
+    Task_Params taskParams;
+    Error_Block eb;
+    
+    if (_touchService != NULL) return true;
+    if ((_touchTrim == 0) || (touchScreen != NULL)) return false;
+    
+    _touchHead  = 0;
+    _touchCount = 0;
+    _touchX     = 0;
+    _touchY     = 0;
+    _touchZ     = 0;
+    
+    Semaphore_Params_init(&semParams);
+    semParams.mode = Semaphore_Mode_BINARY;
+    Semaphore_construct(&_penSem, 0, &semParams);
+    Semaphore_Params_init(&semParams);
+    Semaphore_construct(&_eventSem, 0, &semParams);
+    
+    touchScreen = this;
+    
+    Error_init(&eb);
+    Task_Params_init(&taskParams);
+    taskParams.priority  = priority;
+    taskParams.stackSize = TOUCH_TASK_STACK;
+    taskParams.arg0      = (UArg)this;
+    _touchService = Task_create(_touchTaskFxn, &taskParams, &eb);
+    
+    if (_touchService == NULL) {
+        touchScreen = NULL;
+        Semaphore_destruct(&_penSem);
+        Semaphore_destruct(&_eventSem);
+        return false;
+    }
+    return true;
+}
+
+bool Screen_K35_SPI::getTouchEvent(touchEvent_t &event, uint32_t timeout)
+{
+    if (_touchService == NULL) return false;
+    
+    if (!Semaphore_pend(Semaphore_handle(&_eventSem),
+                        (timeout == TOUCH_WAIT_FOREVER) ? BIOS_WAIT_FOREVER : timeout)) {
+        return false;
+    }
+    
+    uint32_t key = Task_disable();
+    event = _touchEvents[_touchHead];
+    _touchHead = (_touchHead + 1) % TOUCH_QUEUE_SIZE;
+    _touchCount--;
+    Task_restore(key);
+    return true;
+}
+
+void Screen_K35_SPI::_penDownIsr()
+{
+    // Re-enabled by attachInterrupt() once the pen is up again
+    disablePinInterrupt(TOUCH_YN);
+    Semaphore_post(Semaphore_handle(&touchScreen->_penSem));
+}
+
+void Screen_K35_SPI::_touchTaskFxn(UArg arg0, UArg arg1)
+{
+    ((Screen_K35_SPI *)arg0)->_touchTask();
+}
+
+void Screen_K35_SPI::_touchTask()
+{
+    uint16_t x0, y0, z0;
+    
+    while (true) {
+        // No sampling at all until the plates touch
+        _setPenDetect();
+        attachInterrupt(TOUCH_YN, _penDownIsr, FALLING);
+        Semaphore_pend(Semaphore_handle(&_penSem), BIOS_WAIT_FOREVER);
+        
+        // Bounce or an interrupt left over from the last touch
+        if (!_sampleTouch(x0, y0, z0)) continue;
+        
+        // IIR in Q4, started on the first sample
+        _filterX = (int32_t)x0 << 4;
+        _filterY = (int32_t)y0 << 4;
+        _touchX  = x0;
+        _touchY  = y0;
+        _touchZ  = z0;
+        _queueTouch(TOUCH_DOWN, x0, y0, z0);
         
-        delayMicroseconds(1000); // delay(1);
-        a = analogRead(TOUCH_XN);
-        delayMicroseconds(1000); // delay(1);
-        c = analogRead(TOUCH_YP);
-        delayMicroseconds(1000); // delay(1);
-        b = analogRead(TOUCH_XN);
-        delayMicroseconds(1000); // delay(1);
-        d = analogRead(TOUCH_YP);
+        while (true) {
+            Task_sleep(TOUCH_PERIOD);
+            if (!_sampleTouch(x0, y0, z0)) break;
+            
+            _filterX += (((int32_t)x0 << 4) - _filterX) >> TOUCH_IIR_SHIFT;
+            _filterY += (((int32_t)y0 << 4) - _filterY) >> TOUCH_IIR_SHIFT;
+            x0 = (_filterX + 8) >> 4;
+            y0 = (_filterY + 8) >> 4;
+            _touchZ = z0;
+            if ((x0 != _touchX) || (y0 != _touchY)) {
+                _touchX = x0;
+                _touchY = y0;
+                _queueTouch(TOUCH_MOVE, x0, y0, z0);
+            }
+        }
         
-        flag |= (absDiff(a, b) > 8);
-        flag |= (absDiff(c, d) > 8);
-        // z0 = (ANALOG_RESOLUTION - (c-a));
-        // Because a = TOUCH_XN non analog, remove a
-        z0 = ANALOG_RESOLUTION - c;
+        _touchZ = 0;
+        _queueTouch(TOUCH_UP, _touchX, _touchY, 0);
     }
-    while (flag);
 }
 
+void Screen_K35_SPI::_queueTouch(uint8_t type, uint16_t x0, uint16_t y0, uint16_t z0)
+{
+    touchEvent_t event;
+    uint8_t index;
+    
+    event.type = type;
+    event.z    = z0;
+    _mapTouch(x0, y0, event.x, event.y);
+    
+    uint32_t key = Task_disable();
+    if (_touchCount < TOUCH_QUEUE_SIZE) {
+        index = (_touchHead + _touchCount) % TOUCH_QUEUE_SIZE;
+        _touchEvents[index] = event;
+        _touchCount++;
+        Task_restore(key);
+        Semaphore_post(Semaphore_handle(&_eventSem));
+        return;
+    }
+    // Full: a move updates the last move, anything else is lost
+    index = (_touchHead + TOUCH_QUEUE_SIZE - 1) % TOUCH_QUEUE_SIZE;
+    if ((type == TOUCH_MOVE) && (_touchEvents[index].type == TOUCH_MOVE)) {
+        _touchEvents[index] = event;
+    }
+    Task_restore(key);
+}
+#else
+
+bool Screen_K35_SPI::beginTouchService(uint8_t priority)
+{
+    return false;
+}
+
+bool Screen_K35_SPI::getTouchEvent(touchEvent_t &event, uint32_t timeout)
+{
+    return false;
+}
+#endif // ti_sysbios_BIOS___VERS
+
 void Screen_K35_SPI::_setBacklight(bool flag)
 {
     if (flag)   _writeRegister(SSD2119_SLEEP_MODE_REG, 0);
@@ -62,6 +62,32 @@
 #include "LCD_screen_font.h"
 #include "SPI.h"
 
+///
+/// @name   Touch service
+///
+/// @{
+
+#define TOUCH_DOWN          1       ///< pen put down
+#define TOUCH_MOVE          2       ///< pen moved while down
+#define TOUCH_UP            3       ///< pen lifted, at the last position
+#define TOUCH_QUEUE_SIZE    8       ///< events kept for the UI task
+#define TOUCH_TASK_PRIORITY 2       ///< above the sketch tasks
+#define TOUCH_TASK_STACK    0x400
+#define TOUCH_PERIOD        10      ///< ms between samples while the pen is down
+#define TOUCH_WAIT_FOREVER  0xffffffff
+
+/// @}
+
+///
+/// @brief      Touch event queued by the touch service
+///
+struct touchEvent_t {
+    uint8_t  type;  ///< TOUCH_DOWN, TOUCH_MOVE or TOUCH_UP
+    uint16_t x;     ///< coordinates for the current orientation
+    uint16_t y;
+    uint16_t z;     ///< pressure, 0 for TOUCH_UP
+};
+
 //#if LCD_SCREEN_FONT_RELEASE < 117
 //#error Required LCD_SCREEN_FONT_RELEASE 117
 //#endif
@@ -95,6 +121,29 @@ public:
     ///
     String WhoAmI();
     
+    ///
+    /// @brief      Start the touch service
+    /// @details    A task waits for the pen-down interrupt, samples the
+    /// panel every TOUCH_PERIOD ms while the pen is down and queues the
+    /// filtered positions for getTouchEvent().
+    /// @n          getTouch() then returns the last position at once
+    /// instead of sampling the panel.
+    /// @param      priority task priority, default TOUCH_TASK_PRIORITY
+    /// @return     true if the service runs
+    ///
+    bool beginTouchService(uint8_t priority = TOUCH_TASK_PRIORITY);
+    
+    ///
+    /// @brief      Get the next touch event
+    /// @param      event queued event
+    /// @param      timeout ms to wait for an event, 0 returns at once,
+    /// TOUCH_WAIT_FOREVER waits until the panel is touched
+    /// @return     true if an event was taken
+    /// @note       When the UI task falls TOUCH_QUEUE_SIZE events behind, the
+    /// last TOUCH_MOVE in the queue is updated instead of adding a new one.
+    ///
+    bool getTouchEvent(touchEvent_t &event, uint32_t timeout = 0);
+    
 private:
 	// * Virtual =0 compulsory functions
     // Orientation
@@ -127,6 +176,25 @@ private:
     
     // Touch
     void _getOneTouch(uint8_t command8, uint8_t &a, uint8_t &b);
+    void _setPenDetect();
+    bool _penDown();
+    bool _sampleTouch(uint16_t &x0, uint16_t &y0, uint16_t &z0);
+    uint16_t _burstRead(uint8_t pin);
+    
+#if defined(ti_sysbios_BIOS___VERS)
+    // Touch service
+    static void _touchTaskFxn(UArg arg0, UArg arg1);
+    static void _penDownIsr();
+    void _touchTask();
+    void _queueTouch(uint8_t type, uint16_t x0, uint16_t y0, uint16_t z0);
+    
+    Task_Handle      _touchService;
+    Semaphore_Struct _penSem, _eventSem;
+    touchEvent_t     _touchEvents[TOUCH_QUEUE_SIZE];
+    uint8_t          _touchHead, _touchCount;
+    volatile uint16_t _touchX, _touchY, _touchZ;
+    int32_t          _filterX, _filterY;
+#endif
 
     uint8_t _pinScreenDataCommand, _pinScreenReset, _pinScreenChipSelect, _pinScreenBackLight;
 };
@@ -0,0 +1,55 @@
+///
+/// @file       LCD_TouchDraw.ino
+/// @brief      Draw with the pen, using the touch service
+///
+/// @details    The touch service samples the panel from its own task, only
+/// while the pen is down, and queues the positions. The sketch waits for
+/// the events instead of polling getTouch().
+///
+/// @see        ReadMe.txt for references
+///
+
+#include "SPI.h"
+#include "Screen_K35_SPI.h"
+
+Screen_K35_SPI myScreen;
+
+uint16_t lastX, lastY;
+
+void setup()
+{
+    Serial.begin(115200);
+
+    myScreen.begin();
+    myScreen.clear();
+    myScreen.gText(4, 4, "Draw with the pen");
+
+    if (!myScreen.beginTouchService()) {
+        Serial.println("Touch service not started");
+    }
+}
+
+void loop()
+{
+    touchEvent_t event;
+
+    // Sleeps until the panel is touched
+    if (!myScreen.getTouchEvent(event, TOUCH_WAIT_FOREVER)) return;
+
+    switch (event.type) {
+        case TOUCH_DOWN:
+            myScreen.point(event.x, event.y, whiteColour);
+            break;
+        case TOUCH_MOVE:
+            myScreen.line(lastX, lastY, event.x, event.y, whiteColour);
+            break;
+        case TOUCH_UP:
+            Serial.print("Pen up at ");
+            Serial.print(event.x);
+            Serial.print(", ");
+            Serial.println(event.y);
+            break;
+    }
+    lastX = event.x;
+    lastY = event.y;
+}
@@ -0,0 +1,298 @@
+#include <aJSON.h>
+#include <string.h>
+#include <PString.h>
+#include "M2XStreamClient.h"
+
+#define SAMPLE_RENDERED 0x01
+
+static const char kDigitPairs[] =
+  "00010203040506070809"
+  "10111213141516171819"
+  "20212223242526272829"
+  "30313233343536373839"
+  "40414243444546474849"
+  "50515253545556575859"
+  "60616263646566676869"
+  "70717273747576777879"
+  "80818283848586878889"
+  "90919293949596979899";
+
+static const float kPow10f[M2X_MAX_DECIMALS + 1] = {
+  1e0f, 1e1f, 1e2f, 1e3f, 1e4f, 1e5f, 1e6f, 1e7f
+};
+
+static const double kPow10[M2X_MAX_DECIMALS + 1] = {
+  1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7
+};
+
+static inline char* put_pair(char* p, uint32_t n) {
+  memcpy(p, kDigitPairs + 2 * n, 2);
+  return p + 2;
+}
+
+// Writes n / 10^decimals with its decimal point, two digits per division
+static int format_scaled(char* buf, bool negative, uint32_t n, uint8_t decimals) {
+  char digits[10];
+  char* end = digits + sizeof(digits);
+  char* p = end;
+  char* out = buf;
+
+  if (negative && n != 0) {
+    *out++ = '-';
+  }
+  while (n >= 100) {
+    p -= 2;
+    put_pair(p, n % 100);
+    n /= 100;
+  }
+  if (n >= 10) {
+    p -= 2;
+    put_pair(p, n);
+  } else {
+    *--p = '0' + n;
+  }
+  // At least one digit before the point, 0.05 and not .05
+  while (end - p < decimals + 1) {
+    *--p = '0';
+  }
+
+  int whole = end - p - decimals;
+  memcpy(out, p, whole);
+  out += whole;
+  if (decimals > 0) {
+    *out++ = '.';
+    memcpy(out, p + whole, decimals);
+    out += decimals;
+  }
+  *out = 0;
+  return out - buf;
+}
+
+int m2x_format_number(char* buf, float value, uint8_t decimals) {
+  if (decimals > M2X_MAX_DECIMALS) decimals = M2X_MAX_DECIMALS;
+  float scaled = value * kPow10f[decimals];
+  bool negative = scaled < 0;
+  if (negative) scaled = -scaled;
+  // Also false for NaN. 4294967040 is the largest float below 2^32.
+  if (!(scaled <= 4294967040.0f)) {
+    return 0;
+  }
+  return format_scaled(buf, negative, (uint32_t)(scaled + 0.5f), decimals);
+}
+
+int m2x_format_number(char* buf, double value, uint8_t decimals) {
+  if (decimals > M2X_MAX_DECIMALS) decimals = M2X_MAX_DECIMALS;
+  double scaled = value * kPow10[decimals];
+  bool negative = scaled < 0;
+  if (negative) scaled = -scaled;
+  if (!(scaled < 4294967295.0)) {
+    return 0;
+  }
+  return format_scaled(buf, negative, (uint32_t)(scaled + 0.5), decimals);
+}
+
+// "yyyy-mm-dd" of a day number since 1970, after H. Hinnant's
+// days_from_civil inverse: years start in March so that the leap day
+// comes last
+static void format_date(char* buf, uint32_t day) {
+  uint32_t z = day + 719468;
+  uint32_t era = z / 146097;
+  uint32_t doe = z - era * 146097;
+  uint32_t yoe = (doe - doe / 1460 + doe / 36524 - doe / 146096) / 365;
+  uint32_t doy = doe - (365 * yoe + yoe / 4 - yoe / 100);
+  uint32_t mp = (5 * doy + 2) / 153;
+  uint32_t d = doy - (153 * mp + 2) / 5 + 1;
+  uint32_t m = mp < 10 ? mp + 3 : mp - 9;
+  uint32_t y = yoe + era * 400 + (m <= 2);
+
+  buf = put_pair(buf, y / 100);
+  buf = put_pair(buf, y % 100);
+  *buf++ = '-';
+  buf = put_pair(buf, m);
+  *buf++ = '-';
+  buf = put_pair(buf, d);
+  *buf = 0;
+}
+
+// "THH:MM:SS.SSSZ" of the seconds into a day
+static int format_clock(char* buf, uint32_t seconds, uint16_t ms) {
+  char* p = buf;
+
+  *p++ = 'T';
+  p = put_pair(p, seconds / 3600);
+  *p++ = ':';
+  p = put_pair(p, seconds / 60 % 60);
+  *p++ = ':';
+  p = put_pair(p, seconds % 60);
+  *p++ = '.';
+  *p++ = '0' + ms / 100 % 10;
+  p = put_pair(p, ms % 100);
+  *p++ = 'Z';
+  *p = 0;
+  return p - buf;
+}
+
+int m2x_format_time(char* buf, uint32_t at, uint16_t ms) {
+  format_date(buf, at / 86400);
+  return 10 + format_clock(buf + 10, at % 86400, ms);
+}
+
+M2XBatch::M2XBatch(M2XSample* samples, uint16_t capacity, char* body, size_t bodySize)
+  : _samples(samples), _capacity(capacity), _head(0), _count(0), _dropped(0),
+    _body(body), _bodySize(bodySize), _streams(0), _day(0xffffffff) {
+}
+
+int M2XBatch::addStream(const char* name, uint8_t decimals) {
+  if (_streams == M2X_BATCH_MAX_STREAMS) {
+    return -1;
+  }
+  _names[_streams] = name;
+  _decimals[_streams] = decimals > M2X_MAX_DECIMALS ? M2X_MAX_DECIMALS : decimals;
+  return _streams++;
+}
+
+bool M2XBatch::add(uint8_t stream, float value, uint32_t at, uint16_t ms) {
+  if (stream >= _streams || _capacity == 0) {
+    return false;
+  }
+  if (_count == _capacity) {
+    // Full, the oldest sample makes room
+    _head = _head + 1 == _capacity ? 0 : _head + 1;
+    _count--;
+    _dropped++;
+  }
+
+  M2XSample& s = sample(_count++);
+  s.at = at;
+  s.value = value;
+  s.ms = ms;
+  s.stream = stream;
+  s.flags = 0;
+  return true;
+}
+
+void M2XBatch::clear() {
+  _head = 0;
+  _count = 0;
+}
+
+int M2XBatch::renderSample(char* out, const M2XSample& s) {
+  char* p = out;
+
+  *p++ = '{';
+  if (s.at != 0) {
+    uint32_t day = s.at / 86400;
+    if (day != _day) {
+      format_date(_date, day);
+      _day = day;
+    }
+    memcpy(p, "\"timestamp\":\"", 13);
+    p += 13;
+    memcpy(p, _date, 10);
+    p += 10;
+    p += format_clock(p, s.at - day * 86400, s.ms);
+    *p++ = '"';
+    *p++ = ',';
+  }
+  memcpy(p, "\"value\":", 8);
+  p += 8;
+
+  uint8_t decimals = _decimals[s.stream];
+  int length = m2x_format_number(p, s.value, decimals);
+  if (length == 0) {
+    PString number(p, M2X_NUMBER_MAX);
+    number.print(s.value, decimals);
+    length = number.length();
+  }
+  p += length;
+  *p++ = '}';
+  return p - out;
+}
+
+int M2XBatch::render() {
+  char* out = _body;
+  int rendered = 0;
+  bool full = false;
+
+  if (_count == 0) {
+    return 0;
+  }
+  if (_bodySize < 11 + 4) {
+    return E_INVALID;
+  }
+  // Room is kept for the closing "]}}" and the 0 terminator
+  char* end = _body + _bodySize - 4;
+  memcpy(out, "{\"values\":{", 11);
+  out += 11;
+
+  for (uint8_t stream = 0; stream < _streams && !full; stream++) {
+    size_t nameLength = strlen(_names[stream]);
+    bool first = true;
+
+    for (uint16_t i = 0; i < _count; i++) {
+      M2XSample& s = sample(i);
+      if (s.stream != stream || (s.flags & SAMPLE_RENDERED)) {
+        continue;
+      }
+
+      if (first) {
+        // ,"name":[ and the first sample
+        if (out + nameLength + 5 + M2X_SAMPLE_MAX > end) {
+          full = true;
+          break;
+        }
+        if (rendered > 0) {
+          *out++ = ',';
+        }
+        *out++ = '"';
+        memcpy(out, _names[stream], nameLength);
+        out += nameLength;
+        memcpy(out, "\":[", 3);
+        out += 3;
+        first = false;
+      } else {
+        if (out + M2X_SAMPLE_MAX > end) {
+          full = true;
+          break;
+        }
+        *out++ = ',';
+      }
+      out += renderSample(out, s);
+      s.flags |= SAMPLE_RENDERED;
+      rendered++;
+    }
+    if (!first) {
+      *out++ = ']';
+    }
+  }
+
+  if (rendered == 0) {
+    return E_INVALID;
+  }
+  *out++ = '}';
+  *out++ = '}';
+  *out = 0;
+  return out - _body;
+}
+
+void M2XBatch::commit() {
+  uint16_t kept = 0;
+
+  // Moves the samples left waiting up over the rendered ones, in order
+  for (uint16_t i = 0; i < _count; i++) {
+    M2XSample& s = sample(i);
+    if (!(s.flags & SAMPLE_RENDERED)) {
+      if (kept != i) {
+        sample(kept) = s;
+      }
+      kept++;
+    }
+  }
+  _count = kept;
+}
+
+void M2XBatch::rollback() {
+  for (uint16_t i = 0; i < _count; i++) {
+    sample(i).flags &= ~SAMPLE_RENDERED;
+  }
+}
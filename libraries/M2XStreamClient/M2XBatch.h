@@ -0,0 +1,109 @@
+#ifndef M2XBatch_h
+#define M2XBatch_h
+
+#include <stdint.h>
+#include <stddef.h>
+
+// Streams a batch can carry
+#define M2X_BATCH_MAX_STREAMS 16
+
+// Most decimals a number is rendered with
+#define M2X_MAX_DECIMALS 7
+
+// Longest number m2x_format_number() renders, with its 0 terminator
+#define M2X_NUMBER_MAX 20
+
+// Longest sample in a body:
+// ,{"timestamp":"2015-03-22T19:15:00.000Z","value":-429496729.5000000}
+#define M2X_SAMPLE_MAX (49 + M2X_NUMBER_MAX + 1)
+
+// Renders value rounded to decimals digits after the point into buf,
+// which has room for M2X_NUMBER_MAX bytes, and returns the length. The
+// value is scaled to an integer once and printed two digits at a time,
+// much cheaper than Print's digit by digit float arithmetic. Returns 0
+// if value * 10^decimals does not fit 32 bits (or is not a number), in
+// which case buf is untouched and the caller falls back to Print.
+int m2x_format_number(char* buf, float value, uint8_t decimals);
+int m2x_format_number(char* buf, double value, uint8_t decimals);
+
+// Renders seconds since 1970 and milliseconds in ISO8601,
+// "yyyy-mm-ddTHH:MM:SS.SSSZ", into buf (25 bytes) and returns 24
+int m2x_format_time(char* buf, uint32_t at, uint16_t ms);
+
+// One value waiting in a batch, 12 bytes
+typedef struct {
+  uint32_t at;      // seconds since 1970, 0 to let M2X stamp it
+  float value;
+  uint16_t ms;
+  uint8_t stream;   // index returned by M2XBatch::addStream()
+  uint8_t flags;
+} M2XSample;
+
+// Time series samples of several streams of a device, kept in binary
+// in a ring and rendered into a JSON body only when they are posted
+// with M2XStreamClient::postBatch():
+//
+//   M2XSample samples[500];
+//   char body[2048];
+//   M2XBatch batch(samples, 500, body, sizeof(body));
+//   int temperature = batch.addStream("temperature", 1);
+//   ...
+//   batch.add(temperature, degreesC, now);
+//   ...
+//   m2xClient.postBatch(deviceId, batch);
+//
+// Both arrays belong to the caller, so the memory used is fixed. When
+// the ring is full the oldest sample is dropped and counted. A body
+// that cannot hold all the samples is posted in several requests.
+class M2XBatch {
+public:
+  M2XBatch(M2XSample* samples, uint16_t capacity, char* body, size_t bodySize);
+
+  // Registers a stream; name must stay valid as long as the batch.
+  // Returns its index for add(), or -1 once M2X_BATCH_MAX_STREAMS are in.
+  int addStream(const char* name, uint8_t decimals = 2);
+
+  // Appends a sample, overwriting the oldest one when full.
+  // Returns false if stream is not a registered index.
+  bool add(uint8_t stream, float value, uint32_t at = 0, uint16_t ms = 0);
+
+  // Samples waiting to be posted
+  uint16_t available() { return _count; }
+  // Samples overwritten before they could be posted
+  uint32_t dropped() { return _dropped; }
+  void clear();
+
+  // Renders as many waiting samples as fit into the body, grouped by
+  // stream, and returns its length; 0 when nothing is waiting, E_INVALID
+  // if the body cannot even hold one sample. The rendered samples stay
+  // in the ring until commit(); rollback() makes them waiting again.
+  int render();
+  const char* body() { return _body; }
+  void commit();
+  void rollback();
+
+private:
+  M2XSample* _samples;
+  uint16_t _capacity;
+  uint16_t _head;
+  uint16_t _count;
+  uint32_t _dropped;
+  char* _body;
+  size_t _bodySize;
+
+  uint8_t _streams;
+  const char* _names[M2X_BATCH_MAX_STREAMS];
+  uint8_t _decimals[M2X_BATCH_MAX_STREAMS];
+
+  // "yyyy-mm-dd" of the last timestamp rendered, dates change rarely
+  uint32_t _day;
+  char _date[11];
+
+  M2XSample& sample(uint16_t i) {
+    uint16_t at = _head + i;
+    return _samples[at >= _capacity ? at - _capacity : at];
+  }
+  int renderSample(char* out, const M2XSample& s);
+};
+
+#endif  /* M2XBatch_h */
@@ -22,7 +22,10 @@
 #endif
 
 #include "Client.h"
+#include "HttpResponse.h"
 #include "NullPrint.h"
+#include <PString.h>
+#include "M2XBatch.h"
 
 #ifdef DEBUG
 #if defined(ARDUINO_PLATFORM) || defined(ENERGIA_PLATFORM)
@@ -45,6 +48,13 @@
 #define TO_HEX(t_) ((char) (((t_) > 9) ? ((t_) - 10 + 'A') : ((t_) + '0')))
 #define MAX_DOUBLE_DIGITS 7
 
+// A request, but for postBatch()'s body, is built in a stack buffer of
+// this size: one that fits goes out in one write, a longer one in
+// writes of this size
+#ifndef M2X_REQUEST_MAX
+#define M2X_REQUEST_MAX 384
+#endif
+
 static const int E_OK = 0;
 static const int E_NOCONNECTION = -1;
 static const int E_DISCONNECTED = -2;
@@ -57,6 +67,8 @@ public:
   static const char* kDefaultM2XHost;
   static const int kDefaultM2XPort = 80;
 
+  // case_insensitive is kept for existing sketches: response headers are
+  // always matched without regard to case, as HTTP requires.
   M2XStreamClient(Client* client,
                   const char* key,
                   int case_insensitive = 1,
@@ -91,6 +103,13 @@ public:
                         const char* names[], const int counts[],
                         const char* ats[], T values[]);
 
+  // Post the samples waiting in +batch+ to +deviceId+, in as many
+  // requests as its body buffer needs. Samples are only removed from
+  // the batch once M2X accepted them, so after a failure they are sent
+  // again by the next call. Returns the HTTP status code of the last
+  // request, E_OK if there was nothing to post.
+  int postBatch(const char* deviceId, M2XBatch& batch);
+
   // Fetch values for a particular data stream. Since memory is
   // very limited on a board, we cannot parse and get all the
   // data points in memory. Instead, we use callbacks here: whenever
@@ -149,36 +168,30 @@ public:
 private:
   Client* _client;
   const char* _key;
-  int _case_insensitive;
   const char* _host;
   int _port;
   NullPrint _null_print;
+  HttpResponse _response;
 
   // Writes the HTTP header part for updating a stream value
-  void writePutHeader(const char* deviceId,
+  void writePutHeader(PString* request,
+                      const char* deviceId,
                       const char* streamName,
                       int contentLength);
   // Writes the HTTP header part for deleting stream values
-  void writeDeleteHeader(const char* deviceId,
+  void writeDeleteHeader(PString* request,
+                         const char* deviceId,
                          const char* streamName,
                          int contentLength);
   // Writes HTTP header lines including M2X API Key, host, content
   // type and content length(if the body exists)
-  void writeHttpHeader(int contentLength);
-  // Parses HTTP response header and return the content length.
-  // Note that this function does not parse all http headers, as long
-  // as the content length is found, this function will return
-  int readContentLength();
-  // Skips all HTTP response header part. Return minus value in case
-  // the connection is closed before we got all headers
-  int skipHttpHeader();
-  // Parses and returns the HTTP status code, note this function will
-  // return immediately once it gets the status code
+  void writeHttpHeader(PString* request, int contentLength);
+  // Connects and points +request+ at the client: what is built in it
+  // goes out as it fills, and the rest with request->spill()
+  bool beginRequest(PString* request);
+  // Parses the HTTP status line and headers, returning the status code.
+  // The response body can then be read from _response
   int readStatusCode(bool closeClient);
-  // Waits for a certain string pattern in the HTTP header, and returns
-  // once the pattern is found. In the pattern, you can use '*' to denote
-  // any character
-  int waitForString(const char* str);
   // Closes the connection
   void close();
   // Parses JSON response
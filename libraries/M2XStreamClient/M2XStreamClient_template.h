@@ -3,23 +3,48 @@
 
 // Implementations of template functions
 
-int print_encoded_string(Print* print, const char* str);
+// Prints a value the way Print does, floating point numbers with
+// +decimals+ digits through m2x_format_number()
+template <class T>
+inline int print_value(Print* print, T value, uint8_t decimals = 2) {
+  return print->print(value);
+}
+
+inline int print_value(Print* print, float value, uint8_t decimals = 2) {
+  char number[M2X_NUMBER_MAX];
+  int length = m2x_format_number(number, value, decimals);
+  if (length == 0) {
+    return print->print(value, decimals);
+  }
+  return print->write((const uint8_t*) number, length);
+}
+
+inline int print_value(Print* print, double value, uint8_t decimals = 2) {
+  char number[M2X_NUMBER_MAX];
+  int length = m2x_format_number(number, value, decimals);
+  if (length == 0) {
+    return print->print(value, decimals);
+  }
+  return print->write((const uint8_t*) number, length);
+}
 
 template <class T>
 int M2XStreamClient::updateStreamValue(const char* deviceId, const char* streamName, T value) {
-  if (_client->connect(_host, _port)) {
-    DBGLN("%s", "Connected to M2X server!");
-    writePutHeader(deviceId, streamName,
-                   //  for {"value": and }
-                   _null_print.print(value) + 10);
-    _client->print("{\"value\":");
-    _client->print(value);
-    _client->print("}");
-  } else {
-    DBGLN("%s", "ERROR: Cannot connect to M2X server!");
+  char buf[M2X_REQUEST_MAX];
+  PString request(buf, sizeof(buf));
+
+  if (!beginRequest(&request)) {
     return E_NOCONNECTION;
   }
 
+  writePutHeader(&request, deviceId, streamName,
+                 //  for {"value": and }
+                 print_value(&_null_print, value) + 10);
+  request.print("{\"value\":");
+  print_value(&request, value);
+  request.print("}");
+
+  request.spill();
   return readStatusCode(true);
 }
 
@@ -41,7 +66,7 @@ inline int write_multiple_values(Print* print, int streamNum,
         bytes += print->print("\",");
       }
       bytes += print->print("\"value\": \"");
-      bytes += print->print(values[value_index]);
+      bytes += print_value(print, values[value_index]);
       bytes += print->print("\"}");
       if (j < counts[i] - 1) { bytes += print->print(","); }
       value_index++;
@@ -57,19 +82,22 @@ template <class T>
 int M2XStreamClient::postDeviceUpdates(const char* deviceId, int streamNum,
                                        const char* names[], const int counts[],
                                        const char* ats[], T values[]) {
-  if (_client->connect(_host, _port)) {
-    DBGLN("%s", "Connected to M2X server!");
-    int length = write_multiple_values(&_null_print, streamNum, names,
-                                       counts, ats, values);
-    _client->print("POST /v2/devices/");
-    print_encoded_string(_client, deviceId);
-    _client->println("/updates HTTP/1.0");
-    writeHttpHeader(length);
-    write_multiple_values(_client, streamNum, names, counts, ats, values);
-  } else {
-    DBGLN("%s", "ERROR: Cannot connect to M2X server!");
+  char buf[M2X_REQUEST_MAX];
+  PString request(buf, sizeof(buf));
+
+  if (!beginRequest(&request)) {
     return E_NOCONNECTION;
   }
+
+  int length = write_multiple_values(&_null_print, streamNum, names,
+                                     counts, ats, values);
+  request.print("POST /v2/devices/");
+  request.printUrl(deviceId);
+  request.println("/updates HTTP/1.0");
+  writeHttpHeader(&request, length);
+  write_multiple_values(&request, streamNum, names, counts, ats, values);
+
+  request.spill();
   return readStatusCode(true);
 }
 
@@ -97,11 +125,11 @@ static int write_location_data(Print* print, const char* name,
   bytes += print->print("{\"name\":\"");
   bytes += print->print(name);
   bytes += print->print("\",\"latitude\":\"");
-  bytes += print->print(latitude, MAX_DOUBLE_DIGITS);
+  bytes += print_value(print, latitude, MAX_DOUBLE_DIGITS);
   bytes += print->print("\",\"longitude\":\"");
-  bytes += print->print(longitude, MAX_DOUBLE_DIGITS);
+  bytes += print_value(print, longitude, MAX_DOUBLE_DIGITS);
   bytes += print->print("\",\"elevation\":\"");
-  bytes += print->print(elevation);
+  bytes += print_value(print, elevation);
   bytes += print->print("\"}");
   return bytes;
 }
@@ -112,21 +140,23 @@ int M2XStreamClient::updateLocation(const char* deviceId,
                                     T latitude,
                                     T longitude,
                                     T elevation) {
-  if (_client->connect(_host, _port)) {
-    DBGLN("%s", "Connected to M2X server!");
-
-    int length = write_location_data(&_null_print, name, latitude, longitude,
-                                     elevation);
-    _client->print("PUT /v2/devices/");
-    print_encoded_string(_client, deviceId);
-    _client->println("/location HTTP/1.0");
-
-    writeHttpHeader(length);
-    write_location_data(_client, name, latitude, longitude, elevation);
-  } else {
-    DBGLN("%s", "ERROR: Cannot connect to M2X server!");
+  char buf[M2X_REQUEST_MAX];
+  PString request(buf, sizeof(buf));
+
+  if (!beginRequest(&request)) {
     return E_NOCONNECTION;
   }
+
+  int length = write_location_data(&_null_print, name, latitude, longitude,
+                                   elevation);
+  request.print("PUT /v2/devices/");
+  request.printUrl(deviceId);
+  request.println("/location HTTP/1.0");
+
+  writeHttpHeader(&request, length);
+  write_location_data(&request, name, latitude, longitude, elevation);
+
+  request.spill();
   return readStatusCode(true);
 }
 
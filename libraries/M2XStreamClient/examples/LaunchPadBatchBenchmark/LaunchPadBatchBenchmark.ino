@@ -0,0 +1,90 @@
+/*
+  LaunchPadBatchBenchmark
+
+  Measures how fast samples are turned into M2X request bodies, without
+  a network: 10 streams of 50 samples each, rendered by an M2XBatch and,
+  for comparison, through Print the way postDeviceUpdates() used to.
+  The 4 KB body holds less than 100 samples, so a batch is rendered as a few
+  request bodies, as postBatch() would send it. Each result line is
+  followed by the samples per second.
+*/
+
+#include <aJSON.h>
+#include <Benchmark.h>
+#include "M2XStreamClient.h"
+
+#define STREAMS   10
+#define SAMPLES   50
+#define TOTAL     (STREAMS * SAMPLES)
+
+const char *streamNames[STREAMS] = {
+  "s0", "s1", "s2", "s3", "s4", "s5", "s6", "s7", "s8", "s9"
+};
+
+M2XSample samples[TOTAL];
+char body[4096];
+M2XBatch batch(samples, TOTAL, body, sizeof(body));
+
+float values[TOTAL];
+NullPrint nullPrint;
+Benchmark bench(Serial);
+
+// 2015-03-22T19:15:00Z
+uint32_t start = 1427051700;
+
+void fill() {
+  for (int i = 0; i < TOTAL; i++) {
+    batch.add(i % STREAMS, values[i], start + i, i % 1000);
+  }
+}
+
+void renderBatch(void *arg) {
+  fill();
+  while (batch.render() > 0) {
+    batch.commit();
+  }
+}
+
+void printFloats(void *arg) {
+  // The values alone, as Print renders them
+  for (int i = 0; i < TOTAL; i++) {
+    nullPrint.print(values[i]);
+  }
+}
+
+void formatFloats(void *arg) {
+  char number[M2X_NUMBER_MAX];
+  for (int i = 0; i < TOTAL; i++) {
+    m2x_format_number(number, values[i], 2);
+  }
+}
+
+void report() {
+  Serial.print("  ");
+  Serial.print(bench.opsPerSecond() * TOTAL);
+  Serial.println(" samples/s");
+}
+
+void setup() {
+  Serial.begin(115200);
+  delay(1000);
+
+  for (int i = 0; i < TOTAL; i++) {
+    values[i] = 20.0 + (i % 97) * 0.37 - (i % 13);
+  }
+  for (int i = 0; i < STREAMS; i++) {
+    batch.addStream(streamNames[i], 2);
+  }
+  Serial.println("M2X batch benchmark");
+}
+
+void loop() {
+  bench.run("M2XBatch render, 500 samples", renderBatch);
+  report();
+  bench.run("Print float x 500", printFloats);
+  report();
+  bench.run("m2x_format_number x 500", formatFloats);
+  report();
+  Serial.println();
+  delay(5000);
+}
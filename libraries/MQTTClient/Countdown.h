@@ -17,12 +17,19 @@
 #if !defined(COUNTDOWN_H)
 #define COUNTDOWN_H
 
+/*
+ * The interval is kept as a start time and a length, and compared with
+ * millis() - start, which stays right when millis() wraps after 49 days.
+ * A default constructed Countdown never expires.
+ */
 class Countdown
 {
 public:
     Countdown()
-    {  
-		interval_end_ms = 0L;
+    {
+        start_ms = 0L;
+        interval_ms = 0L;
+        armed = false;
     }
     
     Countdown(int ms)
@@ -32,12 +39,14 @@ public:
     
     bool expired()
     {
-        return (interval_end_ms > 0L) && (millis() >= interval_end_ms);
+        return armed && (millis() - start_ms >= interval_ms);
     }
     
     void countdown_ms(unsigned long ms)  
     {
-        interval_end_ms = millis() + ms;
+        start_ms = millis();
+        interval_ms = ms;
+        armed = true;
     }
     
     void countdown(int seconds)
@@ -47,11 +56,15 @@ public:
     
     int left_ms()
     {
-        return interval_end_ms - millis();
+        unsigned long elapsed = millis() - start_ms;
+
+        return (elapsed >= interval_ms) ? 0 : (int)(interval_ms - elapsed);
     }
     
 private:
-    unsigned long interval_end_ms; 
+    unsigned long start_ms;
+    unsigned long interval_ms;
+    bool armed;
 };
 
 #endif
@@ -38,6 +38,24 @@ public:
         return client.connect(hostname, port);
     }
 
+    /*
+     * Waits up to timeout_ms for data: returns the bytes ready to read, 0
+     * if none arrived in time, -1 if the connection closed
+     */
+    int waitReadable(int timeout_ms)
+    {
+        int total = 0, rc;
+
+        while ((rc = client.available()) == 0 && client.connected() && total < timeout_ms)
+        {
+            delay(2);
+            total += 2;
+        }
+        if (rc == 0 && !client.connected())
+            rc = -1;
+        return rc;
+    }
+
     int read(unsigned char* buffer, int len, int timeout)
     {
         int interval = 10;  // all times are in milliseconds
@@ -0,0 +1,1118 @@
+/*******************************************************************************
+ * MQTTBroker.h - a small MQTT 3.1.1 broker for clients on the local network
+ *
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the Eclipse Public License v1.0
+ * and Eclipse Distribution License v1.0 which accompany this distribution.
+ *
+ * The Eclipse Public License is available at
+ *    http://www.eclipse.org/legal/epl-v10.html
+ * and the Eclipse Distribution License is available at
+ *   http://www.eclipse.org/org/documents/edl-v10.php.
+ *******************************************************************************/
+
+#if !defined(MQTTBROKER_H)
+#define MQTTBROKER_H
+
+#include <Arduino.h>
+#include <string.h>
+#include "MQTTClient.h"
+
+#if !defined(MQTTBROKER_TOPIC_MAX)
+    #define MQTTBROKER_TOPIC_MAX 64     // longest topic filter a client can subscribe to
+#endif
+
+namespace MQTT
+{
+
+
+struct BrokerStats
+{
+    unsigned long connects;     // CONNECTs accepted
+    unsigned long refused;      // connections turned away: table full or CONNECT refused
+    unsigned long disconnects;  // accepted clients gone, cleanly or not
+    unsigned long received;     // messages published by clients, wills and publish()
+    unsigned long delivered;    // PUBLISH packets sent to subscribers
+    unsigned long dropped;      // messages or deliveries lost to a full store or queue
+    int clients;                // connected now
+    int subscriptions;
+    int messages;               // message buffers in use
+    int retained;
+};
+
+
+/**
+ * @class Broker
+ * @brief non-blocking MQTT 3.1.1 broker, polled from loop()
+ *
+ * Accepts up to MAX_CLIENTS connections from a WiFiServer and passes messages
+ * between them, so that local sensors and actuators talk without a round
+ * trip through a cloud broker.
+ *
+ * A published message is copied once into a reference-counted buffer taken
+ * from a pool of MAX_MESSAGES; each subscriber's queue, an unacknowledged
+ * QoS 1 delivery, the retained set and a client's will only hold a reference.
+ * Subscriptions are indexed by a hash of the first topic level so that a
+ * message is only matched against filters that can match it.
+ *
+ * Limits, all fixed at compile time:
+ * - clean sessions only: nothing is kept for a client after it disconnects
+ * - QoS 0 and 1; a QoS 2 subscription is granted QoS 1, a QoS 2 PUBLISH is
+ *   acknowledged with PUBREC and delivered once on receipt
+ * - a packet, and a message's topic plus payload, fit in MAX_PACKET_SIZE
+ * - at most MAX_MESSAGES / 2 retained messages
+ *
+ * While a subscriber's queue is full, or no message buffer is free, a
+ * PUBLISH from a client is left unread so that TCP holds the publishers back
+ * rather than messages being dropped; a subscriber that takes none of the
+ * messages waiting for it for twice RETRY_MS is disconnected.
+ *
+ * @param Server a server class with begin() and accept(), such as WiFiServer
+ * @param Network the client class accept() returns, such as WiFiClient
+ */
+template<class Server, class Network, int MAX_CLIENTS = 4, int MAX_SUBSCRIPTIONS = 16, int MAX_MESSAGES = 16, int MAX_PACKET_SIZE = 256>
+class Broker
+{
+
+public:
+
+    typedef void (*messageHandler)(MessageData&);
+
+    /** Construct the broker
+     *  @param server - the server that clients connect to, started by begin()
+     */
+    Broker(Server& server);
+
+    /** Start listening for clients
+     */
+    void begin();
+
+    /** Accept a new client, read and answer the clients' packets and send the
+     *  queued messages.  Call it as often as possible, it never waits.
+     *  @return the number of packets received
+     */
+    int loop();
+
+    /** Publish a message from the sketch to the subscribed clients
+     *  @param topicName - the topic to publish to
+     *  @param message - the message to send
+     *  @return success code -
+     */
+    int publish(const char* topicName, Message& message);
+
+    /** Publish a message from the sketch to the subscribed clients
+     *  @param topicName - the topic to publish to
+     *  @param payload - the data to send
+     *  @param payloadlen - the length of the data
+     *  @param qos - the highest QoS to deliver the message at
+     *  @param retained - whether the message should be retained
+     *  @return success code -
+     */
+    int publish(const char* topicName, void* payload, size_t payloadlen, enum QoS qos = QOS0, bool retained = false);
+
+    /** Set a callback for every message published by a client, whatever its topic
+     *  @param mh - pointer to the callback function
+     */
+    void setMessageHandler(messageHandler mh)
+    {
+        handler = mh;
+    }
+
+    /** The number of connected clients
+     */
+    int clients();
+
+    void stats(BrokerStats& stats);
+
+private:
+
+    static const int QUEUE = 8;             // messages waiting for each client
+    static const int INFLIGHT = 4;          // unacknowledged QoS 1 deliveries per client
+    static const int QOS2_IDS = 4;          // QoS 2 messages from a client awaiting PUBREL
+    static const int FILTERS = 8;           // topic filters in one (UN)SUBSCRIBE
+    static const int CLIENT_ID_MAX = 23;
+    static const unsigned long CONNECT_TIMEOUT_MS = 10000;
+    static const unsigned long RETRY_MS = 20000;
+
+    enum { FREE, WAIT_CONNECT, CONNECTED };
+
+    struct Stored
+    {
+        unsigned char refs;                 // 0 when the buffer is free
+        bool kept;                          // one of the refs is the retained set's
+        bool retain;
+        unsigned char qos;
+        unsigned short topicLen;
+        unsigned short payloadLen;
+        unsigned char data[MAX_PACKET_SIZE];    // the topic, then the payload
+    };
+
+    struct Delivery
+    {
+        signed char message;                // index into messages, -1 when free
+        unsigned char qos;
+        bool retained;
+        unsigned short id;
+        unsigned long sent;
+    };
+
+    struct Session
+    {
+        Network net;
+        unsigned char state;
+        unsigned long last;                 // when the last packet came in
+        unsigned long waiting;              // since when messages have waited for the client
+        unsigned short keepAlive;
+        unsigned short nextId;
+        signed char will;                   // index into messages, -1 for none
+        char clientId[CLIENT_ID_MAX + 1];
+        int rxLen;
+        int need;                           // the whole packet's length, once the header is in
+        Delivery queue[QUEUE];
+        unsigned char head;
+        unsigned char count;
+        Delivery inflight[INFLIGHT];
+        unsigned short qos2[QOS2_IDS];      // 0 when free
+        unsigned char rx[MAX_PACKET_SIZE + 4];  // spare bytes for the CONNECT decoder's fixed fields
+    };
+
+    struct Subscription
+    {
+        signed char client;                 // -1 when free
+        unsigned char qos;
+        unsigned short key;                 // hash of the first level, 0 if it is a wildcard
+        char filter[MQTTBROKER_TOPIC_MAX + 1];
+    };
+
+    int readPacket(Session& s);
+    int handle(int c);
+    int connect(int c);
+    int received(int c);
+    int subscribe(int c);
+    int unsubscribe(int c);
+    int send(Session& s, int len);
+    void deliver(int c);
+    bool append(Session& s, int& len, Delivery& d, bool dup);
+    bool flush(Session& s, int& len);
+    void close(int c, bool graceful);
+    bool isBacklogged();
+    bool isPending(Session& s);
+
+    int dispatch(const char* topic, int topicLen, const void* payload, int payloadLen, int qos, bool retain);
+    int store(const char* topic, int topicLen, const void* payload, int payloadLen, int qos, bool retain);
+    void release(int m);
+    void keep(int m);
+    void route(int m);
+    bool enqueue(int c, int m, int qos, bool retained);
+    int addSubscription(int c, MQTTString& filter, int qos, int* index);
+
+    static unsigned short key(const char* topic, int len);
+    static bool isTopicMatched(const char* filter, const char* topic, int len);
+    static bool isTopicValid(const char* topic, int len);
+    static bool isFilterValid(const char* filter, int len);
+
+    Server& server;
+    Session sessions[MAX_CLIENTS];
+    Subscription subscriptions[MAX_SUBSCRIPTIONS];
+    Stored messages[MAX_MESSAGES];
+    unsigned char txbuf[MAX_PACKET_SIZE + 16];
+    messageHandler handler;
+    BrokerStats counters;
+
+};
+
+}
+
+
+template<class Server, class Network, int MAX_CLIENTS, int MAX_SUBSCRIPTIONS, int MAX_MESSAGES, int MAX_PACKET_SIZE>
+MQTT::Broker<Server, Network, MAX_CLIENTS, MAX_SUBSCRIPTIONS, MAX_MESSAGES, MAX_PACKET_SIZE>::Broker(Server& server) : server(server)
+{
+    for (int i = 0; i < MAX_CLIENTS; ++i)
+    {
+        sessions[i].state = FREE;
+        sessions[i].will = -1;
+    }
+    for (int i = 0; i < MAX_SUBSCRIPTIONS; ++i)
+        subscriptions[i].client = -1;
+    for (int i = 0; i < MAX_MESSAGES; ++i)
+    {
+        messages[i].refs = 0;
+        messages[i].kept = false;
+    }
+    handler = 0;
+    memset(&counters, 0, sizeof(counters));
+}
+
+
+template<class Server, class Network, int MAX_CLIENTS, int MAX_SUBSCRIPTIONS, int MAX_MESSAGES, int MAX_PACKET_SIZE>
+void MQTT::Broker<Server, Network, MAX_CLIENTS, MAX_SUBSCRIPTIONS, MAX_MESSAGES, MAX_PACKET_SIZE>::begin()
+{
+    server.begin();
+}
+
+
+template<class Server, class Network, int MAX_CLIENTS, int MAX_SUBSCRIPTIONS, int MAX_MESSAGES, int MAX_PACKET_SIZE>
+int MQTT::Broker<Server, Network, MAX_CLIENTS, MAX_SUBSCRIPTIONS, MAX_MESSAGES, MAX_PACKET_SIZE>::loop()
+{
+    unsigned long now = millis();
+    int handled = 0;
+
+    Network net = server.accept();
+    if (net)
+    {
+        int c = 0;
+        while (c < MAX_CLIENTS && sessions[c].state != FREE)
+            ++c;
+        if (c == MAX_CLIENTS)
+        {
+            counters.refused++;
+            net.stop();
+        }
+        else
+        {
+            Session& s = sessions[c];
+            s.net = net;
+            s.state = WAIT_CONNECT;
+            s.last = now;
+            s.keepAlive = 0;
+            s.nextId = 0;
+            s.will = -1;
+            s.clientId[0] = '\0';
+            s.rxLen = s.need = 0;
+            s.head = s.count = 0;
+            for (int i = 0; i < INFLIGHT; ++i)
+                s.inflight[i].message = -1;
+            for (int i = 0; i < QOS2_IDS; ++i)
+                s.qos2[i] = 0;
+        }
+    }
+
+    for (int c = 0; c < MAX_CLIENTS; ++c)
+    {
+        Session& s = sessions[c];
+        if (s.state == CONNECTED && isPending(s) && now - s.waiting > 2 * RETRY_MS)
+            close(c, false);        // too slow to keep up
+    }
+
+    for (int c = 0; c < MAX_CLIENTS; ++c)
+    {
+        Session& s = sessions[c];
+
+        // a few packets each, so that one busy client can't starve the others
+        for (int i = 0; i < 4 && s.state != FREE; ++i)
+        {
+            int rc = readPacket(s);
+            if (rc == 0)
+                break;
+            if (rc < 0)
+            {
+                close(c, false);    // malformed, or larger than MAX_PACKET_SIZE
+                break;
+            }
+            s.last = now;
+            if ((s.rx[0] >> 4) == PUBLISH && isBacklogged())
+                break;              // kept in rx until the subscribers catch up
+            rc = handle(c);
+            s.rxLen = s.need = 0;
+            handled++;
+            if (rc != 0)
+                close(c, rc > 0);
+        }
+        if (s.state == FREE)
+            continue;
+
+        if (!s.net.connected())
+            close(c, false);
+        else if (s.state == WAIT_CONNECT && now - s.last > CONNECT_TIMEOUT_MS)
+            close(c, false);
+        else if (s.state == CONNECTED && s.keepAlive && now - s.last > s.keepAlive * 1500UL)
+            close(c, false);
+    }
+
+    for (int c = 0; c < MAX_CLIENTS; ++c)
+    {
+        if (sessions[c].state == CONNECTED)
+            deliver(c);
+    }
+    return handled;
+}
+
+
+/**
+ * Reads what has arrived of the next packet without waiting
+ * @return 1 when a whole packet is in rx, 0 if not yet, -1 if it can't be read
+ */
+template<class Server, class Network, int MAX_CLIENTS, int MAX_SUBSCRIPTIONS, int MAX_MESSAGES, int MAX_PACKET_SIZE>
+int MQTT::Broker<Server, Network, MAX_CLIENTS, MAX_SUBSCRIPTIONS, MAX_MESSAGES, MAX_PACKET_SIZE>::readPacket(Session& s)
+{
+    if (s.need > 0 && s.rxLen == s.need)
+        return 1;               // left unhandled last time
+    while (s.net.available() > 0)
+    {
+        if (s.need == 0)
+        {
+            // the header a byte at a time, up to the end of the remaining length
+            int c = s.net.read();
+            if (c < 0)
+                break;
+            s.rx[s.rxLen++] = c;
+            if (s.rxLen == 1)
+                continue;
+            if (c & 128)
+            {
+                if (s.rxLen == 5)
+                    return -1;
+                continue;
+            }
+            int rem = 0;
+            MQTTPacket_decodeBuf(&s.rx[1], &rem);
+            s.need = s.rxLen + rem;
+            if (s.need > MAX_PACKET_SIZE)
+                return -1;
+        }
+        else
+        {
+            int n = s.net.read(&s.rx[s.rxLen], s.need - s.rxLen);
+            if (n <= 0)
+                break;
+            s.rxLen += n;
+        }
+        if (s.rxLen == s.need)
+            return 1;
+    }
+    return 0;
+}
+
+
+/**
+ * @return 0 to carry on, 1 to close the connection cleanly, -1 to drop it
+ */
+template<class Server, class Network, int MAX_CLIENTS, int MAX_SUBSCRIPTIONS, int MAX_MESSAGES, int MAX_PACKET_SIZE>
+int MQTT::Broker<Server, Network, MAX_CLIENTS, MAX_SUBSCRIPTIONS, MAX_MESSAGES, MAX_PACKET_SIZE>::handle(int c)
+{
+    Session& s = sessions[c];
+    int type = s.rx[0] >> 4;
+    unsigned char acktype, dup;
+    unsigned short id;
+
+    if (s.state == WAIT_CONNECT)
+        return (type == CONNECT) ? connect(c) : -1;
+
+    switch (type)
+    {
+        case PUBLISH:
+            return received(c);
+        case PUBACK:
+            if (MQTTDeserialize_ack(&acktype, &dup, &id, s.rx, s.rxLen) != 1)
+                return -1;
+            for (int i = 0; i < INFLIGHT; ++i)
+            {
+                if (s.inflight[i].message >= 0 && s.inflight[i].id == id)
+                {
+                    release(s.inflight[i].message);
+                    s.inflight[i].message = -1;
+                    s.waiting = millis();
+                }
+            }
+            return 0;
+        case PUBREL:
+            if (MQTTDeserialize_ack(&acktype, &dup, &id, s.rx, s.rxLen) != 1)
+                return -1;
+            for (int i = 0; i < QOS2_IDS; ++i)
+            {
+                if (s.qos2[i] == id)
+                    s.qos2[i] = 0;
+            }
+            return send(s, MQTTSerialize_pubcomp(txbuf, sizeof(txbuf), id));
+        case SUBSCRIBE:
+            return subscribe(c);
+        case UNSUBSCRIBE:
+            return unsubscribe(c);
+        case PINGREQ:
+            return send(s, MQTTSerialize_pingresp(txbuf, sizeof(txbuf)));
+        case DISCONNECT:
+            release(s.will);    // a clean disconnect discards the will
+            s.will = -1;
+            return 1;
+        case PUBREC:
+        case PUBCOMP:
+            return 0;           // nothing is sent at QoS 2, ignore them
+        default:
+            return -1;          // a second CONNECT, or a packet only servers send
+    }
+}
+
+
+template<class Server, class Network, int MAX_CLIENTS, int MAX_SUBSCRIPTIONS, int MAX_MESSAGES, int MAX_PACKET_SIZE>
+int MQTT::Broker<Server, Network, MAX_CLIENTS, MAX_SUBSCRIPTIONS, MAX_MESSAGES, MAX_PACKET_SIZE>::connect(int c)
+{
+    Session& s = sessions[c];
+    MQTTPacket_connectData data = MQTTPacket_connectData_initializer;
+    unsigned char rc = 0;
+    int will = -1;
+
+    if (MQTTDeserialize_connect(&data, s.rx, s.rxLen) != 1)
+    {
+        counters.refused++;
+        send(s, MQTTSerialize_connack(txbuf, sizeof(txbuf), 1, 0));  // unacceptable protocol version
+        return 1;
+    }
+
+    int idLen = data.clientID.lenstring.len;
+    if (idLen > CLIENT_ID_MAX || (idLen == 0 && !data.cleansession))
+        rc = 2;                 // identifier rejected
+    else if (data.willFlag)
+    {
+        if (!isTopicValid(data.will.topicName.lenstring.data, data.will.topicName.lenstring.len) || data.will.qos > QOS2)
+            return -1;
+        will = store(data.will.topicName.lenstring.data, data.will.topicName.lenstring.len,
+                     data.will.message.lenstring.data, data.will.message.lenstring.len,
+                     data.will.qos, data.will.retained);
+        if (will < 0)
+            rc = 3;             // server unavailable
+    }
+    if (rc != 0)
+    {
+        counters.refused++;
+        send(s, MQTTSerialize_connack(txbuf, sizeof(txbuf), rc, 0));
+        return 1;
+    }
+
+    // the same client connecting again takes over from the old connection
+    if (idLen > 0)
+    {
+        for (int i = 0; i < MAX_CLIENTS; ++i)
+        {
+            if (i != c && sessions[i].state == CONNECTED && (int)strlen(sessions[i].clientId) == idLen &&
+                memcmp(sessions[i].clientId, data.clientID.lenstring.data, idLen) == 0)
+                close(i, false);
+        }
+    }
+
+    memcpy(s.clientId, data.clientID.lenstring.data, idLen);
+    s.clientId[idLen] = '\0';
+    s.keepAlive = data.keepAliveInterval;
+    s.will = will;
+    s.state = CONNECTED;
+    counters.connects++;
+    return send(s, MQTTSerialize_connack(txbuf, sizeof(txbuf), 0, 0));
+}
+
+
+template<class Server, class Network, int MAX_CLIENTS, int MAX_SUBSCRIPTIONS, int MAX_MESSAGES, int MAX_PACKET_SIZE>
+int MQTT::Broker<Server, Network, MAX_CLIENTS, MAX_SUBSCRIPTIONS, MAX_MESSAGES, MAX_PACKET_SIZE>::received(int c)
+{
+    Session& s = sessions[c];
+    unsigned char dup, retained;
+    unsigned short id;
+    int qos, payloadlen;
+    unsigned char* payload;
+    MQTTString topicName = MQTTString_initializer;
+    bool duplicate = false;
+
+    if (MQTTDeserialize_publish(&dup, &qos, &retained, &id, &topicName, &payload, &payloadlen, s.rx, s.rxLen) != 1 ||
+        qos > QOS2 || !isTopicValid(topicName.lenstring.data, topicName.lenstring.len))
+        return -1;
+
+    if (qos == QOS2)
+    {
+        int free = -1;
+        for (int i = 0; i < QOS2_IDS; ++i)
+        {
+            if (s.qos2[i] == id)
+                duplicate = true;
+            else if (s.qos2[i] == 0 && free < 0)
+                free = i;
+        }
+        if (!duplicate)
+        {
+            if (free < 0)
+                return -1;
+            s.qos2[free] = id;
+        }
+    }
+
+    if (!duplicate)
+    {
+        if (handler)
+        {
+            Message message;
+            message.qos = (enum QoS)qos;
+            message.retained = retained;
+            message.dup = dup;
+            message.id = id;
+            message.payload = payload;
+            message.payloadlen = payloadlen;
+            MessageData md(topicName, message);
+            handler(md);
+        }
+        dispatch(topicName.lenstring.data, topicName.lenstring.len, payload, payloadlen, qos, retained);
+    }
+
+    if (qos == QOS1)
+        return send(s, MQTTSerialize_puback(txbuf, sizeof(txbuf), id));
+    if (qos == QOS2)
+        return send(s, MQTTSerialize_ack(txbuf, sizeof(txbuf), PUBREC, 0, id));
+    return 0;
+}
+
+
+template<class Server, class Network, int MAX_CLIENTS, int MAX_SUBSCRIPTIONS, int MAX_MESSAGES, int MAX_PACKET_SIZE>
+int MQTT::Broker<Server, Network, MAX_CLIENTS, MAX_SUBSCRIPTIONS, MAX_MESSAGES, MAX_PACKET_SIZE>::subscribe(int c)
+{
+    Session& s = sessions[c];
+    unsigned char dup;
+    unsigned short id;
+    int count = 0;
+    MQTTString filters[FILTERS];
+    int qos[FILTERS];
+    int granted[FILTERS];
+    int index[FILTERS];
+
+    if (MQTTDeserialize_subscribe(&dup, &id, FILTERS, &count, filters, qos, s.rx, s.rxLen) != 1 || count == 0)
+        return -1;
+    for (int i = 0; i < count; ++i)
+        granted[i] = addSubscription(c, filters[i], qos[i], &index[i]);
+    if (send(s, MQTTSerialize_suback(txbuf, sizeof(txbuf), id, count, granted)) != 0)
+        return -1;
+
+    // then the retained messages the new filters match, flagged as retained
+    for (int i = 0; i < count; ++i)
+    {
+        if (granted[i] == 0x80)
+            continue;
+        for (int m = 0; m < MAX_MESSAGES; ++m)
+        {
+            Stored& msg = messages[m];
+            if (msg.kept && isTopicMatched(subscriptions[index[i]].filter, (const char*)msg.data, msg.topicLen))
+                enqueue(c, m, (granted[i] < msg.qos) ? granted[i] : msg.qos, true);
+        }
+    }
+    return 0;
+}
+
+
+template<class Server, class Network, int MAX_CLIENTS, int MAX_SUBSCRIPTIONS, int MAX_MESSAGES, int MAX_PACKET_SIZE>
+int MQTT::Broker<Server, Network, MAX_CLIENTS, MAX_SUBSCRIPTIONS, MAX_MESSAGES, MAX_PACKET_SIZE>::unsubscribe(int c)
+{
+    Session& s = sessions[c];
+    unsigned char dup;
+    unsigned short id;
+    int count = 0;
+    MQTTString filters[FILTERS];
+
+    if (MQTTDeserialize_unsubscribe(&dup, &id, FILTERS, &count, filters, s.rx, s.rxLen) != 1 || count == 0)
+        return -1;
+    for (int i = 0; i < count; ++i)
+    {
+        int len = filters[i].lenstring.len;
+        for (int j = 0; j < MAX_SUBSCRIPTIONS; ++j)
+        {
+            Subscription& sub = subscriptions[j];
+            if (sub.client == c && (int)strlen(sub.filter) == len && memcmp(sub.filter, filters[i].lenstring.data, len) == 0)
+                sub.client = -1;
+        }
+    }
+    return send(s, MQTTSerialize_unsuback(txbuf, sizeof(txbuf), id));
+}
+
+
+/**
+ * @return the granted QoS, or 0x80 if the filter is invalid or the table full
+ */
+template<class Server, class Network, int MAX_CLIENTS, int MAX_SUBSCRIPTIONS, int MAX_MESSAGES, int MAX_PACKET_SIZE>
+int MQTT::Broker<Server, Network, MAX_CLIENTS, MAX_SUBSCRIPTIONS, MAX_MESSAGES, MAX_PACKET_SIZE>::addSubscription(int c, MQTTString& filter, int qos, int* index)
+{
+    const char* text = filter.lenstring.data;
+    int len = filter.lenstring.len;
+    int free = -1;
+
+    if (!isFilterValid(text, len) || qos < QOS0 || qos > QOS2)
+        return 0x80;
+
+    *index = -1;
+    for (int i = 0; i < MAX_SUBSCRIPTIONS && *index < 0; ++i)
+    {
+        Subscription& sub = subscriptions[i];
+        if (sub.client == c && (int)strlen(sub.filter) == len && memcmp(sub.filter, text, len) == 0)
+            *index = i;         // subscribing again replaces the QoS
+        else if (sub.client < 0 && free < 0)
+            free = i;
+    }
+    if (*index < 0)
+    {
+        if (free < 0)
+            return 0x80;
+        *index = free;
+        subscriptions[free].client = c;
+        subscriptions[free].key = key(text, len);
+        memcpy(subscriptions[free].filter, text, len);
+        subscriptions[free].filter[len] = '\0';
+    }
+    subscriptions[*index].qos = (qos > QOS1) ? QOS1 : qos;
+    return subscriptions[*index].qos;
+}
+
+
+template<class Server, class Network, int MAX_CLIENTS, int MAX_SUBSCRIPTIONS, int MAX_MESSAGES, int MAX_PACKET_SIZE>
+int MQTT::Broker<Server, Network, MAX_CLIENTS, MAX_SUBSCRIPTIONS, MAX_MESSAGES, MAX_PACKET_SIZE>::send(Session& s, int len)
+{
+    if (len <= 0 || (int)s.net.write(txbuf, len) != len)
+        return -1;
+    return 0;
+}
+
+
+/**
+ * Sends the client what is queued for it, as many PUBLISH packets in one
+ * write as fit in txbuf, and repeats QoS 1 deliveries not acknowledged in
+ * RETRY_MS.
+ */
+template<class Server, class Network, int MAX_CLIENTS, int MAX_SUBSCRIPTIONS, int MAX_MESSAGES, int MAX_PACKET_SIZE>
+void MQTT::Broker<Server, Network, MAX_CLIENTS, MAX_SUBSCRIPTIONS, MAX_MESSAGES, MAX_PACKET_SIZE>::deliver(int c)
+{
+    Session& s = sessions[c];
+    unsigned long now = millis();
+    int len = 0;
+    bool ok = true;
+
+    for (int i = 0; i < INFLIGHT && ok; ++i)
+    {
+        if (s.inflight[i].message >= 0 && now - s.inflight[i].sent >= RETRY_MS)
+        {
+            ok = append(s, len, s.inflight[i], true);
+            s.inflight[i].sent = now;
+        }
+    }
+
+    while (ok && s.count > 0)
+    {
+        Delivery& d = s.queue[s.head];
+        int slot = -1;
+
+        if (d.qos > QOS0)
+        {
+            for (int i = 0; i < INFLIGHT && slot < 0; ++i)
+            {
+                if (s.inflight[i].message < 0)
+                    slot = i;
+            }
+            if (slot < 0)
+                break;          // wait for a PUBACK
+            if (++s.nextId == 0)
+                s.nextId = 1;
+            d.id = s.nextId;
+        }
+        ok = append(s, len, d, false);
+        s.waiting = now;
+        if (slot >= 0)
+        {
+            s.inflight[slot] = d;   // the queue's reference moves with it
+            s.inflight[slot].sent = now;
+        }
+        else
+            release(d.message);
+        s.head = (s.head + 1) % QUEUE;
+        s.count--;
+        counters.delivered++;
+    }
+
+    if (!(ok && flush(s, len)))
+        close(c, false);
+}
+
+
+template<class Server, class Network, int MAX_CLIENTS, int MAX_SUBSCRIPTIONS, int MAX_MESSAGES, int MAX_PACKET_SIZE>
+bool MQTT::Broker<Server, Network, MAX_CLIENTS, MAX_SUBSCRIPTIONS, MAX_MESSAGES, MAX_PACKET_SIZE>::append(Session& s, int& len, Delivery& d, bool dup)
+{
+    Stored& msg = messages[d.message];
+    MQTTString topicName = MQTTString_initializer;
+    topicName.lenstring.len = msg.topicLen;
+    topicName.lenstring.data = (char*)msg.data;
+
+    int n = MQTTSerialize_publish(&txbuf[len], sizeof(txbuf) - len, dup, d.qos, d.retained, d.id,
+                                  topicName, &msg.data[msg.topicLen], msg.payloadLen);
+    if (n <= 0)
+    {
+        // txbuf is full, send it and start again; a message always fits on its own
+        if (!flush(s, len))
+            return false;
+        n = MQTTSerialize_publish(txbuf, sizeof(txbuf), dup, d.qos, d.retained, d.id,
+                                  topicName, &msg.data[msg.topicLen], msg.payloadLen);
+        if (n <= 0)
+            return false;
+    }
+    len += n;
+    return true;
+}
+
+
+template<class Server, class Network, int MAX_CLIENTS, int MAX_SUBSCRIPTIONS, int MAX_MESSAGES, int MAX_PACKET_SIZE>
+bool MQTT::Broker<Server, Network, MAX_CLIENTS, MAX_SUBSCRIPTIONS, MAX_MESSAGES, MAX_PACKET_SIZE>::flush(Session& s, int& len)
+{
+    int n = len;
+
+    len = 0;
+    return n == 0 || (int)s.net.write(txbuf, n) == n;
+}
+
+
+template<class Server, class Network, int MAX_CLIENTS, int MAX_SUBSCRIPTIONS, int MAX_MESSAGES, int MAX_PACKET_SIZE>
+void MQTT::Broker<Server, Network, MAX_CLIENTS, MAX_SUBSCRIPTIONS, MAX_MESSAGES, MAX_PACKET_SIZE>::close(int c, bool graceful)
+{
+    Session& s = sessions[c];
+    bool connected = (s.state == CONNECTED);
+
+    if (s.state == FREE)
+        return;
+    s.state = FREE;             // first, so that its own will isn't queued to it
+    s.net.stop();
+
+    for (int i = 0; i < MAX_SUBSCRIPTIONS; ++i)
+    {
+        if (subscriptions[i].client == c)
+            subscriptions[i].client = -1;
+    }
+    for (; s.count > 0; s.count--)
+    {
+        release(s.queue[s.head].message);
+        s.head = (s.head + 1) % QUEUE;
+    }
+    for (int i = 0; i < INFLIGHT; ++i)
+    {
+        release(s.inflight[i].message);
+        s.inflight[i].message = -1;
+    }
+
+    if (s.will >= 0)
+    {
+        if (!graceful)
+        {
+            counters.received++;
+            if (messages[s.will].retain)
+                keep(s.will);
+            route(s.will);
+        }
+        release(s.will);
+        s.will = -1;
+    }
+    if (connected)
+        counters.disconnects++;
+}
+
+
+template<class Server, class Network, int MAX_CLIENTS, int MAX_SUBSCRIPTIONS, int MAX_MESSAGES, int MAX_PACKET_SIZE>
+int MQTT::Broker<Server, Network, MAX_CLIENTS, MAX_SUBSCRIPTIONS, MAX_MESSAGES, MAX_PACKET_SIZE>::publish(const char* topicName, Message& message)
+{
+    return publish(topicName, message.payload, message.payloadlen, message.qos, message.retained);
+}
+
+
+template<class Server, class Network, int MAX_CLIENTS, int MAX_SUBSCRIPTIONS, int MAX_MESSAGES, int MAX_PACKET_SIZE>
+int MQTT::Broker<Server, Network, MAX_CLIENTS, MAX_SUBSCRIPTIONS, MAX_MESSAGES, MAX_PACKET_SIZE>::publish(const char* topicName, void* payload, size_t payloadlen, enum QoS qos, bool retained)
+{
+    int topicLen = strlen(topicName);
+
+    if (!isTopicValid(topicName, topicLen))
+        return FAILURE;
+    if (topicLen + payloadlen > MAX_PACKET_SIZE)
+        return BUFFER_OVERFLOW;
+    return dispatch(topicName, topicLen, payload, payloadlen, qos, retained);
+}
+
+
+/**
+ * Stores a message, retains it if asked and queues it to the subscribers
+ */
+template<class Server, class Network, int MAX_CLIENTS, int MAX_SUBSCRIPTIONS, int MAX_MESSAGES, int MAX_PACKET_SIZE>
+int MQTT::Broker<Server, Network, MAX_CLIENTS, MAX_SUBSCRIPTIONS, MAX_MESSAGES, MAX_PACKET_SIZE>::dispatch(const char* topic, int topicLen, const void* payload, int payloadLen, int qos, bool retain)
+{
+    counters.received++;
+    int m = store(topic, topicLen, payload, payloadLen, qos, retain);
+    if (m < 0)
+    {
+        counters.dropped++;
+        return FAILURE;
+    }
+    if (retain)
+        keep(m);
+    route(m);
+    release(m);
+    return SUCCESS;
+}
+
+
+/**
+ * @return the index of a buffer holding the message, with one reference
+ * for the caller, or -1 if there is none free
+ */
+template<class Server, class Network, int MAX_CLIENTS, int MAX_SUBSCRIPTIONS, int MAX_MESSAGES, int MAX_PACKET_SIZE>
+int MQTT::Broker<Server, Network, MAX_CLIENTS, MAX_SUBSCRIPTIONS, MAX_MESSAGES, MAX_PACKET_SIZE>::store(const char* topic, int topicLen, const void* payload, int payloadLen, int qos, bool retain)
+{
+    if (topicLen + payloadLen > MAX_PACKET_SIZE)
+        return -1;
+    for (int m = 0; m < MAX_MESSAGES; ++m)
+    {
+        Stored& msg = messages[m];
+        if (msg.refs == 0)
+        {
+            msg.refs = 1;
+            msg.kept = false;
+            msg.retain = retain;
+            msg.qos = (qos > QOS1) ? QOS1 : qos;
+            msg.topicLen = topicLen;
+            msg.payloadLen = payloadLen;
+            memcpy(msg.data, topic, topicLen);
+            memcpy(&msg.data[topicLen], payload, payloadLen);
+            return m;
+        }
+    }
+    return -1;
+}
+
+
+template<class Server, class Network, int MAX_CLIENTS, int MAX_SUBSCRIPTIONS, int MAX_MESSAGES, int MAX_PACKET_SIZE>
+void MQTT::Broker<Server, Network, MAX_CLIENTS, MAX_SUBSCRIPTIONS, MAX_MESSAGES, MAX_PACKET_SIZE>::release(int m)
+{
+    if (m >= 0 && messages[m].refs > 0)
+        messages[m].refs--;
+}
+
+
+/**
+ * Makes the message the retained one for its topic; an empty payload only
+ * clears the topic's retained message
+ */
+template<class Server, class Network, int MAX_CLIENTS, int MAX_SUBSCRIPTIONS, int MAX_MESSAGES, int MAX_PACKET_SIZE>
+void MQTT::Broker<Server, Network, MAX_CLIENTS, MAX_SUBSCRIPTIONS, MAX_MESSAGES, MAX_PACKET_SIZE>::keep(int m)
+{
+    Stored& msg = messages[m];
+    int kept = 0;
+
+    for (int i = 0; i < MAX_MESSAGES; ++i)
+    {
+        Stored& old = messages[i];
+        if (!old.kept)
+            continue;
+        if (old.topicLen == msg.topicLen && memcmp(old.data, msg.data, msg.topicLen) == 0)
+        {
+            old.kept = false;
+            release(i);
+        }
+        else
+            kept++;
+    }
+    if (msg.payloadLen == 0)
+        return;
+    if (kept >= MAX_MESSAGES / 2)
+    {
+        counters.dropped++;     // keep buffers for the messages in flight
+        return;
+    }
+    msg.kept = true;
+    msg.refs++;
+}
+
+
+/**
+ * Queues the message to each client with a matching subscription, once, at
+ * the highest QoS of its subscriptions that the message allows
+ */
+template<class Server, class Network, int MAX_CLIENTS, int MAX_SUBSCRIPTIONS, int MAX_MESSAGES, int MAX_PACKET_SIZE>
+void MQTT::Broker<Server, Network, MAX_CLIENTS, MAX_SUBSCRIPTIONS, MAX_MESSAGES, MAX_PACKET_SIZE>::route(int m)
+{
+    Stored& msg = messages[m];
+    const char* topic = (const char*)msg.data;
+    unsigned short k = key(topic, msg.topicLen);
+    signed char best[MAX_CLIENTS];
+
+    for (int c = 0; c < MAX_CLIENTS; ++c)
+        best[c] = -1;
+    for (int i = 0; i < MAX_SUBSCRIPTIONS; ++i)
+    {
+        Subscription& sub = subscriptions[i];
+        if (sub.client >= 0 && (sub.key == 0 || sub.key == k) && sub.qos > best[sub.client] &&
+            isTopicMatched(sub.filter, topic, msg.topicLen))
+            best[sub.client] = sub.qos;
+    }
+    for (int c = 0; c < MAX_CLIENTS; ++c)
+    {
+        if (best[c] >= 0 && sessions[c].state == CONNECTED)
+            enqueue(c, m, (best[c] < msg.qos) ? best[c] : msg.qos, false);
+    }
+}
+
+
+template<class Server, class Network, int MAX_CLIENTS, int MAX_SUBSCRIPTIONS, int MAX_MESSAGES, int MAX_PACKET_SIZE>
+bool MQTT::Broker<Server, Network, MAX_CLIENTS, MAX_SUBSCRIPTIONS, MAX_MESSAGES, MAX_PACKET_SIZE>::enqueue(int c, int m, int qos, bool retained)
+{
+    Session& s = sessions[c];
+
+    if (s.count == QUEUE)
+    {
+        counters.dropped++;     // from publish(), a will or a retained message, loop() holds PUBLISHes back
+        return false;
+    }
+    if (!isPending(s))
+        s.waiting = millis();
+    Delivery& d = s.queue[(s.head + s.count) % QUEUE];
+    d.message = m;
+    d.qos = qos;
+    d.retained = retained;
+    d.id = 0;
+    s.count++;
+    messages[m].refs++;
+    return true;
+}
+
+
+template<class Server, class Network, int MAX_CLIENTS, int MAX_SUBSCRIPTIONS, int MAX_MESSAGES, int MAX_PACKET_SIZE>
+bool MQTT::Broker<Server, Network, MAX_CLIENTS, MAX_SUBSCRIPTIONS, MAX_MESSAGES, MAX_PACKET_SIZE>::isBacklogged()
+{
+    int m = 0;
+
+    for (int c = 0; c < MAX_CLIENTS; ++c)
+    {
+        if (sessions[c].state == CONNECTED && sessions[c].count == QUEUE)
+            return true;
+    }
+    while (m < MAX_MESSAGES && messages[m].refs > 0)
+        ++m;
+    return m == MAX_MESSAGES;
+}
+
+
+template<class Server, class Network, int MAX_CLIENTS, int MAX_SUBSCRIPTIONS, int MAX_MESSAGES, int MAX_PACKET_SIZE>
+bool MQTT::Broker<Server, Network, MAX_CLIENTS, MAX_SUBSCRIPTIONS, MAX_MESSAGES, MAX_PACKET_SIZE>::isPending(Session& s)
+{
+    if (s.count > 0)
+        return true;
+    for (int i = 0; i < INFLIGHT; ++i)
+    {
+        if (s.inflight[i].message >= 0)
+            return true;
+    }
+    return false;
+}
+
+
+template<class Server, class Network, int MAX_CLIENTS, int MAX_SUBSCRIPTIONS, int MAX_MESSAGES, int MAX_PACKET_SIZE>
+int MQTT::Broker<Server, Network, MAX_CLIENTS, MAX_SUBSCRIPTIONS, MAX_MESSAGES, MAX_PACKET_SIZE>::clients()
+{
+    int n = 0;
+    for (int c = 0; c < MAX_CLIENTS; ++c)
+    {
+        if (sessions[c].state == CONNECTED)
+            n++;
+    }
+    return n;
+}
+
+
+template<class Server, class Network, int MAX_CLIENTS, int MAX_SUBSCRIPTIONS, int MAX_MESSAGES, int MAX_PACKET_SIZE>
+void MQTT::Broker<Server, Network, MAX_CLIENTS, MAX_SUBSCRIPTIONS, MAX_MESSAGES, MAX_PACKET_SIZE>::stats(BrokerStats& stats)
+{
+    stats = counters;
+    stats.clients = clients();
+    stats.subscriptions = stats.messages = stats.retained = 0;
+    for (int i = 0; i < MAX_SUBSCRIPTIONS; ++i)
+    {
+        if (subscriptions[i].client >= 0)
+            stats.subscriptions++;
+    }
+    for (int m = 0; m < MAX_MESSAGES; ++m)
+    {
+        if (messages[m].refs > 0)
+            stats.messages++;
+        if (messages[m].kept)
+            stats.retained++;
+    }
+}
+
+
+/**
+ * The subscription index: a hash of the topic's first level, 0 for a
+ * filter starting with a wildcard, which is checked against every topic
+ */
+template<class Server, class Network, int MAX_CLIENTS, int MAX_SUBSCRIPTIONS, int MAX_MESSAGES, int MAX_PACKET_SIZE>
+unsigned short MQTT::Broker<Server, Network, MAX_CLIENTS, MAX_SUBSCRIPTIONS, MAX_MESSAGES, MAX_PACKET_SIZE>::key(const char* topic, int len)
+{
+    unsigned short hash = 0;
+
+    if (len > 0 && (topic[0] == '+' || topic[0] == '#'))
+        return 0;
+    for (int i = 0; i < len && topic[i] != '/'; ++i)
+        hash = hash * 31 + (unsigned char)topic[i];
+    return (hash == 0) ? 1 : hash;
+}
+
+
+/**
+ * Matches a topic name, of len bytes, against a filter with wildcards; a
+ * topic starting with '$' is not matched by a filter starting with one
+ */
+template<class Server, class Network, int MAX_CLIENTS, int MAX_SUBSCRIPTIONS, int MAX_MESSAGES, int MAX_PACKET_SIZE>
+bool MQTT::Broker<Server, Network, MAX_CLIENTS, MAX_SUBSCRIPTIONS, MAX_MESSAGES, MAX_PACKET_SIZE>::isTopicMatched(const char* filter, const char* topic, int len)
+{
+    const char* end = topic + len;
+
+    if (len > 0 && topic[0] == '$' && (filter[0] == '+' || filter[0] == '#'))
+        return false;
+    while (*filter)
+    {
+        if (*filter == '#')
+            return true;        // the rest of the topic, or none of it
+        if (*filter == '+')
+        {
+            while (topic < end && *topic != '/')
+                ++topic;
+            ++filter;
+            continue;
+        }
+        if (topic == end)
+            return strcmp(filter, "/#") == 0;   // "a/#" matches "a" too
+        if (*topic != *filter)
+            return false;
+        ++topic;
+        ++filter;
+    }
+    return topic == end;
+}
+
+
+template<class Server, class Network, int MAX_CLIENTS, int MAX_SUBSCRIPTIONS, int MAX_MESSAGES, int MAX_PACKET_SIZE>
+bool MQTT::Broker<Server, Network, MAX_CLIENTS, MAX_SUBSCRIPTIONS, MAX_MESSAGES, MAX_PACKET_SIZE>::isTopicValid(const char* topic, int len)
+{
+    if (len <= 0 || len > MAX_PACKET_SIZE)
+        return false;
+    for (int i = 0; i < len; ++i)
+    {
+        if (topic[i] == '+' || topic[i] == '#' || topic[i] == '\0')
+            return false;
+    }
+    return true;
+}
+
+
+/**
+ * Wildcards must take a whole level, and '#' only the last one
+ */
+template<class Server, class Network, int MAX_CLIENTS, int MAX_SUBSCRIPTIONS, int MAX_MESSAGES, int MAX_PACKET_SIZE>
+bool MQTT::Broker<Server, Network, MAX_CLIENTS, MAX_SUBSCRIPTIONS, MAX_MESSAGES, MAX_PACKET_SIZE>::isFilterValid(const char* filter, int len)
+{
+    if (len <= 0 || len > MQTTBROKER_TOPIC_MAX)
+        return false;
+    for (int i = 0; i < len; ++i)
+    {
+        char ch = filter[i];
+        if (ch == '\0')
+            return false;
+        if ((ch == '+' || ch == '#') && ((i > 0 && filter[i - 1] != '/') || (i + 1 < len && filter[i + 1] != '/')))
+            return false;
+        if (ch == '#' && i + 1 != len)
+            return false;
+    }
+    return true;
+}
+
+#endif
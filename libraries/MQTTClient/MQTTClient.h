@@ -85,8 +85,11 @@ private:
  *
  * This version of the API blocks on all method calls, until they are complete.  This means that only one
  * MQTT request can be in process at any one time.
- * @param Network a network class which supports send, receive
- * @param Timer a timer class with the methods:
+ * Between packets the client blocks in the network's waitReadable() until data arrives, a keepalive
+ * ping is due or the caller's time runs out, whichever is first, so an idle client uses no CPU.
+ * @param Network a network class which supports read, write and waitReadable(timeout_ms), the last
+ *     returning the bytes ready to read, 0 on timeout or -1 if the connection closed
+ * @param Timer a timer class with the methods: countdown_ms, countdown, expired and left_ms
  */
 template<class Network, class Timer, int MAX_MQTT_PACKET_SIZE = 50, int MAX_MESSAGE_HANDLERS = 5>
 class Client
@@ -191,6 +194,7 @@ public:
 private:
 
     int cycle(Timer& timer);
+    int waitEvent(Timer& timer);
     int waitfor(int packet_type, Timer& timer);
     int keepalive();
     int publish(int len, Timer& timer, enum QoS qos);
@@ -208,6 +212,7 @@ private:
     unsigned char readbuf[MAX_MQTT_PACKET_SIZE];
 
     Timer last_sent, last_received;
+    Timer ping_timer;                   // the PINGRESP is due before it expires
     unsigned int keepAliveInterval;
     bool ping_outstanding;
     bool cleansession;
@@ -251,6 +256,7 @@ MQTT::Client<Network, Timer, a, MAX_MESSAGE_HANDLERS>::Client(Network& network,
 {
     last_sent = Timer();
     last_received = Timer();
+    ping_timer = Timer();
     ping_outstanding = false;
     for (int i = 0; i < MAX_MESSAGE_HANDLERS; ++i)
         messageHandlers[i].topicFilter = 0;
@@ -471,7 +477,7 @@ int MQTT::Client<Network, Timer, a, b>::yield(unsigned long timeout_ms)
     timer.countdown_ms(timeout_ms);
     while (!timer.expired())
     {
-        if (cycle(timer) < 0)
+        if (waitEvent(timer) < 0)
         {
             rc = FAILURE;
             break;
@@ -558,7 +564,6 @@ int MQTT::Client<Network, Timer, MAX_MQTT_PACKET_SIZE, b>::cycle(Timer& timer)
             ping_outstanding = false;
             break;
     }
-    keepalive();
 exit:
     if (rc == SUCCESS)
         rc = packet_type;
@@ -566,26 +571,34 @@ exit:
 }
 
 
+/**
+ * Sends a PINGREQ once nothing has been sent or received for the keepalive interval
+ * @return FAILURE if the ping can't be sent, or its PINGRESP is overdue
+ */
 template<class Network, class Timer, int MAX_MQTT_PACKET_SIZE, int b>
 int MQTT::Client<Network, Timer, MAX_MQTT_PACKET_SIZE, b>::keepalive()
 {
-    int rc = FAILURE;
+    int rc = SUCCESS;
 
     if (keepAliveInterval == 0)
-    {
-        rc = SUCCESS;
         goto exit;
-    }
 
-    if (last_sent.expired() || last_received.expired())
+    if (ping_outstanding)
+    {
+        if (ping_timer.expired())
+            rc = FAILURE; // the server has gone
+    }
+    else if (last_sent.expired() || last_received.expired())
     {
-        if (!ping_outstanding)
+        Timer timer = Timer(1000);
+        int len = MQTTSerialize_pingreq(sendbuf, MAX_MQTT_PACKET_SIZE);
+        if (len > 0 && (rc = sendPacket(len, timer)) == SUCCESS) // send the ping packet
         {
-            Timer timer = Timer(1000);
-            int len = MQTTSerialize_pingreq(sendbuf, MAX_MQTT_PACKET_SIZE);
-            if (len > 0 && (rc = sendPacket(len, timer)) == SUCCESS) // send the ping packet
-                ping_outstanding = true;
+            ping_outstanding = true;
+            ping_timer.countdown_ms(command_timeout_ms);
         }
+        else
+            rc = FAILURE;
     }
 
 exit:
@@ -593,6 +606,47 @@ exit:
 }
 
 
+/**
+ * Blocks until a packet arrives, the next keepalive ping is due or the timer expires, and
+ * handles what happened
+ * @return the MQTT packet type handled, SUCCESS (0) if none, or a negative failure code
+ */
+template<class Network, class Timer, int a, int b>
+int MQTT::Client<Network, Timer, a, b>::waitEvent(Timer& timer)
+{
+    int wait = timer.left_ms(),
+        rc;
+
+    if (keepalive() != SUCCESS)
+    {
+        isconnected = false;
+        return FAILURE;
+    }
+    if (keepAliveInterval > 0)
+    {
+        int due = ping_outstanding ? ping_timer.left_ms() : last_sent.left_ms();
+
+        if (!ping_outstanding && last_received.left_ms() < due)
+            due = last_received.left_ms();
+        if (due < wait)
+            wait = due;
+    }
+
+    rc = ipstack.waitReadable(wait);
+    if (rc < 0)
+    {
+        isconnected = false;
+        return FAILURE;
+    }
+    if (rc == 0)
+        return SUCCESS;
+
+    // a packet that has started is read whole, even if the caller's time is nearly up
+    Timer packet_timer = Timer(command_timeout_ms);
+    return cycle(timer.left_ms() < (int)command_timeout_ms ? packet_timer : timer);
+}
+
+
 // only used in single-threaded mode where one command at a time is in process
 template<class Network, class Timer, int a, int b>
 int MQTT::Client<Network, Timer, a, b>::waitfor(int packet_type, Timer& timer)
@@ -603,8 +657,10 @@ int MQTT::Client<Network, Timer, a, b>::waitfor(int packet_type, Timer& timer)
     {
         if (timer.expired())
             break; // we timed out
+        if ((rc = waitEvent(timer)) < 0)
+            break; // the connection has gone
     }
-    while ((rc = cycle(timer)) != packet_type);
+    while (rc != packet_type);
 
     return rc;
 }
@@ -622,6 +678,7 @@ int MQTT::Client<Network, Timer, MAX_MQTT_PACKET_SIZE, b>::connect(MQTTPacket_co
 
     this->keepAliveInterval = options.keepAliveInterval;
     this->cleansession = options.cleansession;
+    ping_outstanding = false;
     if ((len = MQTTSerialize_connect(sendbuf, MAX_MQTT_PACKET_SIZE, &options)) <= 0)
         goto exit;
     if ((rc = sendPacket(len, connect_timer)) != SUCCESS)  // send the connect packet
@@ -146,3 +146,17 @@ exit:
 	return rc;
 }
 
+
+
+int MQTTSerialize_zero(unsigned char* buf, int buflen, unsigned char packettype);
+
+/**
+  * Serializes a pingresp packet into the supplied buffer, ready for writing to a socket
+  * @param buf the buffer into which the packet will be serialized
+  * @param buflen the length in bytes of the supplied buffer, to avoid overruns
+  * @return serialized length, or error if 0
+  */
+int MQTTSerialize_pingresp(unsigned char* buf, int buflen)
+{
+	return MQTTSerialize_zero(buf, buflen, PINGRESP);
+}
@@ -55,6 +55,8 @@ int MQTTDeserialize_subscribe(unsigned char* dup, unsigned short* packetid, int
 	*count = 0;
 	while (curdata < enddata)
 	{
+		if (*count == maxcount) /* more topic filters than the caller has room for */
+			goto exit;
 		if (!readMQTTLenString(&topicFilters[*count], &curdata, enddata))
 			goto exit;
 		if (curdata >= enddata) /* do we have enough data to read the req_qos version byte? */
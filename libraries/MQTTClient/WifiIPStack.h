@@ -18,6 +18,7 @@
 #define ARDUINOWIFIIPSTACK_H
 
 #include <WiFi.h>
+#include "Countdown.h"
 
 class WifiIPStack 
 {
@@ -38,21 +39,38 @@ public:
         return iface.connect(hostname, port);
     }
 
+    /*
+     * Waits up to timeout_ms for data without polling: returns the bytes
+     * ready to read, 0 if none arrived in time, -1 if the connection closed
+     */
+    int waitReadable(int timeout_ms)
+    {
+        return iface.waitAvailable(timeout_ms > 0 ? timeout_ms : 0);
+    }
+
+    /*
+     * A packet can span several of WiFiClient's receive buffers, so it is
+     * collected as it arrives rather than waited for as a whole
+     */
     int read(unsigned char* buffer, int len, int timeout)
     {
-        int interval = 10;  // all times are in milliseconds
-		int total = 0, rc = -1;
+        Countdown timer(timeout);
+        int got = 0;
 
-		if (timeout < 30)
-			interval = 2;
-		while (iface.available() < len && total < timeout)
-		{
-			delay(interval);
-			total += interval;
-		}
-		if (iface.available() >= len)
-			rc = iface.readBytes((char*)buffer, len);
-		return rc;
+        while (got < len)
+        {
+            int rc = iface.waitAvailable(timer.left_ms());
+            if (rc < 0)
+                return -1;
+            if (rc == 0)
+            {
+                if (timer.expired())
+                    return -1;
+                continue;
+            }
+            got += iface.read(buffer + got, len - got);
+        }
+        return got;
     }
 
     
@@ -0,0 +1,97 @@
+/*******************************************************************************
+ * LocalBroker.ino
+ *
+ * Runs an MQTT broker on the LaunchPad on port 1883, so that sensors and
+ * actuators on the same network exchange messages without a cloud broker.
+ * Any MQTT 3.1.1 client can connect, publish and subscribe, with QoS 0 or 1
+ * and retained messages.
+ *
+ * The broker publishes the board's uptime to "broker/uptime", retained, so
+ * that a new subscriber gets the last value at once, and prints every
+ * message a client publishes and the broker's counters.
+ *
+ * Define ACCESS_POINT to have the board create its own network instead of
+ * joining one.
+ *
+ * The host program in extras/mqtt_load.c measures how fast clients can
+ * connect and how many messages the broker passes on.
+ *
+ * Complexity: medium
+ *******************************************************************************/
+
+#include <SPI.h>
+#include <WiFi.h>
+#include <MQTTBroker.h>
+
+// #define ACCESS_POINT
+
+// your network name also called SSID
+char ssid[] = "energia";
+// your network password
+char password[] = "launchpad";
+
+WiFiServer server(1883);
+MQTT::Broker<WiFiServer, WiFiClient> broker(server);
+
+unsigned long lastReport = 0;
+
+void messageArrived(MQTT::MessageData& md)
+{
+  Serial.print("Message on ");
+  Serial.write((uint8_t*)md.topicName.lenstring.data, md.topicName.lenstring.len);
+  Serial.print(": ");
+  Serial.write((uint8_t*)md.message.payload, md.message.payloadlen);
+  Serial.println();
+}
+
+void setup()
+{
+  Serial.begin(115200);
+
+#ifdef ACCESS_POINT
+  Serial.print("Starting network ");
+  Serial.println(ssid);
+  WiFi.beginNetwork(ssid, password);
+#else
+  Serial.print("Attempting to connect to Network named: ");
+  Serial.println(ssid);
+  WiFi.begin(ssid, password);
+#endif
+  while (WiFi.localIP() == INADDR_NONE) {
+    Serial.print(".");
+    delay(300);
+  }
+
+  broker.setMessageHandler(messageArrived);
+  broker.begin();
+
+  Serial.print("\nBroker listening on ");
+  Serial.print(WiFi.localIP());
+  Serial.println(":1883");
+}
+
+void loop()
+{
+  broker.loop();
+
+  if (millis() - lastReport >= 10000) {
+    char uptime[12];
+    MQTT::BrokerStats stats;
+
+    lastReport = millis();
+    sprintf(uptime, "%lu", lastReport / 1000);
+    broker.publish("broker/uptime", uptime, strlen(uptime), MQTT::QOS0, true);
+
+    broker.stats(stats);
+    Serial.print(stats.clients);
+    Serial.print(" clients, ");
+    Serial.print(stats.subscriptions);
+    Serial.print(" subscriptions, ");
+    Serial.print(stats.received);
+    Serial.print(" received, ");
+    Serial.print(stats.delivered);
+    Serial.print(" delivered, ");
+    Serial.print(stats.dropped);
+    Serial.println(" dropped");
+  }
+}
@@ -0,0 +1,316 @@
+/*
+ mqtt_load.c - connection and message rate load for the MQTT broker
+
+ Runs on a host on the same network as the board running
+ examples/LocalBroker, and builds its packets with this library's codecs:
+
+   cc -O2 -I.. -o mqtt_load mqtt_load.c ../MQTTConnectClient.c \
+      ../MQTTSerializePublish.c ../MQTTDeserializePublish.c \
+      ../MQTTSubscribeClient.c ../MQTTPacket.c
+
+   ./mqtt_load connect <broker> [connections]
+   ./mqtt_load rate <broker> [subscribers] [messages] [qos] [payload bytes]
+
+ connect opens a connection, waits for the CONNACK and disconnects, one
+ client after the other, and reports connections per second and the
+ CONNACK latency. rate connects the subscribers to "load/#" and one
+ publisher sending to "load/t", at most 4 messages unacknowledged at QoS 1,
+ and reports the messages in and out per second, the messages lost and
+ the latency from PUBLISH to delivery.
+ */
+
+#define _DEFAULT_SOURCE
+
+#include <arpa/inet.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <poll.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "MQTTPacket.h"
+
+#define PORT        1883
+#define MAX_SUBS    32
+#define WINDOW      4       /* QoS 1 messages the publisher has unacknowledged */
+#define TIMEOUT_MS  5000
+
+typedef struct {
+    int fd;
+    unsigned char rx[1024];
+    int rxLen;
+    long received;
+} Conn;
+
+static struct sockaddr_in broker;
+
+static double now(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (ts.tv_sec + ts.tv_nsec * 1e-9);
+}
+
+static int resolve(const char *host)
+{
+    struct addrinfo hints, *res;
+
+    memset(&hints, 0, sizeof(hints));
+    hints.ai_family = AF_INET;
+    hints.ai_socktype = SOCK_STREAM;
+    if (getaddrinfo(host, NULL, &hints, &res) != 0) {
+        return 0;
+    }
+    memcpy(&broker, res->ai_addr, sizeof(broker));
+    broker.sin_port = htons(PORT);
+    freeaddrinfo(res);
+    return 1;
+}
+
+static int sendAll(Conn *c, unsigned char *buf, int len)
+{
+    while (len > 0) {
+        int n = send(c->fd, buf, len, 0);
+        if (n <= 0) {
+            return 0;
+        }
+        buf += n;
+        len -= n;
+    }
+    return 1;
+}
+
+/*
+ * Moves the next whole packet in c->rx to pkt, reading more if wait_ms
+ * allows; returns its length, 0 if none arrived in time or -1 if the
+ * connection is gone
+ */
+static int nextPacket(Conn *c, unsigned char *pkt, int wait_ms)
+{
+    for (;;) {
+        if (c->rxLen >= 2) {
+            int rem = 0, i = 1, mult = 1, len;
+            while (i < c->rxLen && i < 5) {
+                rem += (c->rx[i] & 127) * mult;
+                mult *= 128;
+                if ((c->rx[i++] & 128) == 0) {
+                    break;
+                }
+            }
+            len = i + rem;
+            if ((c->rx[i - 1] & 128) == 0 && c->rxLen >= len) {
+                memcpy(pkt, c->rx, len);
+                memmove(c->rx, c->rx + len, c->rxLen - len);
+                c->rxLen -= len;
+                return len;
+            }
+        }
+
+        struct pollfd pfd = { c->fd, POLLIN, 0 };
+        if (poll(&pfd, 1, wait_ms) <= 0) {
+            return 0;
+        }
+        int n = recv(c->fd, c->rx + c->rxLen, sizeof(c->rx) - c->rxLen, 0);
+        if (n <= 0) {
+            return -1;
+        }
+        c->rxLen += n;
+    }
+}
+
+static int mqttConnect(Conn *c, const char *id)
+{
+    MQTTPacket_connectData data = MQTTPacket_connectData_initializer;
+    unsigned char buf[128];
+    int one = 1, len;
+
+    memset(c, 0, sizeof(*c));
+    c->fd = socket(AF_INET, SOCK_STREAM, 0);
+    setsockopt(c->fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+    if (connect(c->fd, (struct sockaddr *)&broker, sizeof(broker)) < 0) {
+        close(c->fd);
+        return 0;
+    }
+    data.clientID.cstring = (char *)id;
+    data.keepAliveInterval = 60;
+    len = MQTTSerialize_connect(buf, sizeof(buf), &data);
+    if (!sendAll(c, buf, len) || nextPacket(c, buf, TIMEOUT_MS) != 4 ||
+        buf[0] >> 4 != CONNACK || buf[3] != 0) {
+        close(c->fd);
+        return 0;
+    }
+    return 1;
+}
+
+static void mqttDisconnect(Conn *c)
+{
+    unsigned char buf[2];
+
+    sendAll(c, buf, MQTTSerialize_disconnect(buf, sizeof(buf)));
+    close(c->fd);
+}
+
+static int connectRate(int count)
+{
+    double start = now(), min = 1e9, max = 0, total = 0;
+    char id[24];
+    int i, ok = 0;
+
+    for (i = 0; i < count; i++) {
+        Conn c;
+        double t = now();
+
+        sprintf(id, "load-%d", i);
+        if (!mqttConnect(&c, id)) {
+            continue;
+        }
+        t = now() - t;
+        mqttDisconnect(&c);
+        ok++;
+        total += t;
+        if (t < min) min = t;
+        if (t > max) max = t;
+    }
+    total /= ok ? ok : 1;
+    printf("%d of %d connections, %.1f per second\n", ok, count, ok / (now() - start));
+    printf("CONNACK in %.1f ms min, %.1f avg, %.1f max\n", min * 1e3, total * 1e3, max * 1e3);
+    return ok == count ? 0 : 1;
+}
+
+static int messageRate(int subscribers, int messages, int qos, int size)
+{
+    static Conn subs[MAX_SUBS];
+    Conn pub;
+    unsigned char buf[1100], payload[1024];
+    MQTTString topic = MQTTString_initializer;
+    struct pollfd pfds[MAX_SUBS + 1];
+    double start, end, latency = 0, worst = 0;
+    long expected = (long)subscribers * messages, delivered = 0;
+    int sent = 0, acked = 0, i, len, sub_qos = qos;
+    char id[24];
+
+    for (i = 0; i < subscribers; i++) {
+        sprintf(id, "sub-%d", i);
+        topic.cstring = "load/#";
+        if (!mqttConnect(&subs[i], id)) {
+            fprintf(stderr, "subscriber %d can't connect\n", i);
+            return 1;
+        }
+        len = MQTTSerialize_subscribe(buf, sizeof(buf), 0, 1, 1, &topic, &sub_qos);
+        sendAll(&subs[i], buf, len);
+        if (nextPacket(&subs[i], buf, TIMEOUT_MS) <= 0 || buf[0] >> 4 != SUBACK) {
+            fprintf(stderr, "subscriber %d not subscribed\n", i);
+            return 1;
+        }
+        pfds[i].fd = subs[i].fd;
+        pfds[i].events = POLLIN;
+    }
+    if (!mqttConnect(&pub, "pub")) {
+        fprintf(stderr, "publisher can't connect\n");
+        return 1;
+    }
+    pfds[subscribers].fd = pub.fd;     /* for the PUBACKs */
+    pfds[subscribers].events = POLLIN;
+
+    topic.cstring = "load/t";
+    memset(payload, 'x', sizeof(payload));
+    start = end = now();
+    while (delivered < expected) {
+        /* take the PUBACKs, then publish while the window allows */
+        while (qos > 0 && nextPacket(&pub, buf, 0) > 0) {
+            acked++;
+        }
+        while (sent < messages && (qos == 0 || sent - acked < WINDOW)) {
+            double t = now();
+            memcpy(payload, &t, sizeof(t));
+            len = MQTTSerialize_publish(buf, sizeof(buf), 0, qos, 0, sent + 1, topic, payload, size);
+            if (!sendAll(&pub, buf, len)) {
+                fprintf(stderr, "publisher lost\n");
+                return 1;
+            }
+            sent++;
+            if (qos == 0) {
+                break;      /* give the subscribers a turn */
+            }
+        }
+
+        if (poll(pfds, subscribers + 1, TIMEOUT_MS) <= 0 && sent == messages) {
+            break;          /* whatever is missing won't come */
+        }
+        for (i = 0; i < subscribers; i++) {
+            unsigned char dup, retained, *data;
+            unsigned short packetid;
+            int q, datalen;
+            MQTTString name;
+
+            if (!(pfds[i].revents & POLLIN)) {
+                continue;
+            }
+            while ((len = nextPacket(&subs[i], buf, 0)) > 0) {
+                if (MQTTDeserialize_publish(&dup, &q, &retained, &packetid, &name, &data, &datalen, buf, len) != 1 ||
+                    retained) {
+                    continue;
+                }
+                if (q == 1) {
+                    unsigned char ack[4];
+                    sendAll(&subs[i], ack, MQTTSerialize_puback(ack, sizeof(ack), packetid));
+                }
+                if (datalen >= (int)sizeof(double)) {
+                    double t;
+                    memcpy(&t, data, sizeof(t));
+                    t = now() - t;
+                    latency += t;
+                    if (t > worst) worst = t;
+                }
+                subs[i].received++;
+                delivered++;
+                end = now();
+            }
+        }
+    }
+
+    for (i = 0; i < subscribers; i++) {
+        mqttDisconnect(&subs[i]);
+    }
+    mqttDisconnect(&pub);
+
+    end -= start;
+    printf("%d messages of %d bytes at QoS %d to %d subscribers in %.2f s\n", sent, size, qos, subscribers, end);
+    printf("%.1f messages per second in, %.1f deliveries per second out\n", sent / end, delivered / end);
+    printf("%ld of %ld deliveries lost\n", expected - delivered, expected);
+    printf("latency %.1f ms avg, %.1f ms max\n", delivered ? latency * 1e3 / delivered : 0, worst * 1e3);
+    return delivered == expected ? 0 : 1;
+}
+
+int main(int argc, char *argv[])
+{
+    if (argc < 3 || !resolve(argv[2])) {
+        fprintf(stderr, "usage: %s connect <broker> [connections]\n"
+                        "       %s rate <broker> [subscribers] [messages] [qos] [payload bytes]\n",
+                argv[0], argv[0]);
+        return 2;
+    }
+
+    if (strcmp(argv[1], "connect") == 0) {
+        return connectRate(argc > 3 ? atoi(argv[3]) : 100);
+    }
+    else {
+        int subscribers = argc > 3 ? atoi(argv[3]) : 3;
+        int messages = argc > 4 ? atoi(argv[4]) : 1000;
+        int qos = argc > 5 ? atoi(argv[5]) : 0;
+        int size = argc > 6 ? atoi(argv[6]) : 16;
+
+        if (subscribers < 1 || subscribers > MAX_SUBS || qos < 0 || qos > 1 ||
+            size < (int)sizeof(double) || size > 1024) {
+            fprintf(stderr, "1 to %d subscribers, QoS 0 or 1, %d to 1024 bytes\n", MAX_SUBS, (int)sizeof(double));
+            return 2;
+        }
+        return messageRate(subscribers, messages, qos, size);
+    }
+}
@@ -43,8 +43,14 @@
 #include "Energia.h"
 #include "OneMsTaskTimer.h"
 
-volatile int8_t overflowing;
-OneMsTaskTimer_t * p_initial_OneMsTaskTimer = 0;
+#define WHEEL_MASK (ONEMSTASK_WHEEL_SIZE - 1)
+
+// flags bit set while a ONEMSTASK_DEFERRED call is queued
+#define ONEMSTASK_PENDING 0x80
+
+static OneMsTaskTimer_t * wheel[ONEMSTASK_WHEEL_SIZE];
+static volatile uint32_t wheelNow;      // last tick the wheel was advanced to
+static volatile uint32_t wheelTasks;    // tasks in the wheel
 
 #if defined(__MSP430__)
 
@@ -108,7 +114,6 @@ uint32_t timer_index_ = DEFAULT_TIMER;
 
 void OneMsTaskTimer::start(uint32_t timer_index) {
   //// !!!! count = 0;
-  overflowing = 0;
   // identical to the wiring_analog.c pwm setup so is compatible
   TAxCCR0 = PWM_PERIOD;           // PWM Period
   TAxCTL = TACLR | TASSEL_2 | MC__UP | PWM_DIV;            // SMCLK, up mode
@@ -129,7 +134,7 @@ void OneMsTaskTimer_int(void)
 {
   OneMsTaskTimer::_ticHandler();
 }
-
+
 #endif //if defined(__MSP430__)
 
 
@@ -158,7 +163,6 @@ void OneMsTaskTimer_int(void);
 void OneMsTaskTimer::start(uint32_t timer_index) {
   uint32_t load = (F_CPU / 1000);
   //// !!!! count = 0;
-  overflowing = 0;
   // Base address for first timer
   g_ulBase = TIMERA0_BASE + (timer_index <<12);
   // Configuring the timers
@@ -224,7 +228,6 @@ void OneMsTaskTimer_int(void);
 void OneMsTaskTimer::start(uint32_t timer_index) {
   uint32_t load = (F_CPU / 1000);
   //// !!!! count = 0;
-  overflowing = 0;
   // Base address for first timer
   g_ulBase = getTimerBase(timerToOffset(timer_index));
   timerAB = TIMER_A << timerToAB(timer_index);
@@ -265,26 +268,200 @@ void OneMsTaskTimer_int(void)
 #include <xdc/runtime/Error.h>
 #include <ti/sysbios/BIOS.h>
 #include <ti/sysbios/knl/Clock.h>
-#include <xdc/runtime/Error.h>
+#include <ti/sysbios/knl/Swi.h>
+#include <ti/sysbios/knl/Task.h>
+#include <ti/sysbios/knl/Semaphore.h>
 #include <xdc/runtime/Types.h>
 
 #define DEFAULT_TIMER 1
 uint32_t timer_index_ = DEFAULT_TIMER;
-static volatile uint32_t g_ulBase;
+static Clock_Handle clock_ = NULL;
+static volatile bool running_ = false;
+static bool tickless_ = false;
 void OneMsTaskTimer_int(UArg arg);
 
+static Task_Handle deferredTask = NULL;
+static Semaphore_Struct deferredSem;
+static OneMsTaskTimer_t * deferredHead = 0;
+static OneMsTaskTimer_t * deferredTail = 0;
+
+static uint32_t nextDue(void);
+static void rebase(uint32_t now);
+
+// the wheel is advanced by the Clock Swi, so holding off Swis is enough
+static inline uint32_t lock() {
+  return (Swi_disable());
+}
+
+static inline void unlock(uint32_t key) {
+  Swi_restore(key);
+}
+
+// tick a task added now is counted from
+static inline uint32_t timerNow() {
+  return (running_ ? Clock_getTicks() : wheelNow);
+}
+
+// tick to advance the wheel to
+static inline uint32_t timerTicks() {
+  return (Clock_getTicks());
+}
+
+// an empty wheel is not advanced in tickless mode: catch it up before the
+// first task goes in, rather than have the next tick step it through every
+// tick since, called locked
+static inline void wake() {
+  if (tickless_ && running_) {
+    wheelNow = Clock_getTicks();
+  }
+}
+
+// in tickless mode arm the Clock for the next due task, called locked
+static void reprogram() {
+  uint32_t now, next;
+
+  if (!tickless_ || !running_) {
+    return;
+  }
+  Clock_stop(clock_);
+  if (wheelTasks == 0) {
+    return;
+  }
+  next = nextDue();
+  now = Clock_getTicks();
+  Clock_setTimeout(clock_, (int32_t)(next - now) > 0 ? next - now : 1);
+  Clock_start(clock_);
+}
+
+static void deferredFxn(UArg arg0, UArg arg1) {
+  OneMsTaskTimer_t * task;
+  uint32_t key;
+
+  while (1) {
+    Semaphore_pend(Semaphore_handle(&deferredSem), BIOS_WAIT_FOREVER);
+    while (1) {
+      key = lock();
+      task = deferredHead;
+      if (task != 0) {
+        deferredHead = task->nextDeferred;
+        if (deferredHead == 0) {
+          deferredTail = 0;
+        }
+        task->flags &= ~ONEMSTASK_PENDING;
+      }
+      unlock(key);
+      if (task == 0) {
+        break;
+      }
+      (*task->func)();
+    }
+  }
+}
+
+static void startDeferred() {
+  Semaphore_Params semParams;
+  Task_Params taskParams;
+  Error_Block eb;
+
+  if (deferredTask != NULL) {
+    return;
+  }
+  Semaphore_Params_init(&semParams);
+  semParams.mode = Semaphore_Mode_BINARY;
+  Semaphore_construct(&deferredSem, 0, &semParams);
+
+  Error_init(&eb);
+  Task_Params_init(&taskParams);
+  taskParams.priority = ONEMSTASK_TASK_PRIORITY;
+  taskParams.stackSize = ONEMSTASK_TASK_STACK;
+  deferredTask = Task_create(deferredFxn, &taskParams, &eb);
+}
+
+// calls a due task, or queues it for the deferred task
+static void dispatch(OneMsTaskTimer_t * task) {
+  if ((task->flags & ONEMSTASK_DEFERRED) == 0 || deferredTask == NULL) {
+    (*task->func)();
+    return;
+  }
+  // still queued from the last time it was due: call it once
+  if (task->flags & ONEMSTASK_PENDING) {
+    return;
+  }
+  task->flags |= ONEMSTASK_PENDING;
+  task->nextDeferred = 0;
+  if (deferredTail != 0) {
+    deferredTail->nextDeferred = task;
+  }else{
+    deferredHead = task;
+  }
+  deferredTail = task;
+  Semaphore_post(Semaphore_handle(&deferredSem));
+}
+
+// drops a queued deferred call of a removed task, called locked
+static void undefer(OneMsTaskTimer_t * task) {
+  OneMsTaskTimer_t ** p_link = &deferredHead;
+  OneMsTaskTimer_t * p_prev = 0;
+
+  if ((task->flags & ONEMSTASK_PENDING) == 0) {
+    return;
+  }
+  while (*p_link != task) {
+    p_prev = *p_link;
+    p_link = &p_prev->nextDeferred;
+  }
+  *p_link = task->nextDeferred;
+  if (deferredTail == task) {
+    deferredTail = p_prev;
+  }
+  task->flags &= ~ONEMSTASK_PENDING;
+}
+
+void OneMsTaskTimer::set_tickless(bool enable) {
+  tickless_ = enable;
+}
+
 void OneMsTaskTimer::start(uint32_t timer_index) {
     Clock_Params clockParams;
-    Clock_Handle myClock;
     Error_Block eb;
-    Error_init(&eb);
+    uint32_t key;
+
+    if (clock_ == NULL) {
+        Error_init(&eb);
+        Clock_Params_init(&clockParams);
+        clockParams.startFlag = FALSE;
+        clock_ = Clock_create(OneMsTaskTimer_int, 1, &clockParams, &eb);
+        if (clock_ == NULL) {
+            return;
+        }
+    }
 
-    Clock_Params_init(&clockParams);
-    clockParams.period = 1;
-    clockParams.startFlag = TRUE;
-    clockParams.arg = (UArg)0x5555;
+    key = lock();
+    if (!running_) {
+        // time does not pass for the tasks while the timer is stopped
+        rebase(Clock_getTicks());
+        Clock_setPeriod(clock_, tickless_ ? 0 : 1);
+        Clock_setTimeout(clock_, 1);
+        running_ = true;
+        if (tickless_) {
+            reprogram();
+        }else{
+            Clock_start(clock_);
+        }
+    }
+    unlock(key);
+}
+
+void OneMsTaskTimer::stop() {
+    uint32_t key;
 
-    myClock = Clock_create(OneMsTaskTimer_int, 1, &clockParams, &eb);
+    if (clock_ == NULL) {
+        return;
+    }
+    key = lock();
+    Clock_stop(clock_);
+    running_ = false;
+    unlock(key);
 }
 
 void OneMsTaskTimer_int(UArg arg)
@@ -292,6 +469,45 @@ void OneMsTaskTimer_int(UArg arg)
   OneMsTaskTimer::_ticHandler();
 }
 
+#else
+
+// the wheel is advanced by the timer interrupt
+static inline uint32_t lock() {
+  noInterrupts();
+  return (0);
+}
+
+static inline void unlock(uint32_t key) {
+  interrupts();
+}
+
+static inline uint32_t timerNow() {
+  return (wheelNow);
+}
+
+static inline uint32_t timerTicks() {
+  return (wheelNow + 1);
+}
+
+static inline void wake() {
+}
+
+static inline void reprogram() {
+}
+
+static inline void dispatch(OneMsTaskTimer_t * task) {
+  (*task->func)();
+}
+
+static inline void undefer(OneMsTaskTimer_t * task) {
+}
+
+static inline void startDeferred() {
+}
+
+void OneMsTaskTimer::set_tickless(bool enable) {
+}
+
 #endif //#if defined(ti_sysbios_BIOS___VERS)
 // ---------------------------------------------------------------------
 // Common Functions
@@ -307,66 +523,140 @@ void OneMsTaskTimer::start() {
 }
 
 
-// add an additional task into the handler
-void OneMsTaskTimer::add(OneMsTaskTimer_t * task) {
-  OneMsTaskTimer_t * p_task = p_initial_OneMsTaskTimer;
-  if (p_task == 0){
-	  p_initial_OneMsTaskTimer = task;
-  }else{
-	while (p_task->nextTask != 0){
-	  p_task = p_task->nextTask;
-	}
-	p_task->nextTask = task;
+// puts a task at the front of a list
+static void listAdd(OneMsTaskTimer_t ** p_head, OneMsTaskTimer_t * task) {
+  task->nextTask = *p_head;
+  if (task->nextTask != 0){
+    task->nextTask->prevTask = &task->nextTask;
+  }
+  task->prevTask = p_head;
+  *p_head = task;
+}
+
+// takes a task out of whatever list it is in
+static void listRemove(OneMsTaskTimer_t * task) {
+  *task->prevTask = task->nextTask;
+  if (task->nextTask != 0){
+    task->nextTask->prevTask = task->prevTask;
   }
-  p_task = task;
-	
+  task->nextTask = 0;
+  task->prevTask = 0;
+}
+
+// a task due at tick t waits in slot t % ONEMSTASK_WHEEL_SIZE
+static void insert(OneMsTaskTimer_t * task) {
+  listAdd(&wheel[task->count & WHEEL_MASK], task);
+}
+
+#if defined(ti_sysbios_BIOS___VERS)
+// first tick with a due task, looking at most one turn of the wheel ahead
+static uint32_t nextDue(void) {
+  OneMsTaskTimer_t * p_task;
+  uint32_t tick;
+
+  for (tick = wheelNow + 1; tick != wheelNow + ONEMSTASK_WHEEL_SIZE; tick++){
+    for (p_task = wheel[tick & WHEEL_MASK]; p_task != 0; p_task = p_task->nextTask){
+      if (p_task->count == tick){
+        return (tick);
+      }
+    }
+  }
+  return (tick);
+}
+
+// moves the wheel to now, keeping the time left for each task
+static void rebase(uint32_t now) {
+  OneMsTaskTimer_t * p_all = 0;
+  OneMsTaskTimer_t * p_task;
+  uint32_t slot;
+
+  for (slot = 0; slot < ONEMSTASK_WHEEL_SIZE; slot++){
+    while ((p_task = wheel[slot]) != 0){
+      listRemove(p_task);
+      listAdd(&p_all, p_task);
+    }
+  }
+  while ((p_task = p_all) != 0){
+    listRemove(p_task);
+    p_task->count += now - wheelNow;
+    insert(p_task);
+  }
+  wheelNow = now;
+}
+#endif
+
+// add an additional task into the handler, or restart it if it is in already
+void OneMsTaskTimer::add(OneMsTaskTimer_t * task) {
+  uint32_t key;
+
   // ensure save initialisation
   if (task->msecs == 0)
   	task->msecs = 1;
-  task->count = 0;
-  task->nextTask = 0;
+  if (task->flags & ONEMSTASK_DEFERRED)
+    startDeferred();
+
+  key = lock();
+  if (task->prevTask != 0){
+    listRemove(task);
+  }else{
+    if (wheelTasks == 0){
+      wake();
+    }
+    wheelTasks++;
+  }
+  task->count = timerNow() + task->msecs;
+  insert(task);
+  reprogram();
+  unlock(key);
 }
 
 // removes an task from the handler
 void OneMsTaskTimer::remove(OneMsTaskTimer_t * task) {
-  OneMsTaskTimer_t * p_task;
-  OneMsTaskTimer_t * p_nexttask;
-  p_nexttask = (OneMsTaskTimer_t *)p_initial_OneMsTaskTimer;
-  p_task = p_nexttask;
+  uint32_t key;
 
-  while (p_nexttask != task && p_nexttask != 0){
-    p_task = p_nexttask;
-    p_nexttask = p_task->nextTask;
-  }
-  if (p_nexttask != 0){
-    if (p_nexttask == p_initial_OneMsTaskTimer){
-      if (p_nexttask != 0){
-        p_initial_OneMsTaskTimer = p_nexttask->nextTask;
-      }else{
-        p_initial_OneMsTaskTimer = 0;
-      }
-    }else{
-      p_task->nextTask = p_nexttask->nextTask;
-    }
+  key = lock();
+  if (task->prevTask != 0){
+    listRemove(task);
+    wheelTasks--;
   }
+  undefer(task);
+  reprogram();
+  unlock(key);
 }
 
 // called by the ISR every time we get an interrupt
 void OneMsTaskTimer::_ticHandler() {
-  OneMsTaskTimer_t * p_task = p_initial_OneMsTaskTimer;
-
-  while (p_task != 0){
-    // It is a 1000hz interrupt so each interrupt is 1msec
-    p_task->count += 1;
-    if (p_task->count >= p_task->msecs && !overflowing) {
-      overflowing = 1;
-      // subtract ms to catch missed overflows. set to 0 if you don't want this.
-      // do this before running supplied function so don't take into account handler time
-      p_task->count = p_task->count - p_task->msecs;
-      // call the program supplied function
-      (*p_task->func)();
-      overflowing = 0;
+  uint32_t now = timerTicks();
+  OneMsTaskTimer_t * p_expired;
+  OneMsTaskTimer_t * p_task;
+  OneMsTaskTimer_t * p_next;
+
+  while (wheelNow != now){
+    wheelNow++;
+
+    // only the tasks sharing this slot are looked at, those due in a
+    // later turn of the wheel stay
+    p_expired = 0;
+    for (p_task = wheel[wheelNow & WHEEL_MASK]; p_task != 0; p_task = p_next){
+      p_next = p_task->nextTask;
+      if (p_task->count == wheelNow){
+        listRemove(p_task);
+        listAdd(&p_expired, p_task);
+      }
+    }
+
+    // every due task is called, a function may add or remove tasks
+    while ((p_task = p_expired) != 0){
+      listRemove(p_task);
+      if (p_task->flags & ONEMSTASK_ONESHOT){
+        wheelTasks--;
+      }else{
+        // counted from when it was due so a late call does not drift
+        p_task->count += p_task->msecs;
+        insert(p_task);
+      }
+      dispatch(p_task);
     }
-    p_task = (OneMsTaskTimer_t *)p_task->nextTask;
   }
+  reprogram();
 }
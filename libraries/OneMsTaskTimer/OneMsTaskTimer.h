@@ -54,6 +54,11 @@ How to use:
    Parameter 2: pointer to function which should be called by the tasks
    Parameter 3: init 0 - only used internal
    Parameter 4: init 0 - only used internal
+   Parameter 5: optional flags, 0 if omitted
+                ONEMSTASK_ONESHOT  - call the function once, Parameter 1 ms after add()
+                ONEMSTASK_DEFERRED - call the function from a task instead of the
+                                     timer interrupt (TI-RTOS only), so it may block
+                                     or take longer than a tick
  
  Add a task to the list to be processed:
    OneMsTaskTimer::add(&myTask1); // 500ms period
@@ -65,6 +70,9 @@ How to use:
 
   To remove a task from the list use:
     void remove(OneMsTaskTimer_t * task);
+  A one-shot task removes itself once it has been called and can be added again.
+  add() and remove() take the same short time however many tasks there are, and
+  may be called from a task function.
 	
   When getting problems that a timer is used by another function already, a different
   Timer can be selected with:  
@@ -74,6 +82,15 @@ How to use:
         #define DEFAULT_TIMER TIMER_A0_MODULE
 		in the library source file
 
+  With TI-RTOS the timer can run tickless: instead of an interrupt every
+  millisecond it is only woken up when the next task is due.
+   void set_tickless(bool enable); // before start()
+
+ Implementation:
+  The tasks are kept in a hashed timer wheel of ONEMSTASK_WHEEL_SIZE slots, a task
+  due at tick t waits in slot t % ONEMSTASK_WHEEL_SIZE. Each tick only looks at one
+  slot, so the work per tick depends on the tasks sharing that slot rather than on
+  the number of tasks.
 */
 
 
@@ -82,23 +99,33 @@ How to use:
 
 #include <stdint.h>
 
+#define ONEMSTASK_ONESHOT       0x01
+#define ONEMSTASK_DEFERRED      0x02
+
+#define ONEMSTASK_WHEEL_SIZE    64      // slots, a power of two
+#define ONEMSTASK_TASK_PRIORITY 2       // task calling ONEMSTASK_DEFERRED functions
+#define ONEMSTASK_TASK_STACK    0x400
+
 typedef struct OneMsTaskTimer_t{
     uint32_t msecs;
     void (*func)();
-    uint32_t count;
-    OneMsTaskTimer_t * nextTask;
+    uint32_t count;                     // tick of the next call
+    OneMsTaskTimer_t * nextTask;        // next task in the same wheel slot
+    uint32_t flags;
+    OneMsTaskTimer_t ** prevTask;       // link pointing at this task, 0 if not added
+    OneMsTaskTimer_t * nextDeferred;    // queue of ONEMSTASK_DEFERRED calls
 } OneMsTaskTimer_t;
 
 
 namespace OneMsTaskTimer {
-//	extern volatile int8_t overflowing;
 	void add(OneMsTaskTimer_t * task);
 	void remove(OneMsTaskTimer_t * task);
 	void start();
 	void start(uint32_t timer_index);
 	void stop();
 	void set_timer_index(uint32_t timer_index);
+	void set_tickless(bool enable);
 	void _ticHandler();
 }
 
-#endif
+#endif
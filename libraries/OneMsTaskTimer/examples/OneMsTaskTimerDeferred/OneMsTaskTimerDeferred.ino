@@ -0,0 +1,52 @@
+/*
+ Sample program that uses a deferred and a one-shot task triggered by the
+ OneMsTaskTimer, with the timer running tickless.
+
+ report() prints, which is too slow for the timer interrupt, so it is
+ flagged ONEMSTASK_DEFERRED and called from a task instead.
+ ledOff() is a one-shot task: every report switches the LED on and
+ adds ledOff() again to switch it off 50ms later.
+
+ The circuit:
+ * LED common tied to VCC.
+ * LED connected to I/Os
+  
+ This example code is in the public domain.
+ 
+*/
+
+#include "OneMsTaskTimer.h"
+
+const int heartbeatPin = RED_LED;
+volatile unsigned long reports = 0;
+
+OneMsTaskTimer_t reportTask ={1000, report, 0, 0, ONEMSTASK_DEFERRED};
+OneMsTaskTimer_t ledOffTask ={50,   ledOff, 0, 0, ONEMSTASK_ONESHOT};
+
+void setup()  { 
+  // open the hardware serial port
+  Serial.begin(115200);
+  pinMode(heartbeatPin, OUTPUT);
+  OneMsTaskTimer::add(&reportTask); // 1000ms period, called from a task
+  OneMsTaskTimer::set_tickless(true);
+  OneMsTaskTimer::start();
+} 
+
+void loop()  { 
+}
+
+// called from the OneMsTaskTimer task, may take its time
+void report(){
+  reports++;
+  Serial.print("report ");
+  Serial.print(reports);
+  Serial.print(" at ");
+  Serial.println(millis());
+  digitalWrite(heartbeatPin, HIGH);
+  OneMsTaskTimer::add(&ledOffTask); // once, 50ms from now
+}
+
+// interrupt handler passed to OneMsTaskTimer
+void ledOff(){
+  digitalWrite(heartbeatPin, LOW);
+}
@@ -112,6 +112,7 @@
 #define DIRECT_WRITE_HIGH(base, mask)   ((*(base+0x0FF)) |= (mask))
 
 #elif defined(__CC3200R1M1RGC__)
+#include <inc/hw_types.h>
 #include <inc/hw_gpio.h>
 // CC3200 Launchpad
 #define PIN_TO_BASEREG(pin)             (portBASERegister(digitalPinToPort(pin)))
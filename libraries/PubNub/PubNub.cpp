@@ -5,6 +5,8 @@
 #endif
 
 #include <ctype.h>
+#include <stdio.h>
+#include <string.h>
 #include "PubNub.h"
 
 //#define PUBNUB_DEBUG 1
@@ -24,7 +26,8 @@
  * so we should call .flush() after initiating a connection.
  *
  * (ii) It appears .stop() does not block on really terminating
- * the connection, do that manually.
+ * the connection; we never reuse a client object for a new connection
+ * right away, so we do not wait for it.
  *
  * (iii) Data may still be available while connected() returns false
  * already; use available() test on a lot of places where we used
@@ -39,6 +42,9 @@ bool PubNub::begin(const char *publish_key_, const char *subscribe_key_, const c
 	subscribe_key = subscribe_key_;
 	origin = origin_;
 	uuid = NULL;
+	retry_at = 0;
+	retry_delay = 0;
+	return true;
 }
 
 void PubNub::set_uuid(const char *uuid_)
@@ -46,99 +52,140 @@ void PubNub::set_uuid(const char *uuid_)
 	uuid = uuid_;
 }
 
-PubNub_BASE_CLIENT *PubNub::publish(const char *channel, const char *message, int timeout)
+/* Take the subscribe connection if nothing is under way on it, the
+ * publish connection otherwise. */
+PubSubClient &PubNub::_claim_client()
 {
-	PubNub_BASE_CLIENT &client = publish_client;
-	unsigned long t_start;
+	PubSubClient *client = &subscribe_client;
+
+	noInterrupts();
+	if (client->busy)
+		client = &publish_client;
+	client->busy = true;
+	interrupts();
+	return *client;
+}
+
+/* Open the connection unless it is kept alive from the last request.
+ * While a retry delay runs, fail right away instead of blocking. */
+bool PubNub::_connect(PubSubClient &client)
+{
+	if (client.connected())
+		return true;
+	if (retry_delay != 0 && (long) (millis() - retry_at) < 0) {
+		DBGprintln("Waiting to reconnect");
+		return false;
+	}
 
-retry:
-	t_start = millis();
 	/* connect() timeout is about 30s, much lower than our usual
 	 * timeout is. */
 	if (!client.connect(origin, 80)) {
 		DBGprintln("Connection error");
 		client.stop();
-		return NULL;
+		retry_delay = retry_delay ? retry_delay * 2 : PubNub_RETRY_MIN;
+		if (retry_delay > PubNub_RETRY_MAX)
+			retry_delay = PubNub_RETRY_MAX;
+		retry_at = millis() + retry_delay;
+		return false;
 	}
-
 	client.flush();
-	client.print("GET /publish/");
-	client.print(publish_key);
-	client.print("/");
-	client.print(subscribe_key);
-	client.print("/0/");
-	client.print(channel);
-	client.print("/0/");
-
-	/* Inject message, URI-escaping it in the process.
-	 * We are careful to save RAM by not using any copies
-	 * of the string or explicit buffers. */
-	const char *pmessage = message;
-	while (pmessage[0]) {
-		/* RFC 3986 Unreserved characters plus few
-		 * safe reserved ones. */
-		size_t okspan = strspn(pmessage, "abcdefghijklmnopqrstuvwxyzABCDEFGHIJKLMNOPQRSTUVWXYZ0123456789-_.~" ",=:;@[]");
-		if (okspan > 0) {
-			client.write((const uint8_t *) pmessage, okspan);
-			pmessage += okspan;
-		}
-		if (pmessage[0]) {
-			/* %-encode a non-ok character. */
-			char enc[3] = {'%'};
-			enc[1] = "0123456789ABCDEF"[pmessage[0] / 16];
-			enc[2] = "0123456789ABCDEF"[pmessage[0] % 16];
-			client.write((const uint8_t *) enc, 3);
-			pmessage++;
-		}
+	retry_delay = 0;
+	return true;
+}
+
+PubNub_BASE_CLIENT *PubNub::publish(const char *channel, const char *message, int timeout)
+{
+	PubSubClient &client = _claim_client();
+	char buf[PubNub_REQUEST_MAX];
+	PString request(buf, sizeof(buf));
+	unsigned long t_start;
+	bool reused;
+
+	client._finish();
+	client.busy = true;
+	request.spillTo(&client);
+
+retry:
+	t_start = millis();
+	reused = client.connected();
+	if (!_connect(client)) {
+		client.busy = false;
+		return NULL;
 	}
 
-	enum PubNub_BH ret = this->_request_bh(client, t_start, timeout, '?');
+	request.begin();
+	request.print("GET /publish/");
+	request.print(publish_key);
+	request.print("/");
+	request.print(subscribe_key);
+	request.print("/0/");
+	request.print(channel);
+	request.print("/0/");
+	/* Inject message, URI-escaping it in the process: RFC 3986
+	 * unreserved characters plus a few safe reserved ones. */
+	request.printUrl(message, ",=:;@[]");
+	_end_request(request, '?');
+
+	enum PubNub_BH ret = this->_request_bh(client, request, t_start, timeout);
 	switch (ret) {
 	case PubNub_BH_OK:
 		/* Success and reached body, return handle to the client
 		 * for further perusal. */
 		return &client;
+	case PubNub_BH_CLOSED:
+		/* The server closed the kept-alive connection before
+		 * our request arrived. Open a new one. */
+		client.stop();
+		if (reused)
+			goto retry;
+		return NULL;
 	case PubNub_BH_ERROR:
 		/* Failure. */
 		client.stop();
-		while (client.connected()) ;
 		return NULL;
 	case PubNub_BH_TIMEOUT:
 		/* Time out. Try again. */
 		client.stop();
-		while (client.connected()) ;
 		goto retry;
 	}
+	return NULL;
 }
 
 PubSubClient *PubNub::subscribe(const char *channel, int timeout)
 {
 	PubSubClient &client = subscribe_client;
+	char buf[PubNub_REQUEST_MAX];
+	PString request(buf, sizeof(buf));
 	unsigned long t_start;
+	bool reused;
+
+	client._finish();
+	client.busy = true;
+	request.spillTo(&client);
 
 retry:
 	t_start = millis();
-	/* connect() timeout is about 30s, much lower than our usual
-	 * timeout is. */
-	if (!client.connect(origin, 80)) {
-		DBGprintln("Connection error");
-		client.stop();
+	reused = client.connected();
+	if (!_connect(client)) {
+		client.busy = false;
 		return NULL;
 	}
 
-	client.flush();
-	client.print("GET /subscribe/");
-	client.print(subscribe_key);
-	client.print("/");
-	client.print(channel);
-	client.print("/0/");
-	client.print(client.server_timetoken());
+	/* The time token is the one _finish() just read. */
+	request.begin();
+	request.print("GET /subscribe/");
+	request.print(subscribe_key);
+	request.print("/");
+	request.print(channel);
+	request.print("/0/");
+	request.print(client.server_timetoken());
 	if (uuid) {
-		client.print("?uuid=");
-		client.print(uuid);
+		request.print("?uuid=");
+		request.print(uuid);
 	}
+	_end_request(request, uuid ? '&' : '?');
 
-	enum PubNub_BH ret = this->_request_bh(client, t_start, timeout, uuid ? '&' : '?');
+	enum PubNub_BH ret = this->_request_bh(client, request, t_start, timeout);
 	switch (ret) {
 	case PubNub_BH_OK:
 		/* Success and reached body. We need to eat '[' first,
@@ -148,8 +195,8 @@ retry:
 		    || client.read() != '[') {
 			/* Something unexpected. */
 			DBGprintln("Unexpected body in subscribe");
+			client.keepalive = false;
 			client.stop();
-			while (client.connected()) ;
 			return NULL;
 		}
 		/* Now return handle to the client for further perusal.
@@ -159,211 +206,299 @@ retry:
 		client.start_body();
 		return &client;
 
+	case PubNub_BH_CLOSED:
+		/* The server closed the kept-alive connection before
+		 * our request arrived. Open a new one. */
+		client.stop();
+		if (reused)
+			goto retry;
+		return NULL;
+
 	case PubNub_BH_ERROR:
 		/* Failure. */
 		client.stop();
-		while (client.connected()) ;
 		return NULL;
 
 	case PubNub_BH_TIMEOUT:
 		/* Time out. Try again. */
 		client.stop();
-		while (client.connected()) ;
 		goto retry;
 	}
+	return NULL;
 }
 
 PubNub_BASE_CLIENT *PubNub::history(const char *channel, int limit, int timeout)
 {
-	PubNub_BASE_CLIENT &client = history_client;
+	PubSubClient &client = _claim_client();
+	char buf[PubNub_REQUEST_MAX];
+	PString request(buf, sizeof(buf));
 	unsigned long t_start;
+	bool reused;
+
+	client._finish();
+	client.busy = true;
+	request.spillTo(&client);
 
 retry:
 	t_start = millis();
-	if (!client.connect(origin, 80)) {
-		DBGprintln("Connection error");
-		client.stop();
+	reused = client.connected();
+	if (!_connect(client)) {
+		client.busy = false;
 		return NULL;
 	}
 
-	client.flush();
-	client.print("GET /history/");
-	client.print(subscribe_key);
-	client.print("/");
-	client.print(channel);
-	client.print("/0/");
-	client.print(limit, DEC);
-
-	enum PubNub_BH ret = this->_request_bh(client, t_start, timeout, '?');
+	request.begin();
+	request.print("GET /history/");
+	request.print(subscribe_key);
+	request.print("/");
+	request.print(channel);
+	request.print("/0/");
+	request.print(limit);
+	_end_request(request, '?');
+
+	enum PubNub_BH ret = this->_request_bh(client, request, t_start, timeout);
 	switch (ret) {
 	case PubNub_BH_OK:
 		/* Success and reached body, return handle to the client
 		 * for further perusal. */
 		return &client;
+	case PubNub_BH_CLOSED:
+		/* The server closed the kept-alive connection before
+		 * our request arrived. Open a new one. */
+		client.stop();
+		if (reused)
+			goto retry;
+		return NULL;
 	case PubNub_BH_ERROR:
 		/* Failure. */
 		client.stop();
-		while (client.connected()) ;
 		return NULL;
 	case PubNub_BH_TIMEOUT:
 		/* Time out. Try again. */
 		client.stop();
-		while (client.connected()) ;
 		goto retry;
 	}
+	return NULL;
+}
+
+/* Finish the first line of the request and add the headers. */
+void PubNub::_end_request(PString &request, char qparsep)
+{
+	request.print(qparsep);
+	request.print("pnsdk=PubNub-Arduino/1.0 HTTP/1.1\r\n");
+	/* Finish HTTP request; HTTP/1.1 keeps the connection open. */
+	request.print("Host: ");
+	request.print(origin);
+	request.print("\r\nUser-Agent: PubNub-Arduino/1.0\r\n\r\n");
 }
 
-enum PubNub_BH PubNub::_request_bh(PubNub_BASE_CLIENT &client, unsigned long t_start, int timeout, char qparsep)
+enum PubNub_BH PubNub::_request_bh(PubSubClient &client, PString &request, unsigned long t_start, int timeout)
 {
-	/* Finish the first line of the request. */
-	client.print(qparsep);
-	client.print("pnsdk=PubNub-Arduino/1.0 HTTP/1.1\r\n");
-	/* Finish HTTP request. */
-	client.print("Host: ");
-	client.print(origin);
-	client.print("\r\nUser-Agent: PubNub-Arduino/1.0\r\nConnection: close\r\n\r\n");
-
-#define WAIT() do { \
-	while (!client.available()) { \
-		/* wait, just check for timeout */ \
-		if (millis() - t_start > (unsigned long) timeout * 1000) { \
-			DBGprintln("Timeout in bottom half"); \
-			return PubNub_BH_TIMEOUT; \
-		} \
-		if (!client.connected()) { \
-			/* Oops, connection interrupted. */ \
-			DBGprintln("Connection reset in bottom half"); \
-			return PubNub_BH_ERROR; \
-		} \
-	} \
-} while (0)
-
-	/* Read first line with HTTP code. */
-	/* "HTTP/1.x " */
-	do {
-		WAIT();
-	} while (client.read() != ' ');
-	/* Now, first digit of HTTP code. */
-	WAIT();
-	char c = client.read();
-	if (c != '2') {
+	char connection[8];
+	HttpHeader headers[] = { HTTP_HEADER("connection", connection) };
+
+	/* What is left of the request, all of it unless it outgrew
+	 * the buffer, goes out in one write. */
+	request.spill();
+
+	/* Wait for the status line and headers, with whatever is left
+	 * of our timeout. The response parser takes the headers (and
+	 * the size line of a chunked body) straight out of the client's
+	 * receive buffer and stops at the first byte of the body.
+	 * Our minimalistic chunked support means that we hope for just
+	 * a single chunk, and do not keep such a connection. */
+	unsigned long t_elapsed = millis() - t_start;
+	if (t_elapsed >= (unsigned long) timeout * 1000) {
+		DBGprintln("Timeout in bottom half");
+		return PubNub_BH_TIMEOUT;
+	}
+	HttpResponse response(client);
+	response.begin(headers, 1);
+	int status = response.parseHeaders((unsigned long) timeout * 1000 - t_elapsed);
+	if (status == HTTP_RESPONSE_ERROR_TIMEOUT) {
+		DBGprintln("Timeout in bottom half");
+		return PubNub_BH_TIMEOUT;
+	}
+	if (status == HTTP_RESPONSE_ERROR_DISCONNECTED) {
+		/* Oops, connection interrupted. */
+		DBGprintln("Connection reset in bottom half");
+		return PubNub_BH_CLOSED;
+	}
+	if (status < 0) {
+		DBGprintln("Malformed reply in bottom half");
+		return PubNub_BH_ERROR;
+	}
+	if (status / 100 != 2) {
 		/* HTTP code that is NOT 2xx means trouble.
 		 * kthxbai */
-		DBGprint("Wrong HTTP status first digit ");
-		DBGprint((int) c, DEC);
+		DBGprint("Wrong HTTP status ");
+		DBGprint(status, DEC);
 		DBGprintln(" in bottom half");
 		return PubNub_BH_ERROR;
 	}
 
-	/* Now, we enter in a state machine that shall guide us through
-	 * the remaining headers to the beginning of the body. */
-	enum {
-		RS_SKIPLINE, /* Skip the rest of this line. */
-		RS_LOADLINE, /* Try loading the line in a buffer. */
-	} request_state = RS_SKIPLINE; /* Skip the rest of status line first. */
-	bool chunked = false;
-
-	while (client.connected() || client.available()) {
-		/* Let's hope there is no stray LF without CR. */
-		if (request_state == RS_SKIPLINE) {
-			do {
-				WAIT();
-			} while (client.read() != '\n');
-			request_state = RS_LOADLINE;
-
-		} else { /* request_state == RS_LOADLINE */
-			/* line[] must be enough to hold
-			 * Transfer-Encoding: chunked (or \r\n) */
-			const static char PROGMEM chunked_str[] = "Transfer-Encoding: chunked\r\n";
-			char line[sizeof(chunked_str)]; /* Not NUL-terminated! */
-			int linelen = 0;
-			char ch = 0;
-			do {
-				WAIT();
-				ch = client.read();
-				line[linelen++] = ch;
-				if (linelen == strlen_P(chunked_str)
-				    && !strncasecmp_P(line, chunked_str, linelen)) {
-					/* Chunked encoding header. */
-					chunked = true;
-					break;
-				}
-			} while (ch != '\n' && linelen < sizeof(line));
-			if (ch != '\n') {
-				/* We are not at the end of the line yet.
-				 * Skip the rest of the line. */
-				request_state = RS_SKIPLINE;
-			} else if (linelen == 2 && line[0] == '\r') {
-				/* Empty line. This means headers end. */
-				break;
-			}
-		}
-	}
+	/* Body begins now. */
+	client._begin_reply(response.chunked() ? -1 : response.contentLength(),
+			    strcasecmp(connection, "close") != 0);
+	return PubNub_BH_OK;
+}
+
 
-	if (chunked) {
-		/* There is one extra line due to Transfer-encoding: chunked.
-		 * Our minimalistic support means that we hope for just
-		 * a single chunk, just skip the first line after header. */
-		do {
-			WAIT();
-		} while (client.read() != '\n');
+void PubSubClient::_begin_reply(long length, bool keep)
+{
+	state = length == 0 ? PS_END : PS_BODY;
+	remaining = length;
+	keepalive = keep && length >= 0;
+	json_enabled = false;
+}
+
+/* Drop len bytes of the reply from the receive buffer. */
+void PubSubClient::_take(size_t len)
+{
+	PubNub_BASE_CLIENT::consume(len);
+	if (remaining > 0) {
+		remaining -= len;
+		if (remaining == 0 && state == PS_BODY)
+			state = PS_END;
 	}
+}
 
-	/* Body begins now. */
-	return PubNub_BH_OK;
+int PubSubClient::available()
+{
+	int len = PubNub_BASE_CLIENT::available();
+	if (state == PS_IDLE)
+		return len;
+	if (state == PS_END)
+		return 0;
+	if (remaining >= 0 && len > remaining)
+		len = remaining;
+	return len;
 }
 
+uint8_t PubSubClient::connected()
+{
+	if (state == PS_END)
+		return false;
+	return PubNub_BASE_CLIENT::connected();
+}
+
+int PubSubClient::peek()
+{
+	if (state == PS_IDLE)
+		return PubNub_BASE_CLIENT::peek();
+	if (!available())
+		return -1;
+	return PubNub_BASE_CLIENT::peek();
+}
 
 int PubSubClient::read()
 {
-	int c = PubNub_BASE_CLIENT::read();
-	if (!json_enabled || c == -1)
-		return c;
+	uint8_t c;
 
-	this->_state_input(c, NULL, 0);
-	return c;
+	if (state == PS_IDLE)
+		return PubNub_BASE_CLIENT::read();
+	return read(&c, 1) == 1 ? c : -1;
 }
 
 int PubSubClient::read(uint8_t *buf, size_t size)
 {
-	int len = PubNub_BASE_CLIENT::read(buf, size);
-	if (!json_enabled || len <= 0)
-		return len;
-	for (int i = 0; i < len; i++) {
-		this->_state_input(buf[i], &buf[i+1], len - i - 1);
-		if (!available() && !connected()) {
-			/* We have hit the end somewhere in this buffer.
-			 * From user perspective, only characters up to
-			 * index i are valid. */
-			return i + 1;
-		}
-	}
+	const uint8_t *data;
+	int len;
+
+	if (state == PS_IDLE)
+		return PubNub_BASE_CLIENT::read(buf, size);
+	if (state == PS_END)
+		return 0;
+
+	/* peekBuffer() is bounded by available(), so by the body */
+	len = PubNub_BASE_CLIENT::peekBuffer(&data);
+	if (len <= 0)
+		return 0;
+	if ((size_t) len > size)
+		len = size;
+	if (json_enabled)
+		len = this->_scan(data, len);
+	memcpy(buf, data, len);
+	this->_take(len);
 	return len;
 }
 
 bool PubSubClient::wait_for_data(int timeout)
 {
 	unsigned long t_start = millis();
-	while (connected() && !available()) {
+	while (!available()) {
+		if (state == PS_END || !connected())
+			return false;
 		if (millis() - t_start > (unsigned long) timeout * 1000)
 			return false; /* Time out. */
+		delay(1);
+	}
+	return true;
+}
+
+/* Like wait_for_data(), for reading past what the user sees. */
+bool PubSubClient::_wait_raw(unsigned long timeout)
+{
+	unsigned long t_start = millis();
+	while (PubNub_BASE_CLIENT::available() <= 0) {
+		if (!PubNub_BASE_CLIENT::connected())
+			return false;
+		if (millis() - t_start > timeout)
+			return false;
+		delay(1);
 	}
-	return available();
+	return true;
 }
 
 void PubSubClient::stop()
 {
-	if ((!available() && !connected()) || !json_enabled) {
+	if (state == PS_IDLE) {
 		PubNub_BASE_CLIENT::stop();
+		keepalive = false;
+		busy = false;
+		return;
+	}
+	this->_finish();
+}
+
+/* Read the rest of the reply, catching the timetoken, and close the
+ * connection unless it can carry the next request. */
+void PubSubClient::_finish()
+{
+	uint8_t skip[32];
+	bool body_read;
+
+	if (state == PS_IDLE) {
+		busy = false;
 		return;
 	}
-	/* We are still connected. Read the rest of the stream so that
-	 * we catch the timetoken. */
-	while (wait_for_data()) {
-		char ch = read();
-		this->_state_input(ch, NULL, 0);
+
+	/* Messages the user did not read. */
+	if (json_enabled) {
+		while (state == PS_BODY && wait_for_data(PubNub_TAIL_TIMEOUT / 1000))
+			read(skip, sizeof(skip));
 	}
+	body_read = state == PS_END;
+	state = PS_IDLE;
+
+	if (json_enabled && body_read)
+		this->_read_tail();
 	json_enabled = false;
+
+	/* Whatever else is left of the body. */
+	while (remaining > 0 && _wait_raw(PubNub_TAIL_TIMEOUT)) {
+		const uint8_t *data;
+		int len = PubNub_BASE_CLIENT::peekBuffer(&data);
+		if (len > remaining)
+			len = remaining;
+		this->_take(len);
+	}
+
+	if (!keepalive || remaining != 0) {
+		PubNub_BASE_CLIENT::stop();
+		keepalive = false;
+	}
+	busy = false;
 }
 
 void PubSubClient::start_body()
@@ -371,89 +506,121 @@ void PubSubClient::start_body()
 	json_enabled = true;
 	in_string = after_backslash = false;
 	braces_depth = 0;
+	channels[0] = 0;
 }
 
-void PubSubClient::_state_input(uint8_t ch, uint8_t *nextbuf, size_t nextsize)
+size_t PubSubClient::_scan(const uint8_t *buf, size_t len)
 {
-	/* Process a single character on input, updating the JSON
-	 * state machine. If we reached the last character of input
-	 * (just before expected ","), we will eat the rest of the body,
-	 * update timetoken and close the connection. */
-	if (in_string) {
-		if (after_backslash) {
-			/* Whatever this is... */
-			after_backslash = false;
-			return;
-		}
-		switch (ch) {
-		case '"':
+	/* Scan a span of the body, updating the JSON state machine.
+	 * Returns how many bytes of buf belong to the message array;
+	 * when its end is among them, the body the user sees ends
+	 * there and stop() reads the timetoken after it. */
+	const uint8_t *p = buf;
+	const uint8_t *end = buf + len;
+
+	while (p < end) {
+		if (in_string) {
+			if (after_backslash) {
+				/* Whatever this is... */
+				after_backslash = false;
+				p++;
+				continue;
+			}
+			/* Only a quote or a backslash matters in a string. */
+			while (p < end && *p != '"' && *p != '\\')
+				p++;
+			if (p == end)
+				break;
+			if (*p++ == '\\') {
+				after_backslash = true;
+				continue;
+			}
 			in_string = false;
 			if (braces_depth == 0)
 				goto body_end;
-			return;
-		case '\\':
-			after_backslash = true;
-			return;
-		default:
-			return;
+			continue;
 		}
 
-	} else {
-		switch (ch) {
+		/* Outside of strings, only quotes and braces matter. */
+		while (p < end && *p != '"' && *p != '[' && *p != ']'
+		       && *p != '{' && *p != '}')
+			p++;
+		if (p == end)
+			break;
+		switch (*p++) {
 		case '"':
 			in_string = true;
-			return;
+			break;
 		case '{':
 		case '[':
 			braces_depth++;
-			return;
-		case '}':
-		case ']':
+			break;
+		default:
 			braces_depth--;
 			if (braces_depth <= 0)
 				goto body_end;
-			return;
-		default:
-			return;
+			break;
 		}
 	}
+	return len;
 
-	return;
 body_end:
 	/* End of data here. */
-	this->_grab_timetoken(nextbuf, nextsize);
+	state = PS_END;
+	return p - buf;
 }
 
-void PubSubClient::_grab_timetoken(uint8_t *nextbuf, size_t nextsize)
+void PubSubClient::_read_tail()
 {
-	char new_timetoken[22];
-	size_t new_timetoken_len = 0;
+	char new_timetoken[sizeof(timetoken)];
+	size_t field_len = 0;
+	uint8_t field = 0;
+	bool in_field = false;
 
 	/* Expected followup now is:
 	 * 	,"13511688131075270"]
-	 */
-	/* Somewhat unwieldy macros that will first exhaust nextbuf[],
-	 * then read directly from socket. */
-#define WAIT() do { \
-	if (nextsize > 0) \
-		break; \
-	if (!wait_for_data()) { \
-		/* Oops, connection interrupted. */ \
-		return; \
-	} \
-} while (0)
-#define GETCHAR() (nextsize > 0 ? (nextsize--, *nextbuf++) : read())
-	do { WAIT(); } while (GETCHAR() != ',');
-	do { WAIT(); } while (GETCHAR() != '"');
-	do {
-		WAIT();
-		char ch = GETCHAR();
-		if (ch == '"')
-			break;
-		new_timetoken[new_timetoken_len++] = ch;
-		if (new_timetoken_len >= sizeof(new_timetoken) - 1)
-			break;
-	} while (1);
-	memcpy(timetoken, new_timetoken, new_timetoken_len);
-	timetoken[new_timetoken_len] = 0;
+	 * or, when several channels are subscribed:
+	 * 	,"13511688131075270","chan1,chan2,chan1"]
+	 * It is parsed straight out of the receive buffer. */
+	while (remaining != 0 && _wait_raw(PubNub_TAIL_TIMEOUT)) {
+		const uint8_t *data;
+		int len = PubNub_BASE_CLIENT::peekBuffer(&data);
+		if (remaining > 0 && len > remaining)
+			len = remaining;
+
+		for (int i = 0; i < len; i++) {
+			char ch = data[i];
+			if (!in_field) {
+				if (ch == '"') {
+					in_field = true;
+					field_len = 0;
+				} else if (ch == ']') {
+					this->_take(i + 1);
+					goto tail_end;
+				}
+				continue;
+			}
+			if (ch == '"') {
+				if (field == 0)
+					new_timetoken[field_len] = 0;
+				else if (field == 1)
+					channels[field_len] = 0;
+				field++;
+				in_field = false;
+			} else if (field == 0) {
+				if (field_len < sizeof(new_timetoken) - 1)
+					new_timetoken[field_len++] = ch;
+			} else if (field == 1) {
+				if (field_len < sizeof(channels) - 1)
+					channels[field_len++] = ch;
+			}
+		}
+		this->_take(len);
+	}
+
+tail_end:
+	if (field > 0)
+		strcpy(timetoken, new_timetoken);
+	if (field < 2)
+		channels[0] = 0;
 }
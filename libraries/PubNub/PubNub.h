@@ -25,6 +25,9 @@
 #error PubNub_BASE_CLIENT set to an invalid value!
 #endif
 
+#include <HttpResponse.h>
+#include <PString.h>
+
 
 /* Some notes:
  *
@@ -32,10 +35,10 @@
  * Arduino Uno or even Arduino Mega's computing power and memory limits.
  * All the traffic goes on the wire unencrypted and unsigned.
  *
- * (ii) We re-resolve the origin server IP address before each request.
- * This means some slow-down for intensive communication, but we rather
- * expect light traffic and very long-running sketches (days, months),
- * where refreshing the IP address is quite desirable.
+ * (ii) Requests go over a kept-alive connection; we re-resolve the
+ * origin server IP address only when it has to be reopened. With very
+ * long-running sketches (days, months) that still happens often enough
+ * to pick up address changes.
  *
  * (iii) We let the users read replies at their leisure instead of
  * returning an already preloaded string so that (a) they can do that
@@ -72,34 +75,66 @@
  * (viii) It is essential to use a new enough Arduino version so that
  * the WiFi library actually works properly. Most notably, version 1.0.5
  * has been confirmed to work while Arduino 1.0.4 is broken.
+ *
+ * (ix) When a connection cannot be opened, further calls fail at once
+ * instead of blocking until a retry delay has passed; the delay doubles
+ * from PubNub_RETRY_MIN up to PubNub_RETRY_MAX with every failure.
  */
 
 
+/* Size of the stack buffer a request is built in: one that fits goes
+ * out in one write, a longer one in writes of this size. */
+#define PubNub_REQUEST_MAX 256
+
+/* Longest channel list kept from a multi-channel subscribe reply. */
+#define PubNub_CHANNELS_SIZE 64
+
+/* Connection retry delays, in ms. */
+#define PubNub_RETRY_MIN 1000
+#define PubNub_RETRY_MAX 32000
+
+/* How long to wait for the rest of a reply the user did not read, in ms. */
+#define PubNub_TAIL_TIMEOUT 10000
+
+
 /* This class is a thin EthernetClient wrapper whose goal is to
  * automatically acquire time token information when reading
- * subscribe call response.
+ * subscribe call response, and to keep the connection open between
+ * requests.
  *
  * (i) The user application sees only the JSON body, not the timetoken.
- * As soon as the body ends, PubSubclient reads the rest of HTTP reply
- * itself and disconnects. The stored timetoken is used in the next call
- * to the PubSub::subscribe method then. */
+ * As soon as the body ends, available() and connected() report the end
+ * of the reply; stop() then reads the rest of it and keeps the connection
+ * for the next request unless the server closes it. The stored timetoken
+ * is used in the next call to the PubSub::subscribe method then.
+ *
+ * (ii) The JSON body is scanned a buffered span at a time, skipping
+ * over runs of characters that cannot end it. */
 class PubSubClient : public PubNub_BASE_CLIENT {
 public:
 	PubSubClient() :
-		PubNub_BASE_CLIENT(), json_enabled(false)
+		PubNub_BASE_CLIENT(), json_enabled(false), busy(false),
+		state(PS_IDLE), remaining(-1)
 	{
 		strcpy(timetoken, "0");
+		channels[0] = 0;
 	}
 
-	/* Customized functions that make reading stop as soon as we
-	 * have hit ',' outside of braces and string, which indicates
-	 * end of JSON body. */
+	/* Customized functions that make reading stop at the end of the
+	 * reply: after Content-Length bytes or, for subscribe, as soon as
+	 * we have hit the end of the message array. */
+	virtual int available();
 	virtual int read();
 	virtual int read(uint8_t *buf, size_t size);
+	virtual int peek();
+	virtual uint8_t connected();
+
+	/* Finish the reply, keeping the connection for the next request.
+	 * Outside of a reply, close the connection. */
 	virtual void stop();
 
 	/* Block until data is available. Returns false in case the
-	 * connection goes down or timeout expires. */
+	 * connection goes down, the reply ends or timeout expires. */
 	bool wait_for_data(int timeout = 310);
 
 	/* Enable the JSON state machine. */
@@ -107,18 +142,43 @@ public:
 
 	inline char *server_timetoken() { return timetoken; }
 
+	/* When several channels are subscribed, the channel of each
+	 * message of the last reply, comma separated and in order.
+	 * Empty if there was only one. */
+	inline char *server_channels() { return channels; }
+
 private:
-	void _state_input(uint8_t ch, uint8_t *nextbuf, size_t nextsize);
-	void _grab_timetoken(uint8_t *nextbuf, size_t nextsize);
+	friend class PubNub;
+
+	enum State {
+		PS_IDLE,	/* no reply, calls go to the connection */
+		PS_BODY,	/* reply body being read */
+		PS_END,		/* body read, the rest is left for stop() */
+	};
+
+	void _begin_reply(long length, bool keep);
+	void _finish();
+	size_t _scan(const uint8_t *buf, size_t len);
+	void _take(size_t len);
+	bool _wait_raw(unsigned long timeout);
+	void _read_tail();
 
 	/* JSON state machine context */
 	bool json_enabled:1;
 	bool in_string:1;
 	bool after_backslash:1;
+	bool keepalive:1;
 	int braces_depth;
 
+	/* A request is under way or its reply is being read. */
+	volatile bool busy;
+
+	enum State state;
+	long remaining;		/* body bytes left, -1 until the connection closes */
+
 	/* Time token acquired during the last subscribe request. */
 	char timetoken[22];
+	char channels[PubNub_CHANNELS_SIZE];
 };
 
 
@@ -126,6 +186,7 @@ enum PubNub_BH {
 	PubNub_BH_OK,
 	PubNub_BH_ERROR,
 	PubNub_BH_TIMEOUT,
+	PubNub_BH_CLOSED,
 };
 
 class PubNub {
@@ -138,6 +199,11 @@ public:
 	 * (If you are passing string literals, don't worry about it.)
 	 * Note that you should run only a single publish at once.
 	 *
+	 * Publish, history and subscribe share one kept-alive connection
+	 * while no subscribe reply is pending on it; a second connection
+	 * is opened for publish and history otherwise. A new request on
+	 * a connection finishes the reply still open on it.
+	 *
 	 * @param string publish_key required key to send messages.
 	 * @param string subscribe_key required key to receive messages.
 	 * @param string origin optional setting for cloud origin.
@@ -171,7 +237,9 @@ public:
 	 * the reply, just call client->stop(); immediately.
 	 *
 	 * It returns an object that is typically EthernetClient (but it
-	 * can be a WiFiClient if you enabled the WiFi shield).
+	 * can be a WiFiClient if you enabled the WiFi shield). The
+	 * connection stays open; connected() turns false at the end of
+	 * the reply.
 	 *
 	 * @param string channel required channel name.
 	 * @param string message required message string in JSON format.
@@ -193,7 +261,11 @@ public:
 	 * able to handle that. Note that the reply specifically does not
 	 * include the time token present in the raw reply.
 	 *
-	 * @param string channel required channel name.
+	 * Several channels are listened to at once by passing their names
+	 * separated by commas, e.g. "temp,humidity"; server_channels() of
+	 * the returned client then names the channel of each message.
+	 *
+	 * @param string channel required channel name or comma separated list.
 	 * @param string timeout optional timeout in seconds.
 	 * @return string Stream-ish object with reply message or NULL on error. */
 	PubSubClient *subscribe(const char *channel, int timeout = 310);
@@ -210,13 +282,20 @@ public:
 	PubNub_BASE_CLIENT *history(const char *channel, int limit = 10, int timeout = 310);
 
 private:
-	enum PubNub_BH _request_bh(PubNub_BASE_CLIENT &client, unsigned long t_start, int timeout, char qparsep);
+	void _end_request(PString &request, char qparsep);
+	enum PubNub_BH _request_bh(PubSubClient &client, PString &request, unsigned long t_start, int timeout);
+	bool _connect(PubSubClient &client);
+	PubSubClient &_claim_client();
 
 	const char *publish_key, *subscribe_key;
 	const char *origin;
 	const char *uuid;
 
-	PubNub_BASE_CLIENT publish_client, history_client;
+	/* No connection attempt before retry_at while retry_delay != 0. */
+	unsigned long retry_at;
+	unsigned long retry_delay;
+
+	PubSubClient publish_client;
 	PubSubClient subscribe_client;
 };
 
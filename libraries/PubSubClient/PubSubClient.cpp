@@ -8,10 +8,12 @@
 #include <string.h>
 
 PubSubClient::PubSubClient(Client& client) {
+   init();
    this->_client = &client;
 }
 
 PubSubClient::PubSubClient(uint8_t *ip, uint16_t port, void (*callback)(char*,uint8_t*,unsigned int), Client& client) {
+   init();
    this->_client = &client;
    this->callback = callback;
    this->ip = ip;
@@ -19,12 +21,38 @@ PubSubClient::PubSubClient(uint8_t *ip, uint16_t port, void (*callback)(char*,ui
 }
 
 PubSubClient::PubSubClient(char* domain, uint16_t port, void (*callback)(char*,uint8_t*,unsigned int), Client& client) {
+   init();
    this->_client = &client;
    this->callback = callback;
    this->domain = domain;
    this->port = port;
 }
 
+PubSubClient::~PubSubClient() {
+   releaseBuffer();
+}
+
+void PubSubClient::init() {
+   this->callback = NULL;
+   this->ip = NULL;
+   this->domain = NULL;
+   this->port = 0;
+   this->buffer = NULL;
+   this->bufferSize = 0;
+   this->maxPacketSize = MQTT_MAX_PACKET_SIZE;
+}
+
+void PubSubClient::setBufferSize(uint16_t size) {
+   // Takes effect on the next connect()
+   this->maxPacketSize = size;
+}
+
+void PubSubClient::releaseBuffer() {
+   NetBuffers.release(buffer);
+   buffer = NULL;
+   bufferSize = 0;
+}
+
 boolean PubSubClient::connect(char *id) {
    return connect(id,NULL,NULL,0,0,0,0);
 }
@@ -41,6 +69,14 @@ boolean PubSubClient::connect(char *id, char* willTopic, uint8_t willQos, uint8_
 boolean PubSubClient::connect(char *id, char *user, char *pass, char* willTopic, uint8_t willQos, uint8_t willRetain, char* willMessage) {
    if (!connected()) {
       int result = 0;
+
+      if (buffer == NULL) {
+         buffer = (uint8_t*)NetBuffers.acquire(maxPacketSize);
+         if (buffer == NULL) {
+            return false;
+         }
+         bufferSize = maxPacketSize;
+      }
       
       if (domain != NULL) {
         result = _client->connect(this->domain, this->port);
@@ -97,6 +133,7 @@ boolean PubSubClient::connect(char *id, char *user, char *pass, char* willTopic,
             unsigned long t = millis();
             if (t-lastInActivity > MQTT_KEEPALIVE*1000UL) {
                _client->stop();
+               releaseBuffer();
                return false;
             }
          }
@@ -109,6 +146,7 @@ boolean PubSubClient::connect(char *id, char *user, char *pass, char* willTopic,
          }
       }
       _client->stop();
+      releaseBuffer();
    }
    return false;
 }
@@ -135,7 +173,7 @@ uint16_t PubSubClient::readPacket() {
    
    for (uint16_t i = 0;i<length;i++)
    {
-      if (len < MQTT_MAX_PACKET_SIZE) {
+      if (len < bufferSize) {
          buffer[len++] = readByte();
       } else {
          readByte();
@@ -147,11 +185,12 @@ uint16_t PubSubClient::readPacket() {
 }
 
 boolean PubSubClient::poll() {
-   if (connected()) {
+   if (connected() && buffer != NULL) {
       unsigned long t = millis();
       if ((t - lastInActivity > MQTT_KEEPALIVE * 1000UL) || (t - lastOutActivity > MQTT_KEEPALIVE * 1000UL)) {
          if (pingOutstanding) {
             _client->stop();
+            releaseBuffer();
             return false;
          } else {
             buffer[0] = MQTTPINGREQ;
@@ -190,6 +229,8 @@ boolean PubSubClient::poll() {
       }
       return true;
    }
+   // The connection was lost, the buffer isn't needed until connect()
+   releaseBuffer();
    return false;
 }
 
@@ -202,9 +243,12 @@ boolean PubSubClient::publish(char* topic, uint8_t* payload, unsigned int plengt
 }
 
 boolean PubSubClient::publish(char* topic, uint8_t* payload, unsigned int plength, boolean retained) {
-   if (connected()) {
+   if (connected() && buffer != NULL) {
       // Leave room in the buffer for header and variable length field
       uint16_t length = 5;
+      if (length + 2 + strlen(topic) + plength > bufferSize) {
+         return false;
+      }
       length = writeString(topic,buffer,length);
       uint16_t i;
       for (i=0;i<plength;i++) {
@@ -229,11 +273,14 @@ boolean PubSubClient::publish_P(char* topic, uint8_t* payload, unsigned int plen
    uint8_t header;
    unsigned int len;
    
-   if (!connected()) {
+   if (!connected() || buffer == NULL) {
       return false;
    }
    
    tlen = strlen(topic);
+   if (5 + 2 + tlen > bufferSize) {
+      return false;
+   }
    
    header = MQTTPUBLISH;
    if (retained) {
@@ -292,9 +339,12 @@ boolean PubSubClient::write(uint8_t header, uint8_t* buf, uint16_t length) {
 
 
 boolean PubSubClient::subscribe(char* topic) {
-   if (connected()) {
+   if (connected() && buffer != NULL) {
       // Leave room in the buffer for header and variable length field
       uint16_t length = 7;
+      if (length + 2 + strlen(topic) + 1 > bufferSize) {
+         return false;
+      }
       nextMsgId++;
       if (nextMsgId == 0) {
          nextMsgId = 1;
@@ -309,10 +359,10 @@ boolean PubSubClient::subscribe(char* topic) {
 }
 
 void PubSubClient::disconnect() {
-   buffer[0] = MQTTDISCONNECT;
-   buffer[1] = 0;
-   _client->write(buffer,2);
+   uint8_t packet[2] = { MQTTDISCONNECT, 0 };
+   _client->write(packet,2);
    _client->stop();
+   releaseBuffer();
    lastInActivity = lastOutActivity = millis();
 }
 
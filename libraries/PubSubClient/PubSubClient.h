@@ -9,8 +9,9 @@
 
 #include <Arduino.h>
 #include "Client.h"
+#include <NetBuffers.h>
 
-// MQTT_MAX_PACKET_SIZE : Maximum packet size
+// MQTT_MAX_PACKET_SIZE : Maximum packet size, unless setBufferSize() is used
 #define MQTT_MAX_PACKET_SIZE 128
 
 // MQTT_KEEPALIVE : keepAlive interval in Seconds
@@ -40,7 +41,9 @@
 class PubSubClient {
 private:
    Client* _client;
-   uint8_t buffer[MQTT_MAX_PACKET_SIZE];
+   uint8_t* buffer;        // from the NetBuffers pool while connected
+   uint16_t bufferSize;
+   uint16_t maxPacketSize;
    uint16_t nextMsgId;
    unsigned long lastOutActivity;
    unsigned long lastInActivity;
@@ -53,10 +56,16 @@ private:
    uint8_t *ip;
    char* domain;
    uint16_t port;
+   void init();
+   void releaseBuffer();
 public:
    PubSubClient(Client& client);
    PubSubClient(uint8_t *, uint16_t, void(*)(char*,uint8_t*,unsigned int),Client& client);
    PubSubClient(char*, uint16_t, void(*)(char*,uint8_t*,unsigned int),Client& client);
+   ~PubSubClient();
+   // Largest packet sent or received; the buffer is taken from the
+   // NetBuffers pool on connect() and given back on disconnect()
+   void setBufferSize(uint16_t size);
    boolean connect(char *);
    boolean connect(char *, char *, char *);
    boolean connect(char *, char *, uint8_t, uint8_t, char *);
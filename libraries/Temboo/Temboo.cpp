@@ -20,6 +20,7 @@
  ###############################################################################
  */
 
+#include <stdlib.h>
 #include <string.h>
 #include <Client.h>
 #include <Temboo.h>
@@ -27,10 +28,8 @@
 #include "utility/TembooSession.h"
 
 static const char HTTP_CODE[] PROGMEM = "HTTP_CODE\x0A\x1F";
-static char HTTP_EOL[]  = "\r\n";
-static char HTTP_EOH[] = "\r\n\r\n";
 
-TembooChoreo::TembooChoreo(Client& client) : m_client(client) {
+TembooChoreo::TembooChoreo(Client& client) : m_client(client), m_response(client) {
     m_accountName = NULL;
     m_appKeyName = NULL;
     m_appKeyValue = NULL;
@@ -229,15 +228,27 @@ int TembooChoreo::run(IPAddress addr, uint16_t port, uint16_t timeoutSecs, bool
             delay(10);
         }
         
-        if (!m_client.findUntil("HTTP/1.", HTTP_EOL)) {
+        // Read the status line and headers in one pass, keeping the
+        // x-temboo-time header in case we need to resync the clock.
+        char tembooTime[16];
+        HttpHeader headers[] = {HTTP_HEADER("x-temboo-time", tembooTime)};
+        m_response.begin(headers, 1);
+        unsigned long elapsedSecs = session.getTime() - timeoutBeginSecs;
+        unsigned long timeoutMillis = 1;
+        if (elapsedSecs < timeoutSecs) {
+            timeoutMillis = (timeoutSecs - elapsedSecs) * 1000UL;
+        }
+        int code = m_response.parseHeaders(timeoutMillis);
+        if (code == HTTP_RESPONSE_ERROR_TIMEOUT) {
+            TEMBOO_TRACELN("Receive time out");
+            m_client.stop();
+            return TEMBOO_ERROR_STREAM_TIMEOUT;
+        }
+        if (code < 0) {
             TEMBOO_TRACELN("No HTTP");
             return TEMBOO_ERROR_HTTP_ERROR;
         }
-        //Don't care if the next byte is a '1' or a '0'
-        m_client.read();
-        
-        //Read the HTTP status code
-        httpCode = (uint16_t)m_client.parseInt();
+        httpCode = (uint16_t)code;
         
         // We expect HTTP response codes to be <= 599, but
         // we need to be prepared for anything.
@@ -249,8 +260,8 @@ int TembooChoreo::run(IPAddress addr, uint16_t port, uint16_t timeoutSecs, bool
         // if we get an auth error AND there was an x-temboo-time header,
         // update the session timeOffset
         if ((httpCode == 401) && (i == 0)) {
-            if (m_client.findUntil("x-temboo-time:", HTTP_EOH)) {
-                TembooSession::setTime((unsigned long)m_client.parseInt());
+            if (tembooTime[0] != '\0') {
+                TembooSession::setTime(strtoul(tembooTime, NULL, 10));
                 while(m_client.available()) {
                     m_client.read();
                 }
@@ -274,10 +285,6 @@ int TembooChoreo::run(IPAddress addr, uint16_t port, uint16_t timeoutSecs, bool
         return TEMBOO_ERROR_HTTP_ERROR;
     }
     
-    if (!m_client.find(HTTP_EOH)) {
-        return TEMBOO_ERROR_HTTP_ERROR;
-    }
-    
     return TEMBOO_ERROR_OK;
 }
 
@@ -289,11 +296,11 @@ int TembooChoreo::available() {
     // If we're still sending the HTTP response code,
     // report at least one character available.
     if (m_nextChar != NULL) {
-        return m_client.available() + 1;
+        return m_response.available() + 1;
     }
     
-    // Otherwise, return however many characters the client has.
-    return m_client.available();
+    // Otherwise, return however much of the body has arrived.
+    return m_response.available();
 }
 
 
@@ -304,8 +311,8 @@ int TembooChoreo::peek() {
         return (int)*m_nextChar;
     }
     
-    // Otherwise, return whatever is in the client buffer.
-    return m_client.peek();
+    // Otherwise, return whatever is next in the body.
+    return m_response.peek();
 }
 
 
@@ -336,12 +343,30 @@ int TembooChoreo::read() {
             break;
             
         default:
-            c = m_client.read();
+            c = m_response.read();
     }
     return c;
 }
 
 
+int TembooChoreo::read(uint8_t* buffer, size_t size) {
+    
+    // The HTTP response code goes out a character at a time,
+    // the body is copied out of the response in bulk.
+    size_t count = 0;
+    while (m_nextState != END && count < size) {
+        buffer[count++] = (uint8_t)read();
+    }
+    if (count < size) {
+        int len = m_response.read(buffer + count, size - count);
+        if (len > 0) {
+            count += len;
+        }
+    }
+    return count;
+}
+
+
 size_t TembooChoreo::write(uint8_t data) {
     return m_client.write(data);
 }
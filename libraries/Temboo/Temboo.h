@@ -27,6 +27,7 @@
 #include <Stream.h>
 #include <Client.h>
 #include <IPAddress.h>
+#include <HttpResponse.h>
 #include "utility/ChoreoInputSet.h"
 #include "utility/ChoreoOutputSet.h"
 #include "utility/ChoreoPreset.h"
@@ -126,6 +127,9 @@ class TembooChoreo : public Stream {
         int peek();
         void flush();
 
+        // reads up to size bytes of the choreo output in one go
+        int read(uint8_t* buffer, size_t size);
+
         //Print interface - see the Arduino library documentation
         size_t write(uint8_t data);
 
@@ -140,6 +144,7 @@ class TembooChoreo : public Stream {
         const char* m_appKeyName;
         const char* m_path;
         Client& m_client;
+        HttpResponse m_response;
         char m_httpCodeStr[6];
         const char* m_nextChar;
         enum State {START, HTTP_CODE_TAG, HTTP_CODE_VALUE, END};
@@ -44,12 +44,29 @@ static const char SDK_ID[]                 PROGMEM = "?source_id=TI_SDK1";
 
 unsigned long TembooSession::s_timeOffset = 0;
 
+// passes the request on to the client, echoing it when tracing
+class RequestSink : public Print {
+    public:
+        RequestSink(Client& client) : m_client(client) {}
+
+        virtual size_t write(uint8_t c) {
+            return write(&c, 1);
+        }
+
+        virtual size_t write(const uint8_t* buffer, size_t size) {
+            TEMBOO_TRACE_BYTES(buffer, size);
+            return m_client.write(buffer, size);
+        }
+
+    private:
+        Client& m_client;
+};
+
 TembooSession::TembooSession(Client& client, 
         IPAddress serverAddr, 
         uint16_t port) : m_client(client) {
     m_addr = serverAddr;
     m_port = port;
-    m_sendQueueDepth = 0;
 }
 
 
@@ -152,52 +169,65 @@ int TembooSession::executeChoreo(
     if (connected > 0) {
 
         TEMBOO_TRACELN("OK. req:");
-        qsendProgmem(POST);
-        qsendProgmem(BASE_CHOREO_URI);
-        qsend(path);
-        qsendProgmem(SDK_ID);
-        qsendlnProgmem(POSTAMBLE);
-        
-        // Send our custom authentication header
+
+        // The request is built in a stack buffer and handed to the
+        // client as it fills: in one write unless it is longer than
+        // TEMBOO_REQUEST_SIZE.
+        RequestSink sink(m_client);
+        char requestBuf[TEMBOO_REQUEST_SIZE];
+        PString request(requestBuf, sizeof(requestBuf));
+        request.spillTo(&sink);
+
+        printProgmem(request, POST);
+        printProgmem(request, BASE_CHOREO_URI);
+        request.print(path);
+        printProgmem(request, SDK_ID);
+        printProgmem(request, POSTAMBLE, true);
+    
+        // Add our custom authentication header
         // (app-key-name:hmac)
-        qsendProgmem(HEADER_AUTH);
-        qsend(appKeyName);
-        qsend(":");
-        qsendln(auth);
-        
-        // send the standard host header
-        qsendProgmem(HEADER_HOST);
-        qsendln(host);
-        
-        // send the standard accept header
-        qsendlnProgmem(HEADER_ACCEPT);
-        
-        // send our custom account name neader
-        qsendProgmem(HEADER_ORG);
-        qsend(accountName);
-        qsendlnProgmem(HEADER_DOM);
-        
-        // send the standard content type header
-        qsendlnProgmem(HEADER_CONTENT_TYPE);
-        
-        // send our custom client time header
-        qsendProgmem(HEADER_TIME);
-        qsendln(buffer);
-        
-        // send the standard content length header
-        qsendProgmem(HEADER_CONTENT_LENGTH);
-        qsendln(uint16toa(contentLength, buffer));
+        printProgmem(request, HEADER_AUTH);
+        request.print(appKeyName);
+        request.print(":");
+        request.print(auth);
+        printProgmem(request, EOL);
+    
+        // add the standard host header
+        printProgmem(request, HEADER_HOST);
+        request.print(host);
+        printProgmem(request, EOL);
+    
+        // add the standard accept header
+        printProgmem(request, HEADER_ACCEPT, true);
+    
+        // add our custom account name neader
+        printProgmem(request, HEADER_ORG);
+        request.print(accountName);
+        printProgmem(request, HEADER_DOM, true);
+    
+        // add the standard content type header
+        printProgmem(request, HEADER_CONTENT_TYPE, true);
+    
+        // add our custom client time header
+        printProgmem(request, HEADER_TIME);
+        request.print(buffer);
+        printProgmem(request, EOL);
+    
+        // add the standard content length header
+        printProgmem(request, HEADER_CONTENT_LENGTH);
+        request.print(uint16toa(contentLength, buffer));
+        printProgmem(request, EOL);
 
-        qsendProgmem(EOL);
-        
-        // Format and send the body of the request
+        printProgmem(request, EOL);
+    
+        // Format the body of the request
         fmt.reset();
         while(fmt.hasNext()) {
-            qsend(fmt.next());
+            request.print(fmt.next());
         }
 
-        qsendProgmem(EOL);
-        qflush();
+        printProgmem(request, EOL);
+        request.spill();
         return 0;
     } else {
         TEMBOO_TRACELN("FAIL");
@@ -244,48 +274,13 @@ uint16_t TembooSession::getAuth(DataFormatter& fmt, const char* appKeyValue, con
 }
 
 
-void TembooSession::qsend(const char* s) {
-    char c = *s++;
-    while(c != '\0') {
-        qsend(c);
-        c = *s++;
-    }
-}
-
-
-void TembooSession::qsendProgmem(const char* s) {
+void TembooSession::printProgmem(PString& request, const char* s, bool newline) {
     char c = pgm_read_byte(s++);
     while(c != '\0') {
-        qsend(c);
+        request.print(c);
         c = pgm_read_byte(s++);
     }
-}
-
-
-void TembooSession::qsend(char c) {
-    m_sendQueue[m_sendQueueDepth++] = c;
-    if (m_sendQueueDepth >= TEMBOO_SEND_QUEUE_SIZE) {
-        qflush();
+    if (newline) {
+        printProgmem(request, EOL);
     }
 }
-
-
-void TembooSession::qflush() {
-    m_client.write((const uint8_t*)m_sendQueue, m_sendQueueDepth);
-    TEMBOO_TRACE_BYTES(m_sendQueue, m_sendQueueDepth);
-    m_sendQueueDepth = 0;
-}
-
-
-void TembooSession::qsendln(const char* s) {
-    qsend(s);
-    qsendProgmem(EOL);
-}
-
-
-void TembooSession::qsendlnProgmem(const char* s) {
-    qsendProgmem(s);
-    qsendProgmem(EOL);
-}
-
-
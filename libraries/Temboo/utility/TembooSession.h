@@ -27,17 +27,16 @@
 #include <Arduino.h>
 #include <IPAddress.h>
 #include <Client.h>
+#include <PString.h>
 #include "TembooGlobal.h"
 
-#ifndef TEMBOO_SEND_QUEUE_SIZE
+#ifndef TEMBOO_REQUEST_SIZE
 
-// Some network interfaces (i.e. ethernet or WiFi shields) can only accept
-// a limited amount of data.  If you try to send more than the limit, the excess
-// is just lost.  However, sending one character at a time is very inefficient.
-// To deal with this situation, we queue up TEMBOO_SEND_QUEUE_SIZE bytes to send
-// to the network device at one time.  This is a compromise between RAM usage 
-// and performance.
-#define TEMBOO_SEND_QUEUE_SIZE (32)
+// The whole request, headers and formatted inputs, is built in a stack
+// buffer of TEMBOO_REQUEST_SIZE bytes, so the network processor sees one
+// send rather than one per 32 bytes. A request that does not fit goes out
+// in writes of that size.
+#define TEMBOO_REQUEST_SIZE (512)
 #endif
 
 
@@ -98,8 +97,6 @@ class TembooSession {
         uint16_t m_port;
         
         Client& m_client;
-        char m_sendQueue[TEMBOO_SEND_QUEUE_SIZE];
-        size_t m_sendQueueDepth;
         
         // calculate the authentication code value of the formatted request body
         // using the salted application key value as the key.  
@@ -107,28 +104,9 @@ class TembooSession {
         uint16_t getAuth(DataFormatter& fmt, const char* appKeyValue, const char* salt, char* hexAuth) const;
         
         
-        // queue an entire nul-terminated char array
-        // from RAM followed by a newline.
-        void qsendln(const char* str);
-        
-        // queue an entire nul-terminated char array
-        // from flash memory (PROGMEM) one byte at a time,
-        // followed by a newline.
-        void qsendlnProgmem(const char* str);
-        
-        // queue an entire nul-terminated char array
-        // from RAM one byte at a time.
-        void qsend(const char*);
-
-        // queue an entire nul-terminated char array 
-        // from flash memory (PROGMEM) one byte at a time.
-        void qsendProgmem(const char*);
-
-        // queue a single character to be sent when the queue is full.
-        void qsend(char);
-        
-        // send the current contents of the send queue to the client.
-        void qflush();
+        // append an entire nul-terminated char array from flash
+        // memory (PROGMEM), optionally followed by a newline.
+        void printProgmem(PString& request, const char* str, bool newline = false);
 
 };
 
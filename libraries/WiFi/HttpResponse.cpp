@@ -0,0 +1,561 @@
+/*
+ HttpResponse.cpp - Incremental HTTP/1.1 response parser for Energia and CC3200 launchpad
+
+ The parser is a byte-driven state machine, but it is fed whole spans
+ of the client's receive buffer: runs of bytes nobody is interested in
+ (reason phrase, unwanted headers, chunk extensions) are skipped with
+ memchr() and header names are matched against the whole table at once
+ while they stream by, so each byte of the response is looked at once.
+
+ This library is free software; you can redistribute it and/or
+ modify it under the terms of the GNU Lesser General Public
+ License as published by the Free Software Foundation; either
+ version 2.1 of the License, or (at your option) any later version.
+
+ This library is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ Lesser General Public License for more details.
+
+ You should have received a copy of the GNU Lesser General Public
+ License along with this library; if not, write to the Free Software
+ Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#include <ctype.h>
+#include <stdlib.h>
+#include <string.h>
+#include "HttpResponse.h"
+
+//
+//headers the parser always needs, ahead of the caller's table
+//
+#define BUILTIN_CONTENT_LENGTH    0
+#define BUILTIN_TRANSFER_ENCODING 1
+#define BUILTIN_COUNT             2
+
+static const HttpHeader builtinHeaders[BUILTIN_COUNT] = {
+    {"content-length", 14, NULL, 0},
+    {"transfer-encoding", 17, NULL, 0},
+};
+
+HttpResponse::HttpResponse(Client& client) : _client(client)
+{
+    begin();
+}
+
+void HttpResponse::begin(HttpHeader *headers, uint8_t count)
+{
+    if (count > HTTP_RESPONSE_MAX_HEADERS) {
+        count = HTTP_RESPONSE_MAX_HEADERS;
+    }
+    _headers = headers;
+    _headerCount = count;
+    for (uint8_t i = 0; i < count; i++) {
+        if (headers[i].valueSize > 0) {
+            headers[i].value[0] = '\0';
+        }
+    }
+
+    _state = ST_STATUS_VERSION;
+    _status = 0;
+    _contentLength = -1;
+    _chunked = false;
+    _remaining = -1;
+    _match = -1;
+    _held = false;
+}
+
+int HttpResponse::parseHeaders(unsigned long timeout)
+{
+    unsigned long start = millis();
+
+    //
+    //run the state machine over whatever the client has buffered until
+    //the first byte of the body (or the end of an empty body) is reached
+    //
+    while (_state < ST_BODY) {
+        const uint8_t *data;
+        int len = fill(&data);
+        if (len > 0) {
+            drop(parse(data, len));
+            continue;
+        }
+
+        if (!_client.connected()) {
+            return HTTP_RESPONSE_ERROR_DISCONNECTED;
+        }
+        if (timeout != HTTP_RESPONSE_WAIT_FOREVER && millis() - start >= timeout) {
+            return HTTP_RESPONSE_ERROR_TIMEOUT;
+        }
+        delay(1);
+    }
+
+    if (_state == ST_ERROR) {
+        return HTTP_RESPONSE_ERROR_MALFORMED;
+    }
+    return _status;
+}
+
+boolean HttpResponse::done()
+{
+    if (_state == ST_DONE) {
+        return true;
+    }
+
+    //
+    //a body without a length ends when the server closes the connection
+    //
+    return _state == ST_BODY && _remaining < 0 && !_client.connected();
+}
+
+size_t HttpResponse::write(uint8_t b)
+{
+    return _client.write(b);
+}
+
+size_t HttpResponse::write(const uint8_t *buffer, size_t size)
+{
+    return _client.write(buffer, size);
+}
+
+int HttpResponse::available()
+{
+    if (!framing()) {
+        return 0;
+    }
+
+    const uint8_t *data;
+    int len = _client.peekBuffer(&data);
+    if (len < 0) {
+        //
+        //the client keeps its buffer to itself
+        //
+        len = _client.available() + (_held ? 1 : 0);
+    }
+    if (_remaining >= 0 && len > _remaining) {
+        len = _remaining;
+    }
+    return len;
+}
+
+int HttpResponse::read()
+{
+    uint8_t b;
+    if (read(&b, 1) == 1) {
+        return b;
+    }
+    return -1;
+}
+
+int HttpResponse::read(uint8_t *buf, size_t size)
+{
+    size_t count = 0;
+
+    //
+    //copy body data straight out of the client, stopping at chunk
+    //boundaries to step over the framing in between
+    //
+    while (count < size && framing()) {
+        size_t len = size - count;
+        if (_remaining >= 0 && len > (size_t)_remaining) {
+            len = _remaining;
+        }
+
+        int got;
+        if (_held) {
+            buf[count] = _hold;
+            _held = false;
+            got = 1;
+        }
+        else {
+            got = _client.read(buf + count, len);
+        }
+        if (got <= 0) {
+            break;
+        }
+        count += got;
+        advance(got);
+    }
+    return count;
+}
+
+int HttpResponse::peek()
+{
+    const uint8_t *data;
+    if (peekBuffer(&data) <= 0) {
+        return -1;
+    }
+    return data[0];
+}
+
+int HttpResponse::peekBuffer(const uint8_t **buffer)
+{
+    if (!framing()) {
+        return 0;
+    }
+
+    int len = fill(buffer);
+    if (_remaining >= 0 && len > _remaining) {
+        len = _remaining;
+    }
+    return len;
+}
+
+void HttpResponse::consume(size_t size)
+{
+    if (size == 0 || _state != ST_BODY) {
+        return;
+    }
+    if (_remaining >= 0 && size > (size_t)_remaining) {
+        size = _remaining;
+    }
+    drop(size);
+    advance(size);
+}
+
+void HttpResponse::flush()
+{
+    //
+    //discard the part of the body that has already arrived
+    //
+    const uint8_t *data;
+    int len;
+    while ((len = peekBuffer(&data)) > 0) {
+        consume(len);
+    }
+}
+
+const HttpHeader *HttpResponse::entry(uint8_t index)
+{
+    if (index < BUILTIN_COUNT) {
+        return &builtinHeaders[index];
+    }
+    return &_headers[index - BUILTIN_COUNT];
+}
+
+//
+//Returns the bytes the client has buffered without taking them from it.
+//A client that does not expose its buffer is read one byte at a time,
+//holding on to that byte until it's dropped.
+//
+int HttpResponse::fill(const uint8_t **data)
+{
+    if (!_held) {
+        int len = _client.peekBuffer(data);
+        if (len >= 0) {
+            return len;
+        }
+
+        int c = _client.read();
+        if (c < 0) {
+            return 0;
+        }
+        _hold = c;
+        _held = true;
+    }
+    *data = &_hold;
+    return 1;
+}
+
+void HttpResponse::drop(size_t size)
+{
+    if (size == 0) {
+        return;
+    }
+    if (_held) {
+        _held = false;
+        return;
+    }
+    _client.consume(size);
+}
+
+//
+//Steps over chunk framing that has already arrived.
+//Returns true if body data is next.
+//
+boolean HttpResponse::framing()
+{
+    while (_state < ST_BODY) {
+        if (_state < ST_CHUNK_SIZE) {
+            //
+            //headers haven't been parsed, there is no body yet
+            //
+            return false;
+        }
+
+        const uint8_t *data;
+        int len = fill(&data);
+        if (len <= 0) {
+            return false;
+        }
+        drop(parse(data, len));
+    }
+    return _state == ST_BODY;
+}
+
+void HttpResponse::advance(size_t size)
+{
+    if (_remaining < 0) {
+        return;
+    }
+
+    _remaining -= size;
+    if (_remaining == 0) {
+        _state = _chunked ? ST_CHUNK_END : ST_DONE;
+    }
+}
+
+//
+//Runs the state machine over a span of the response and returns the number
+//of bytes consumed. Stops at the first byte of body data.
+//
+int HttpResponse::parse(const uint8_t *data, int len)
+{
+    int i = 0;
+
+    while (i < len && _state < ST_BODY) {
+        switch (_state) {
+            case ST_STATUS_REASON:
+            case ST_HEADER_SKIP:
+            case ST_CHUNK_EXT:
+            case ST_CHUNK_END: {
+                //
+                //nothing of interest before the end of the line
+                //
+                const uint8_t *eol = (const uint8_t *)memchr(&data[i], '\n', len - i);
+                if (eol == NULL) {
+                    return len;
+                }
+                i = eol - data;
+                break;
+            }
+            default:
+                break;
+        }
+
+        char c = data[i++];
+        switch (_state) {
+            case ST_STATUS_VERSION:
+                if (c == ' ') {
+                    _status = 0;
+                    _state = ST_STATUS_CODE;
+                }
+                break;
+
+            case ST_STATUS_CODE:
+                if (c >= '0' && c <= '9') {
+                    _status = _status * 10 + (c - '0');
+                }
+                else if (_status == 0) {
+                    _state = ST_ERROR;
+                }
+                else if (c == '\n') {
+                    _state = ST_HEADER_START;
+                }
+                else {
+                    _state = ST_STATUS_REASON;
+                }
+                break;
+
+            case ST_STATUS_REASON:
+            case ST_HEADER_SKIP:
+                _state = ST_HEADER_START;
+                break;
+
+            case ST_HEADER_START:
+                if (c == '\r') {
+                    _state = ST_HEADERS_END;
+                    break;
+                }
+                if (c == '\n') {
+                    endHeaders();
+                    break;
+                }
+                _candidates = 0xFFFFFFFF >> (32 - BUILTIN_COUNT - _headerCount);
+                _nameLen = 0;
+                _state = ST_HEADER_NAME;
+                //fall through
+
+            case ST_HEADER_NAME:
+                if (c == ':') {
+                    selectHeader();
+                }
+                else if (c == '\n') {
+                    _state = ST_HEADER_START;
+                }
+                else {
+                    matchName(c);
+                }
+                break;
+
+            case ST_HEADER_VALUE:
+                if (c == '\n') {
+                    endHeader();
+                    _state = ST_HEADER_START;
+                }
+                else if (c == '\r' || ((c == ' ' || c == '\t') && _valueLen == 0)) {
+                    //leading white space and line ends aren't part of the value
+                }
+                else if (_valueLen + 1 < _valueSize) {
+                    _value[_valueLen++] = c;
+                }
+                break;
+
+            case ST_HEADERS_END:
+                if (c == '\n') {
+                    endHeaders();
+                }
+                break;
+
+            case ST_CHUNK_SIZE:
+                if (isxdigit(c)) {
+                    _remaining = (_remaining << 4) + (isdigit(c) ? c - '0' : tolower(c) - 'a' + 10);
+                    break;
+                }
+                if (c == '\r') {
+                    break;
+                }
+                if (c != '\n') {
+                    _state = ST_CHUNK_EXT;
+                    break;
+                }
+                //fall through
+
+            case ST_CHUNK_EXT:
+                //
+                //a zero sized chunk ends the body, only the trailer follows
+                //
+                if (_remaining == 0) {
+                    _nameLen = 0;
+                    _state = ST_TRAILER;
+                }
+                else {
+                    _state = ST_BODY;
+                }
+                break;
+
+            case ST_CHUNK_END:
+                _remaining = 0;
+                _state = ST_CHUNK_SIZE;
+                break;
+
+            case ST_TRAILER:
+                if (c == '\n') {
+                    if (_nameLen == 0) {
+                        _state = ST_DONE;
+                    }
+                    _nameLen = 0;
+                }
+                else if (c != '\r') {
+                    _nameLen = 1;
+                }
+                break;
+
+            default:
+                break;
+        }
+    }
+    return i;
+}
+
+//
+//Drops the table entries that don't match the next character of the name
+//
+void HttpResponse::matchName(char c)
+{
+    c = tolower(c);
+
+    uint32_t candidates = _candidates;
+    for (uint8_t i = 0; candidates != 0; i++, candidates >>= 1) {
+        if (candidates & 1) {
+            const HttpHeader *header = entry(i);
+            if (_nameLen >= header->nameLen || header->name[_nameLen] != c) {
+                _candidates &= ~(1UL << i);
+            }
+        }
+    }
+
+    if (_candidates == 0) {
+        //
+        //not a header we are looking for, skip the rest of the line
+        //
+        _state = ST_HEADER_SKIP;
+        return;
+    }
+    _nameLen++;
+}
+
+void HttpResponse::selectHeader()
+{
+    uint32_t candidates = _candidates;
+    for (uint8_t i = 0; candidates != 0; i++, candidates >>= 1) {
+        if ((candidates & 1) && entry(i)->nameLen == _nameLen) {
+            _match = i;
+            if (i < BUILTIN_COUNT) {
+                _value = _scratch;
+                _valueSize = sizeof(_scratch);
+            }
+            else {
+                _value = entry(i)->value;
+                _valueSize = entry(i)->valueSize;
+            }
+            _valueLen = 0;
+            _state = ST_HEADER_VALUE;
+            return;
+        }
+    }
+    _state = ST_HEADER_SKIP;
+}
+
+void HttpResponse::endHeader()
+{
+    if (_valueSize == 0) {
+        _match = -1;
+        return;
+    }
+
+    while (_valueLen > 0 && (_value[_valueLen - 1] == ' ' || _value[_valueLen - 1] == '\t')) {
+        _valueLen--;
+    }
+    _value[_valueLen] = '\0';
+
+    if (_match == BUILTIN_CONTENT_LENGTH) {
+        _contentLength = strtol(_value, NULL, 10);
+    }
+    else if (_match == BUILTIN_TRANSFER_ENCODING) {
+        //
+        //chunked is always the last transfer coding applied
+        //
+        _chunked = _valueLen >= 7 && strcasecmp(&_value[_valueLen - 7], "chunked") == 0;
+    }
+    _match = -1;
+}
+
+void HttpResponse::endHeaders()
+{
+    if (_status / 100 == 1) {
+        //
+        //interim response (e.g. 100 Continue), the real one follows
+        //
+        _contentLength = -1;
+        _chunked = false;
+        _state = ST_STATUS_VERSION;
+    }
+    else if (_status == 204 || _status == 304) {
+        _remaining = 0;
+        _state = ST_DONE;
+    }
+    else if (_chunked) {
+        _remaining = 0;
+        _state = ST_CHUNK_SIZE;
+    }
+    else if (_contentLength == 0) {
+        _remaining = 0;
+        _state = ST_DONE;
+    }
+    else {
+        _remaining = _contentLength;
+        _state = ST_BODY;
+    }
+}
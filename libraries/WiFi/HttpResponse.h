@@ -0,0 +1,160 @@
+/*
+ HttpResponse.h - Incremental HTTP/1.1 response parser for Energia and CC3200 launchpad
+
+ This library is free software; you can redistribute it and/or
+ modify it under the terms of the GNU Lesser General Public
+ License as published by the Free Software Foundation; either
+ version 2.1 of the License, or (at your option) any later version.
+
+ This library is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ Lesser General Public License for more details.
+
+ You should have received a copy of the GNU Lesser General Public
+ License along with this library; if not, write to the Free Software
+ Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#ifndef httpresponse_h
+#define httpresponse_h
+#include <ti/runtime/wiring/Arduino.h>
+#include <ti/runtime/wiring/Stream.h>
+#include <ti/runtime/wiring/Client.h>
+
+#define HTTP_RESPONSE_ERROR_TIMEOUT      -1
+#define HTTP_RESPONSE_ERROR_DISCONNECTED -2
+#define HTTP_RESPONSE_ERROR_MALFORMED    -3
+
+//
+//parseHeaders() timeout that waits until the peer closes the connection
+//
+#define HTTP_RESPONSE_WAIT_FOREVER 0
+
+//
+//at most this many caller headers can be matched per response
+//
+#define HTTP_RESPONSE_MAX_HEADERS 30
+
+//
+//An entry of the header-name table handed to HttpResponse::begin().
+//The name must be lower case and is matched without regard to case.
+//The value of the header is copied (NUL terminated, truncated to
+//valueSize - 1 characters) into value, which is emptied by begin().
+//
+typedef struct {
+    const char *name;
+    uint8_t nameLen;
+    char *value;
+    uint8_t valueSize;
+} HttpHeader;
+
+//
+//builds an HttpHeader entry from a string literal and a char array
+//
+#define HTTP_HEADER(name, value) { name, sizeof(name) - 1, value, sizeof(value) }
+
+//
+//Parses an HTTP response as it arrives on a Client in a single pass:
+//status line, the headers listed in the table, Content-Length and
+//chunked Transfer-Encoding. Afterwards the (de-chunked) body is read
+//through the Stream interface or in bulk with read(buf, size).
+//
+//Clients that expose their receive buffer through Stream::peekBuffer()
+//are parsed in place, so nothing past the end of the headers is taken
+//from the client; other clients are read one byte at a time.
+//
+class HttpResponse : public Stream {
+
+public:
+    HttpResponse(Client& client);
+
+    /*
+     * Reset the parser for a new response on the client
+     *
+     * param headers: table of headers whose values should be captured
+     * param count: number of entries in headers
+     */
+    void begin(HttpHeader *headers = NULL, uint8_t count = 0);
+
+    /*
+     * Read the status line and headers, up to the first body byte
+     *
+     * param timeout: milliseconds to wait for the headers to arrive
+     *
+     * return: the HTTP status code or one of HTTP_RESPONSE_ERROR_*
+     */
+    int parseHeaders(unsigned long timeout = HTTP_RESPONSE_WAIT_FOREVER);
+
+    int status() { return _status; }
+    long contentLength() { return _contentLength; }
+    boolean chunked() { return _chunked; }
+
+    /*
+     * true once the whole body has been read
+     */
+    boolean done();
+
+    virtual size_t write(uint8_t);
+    virtual size_t write(const uint8_t *buffer, size_t size);
+    virtual int available();
+    virtual int read();
+    virtual int read(uint8_t *buf, size_t size);
+    virtual int peek();
+    virtual int peekBuffer(const uint8_t **buffer);
+    virtual void consume(size_t size);
+    virtual void flush();
+
+private:
+    enum State {
+        ST_STATUS_VERSION,
+        ST_STATUS_CODE,
+        ST_STATUS_REASON,
+        ST_HEADER_START,
+        ST_HEADER_NAME,
+        ST_HEADER_VALUE,
+        ST_HEADER_SKIP,
+        ST_HEADERS_END,
+        ST_CHUNK_SIZE,
+        ST_CHUNK_EXT,
+        ST_CHUNK_END,
+        ST_TRAILER,
+        ST_BODY,
+        ST_DONE,
+        ST_ERROR
+    };
+
+    const HttpHeader *entry(uint8_t index);
+    int fill(const uint8_t **data);
+    void drop(size_t size);
+    int parse(const uint8_t *data, int len);
+    boolean framing();
+    void advance(size_t size);
+    void matchName(char c);
+    void selectHeader();
+    void endHeader();
+    void endHeaders();
+
+    Client& _client;
+    HttpHeader *_headers;
+    uint8_t _headerCount;
+
+    State _state;
+    int _status;
+    long _contentLength;
+    boolean _chunked;
+    long _remaining;            // bytes left in this chunk or body, -1 if unknown
+
+    uint32_t _candidates;       // header table entries still matching the name
+    uint8_t _nameLen;
+    int8_t _match;              // header table entry whose value is being read
+    char *_value;
+    uint8_t _valueLen;
+    uint8_t _valueSize;
+    char _scratch[16];          // value of a built-in header
+
+    boolean _held;              // _hold contains a byte read from the client
+    uint8_t _hold;
+};
+
+#endif
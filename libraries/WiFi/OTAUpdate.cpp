@@ -0,0 +1,319 @@
+/*
+ OTAUpdate.cpp - Firmware image download into the serial flash for Energia and CC3200 launchpad
+
+ This library is free software; you can redistribute it and/or
+ modify it under the terms of the GNU Lesser General Public
+ License as published by the Free Software Foundation; either
+ version 2.1 of the License, or (at your option) any later version.
+
+ This library is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ Lesser General Public License for more details.
+
+ You should have received a copy of the GNU Lesser General Public
+ License along with this library; if not, write to the Free Software
+ Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <PString.h>
+#include "WiFi.h"
+#include "OTAUpdate.h"
+
+#include "inc/hw_memmap.h"
+#include "inc/hw_types.h"
+#include "inc/hw_shamd5.h"
+#include "driverlib/rom_map.h"
+#include "driverlib/prcm.h"
+#include "driverlib/shamd5.h"
+
+#define SHA256_SIZE     32
+#define HASH_BLOCK_SIZE 64
+
+//
+//converts 64 hex digits into the 32 byte digest
+//
+static boolean parseDigest(const char *hex, uint8_t *digest)
+{
+    if (hex == NULL || strlen(hex) != 2 * SHA256_SIZE) {
+        return false;
+    }
+
+    for (int i = 0; i < 2 * SHA256_SIZE; i++) {
+        char c = hex[i];
+        uint8_t nibble;
+        if (c >= '0' && c <= '9') {
+            nibble = c - '0';
+        } else if (c >= 'a' && c <= 'f') {
+            nibble = c - 'a' + 10;
+        } else if (c >= 'A' && c <= 'F') {
+            nibble = c - 'A' + 10;
+        } else {
+            return false;
+        }
+        if (i & 1) {
+            digest[i / 2] |= nibble;
+        } else {
+            digest[i / 2] = nibble << 4;
+        }
+    }
+    return true;
+}
+
+OTAUpdate::OTAUpdate(WiFiClient& client, SLFS& file) :
+    _client(client), _file(file), _response(client)
+{
+    _timeout = OTA_DEFAULT_TIMEOUT;
+    _retries = OTA_DEFAULT_RETRIES;
+    _status = 0;
+    _size = -1;
+    _received = 0;
+    _fill = 0;
+    _headers[0].name = "content-range";
+    _headers[0].nameLen = sizeof("content-range") - 1;
+    _headers[0].value = _range;
+    _headers[0].valueSize = sizeof(_range);
+}
+
+int OTAUpdate::update(const char *host, uint16_t port, const char *path,
+                      const char *filename, const char *sha256, boolean ssl)
+{
+    uint8_t expected[SHA256_SIZE];
+    uint8_t digest[SHA256_SIZE];
+    uint8_t attempt = 0;
+    boolean open = false;
+    int rc;
+
+    if (host == NULL || path == NULL || filename == NULL || !parseDigest(sha256, expected)) {
+        return OTA_ERROR_ARGUMENT;
+    }
+
+    _status = 0;
+    _size = -1;
+    _received = 0;
+    _fill = 0;
+
+    while (true) {
+        long progress = _received;
+
+        rc = request(host, port, path, ssl);
+        if (rc == 200) {
+            //
+            //the whole image: also what a server that ignores Range sends
+            //back, in which case the download starts over
+            //
+            _status = rc;
+            long length = _response.contentLength();
+            if (length <= 0 || (_size >= 0 && length != _size)) {
+                rc = OTA_ERROR_SIZE;
+                break;
+            }
+            _size = length;
+            _received = 0;
+            _fill = 0;
+            progress = 0;
+            if (!open) {
+                rc = openImage(filename);
+                if (rc != OTA_OK) {
+                    break;
+                }
+                open = true;
+            } else {
+                _file.seek(0);
+            }
+            hashBegin();
+            rc = transfer();
+        } else if (rc == 206 && _size >= 0) {
+            //
+            //the rest of the image, which must start where we stopped
+            //
+            _status = rc;
+            if (strncmp(_range, "bytes ", 6) != 0 || strtol(_range + 6, NULL, 10) != _received) {
+                rc = OTA_ERROR_HTTP;
+                break;
+            }
+            rc = transfer();
+        } else if (rc >= 0) {
+            _status = rc;
+            rc = OTA_ERROR_HTTP;
+            break;
+        } else {
+            rc = open ? OTA_ERROR_INCOMPLETE : OTA_ERROR_CONNECT;
+        }
+
+        if (rc == OTA_OK || rc == OTA_ERROR_FILE) {
+            break;
+        }
+        if (_received > progress) {
+            attempt = 0;
+        }
+        if (++attempt > _retries) {
+            break;
+        }
+        delay(500 * attempt);
+    }
+    _client.stop();
+
+    if (rc == OTA_OK) {
+        hashEnd(digest);
+        if (memcmp(digest, expected, SHA256_SIZE) != 0) {
+            rc = OTA_ERROR_DIGEST;
+        }
+    }
+
+    if (open) {
+        if (rc == OTA_OK) {
+            if (_file.close() != SL_FS_OK) {
+                rc = OTA_ERROR_FILE;
+            }
+        } else {
+            _file.abort();
+        }
+    }
+    return rc;
+}
+
+//
+//connects, sends the GET (with a Range once part of the image is here)
+//and parses the response headers
+//
+int OTAUpdate::request(const char *host, uint16_t port, const char *path, boolean ssl)
+{
+    int connected;
+
+    _client.stop();
+    if (ssl) {
+        connected = _client.sslConnect(host, port);
+    } else {
+        connected = _client.connect(host, port);
+    }
+    if (!connected) {
+        return HTTP_RESPONSE_ERROR_DISCONNECTED;
+    }
+
+    //
+    //_block is empty between transfers, so the request is built there
+    //and sent in one piece
+    //
+    PString request((char *)_block, sizeof(_block));
+    request.print("GET ");
+    request.print(path);
+    request.print(" HTTP/1.1\r\nHost: ");
+    request.print(host);
+    request.print("\r\n");
+    if (_received > 0) {
+        request.print("Range: bytes=");
+        request.print(_received);
+        request.print("-\r\n");
+    }
+    request.print("Connection: close\r\n\r\n");
+    if (request.length() + 1 >= request.capacity()) {
+        return HTTP_RESPONSE_ERROR_MALFORMED;
+    }
+
+    _client.write((const uint8_t *)_block, request.length());
+    _response.begin(_headers, 1);
+    return _response.parseHeaders(_timeout);
+}
+
+int OTAUpdate::openImage(const char *filename)
+{
+    SlFsFileInfo_t info;
+    int32_t mode;
+
+    if (sl_FsGetInfo((const _u8 *)filename, 0, &info) == SL_FS_OK) {
+        if ((long)info.AllocatedLen < _size) {
+            return OTA_ERROR_SIZE;
+        }
+        mode = FS_MODE_OPEN_WRITE;
+    } else {
+        mode = FS_MODE_OPEN_CREATE(_size, _FS_FILE_OPEN_FLAG_COMMIT);
+    }
+
+    if (_file.open(filename, mode) != SL_FS_OK) {
+        return OTA_ERROR_FILE;
+    }
+    return OTA_OK;
+}
+
+//
+//reads the body into _block, writing and hashing each full block
+//
+int OTAUpdate::transfer()
+{
+    unsigned long last = millis();
+
+    while (_received < _size) {
+        size_t room = sizeof(_block) - _fill;
+        if ((long)room > _size - _received) {
+            room = _size - _received;
+        }
+
+        int len = _response.read((uint8_t *)_block + _fill, room);
+        if (len > 0) {
+            _fill += len;
+            _received += len;
+            last = millis();
+            if (_fill == sizeof(_block) || _received == _size) {
+                if (!writeBlock(_fill)) {
+                    return OTA_ERROR_FILE;
+                }
+                _fill = 0;
+            }
+            continue;
+        }
+
+        if (_response.done() || (!_client.connected() && !_client.available())
+            || millis() - last >= _timeout) {
+            //
+            //bytes short of a whole block are fetched again, so the
+            //hash engine only ever sees whole blocks before the last
+            //
+            _received -= _fill;
+            _fill = 0;
+            return OTA_ERROR_INCOMPLETE;
+        }
+        delay(1);
+    }
+    return OTA_OK;
+}
+
+boolean OTAUpdate::writeBlock(size_t len)
+{
+    uint8_t *data = (uint8_t *)_block;
+
+    if (_file.write(data, len) != len) {
+        return false;
+    }
+
+    //
+    //the engine only hashes the length set in hashBegin(), so the last,
+    //short block can be padded out to a whole one
+    //
+    size_t padded = (len + HASH_BLOCK_SIZE - 1) & ~(HASH_BLOCK_SIZE - 1);
+    memset(data + len, 0, padded - len);
+    for (size_t i = 0; i < padded; i += HASH_BLOCK_SIZE) {
+        MAP_SHAMD5DataWrite(SHAMD5_BASE, data + i);
+    }
+    return true;
+}
+
+void OTAUpdate::hashBegin()
+{
+    MAP_PRCMPeripheralClkEnable(PRCM_DTHE, PRCM_RUN_MODE_CLK);
+    MAP_PRCMPeripheralReset(PRCM_DTHE);
+    MAP_SHAMD5ConfigSet(SHAMD5_BASE, SHAMD5_ALGO_SHA256);
+
+    while ((HWREG(SHAMD5_BASE + SHAMD5_O_IRQSTATUS) & SHAMD5_INT_CONTEXT_READY) == 0) {
+    }
+    MAP_SHAMD5DataLengthSet(SHAMD5_BASE, _size);
+}
+
+void OTAUpdate::hashEnd(uint8_t *digest)
+{
+    while ((HWREG(SHAMD5_BASE + SHAMD5_O_IRQSTATUS) & SHAMD5_INT_OUTPUT_READY) == 0) {
+    }
+    MAP_SHAMD5ResultRead(SHAMD5_BASE, digest);
+}
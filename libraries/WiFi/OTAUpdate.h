@@ -0,0 +1,107 @@
+/*
+ OTAUpdate.h - Firmware image download into the serial flash for Energia and CC3200 launchpad
+
+ This library is free software; you can redistribute it and/or
+ modify it under the terms of the GNU Lesser General Public
+ License as published by the Free Software Foundation; either
+ version 2.1 of the License, or (at your option) any later version.
+
+ This library is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ Lesser General Public License for more details.
+
+ You should have received a copy of the GNU Lesser General Public
+ License along with this library; if not, write to the Free Software
+ Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#ifndef otaupdate_h
+#define otaupdate_h
+#include <ti/runtime/wiring/Arduino.h>
+#include "WiFiClient.h"
+#include "HttpResponse.h"
+#include "SLFS.h"
+
+#define OTA_OK                  0
+#define OTA_ERROR_ARGUMENT     -1   // bad digest string or path
+#define OTA_ERROR_CONNECT      -2   // no connection after all retries
+#define OTA_ERROR_HTTP         -3   // status other than 200 or 206, see httpStatus()
+#define OTA_ERROR_SIZE         -4   // no Content-Length, or the image does not fit the file
+#define OTA_ERROR_FILE         -5   // the image file could not be opened or written
+#define OTA_ERROR_INCOMPLETE   -6   // the transfer broke off after all retries
+#define OTA_ERROR_DIGEST       -7   // the image does not match the expected SHA-256
+
+//
+//bytes collected before each write to the serial flash; a multiple of
+//the 64 byte hash block
+//
+#define OTA_BLOCK_SIZE 1024
+
+#define OTA_DEFAULT_TIMEOUT 10000
+#define OTA_DEFAULT_RETRIES 3
+
+//
+//Downloads an image over HTTP(S) into a file of the SimpleLink file
+//system. The image is written in OTA_BLOCK_SIZE blocks and hashed by the
+//SHA/MD5 engine as it arrives. A connection that breaks off is resumed
+//with a Range request where the last one stopped.
+//
+//If the file does not exist yet it is created fail-safe with the size
+//given by Content-Length, so the previous image survives until the new
+//one has been verified: a complete, matching image is committed by
+//closing the file, anything else is discarded with SLFS::abort().
+//Existing files are only fail-safe if they were created with
+//_FS_FILE_OPEN_FLAG_COMMIT.
+//
+//The hash engine is owned by update() until it returns.
+//
+class OTAUpdate {
+
+public:
+    OTAUpdate(WiFiClient& client, SLFS& file = SerFlash);
+
+    void setTimeout(unsigned long timeout) { _timeout = timeout; }
+    void setRetries(uint8_t retries) { _retries = retries; }
+
+    /*
+     * Download an image and replace the file with it
+     *
+     * param host, port, path: where the image is served
+     * param filename: SimpleLink file receiving the image
+     * param sha256: expected digest of the image, 64 hex digits
+     * param ssl: connect with sslConnect()
+     *
+     * return: OTA_OK or one of OTA_ERROR_*
+     */
+    int update(const char *host, uint16_t port, const char *path,
+               const char *filename, const char *sha256, boolean ssl = false);
+
+    long size() { return _size; }
+    long received() { return _received; }
+    int httpStatus() { return _status; }
+
+private:
+    int request(const char *host, uint16_t port, const char *path, boolean ssl);
+    int openImage(const char *filename);
+    int transfer();
+    boolean writeBlock(size_t len);
+    void hashBegin();
+    void hashEnd(uint8_t *digest);
+
+    WiFiClient& _client;
+    SLFS& _file;
+    HttpResponse _response;
+    HttpHeader _headers[1];
+    unsigned long _timeout;
+    uint8_t _retries;
+
+    int _status;
+    long _size;                 // image size, -1 until the first response
+    long _received;             // bytes of the image received so far
+    size_t _fill;               // bytes in _block not yet written and hashed
+    char _range[48];            // Content-Range of a resumed request
+    uint32_t _block[OTA_BLOCK_SIZE / 4]; // word aligned for the hash engine
+};
+
+#endif
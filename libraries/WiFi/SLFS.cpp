@@ -113,6 +113,22 @@ int32_t SLFS::close(void)
     return retval;
 }
 
+int32_t SLFS::abort(void)
+{
+    if (!filehandle) {
+        retval = SLFS_LIB_ERR_FILE_NOT_OPEN;
+        return retval;
+    }
+
+    offset = 0;
+    filesize = 0;
+    retval = sl_FsClose(filehandle, NULL, (const _u8 *)"A", 1);
+    filehandle = 0;
+    is_write = false;
+
+    return retval;
+}
+
 int32_t SLFS::seek(int32_t pos)
 {
     retval = SL_FS_OK;
@@ -225,6 +241,13 @@ size_t SLFS::readBytes(void *buffer, size_t len)
     return retval;
 }
 
+int SLFS::read(uint8_t *buf, size_t size)
+{
+    if (filehandle && !is_write && size > (size_t)(filesize - offset))
+        size = filesize - offset;
+    return (int)readBytes(buf, size);
+}
+
 String SLFS::readBytes(size_t maxlen)
 {
     char *sh = NULL;
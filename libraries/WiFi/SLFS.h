@@ -97,6 +97,13 @@ class SLFS : public Stream {
         /// @returns SL_FS_OK if successful, negative number if error
         int32_t close(void);
 
+        ///
+        /// @brief Abort file
+        /// @details Close a file opened for write, discarding what was written since it was opened.  Only files created
+        ///          with the _FS_FILE_OPEN_FLAG_COMMIT option keep their previous contents; see @ref open_opts.
+        /// @returns SL_FS_OK if successful, negative number if error
+        int32_t abort(void);
+
         ///
         /// @brief Delete file
         /// @details Delete a file by filename.
@@ -226,6 +233,14 @@ class SLFS : public Stream {
         size_t readBytes(void *buf, size_t maxlen);
         String readBytes(size_t maxlen = 1024);
 
+        ///
+        /// @brief Read a block
+        /// @details Stream bulk-read variant of readBytes(), used by pump() to move whole blocks out of a file.
+        /// @param buf Buffer for receiving data.  This buffer must be able to take up to @c size bytes.
+        /// @param size Maximum number of bytes to read
+        /// @returns Number of bytes actually read, or 0 if we're at the end-of-file or an error occurred.
+        virtual int read(uint8_t *buf, size_t size);
+
         ///
         /// @brief Free String object
         /// @details When using the readBytes() variant which returns a String, a String object is allocated which may be ignored
@@ -34,7 +34,10 @@
 
 #include <ti/runtime/wiring/Energia.h>
 #include <xdc/runtime/System.h>
+#include <xdc/runtime/Error.h>
 #include "WiFi.h"
+#include <ti/runtime/wiring/SysTime.h>
+#include <ti/runtime/wiring/TokenLog.h>
 
 extern "C" {
     #include <string.h>
@@ -62,7 +65,7 @@ extern "C" {
 //
 volatile wl_status_t WiFiClass::WiFi_status = WL_DISCONNECTED;
 volatile uint32_t WiFiClass::local_IP = 0;
-bool WiFiClass::_initialized = false;
+volatile bool WiFiClass::_initialized = false;
 bool WiFiClass::_connecting = false;
 int8_t WiFiClass::role = ROLE_STA;
 volatile int WiFiClass::network_count = 0;
@@ -97,6 +100,61 @@ WiFiClient WiFiClass::clients[MAX_SOCK_NUM];
 char WiFiClass::string_output_buffer[MAX_SSID_LEN];
 IPAddress WiFiClass::ipaddress_output_buffer;
 
+//
+//micros() at the end of each boot phase, 0 until it is reached
+//
+static volatile unsigned long bootTimes[WIFI_BOOT_PHASES];
+
+//
+//init() holds this while it boots the network processor, so a WiFi call
+//made while initAsync() is still booting waits for it to finish.
+//Constructed on first use since initAsync() may run from a global
+//constructor, before this file's constructors have run.
+//
+static Semaphore_Struct initSem;
+static bool initSemConstructed = false;
+
+static Semaphore_Handle initLock()
+{
+    UInt key = Task_disable();
+    if (!initSemConstructed) {
+        Semaphore_Params semParams;
+        Semaphore_Params_init(&semParams);
+        semParams.mode = Semaphore_Mode_BINARY;
+        Semaphore_construct(&initSem, 1, &semParams);
+        initSemConstructed = true;
+    }
+    Task_restore(key);
+    return Semaphore_handle(&initSem);
+}
+
+//
+//serializes sl_Select(), see selectReadable(). Constructed on first use
+//like initSem, a global object may open a socket before this file's
+//constructors have run.
+//
+static Semaphore_Struct selectSem;
+static bool selectSemConstructed = false;
+
+static Semaphore_Handle selectLock()
+{
+    UInt key = Task_disable();
+    if (!selectSemConstructed) {
+        Semaphore_Params semParams;
+        Semaphore_Params_init(&semParams);
+        semParams.mode = Semaphore_Mode_BINARY;
+        Semaphore_construct(&selectSem, 1, &semParams);
+        selectSemConstructed = true;
+    }
+    Task_restore(key);
+    return Semaphore_handle(&selectSem);
+}
+
+static void initTaskFxn(UArg arg0, UArg arg1)
+{
+    WiFiClass::init();
+}
+
 //--tested, working--//
 WiFiClass::WiFiClass()
 {
@@ -114,6 +172,7 @@ bool WiFiClass::init()
 {
     WiFi_Params        wifiParams;
     WiFi_Handle        handle;
+    Semaphore_Handle   lock;
 
     //
     //only initialize once
@@ -122,6 +181,19 @@ bool WiFiClass::init()
         return true;
     }
 
+    //
+    //wait for a boot already under way, it may have finished meanwhile
+    //
+    lock = initLock();
+    Semaphore_pend(lock, BIOS_WAIT_FOREVER);
+    if (_initialized) {
+        Semaphore_post(lock);
+        return true;
+    }
+
+    memset((void *)bootTimes, 0, sizeof(bootTimes));
+    bootTimes[WIFI_BOOT_START] = micros();
+
     //
     // initialize TI-RTOS WiFi driver
     //
@@ -138,6 +210,7 @@ bool WiFiClass::init()
     if (handle == NULL) {
         System_abort("WiFi driver failed to open.");
     }
+    bootTimes[WIFI_BOOT_DRIVER] = micros();
 
     //
     //start the SimpleLink driver (no callback)
@@ -148,8 +221,10 @@ bool WiFiClass::init()
     //check if sl_start failed
     //
     if (iRet==ROLE_STA_ERR || iRet==ROLE_AP_ERR || iRet==ROLE_P2P_ERR) {
+        Semaphore_post(lock);
         return false;
     }
+    bootTimes[WIFI_BOOT_NWP] = micros();
     
     //
     //set the mode to station if it's not already in station mode
@@ -159,6 +234,7 @@ bool WiFiClass::init()
         sl_Stop(0);
         sl_Start(NULL, NULL, NULL);
     }
+    bootTimes[WIFI_BOOT_ROLE] = micros();
     
     //
     //disconnect from anything if for some reason it's connected
@@ -174,9 +250,39 @@ bool WiFiClass::init()
     //
     sl_WlanRxStatStart();
 
+    bootTimes[WIFI_BOOT_READY] = micros();
+    Semaphore_post(lock);
     return true;
 }
 
+bool WiFiClass::initAsync(int priority)
+{
+    Task_Params taskParams;
+    Error_Block eb;
+
+    if (_initialized) {
+        return true;
+    }
+
+    //
+    //the task runs init() once and terminates; should a WiFi call get
+    //to init() first, the task finds the work done
+    //
+    Error_init(&eb);
+    Task_Params_init(&taskParams);
+    taskParams.priority = priority;
+    taskParams.stackSize = WIFI_INIT_TASK_STACK;
+    return Task_create(initTaskFxn, &taskParams, &eb) != NULL;
+}
+
+unsigned long WiFiClass::bootTime(uint8_t phase)
+{
+    if (phase >= WIFI_BOOT_PHASES) {
+        return 0;
+    }
+    return bootTimes[phase];
+}
+
 //--tested, working--//
 uint8_t WiFiClass::getSocket()
 {
@@ -193,6 +299,39 @@ uint8_t WiFiClass::getSocket()
     return NO_SOCKET_AVAIL;
 }
 
+bool WiFiClass::selectReadable(int16_t handle, unsigned long timeout)
+{
+    Semaphore_Handle lock = selectLock();
+    unsigned long start = millis();
+    SlTimeval_t tv;
+    SlFdSet_t readsds, errorsds;
+    int ready;
+
+    //
+    //10 ms is the shortest timeout sl_Select() honours. A waiting task
+    //gets the lock as soon as it is posted, so the slices of two callers
+    //interleave
+    //
+    do {
+        tv.tv_sec = 0;
+        tv.tv_usec = 10000;
+        SL_FD_ZERO(&readsds);
+        SL_FD_ZERO(&errorsds);
+        SL_FD_SET(handle, &readsds);
+        SL_FD_SET(handle, &errorsds);
+
+        Semaphore_pend(lock, BIOS_WAIT_FOREVER);
+        ready = sl_Select(handle + 1, &readsds, NULL, &errorsds, &tv);
+        Semaphore_post(lock);
+
+        if (ready != 0) {
+            return (ready > 0);
+        }
+    } while (millis() - start < timeout);
+
+    return false;
+}
+
 
 const char * WiFiClass::driverVersion()
 {
@@ -1066,6 +1205,18 @@ boolean WiFiClass::setDateTime(uint16_t month, uint16_t day, uint16_t year, uint
                           sizeof(SlDateTime_t), (uint8_t *)&dt);
     if (i != 0)
         return false;
+
+    /* The application clock follows, unless it already agrees within a second (as when an SNTP
+     * client that set it passes the time on here): stepping it would drop the fraction.
+     * Days since 1970 from the civil date, with March as the first month of the year.
+     */
+    uint32_t y = year - (month <= 2);
+    uint32_t m = month <= 2 ? month + 9 : month - 3;
+    uint32_t days = 365 * y + y / 4 - y / 100 + y / 400 + (153 * m + 2) / 5 + day - 1 - 719468;
+    uint32_t utc = days * 86400UL + hour * 3600UL + minute * 60UL + second;
+    uint32_t now = SysTime.utc();
+    if (now + 1 < utc || now > utc + 1)
+        SysTime.setUTC((uint64_t)utc * 1000000);
     return true;
 }
 
@@ -1202,7 +1353,7 @@ extern "C" {
  */
 extern void SimpleLinkGeneralEventHandler(SlDeviceEvent_t *pDevEvent)
 {
-    System_printf("General event occurred, Event ID: %x", pDevEvent->Event);
+    TOKENLOG("General event occurred, Event ID: %x", pDevEvent->Event);
 }
 
 /*
@@ -39,6 +39,22 @@
 #define WL_FW_VER_LENGTH 64
 #define MAX_AP_DEVICE_REGISTRY 4
 
+//
+//Network processor boot phases, see WiFiClass::bootTime()
+//
+#define WIFI_BOOT_START  0   // init() started
+#define WIFI_BOOT_DRIVER 1   // SPI, DMA and the WiFi driver are open
+#define WIFI_BOOT_NWP    2   // sl_Start() returned, the network processor runs
+#define WIFI_BOOT_ROLE   3   // the network processor is in station role
+#define WIFI_BOOT_READY  4   // disconnected and mDNS cleared, ready to connect
+#define WIFI_BOOT_PHASES 5
+
+//
+//Task running init() in the background, see WiFiClass::initAsync()
+//
+#define WIFI_INIT_TASK_PRIORITY 2
+#define WIFI_INIT_TASK_STACK    0x800
+
 typedef struct {
     boolean in_use;
     uint8_t ipAddress[4];
@@ -58,9 +74,29 @@ public:
     static int16_t _serverPortArray[MAX_SOCK_NUM];
     static int16_t _typeArray[MAX_SOCK_NUM];
     
-    static bool _initialized;
+    static volatile bool _initialized;
     static bool _connecting;
     static bool init();
+
+    /* Start init() in a background task and return at once
+     *
+     * The network processor boots while setup() initializes sensors and
+     * displays; the first WiFi call that needs it waits for the boot to
+     * finish instead of starting it. Call it first thing in setup(), or
+     * from the constructor of a global object to start before setup().
+     *
+     * param priority: priority of the background task
+     * return: false if the task could not be created
+     */
+    static bool initAsync(int priority = WIFI_INIT_TASK_PRIORITY);
+
+    /* Time a boot phase was reached
+     *
+     * param phase: WIFI_BOOT_START .. WIFI_BOOT_READY
+     * return: micros() when the phase was reached, 0 if not reached yet
+     */
+    static unsigned long bootTime(uint8_t phase);
+
     volatile static int network_count;
     
     //
@@ -89,6 +125,20 @@ public:
      * Get the first socket available
      */
     static uint8_t getSocket();
+
+    /*
+     * Wait until a socket is readable or has an error
+     *
+     * sl_Select() must not be called by two tasks at once, even on
+     * different sockets, so every caller goes through here. The wait
+     * is made of 10 ms selects and the lock is released between them,
+     * so a long wait doesn't hold up the other sockets.
+     *
+     * param handle: simplelink socket handle
+     * param timeout: milliseconds to wait, at least one select is made
+     * return: true if the socket is readable or has an error
+     */
+    static bool selectReadable(int16_t handle, unsigned long timeout);
     
     /*
      * Get firmware and driver version
@@ -319,6 +369,42 @@ public:
      *          else error code
      */
     int hostByName(char* aHostname, IPAddress& aResult);
+
+    /*
+     * Start resolving a host name in the background and return at once
+     *
+     * The lookup runs in one of WIFI_DNS_TASKS tasks, so several lookups
+     * overlap with each other and with the caller's work. A lookup for a
+     * name already being resolved shares that lookup. Collect the address
+     * with lookupResult() or waitLookup(), pass the lookup to
+     * WiFiClient::connect(), or get it through callback.
+     *
+     * param aHostname: name to resolve, copied
+     * param callback: optional, called from the DNS task once resolved
+     * param arg: passed to callback
+     * return: the lookup, not valid() if all WIFI_DNS_SLOTS are pending
+     *         or the name is longer than WIFI_DNS_HOST_MAX - 1
+     */
+    static WiFiLookup resolve(const char* aHostname, WiFiDnsCallback callback = NULL, void* arg = NULL);
+
+    /*
+     * Result of a lookup, without waiting
+     *
+     * A lookup's result stays available until its slot is taken by a
+     * new lookup, after the WIFI_DNS_SLOTS - 1 next ones at the earliest.
+     *
+     * return: 1 with the address in aResult, WIFI_DNS_PENDING, or a
+     *         negative error
+     */
+    static int lookupResult(WiFiLookup lookup, IPAddress& aResult);
+
+    /*
+     * Wait for the result of a lookup
+     *
+     * param timeout: ms, WIFI_DNS_WAIT_FOREVER by default
+     * return: as lookupResult(), WIFI_DNS_TIMEOUT instead of pending
+     */
+    static int waitLookup(WiFiLookup lookup, IPAddress& aResult, unsigned long timeout = WIFI_DNS_WAIT_FOREVER);
     
     /*
      * Start Smartconfig.
@@ -327,7 +413,7 @@ public:
     int startSmartConfig(bool block = true);
 
     /*
-     * Set WiFi network processor Date/Time
+     * Set WiFi network processor Date/Time, and SysTime if it is off by more than a second
      * Params: month (1-12), day (1-31), year, hour (0-23), minute (0-59), second (0-59)
      * return: true if successful, false if invalid parameters were supplied (or sl_DevSet() returned an error)
      */
@@ -35,7 +35,22 @@
 #include "WiFi.h"
 #include "WiFiClient.h"
 #include "WiFiServer.h"
-#include <xdc/runtime/System.h>
+#include <ti/runtime/wiring/RtosTrace.h>
+#include <ti/runtime/wiring/TokenLog.h>
+
+//
+//The receive buffer belongs to the socket rather than to the object, since
+//WiFiClient objects are copied around freely (see ~WiFiClient()). It is
+//taken from the pool when data is received and given back once the data
+//has been read, so a socket with nothing unread holds no buffer.
+//
+static uint8_t* rxBuffers[MAX_SOCK_NUM];
+static size_t rxSizes[MAX_SOCK_NUM];
+
+//
+//the space writeBuffer() hands out, a pool block held until commit()
+//
+static uint8_t* txBuffers[MAX_SOCK_NUM];
 
 //--tested, working--//
 //--client side--//
@@ -46,6 +61,7 @@ WiFiClient::WiFiClient()
     //
     rx_currentIndex = 0;
     rx_fillLevel = 0;
+    rx_bufferSize = 0;
     _socketIndex = NO_SOCKET_AVAIL;
     hasRootCA = false;
     sslVerifyStrict = false;
@@ -61,6 +77,7 @@ WiFiClient::WiFiClient(uint8_t socketIndex)
     //
     rx_currentIndex = 0;
     rx_fillLevel = 0;
+    rx_bufferSize = 0;
     _socketIndex = socketIndex;
 }
 
@@ -87,17 +104,31 @@ WiFiClient::~WiFiClient()
 int WiFiClient::connect(const char* host, uint16_t port)
 {
     //
-    //get the host ip address
+    //get the host ip address, sharing the lookup with any other task
+    //resolving the same name; resolve directly if all lookups are busy
     //
     IPAddress hostIP(0,0,0,0);
-    int success = WiFi.hostByName((char*)host, hostIP);
-    if (!success) {
+    WiFiLookup lookup = WiFi.resolve(host);
+    int success = lookup.valid() ? WiFi.waitLookup(lookup, hostIP)
+                                 : WiFi.hostByName((char*)host, hostIP);
+    if (success != 1) {
         return false;
     }
     
     return connect(hostIP, port);
 }
 
+//--client side--//
+int WiFiClient::connect(WiFiLookup lookup, uint16_t port)
+{
+    IPAddress hostIP(0,0,0,0);
+    if (WiFi.waitLookup(lookup, hostIP) != 1) {
+        return false;
+    }
+
+    return connect(hostIP, port);
+}
+
 //--tested, working--//
 //--client side--//
 int WiFiClient::connect(IPAddress ip, uint16_t port)
@@ -130,7 +161,9 @@ int WiFiClient::connect(IPAddress ip, uint16_t port)
     server.sin_family = SL_AF_INET;
     server.sin_port = sl_Htons(port);
     server.sin_addr.s_addr = ip;
+    RtosTrace.event(RTOSTRACE_SOCKET_BEGIN, "sl_Connect", socketHandle);
     int iRet = sl_Connect(socketHandle, (SlSockAddr_t*)&server, sizeof(SlSockAddrIn_t));
+    RtosTrace.event(RTOSTRACE_SOCKET_END, "sl_Connect", iRet);
 
     if (iRet < 0) {
         sl_Close(socketHandle);
@@ -158,14 +191,26 @@ int WiFiClient::sslConnect(const char* host, uint16_t port)
     //get the host ip address
     //
     IPAddress hostIP(0,0,0,0);
-    int success = WiFi.hostByName((char*)host, hostIP);
-    if (!success) {
+    WiFiLookup lookup = WiFi.resolve(host);
+    int success = lookup.valid() ? WiFi.waitLookup(lookup, hostIP)
+                                 : WiFi.hostByName((char*)host, hostIP);
+    if (success != 1) {
         return false;
     }
     
     return sslConnect(hostIP, port);
 }
 
+int WiFiClient::sslConnect(WiFiLookup lookup, uint16_t port)
+{
+    IPAddress hostIP(0,0,0,0);
+    if (WiFi.waitLookup(lookup, hostIP) != 1) {
+        return false;
+    }
+
+    return sslConnect(hostIP, port);
+}
+
 #define ROOTCA_PEM_FILE "/cert/rootCA.pem"
 
 int WiFiClient::sslConnect(IPAddress ip, uint16_t port)
@@ -208,7 +253,9 @@ int WiFiClient::sslConnect(IPAddress ip, uint16_t port)
     server.sin_family = SL_AF_INET;
     server.sin_port = sl_Htons(port);
     server.sin_addr.s_addr = ip;
+    RtosTrace.event(RTOSTRACE_SOCKET_BEGIN, "sl_Connect", socketHandle);
     int iRet = sl_Connect(socketHandle, (SlSockAddr_t*)&server, sizeof(SlSockAddrIn_t));
+    RtosTrace.event(RTOSTRACE_SOCKET_END, "sl_Connect", iRet);
 
     if ( iRet < 0 && (iRet != SL_ESECSNOVERIFY && iRet != SL_ESECDATEERROR) ) {
         sslLastError = iRet;
@@ -372,6 +419,7 @@ size_t WiFiClient::write(const uint8_t *buffer, size_t size)
             sendSize = size;
         }
         /* Write block to socket, retry if SL_EAGAIN is received */
+        RtosTrace.event(RTOSTRACE_SOCKET_BEGIN, "sl_Send", WiFiClass::_handleArray[_socketIndex]);
         while ((iRet = sl_Send(WiFiClass::_handleArray[_socketIndex], buffer, sendSize, 0))
                 == SL_EAGAIN) {
             delay(10);
@@ -380,6 +428,7 @@ size_t WiFiClient::write(const uint8_t *buffer, size_t size)
             sl_Task();
 #endif
         }
+        RtosTrace.event(RTOSTRACE_SOCKET_END, "sl_Send", iRet);
         if (iRet == sendSize) {
             size -= sendSize;
             buffer += sendSize;
@@ -397,6 +446,46 @@ size_t WiFiClient::write(const uint8_t *buffer, size_t size)
     return (origSize);
 }
 
+//
+//lend a pool block to fill and send with commit(). When the pool is out
+//there is no space to offer, the caller writes from its own buffer
+//
+int WiFiClient::writeBuffer(uint8_t **buffer)
+{
+    if (_socketIndex == NO_SOCKET_AVAIL) {
+        return 0;
+    }
+
+    size_t size = NetBuffers.blockSize();
+    if (txBuffers[_socketIndex] == NULL) {
+        txBuffers[_socketIndex] = (uint8_t*)NetBuffers.acquire(size);
+        if (txBuffers[_socketIndex] == NULL) {
+            return -1;
+        }
+    }
+
+    *buffer = txBuffers[_socketIndex];
+    return size < MAX_SL_SEND_BUFSIZE ? size : MAX_SL_SEND_BUFSIZE;
+}
+
+void WiFiClient::commit(size_t size)
+{
+    if (_socketIndex == NO_SOCKET_AVAIL) {
+        return;
+    }
+
+    //
+    //detach the block first: a failed send calls stop(), which gives
+    //back the socket's blocks
+    //
+    uint8_t* buffer = txBuffers[_socketIndex];
+    txBuffers[_socketIndex] = NULL;
+    if (buffer != NULL && size > 0) {
+        write(buffer, size);
+    }
+    NetBuffers.release(buffer);
+}
+
 //--tested, working--//
 //--client and server side--//
 int WiFiClient::available()
@@ -413,7 +502,21 @@ int WiFiClient::available()
     //then receive some data
     //
     int bytesLeft = rx_fillLevel - rx_currentIndex;
+    if (rxBuffers[_socketIndex] == NULL) {
+        //a copy of this client has read the data and given the buffer back
+        bytesLeft = 0;
+    }
     if (bytesLeft <= 0) {
+        //
+        //if the pool is out of buffers, the data waits in the network processor
+        //
+        uint8_t* buffer = rxBuffer();
+        if (buffer == NULL) {
+            rx_fillLevel = 0;
+            rx_currentIndex = 0;
+            return 0;
+        }
+
         SlTimeval_t timeout;
         memset(&timeout, 0, sizeof(SlTimeval_t));
         timeout.tv_sec = 0;
@@ -431,18 +534,19 @@ int WiFiClient::available()
         //Receive any pending information into the buffer
         //if the connection has died, call stop() to make the object aware it's dead
         //
-        int iRet = sl_Recv(WiFiClass::_handleArray[_socketIndex], rx_buffer, TCP_RX_BUFF_MAX_SIZE, 0);
+        RtosTrace.event(RTOSTRACE_SOCKET_BEGIN, "sl_Recv", WiFiClass::_handleArray[_socketIndex]);
+        int iRet = sl_Recv(WiFiClass::_handleArray[_socketIndex], buffer, rxSizes[_socketIndex], 0);
+        RtosTrace.event(RTOSTRACE_SOCKET_END, "sl_Recv", iRet);
         if ((iRet <= 0) && (iRet != SL_EAGAIN)) {
-            System_printf("socket %p died: sl_Recv() failed (%d)\n",
-                          WiFiClass::_handleArray[_socketIndex], iRet);
+            TOKENLOG("socket %d died: sl_Recv() failed (%d)",
+                     WiFiClass::_handleArray[_socketIndex], iRet);
+            releaseBuffer();
             sl_Close(WiFiClass::_handleArray[_socketIndex]);
 
             WiFiClass::_portArray[_socketIndex] = -1;
             WiFiClass::_handleArray[_socketIndex] = -1;
             WiFiClass::_typeArray[_socketIndex] = -1;
             _socketIndex = NO_SOCKET_AVAIL;
-
-            memset(rx_buffer, 0, TCP_RX_BUFF_MAX_SIZE);
             return 0;
         }
         
@@ -453,6 +557,9 @@ int WiFiClient::available()
         rx_currentIndex = 0;
         rx_fillLevel = (iRet != SL_EAGAIN) ? iRet : 0;
         bytesLeft = rx_fillLevel - rx_currentIndex;
+        if (bytesLeft == 0) {
+            releaseBuffer();
+        }
     }
     
     //
@@ -464,6 +571,44 @@ int WiFiClient::available()
     return bytesLeft;
 }
 
+int WiFiClient::waitAvailable(unsigned long timeout)
+{
+    //
+    //data already in the buffer, or a socket that's gone, needs no wait
+    //
+    int bytesLeft = available();
+    if (bytesLeft > 0) {
+        return bytesLeft;
+    }
+    if (_socketIndex == NO_SOCKET_AVAIL) {
+        return -1;
+    }
+    if (timeout == 0) {
+        return 0;
+    }
+
+    //
+    //block until the socket is readable (or closed, which sl_Recv() then
+    //reports)
+    //
+    if (!WiFiClass::selectReadable(WiFiClass::_handleArray[_socketIndex], timeout)) {
+        return 0;
+    }
+
+    bytesLeft = available();
+    if (_socketIndex == NO_SOCKET_AVAIL) {
+        return -1;
+    }
+    if (bytesLeft == 0) {
+        //
+        //readable, but the pool has no buffer to receive into: don't let
+        //the caller spin on a select that returns at once
+        //
+        delay(1);
+    }
+    return bytesLeft;
+}
+
 //--tested, working--//
 int WiFiClient::read()
 {
@@ -472,7 +617,11 @@ int WiFiClient::read()
     //if there are no more bytes left in the buffer. Returns 0 if nothing more
     //
     if ( available() ) {
-        return rx_buffer[rx_currentIndex++];
+        int b = rxBuffers[_socketIndex][rx_currentIndex++];
+        if (rx_currentIndex >= rx_fillLevel) {
+            releaseBuffer();
+        }
+        return b;
     } else {
         return -1;
     }
@@ -492,8 +641,11 @@ int WiFiClient::read(uint8_t* buf, size_t size)
     if (len > size) {
         len = size;
     }
-    memcpy(buf, &rx_buffer[rx_currentIndex], len);
+    memcpy(buf, &rxBuffers[_socketIndex][rx_currentIndex], len);
     rx_currentIndex += len;
+    if (rx_currentIndex >= rx_fillLevel) {
+        releaseBuffer();
+    }
 
     return len;
 }
@@ -504,22 +656,50 @@ int WiFiClient::peek()
     //
     //return the next byte in the buffer or -1 if we're past the end of the data
     //
-    if (rx_currentIndex < rx_fillLevel) {
-        return rx_buffer[rx_currentIndex];
+    if (_socketIndex != NO_SOCKET_AVAIL && rxBuffers[_socketIndex] != NULL &&
+        rx_currentIndex < rx_fillLevel) {
+        return rxBuffers[_socketIndex][rx_currentIndex];
     } else {
         return -1;
     }
 }
 
+int WiFiClient::peekBuffer(const uint8_t **buffer)
+{
+    //
+    //expose the unread part of the receive buffer, refilling it if it's empty
+    //the bytes stay in the buffer until consume() is called
+    //
+    int len = available();
+    *buffer = len ? &rxBuffers[_socketIndex][rx_currentIndex] : NULL;
+    return len;
+}
+
+void WiFiClient::consume(size_t size)
+{
+    //
+    //never advance past the data that's actually in the buffer
+    //
+    int len = rx_fillLevel - rx_currentIndex;
+    if (len <= 0) {
+        return;
+    }
+    if (size > (size_t)len) {
+        size = len;
+    }
+    rx_currentIndex += size;
+    if (rx_currentIndex >= rx_fillLevel) {
+        releaseBuffer();
+    }
+}
+
 //--tested, working--//
 void WiFiClient::flush()
 {
     //
-    //clear out the buffer and reset all the buffer indicators
+    //drop the unread data and give the buffer back
     //
-    memset(rx_buffer, 0, TCP_RX_BUFF_MAX_SIZE);
-    rx_fillLevel = 0;
-    rx_currentIndex = 0;
+    releaseBuffer();
 }
 
 //--tested, working--//
@@ -532,9 +712,17 @@ void WiFiClient::stop()
         return;
     }
     
+    //
+    //the buffers go back to the pool with any data left unread, since
+    //the socket index is free for another socket once it's closed
+    //
+    releaseBuffer();
+    NetBuffers.release(txBuffers[_socketIndex]);
+    txBuffers[_socketIndex] = NULL;
+
     //
     //disconnect, destroy the socket, and reset the socket tracking variables
-    //in WiFiClass, but don't destroy any of the received data
+    //in WiFiClass
     //
     int iRet = sl_Close(WiFiClass::_handleArray[_socketIndex]);
     if (iRet < 0) {
@@ -577,6 +765,41 @@ uint8_t WiFiClient::status()
     return true;
 }
 
+void WiFiClient::setBufferSize(size_t size)
+{
+    //
+    //takes effect the next time the buffer is taken from the pool
+    //
+    rx_bufferSize = size;
+}
+
+//
+//the socket's receive buffer, taken from the pool if it has none
+//
+uint8_t* WiFiClient::rxBuffer()
+{
+    uint8_t* buffer = rxBuffers[_socketIndex];
+    if (buffer == NULL) {
+        size_t size = rx_bufferSize ? rx_bufferSize : NetBuffers.blockSize();
+        buffer = (uint8_t*)NetBuffers.acquire(size);
+        if (buffer != NULL) {
+            rxBuffers[_socketIndex] = buffer;
+            rxSizes[_socketIndex] = size;
+        }
+    }
+    return buffer;
+}
+
+void WiFiClient::releaseBuffer()
+{
+    if (_socketIndex != NO_SOCKET_AVAIL) {
+        NetBuffers.release(rxBuffers[_socketIndex]);
+        rxBuffers[_socketIndex] = NULL;
+    }
+    rx_fillLevel = 0;
+    rx_currentIndex = 0;
+}
+
 //--tested, working--//
 WiFiClient::operator bool()
 {
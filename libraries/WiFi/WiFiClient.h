@@ -23,8 +23,10 @@
 #include <ti/runtime/wiring/IPAddress.h>
 #include <ti/runtime/wiring/Stream.h>
 #include <ti/runtime/wiring/Client.h>
+#include <ti/runtime/wiring/NetBuffers.h>
+#include "WiFiDns.h"
 
-#define TCP_RX_BUFF_MAX_SIZE 255
+#define TCP_RX_BUFF_MAX_SIZE 255  // no longer used, see setBufferSize()
 
 //
 //Inhereting from stream (which inherits from print)
@@ -42,6 +44,9 @@ public:
     virtual int connect(const char *host, uint16_t port);
     virtual int sslConnect(IPAddress ip, uint16_t port);
     virtual int sslConnect(const char *host, uint16_t port);
+    //connect to the address a WiFi.resolve() lookup gives, once it's there
+    int connect(WiFiLookup lookup, uint16_t port);
+    int sslConnect(WiFiLookup lookup, uint16_t port);
     // SSL root CA verification is a work in progress
     //virtual int sslRootCA(const uint8_t *rootCAfilecontents, const size_t);
     //virtual int useRootCA(void);
@@ -50,14 +55,32 @@ public:
     //virtual const char *sslGetReason(void);
     virtual size_t write(uint8_t);
     virtual size_t write(const uint8_t *buffer, size_t size);
+    virtual int writeBuffer(uint8_t **buffer);
+    virtual void commit(size_t size);
     virtual int available();
+    //
+    //like available(), but waits up to timeout ms for data to arrive, in
+    //10 ms selects shared with the other sockets (see
+    //WiFiClass::selectReadable()); -1 once the connection is closed and
+    //everything was read
+    //
+    int waitAvailable(unsigned long timeout);
     virtual int read();
     virtual int read(uint8_t* buf, size_t size);
     virtual int peek();
+    virtual int peekBuffer(const uint8_t **buffer);
+    virtual void consume(size_t size);
     virtual void flush();
     virtual void stop();
     virtual uint8_t connected();
     virtual operator bool();
+
+    //
+    //received data waits in a buffer from the NetBuffers pool, held only
+    //while there is unread data; size 0, the default, asks for a pool
+    //block, a larger size is taken from the heap
+    //
+    void setBufferSize(size_t size);
     
     friend class WiFiServer;
 
@@ -65,12 +88,15 @@ public:
     
 private:
     int _socketIndex;
-    uint8_t rx_buffer[TCP_RX_BUFF_MAX_SIZE];
+    size_t rx_bufferSize;
     int rx_fillLevel;
     int rx_currentIndex;
     boolean sslVerifyStrict;
     boolean hasRootCA;
     int32_t sslLastError;
+
+    uint8_t* rxBuffer();
+    void releaseBuffer();
 };
 
 #endif
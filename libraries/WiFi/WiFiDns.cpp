@@ -0,0 +1,302 @@
+/*
+ WiFiDns.cpp - Background host name resolution for the CC3200
+
+ sl_NetAppDnsGetHostByName() blocks its caller for a full DNS round trip.
+ resolve() instead queues the name in one of WIFI_DNS_SLOTS slots and
+ WIFI_DNS_TASKS tasks, created on the first call, run the lookups. A
+ slot keeps its answer until it is needed for a new name; a lookup
+ handle carries the slot's tag at the time, so a handle to a reused
+ slot is recognized and reported WIFI_DNS_INVALID.
+
+ This library is free software; you can redistribute it and/or
+ modify it under the terms of the GNU Lesser General Public
+ License as published by the Free Software Foundation; either
+ version 2.1 of the License, or (at your option) any later version.
+
+ This library is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ Lesser General Public License for more details.
+
+ You should have received a copy of the GNU Lesser General Public
+ License along with this library; if not, write to the Free Software
+ Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#include <ti/runtime/wiring/Energia.h>
+#include <xdc/runtime/Error.h>
+#include "WiFi.h"
+
+extern "C" {
+    #include <string.h>
+    #include <ti/mw/wifi/cc3x00/simplelink/include/netapp.h>
+}
+
+#define SLOT_FREE    0
+#define SLOT_QUEUED  1   // waiting for a DNS task
+#define SLOT_RUNNING 2   // a DNS task is resolving it
+#define SLOT_DONE    3
+
+typedef struct {
+    char host[WIFI_DNS_HOST_MAX];
+    uint8_t state;
+    uint8_t tag;
+    int16_t status;
+    uint32_t ip;
+    uint32_t order;              // queued, then answered, order for reuse
+    Semaphore_Struct done;       // posted once the answer is in
+} DnsSlot;
+
+typedef struct {
+    WiFiDnsCallback fxn;         // NULL when the entry is free
+    void *arg;
+    int8_t slot;
+    uint8_t tag;
+} DnsCallback;
+
+static DnsSlot slots[WIFI_DNS_SLOTS];
+static DnsCallback callbacks[WIFI_DNS_CALLBACKS];
+static Semaphore_Struct queued;  // counts the queued slots
+static uint32_t order;
+static bool started = false;
+
+static void dnsTaskFxn(UArg arg0, UArg arg1)
+{
+    DnsCallback ready[WIFI_DNS_CALLBACKS];
+
+    for (;;) {
+        DnsSlot *slot = NULL;
+        uint8_t count = 0;
+        unsigned long ip = 0;
+        int i, ret, status;
+        UInt key;
+
+        Semaphore_pend(Semaphore_handle(&queued), BIOS_WAIT_FOREVER);
+
+        //
+        //the longest queued slot
+        //
+        key = Task_disable();
+        for (i = 0; i < WIFI_DNS_SLOTS; i++) {
+            if (slots[i].state == SLOT_QUEUED &&
+                (slot == NULL || (int32_t)(slots[i].order - slot->order) < 0)) {
+                slot = &slots[i];
+            }
+        }
+        if (slot != NULL) {
+            slot->state = SLOT_RUNNING;
+        }
+        Task_restore(key);
+        if (slot == NULL) {
+            continue;
+        }
+
+        if (!WiFiClass::_initialized) {
+            WiFiClass::init();
+        }
+
+        //
+        //the name can't change while the slot is running
+        //
+        ret = sl_NetAppDnsGetHostByName((signed char *)slot->host, strlen(slot->host), &ip, SL_AF_INET);
+
+        status = ret >= 0 ? 1 : ret;
+        ip = sl_Htonl(ip);
+
+        key = Task_disable();
+        slot->status = status;
+        slot->ip = ip;
+        slot->order = order++;
+        slot->state = SLOT_DONE;
+        for (i = 0; i < WIFI_DNS_CALLBACKS; i++) {
+            if (callbacks[i].fxn != NULL && &slots[callbacks[i].slot] == slot) {
+                ready[count++] = callbacks[i];
+                callbacks[i].fxn = NULL;
+            }
+        }
+        Task_restore(key);
+
+        Semaphore_post(Semaphore_handle(&slot->done));
+        for (i = 0; i < count; i++) {
+            ready[i].fxn(WiFiLookup(ready[i].slot, ready[i].tag), status, IPAddress(ip), ready[i].arg);
+        }
+    }
+}
+
+//
+//Constructs the semaphores and creates the DNS tasks on first use
+//
+static bool startDns()
+{
+    Semaphore_Params semParams;
+    Task_Params taskParams;
+    Error_Block eb;
+    bool first;
+    int i, created = 0;
+
+    UInt key = Task_disable();
+    first = !started;
+    if (first) {
+        Semaphore_Params_init(&semParams);
+        Semaphore_construct(&queued, 0, &semParams);
+        semParams.mode = Semaphore_Mode_BINARY;
+        for (i = 0; i < WIFI_DNS_SLOTS; i++) {
+            Semaphore_construct(&slots[i].done, 0, &semParams);
+        }
+        started = true;
+    }
+    Task_restore(key);
+
+    if (first) {
+        Error_init(&eb);
+        Task_Params_init(&taskParams);
+        taskParams.priority = WIFI_DNS_TASK_PRIORITY;
+        taskParams.stackSize = WIFI_DNS_TASK_STACK;
+        for (i = 0; i < WIFI_DNS_TASKS; i++) {
+            if (Task_create(dnsTaskFxn, &taskParams, &eb) != NULL) {
+                created++;
+            }
+        }
+        return created > 0;
+    }
+    return true;
+}
+
+WiFiLookup WiFiClass::resolve(const char* aHostname, WiFiDnsCallback callback, void* arg)
+{
+    DnsSlot *slot = NULL;
+    int entry = -1;
+    bool queue = false;
+    int i;
+    UInt key;
+
+    if (strlen(aHostname) >= WIFI_DNS_HOST_MAX || !startDns()) {
+        return WiFiLookup();
+    }
+
+    key = Task_disable();
+
+    //
+    //share a lookup for the same name still under way
+    //
+    for (i = 0; i < WIFI_DNS_SLOTS; i++) {
+        if ((slots[i].state == SLOT_QUEUED || slots[i].state == SLOT_RUNNING) &&
+            strcmp(slots[i].host, aHostname) == 0) {
+            slot = &slots[i];
+            break;
+        }
+    }
+
+    //
+    //else take a free slot, or the one answered longest ago
+    //
+    if (slot == NULL) {
+        for (i = 0; i < WIFI_DNS_SLOTS; i++) {
+            if (slots[i].state == SLOT_FREE) {
+                slot = &slots[i];
+                break;
+            }
+            if (slots[i].state == SLOT_DONE &&
+                (slot == NULL || (int32_t)(slots[i].order - slot->order) < 0)) {
+                slot = &slots[i];
+            }
+        }
+        queue = slot != NULL;
+    }
+
+    if (slot != NULL && callback != NULL) {
+        for (i = 0; i < WIFI_DNS_CALLBACKS && entry < 0; i++) {
+            if (callbacks[i].fxn == NULL) {
+                entry = i;
+            }
+        }
+        if (entry < 0) {
+            slot = NULL;
+            queue = false;
+        }
+    }
+
+    if (slot == NULL) {
+        Task_restore(key);
+        return WiFiLookup();
+    }
+
+    if (queue) {
+        strcpy(slot->host, aHostname);
+        slot->tag++;
+        slot->status = WIFI_DNS_PENDING;
+        slot->order = order++;
+        slot->state = SLOT_QUEUED;
+        Semaphore_reset(Semaphore_handle(&slot->done), 0);
+    }
+
+    WiFiLookup lookup(slot - slots, slot->tag);
+    if (entry >= 0) {
+        callbacks[entry].fxn = callback;
+        callbacks[entry].arg = arg;
+        callbacks[entry].slot = lookup.slot;
+        callbacks[entry].tag = lookup.tag;
+    }
+    Task_restore(key);
+
+    if (queue) {
+        Semaphore_post(Semaphore_handle(&queued));
+    }
+    return lookup;
+}
+
+int WiFiClass::lookupResult(WiFiLookup lookup, IPAddress& aResult)
+{
+    int status;
+
+    if (!lookup.valid() || lookup.slot >= WIFI_DNS_SLOTS || !started) {
+        return WIFI_DNS_INVALID;
+    }
+
+    UInt key = Task_disable();
+    DnsSlot *slot = &slots[lookup.slot];
+    if (slot->tag != lookup.tag || slot->state == SLOT_FREE) {
+        status = WIFI_DNS_INVALID;
+    }
+    else if (slot->state != SLOT_DONE) {
+        status = WIFI_DNS_PENDING;
+    }
+    else {
+        status = slot->status;
+        if (status == 1) {
+            aResult = slot->ip;
+        }
+    }
+    Task_restore(key);
+    return status;
+}
+
+int WiFiClass::waitLookup(WiFiLookup lookup, IPAddress& aResult, unsigned long timeout)
+{
+    unsigned long start = millis();
+
+    for (;;) {
+        int status = lookupResult(lookup, aResult);
+        if (status != WIFI_DNS_PENDING) {
+            return status;
+        }
+
+        unsigned long waited = millis() - start;
+        UInt ticks = BIOS_WAIT_FOREVER;
+        if (timeout != WIFI_DNS_WAIT_FOREVER) {
+            if (waited >= timeout) {
+                return WIFI_DNS_TIMEOUT;
+            }
+            ticks = timeout - waited;
+        }
+
+        //
+        //the semaphore stays posted while the slot is done, so every
+        //task waiting on the slot passes in turn
+        //
+        Semaphore_Handle done = Semaphore_handle(&slots[lookup.slot].done);
+        if (Semaphore_pend(done, ticks)) {
+            Semaphore_post(done);
+        }
+    }
+}
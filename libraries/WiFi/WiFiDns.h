@@ -0,0 +1,66 @@
+/*
+ WiFiDns.h - Background host name resolution, see WiFiClass::resolve()
+
+ This library is free software; you can redistribute it and/or
+ modify it under the terms of the GNU Lesser General Public
+ License as published by the Free Software Foundation; either
+ version 2.1 of the License, or (at your option) any later version.
+
+ This library is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ Lesser General Public License for more details.
+
+ You should have received a copy of the GNU Lesser General Public
+ License along with this library; if not, write to the Free Software
+ Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#ifndef wifidns_h
+#define wifidns_h
+
+#include <ti/runtime/wiring/Arduino.h>
+#include <ti/runtime/wiring/IPAddress.h>
+
+//
+//Lookups pending or answered at once, and the tasks doing them
+//
+#define WIFI_DNS_SLOTS          4
+#define WIFI_DNS_CALLBACKS      8
+#define WIFI_DNS_TASKS          2
+#define WIFI_DNS_TASK_PRIORITY  2
+#define WIFI_DNS_TASK_STACK     0x400
+#define WIFI_DNS_HOST_MAX       64
+
+#define WIFI_DNS_WAIT_FOREVER   (~0UL)
+
+//
+//Status of a lookup besides 1 (resolved) and the negative SimpleLink
+//errors of sl_NetAppDnsGetHostByName()
+//
+#define WIFI_DNS_PENDING        0
+#define WIFI_DNS_INVALID        -2000   // no such lookup, or its slot was reused
+#define WIFI_DNS_TIMEOUT        -2001
+
+//
+//A lookup started by WiFiClass::resolve(), copied around by value
+//
+class WiFiLookup {
+public:
+    WiFiLookup() : slot(-1), tag(0) {}
+    WiFiLookup(int8_t slot, uint8_t tag) : slot(slot), tag(tag) {}
+
+    //false if resolve() could not start the lookup
+    bool valid() const { return slot >= 0; }
+
+    int8_t slot;
+    uint8_t tag;
+};
+
+//
+//Called from a DNS task when a lookup completes; status is 1 with the
+//address in ip, or a negative error
+//
+typedef void (*WiFiDnsCallback)(WiFiLookup lookup, int status, IPAddress ip, void *arg);
+
+#endif
@@ -22,6 +22,7 @@
 #include "WiFi.h"
 #include "WiFiClient.h"
 #include "WiFiServer.h"
+#include <ti/runtime/wiring/RtosTrace.h>
 
 WiFiServer::WiFiServer(uint16_t port)
 {
@@ -103,15 +104,18 @@ void WiFiServer::begin()
     WiFiClass::_typeArray[socketIndex] = TYPE_TCP_SERVER;
 }
 
-//--tested, working--//
-WiFiClient WiFiServer::available(byte* status)
+//
+//Accepts a queued connection, if any, and registers it with the WiFiClass
+//Returns the client's socket index, or NO_SOCKET_AVAIL
+//
+int WiFiServer::acceptClient()
 {
     //
     //Get a socket number from the wificlass
     //
     int clientSocketIndex = WiFiClass::getSocket();
-    if (clientSocketIndex == NO_SOCKET_AVAIL) {
-        return WiFiClient(255);
+    if (clientSocketIndex == NO_SOCKET_AVAIL || _socketIndex == NO_SOCKET_AVAIL) {
+        return NO_SOCKET_AVAIL;
     }
     
     //
@@ -130,13 +134,33 @@ WiFiClient WiFiServer::available(byte* status)
     //We've successfully created a socket, so store everything in the wificlass
     //arrays used to keep track of the connected sockets, port #s, and types
     //
-    if (clientHandle > 0) {
-        WiFiClass::_handleArray[clientSocketIndex] = clientHandle;
-        WiFiClass::_typeArray[clientSocketIndex] = TYPE_TCP_CONNECTED_CLIENT;
-        WiFiClass::_portArray[clientSocketIndex] = sl_Htons(clientAddress.sin_port);
-        WiFiClass::_serverPortArray[clientSocketIndex] = _port;
-        WiFiClass::clients[clientSocketIndex] = WiFiClient(clientSocketIndex);
+    if (clientHandle <= 0) {
+        return NO_SOCKET_AVAIL;
+    }
+    WiFiClass::_handleArray[clientSocketIndex] = clientHandle;
+    WiFiClass::_typeArray[clientSocketIndex] = TYPE_TCP_CONNECTED_CLIENT;
+    WiFiClass::_portArray[clientSocketIndex] = sl_Htons(clientAddress.sin_port);
+    WiFiClass::_serverPortArray[clientSocketIndex] = _port;
+    WiFiClass::clients[clientSocketIndex] = WiFiClient(clientSocketIndex);
+    return clientSocketIndex;
+}
+
+WiFiClient WiFiServer::accept()
+{
+    int clientSocketIndex = acceptClient();
+    if (clientSocketIndex == NO_SOCKET_AVAIL) {
+        return WiFiClient(255);
+    }
+    return WiFiClass::clients[clientSocketIndex];
+}
+
+//--tested, working--//
+WiFiClient WiFiServer::available(byte* status)
+{
+    if (WiFiClass::getSocket() == NO_SOCKET_AVAIL) {
+        return WiFiClient(255);
     }
+    acceptClient();
 
     //
     //Now loop through the connected clients
@@ -202,7 +226,10 @@ size_t WiFiServer::write(const uint8_t *buffer, size_t size)
             //the number of bytes send
             //
             int handle = WiFiClass::_handleArray[i];
-            sentBytes += sl_Send(handle, buffer, size, 0);
+            RtosTrace.event(RTOSTRACE_SOCKET_BEGIN, "sl_Send", handle);
+            int iRet = sl_Send(handle, buffer, size, 0);
+            RtosTrace.event(RTOSTRACE_SOCKET_END, "sl_Send", iRet);
+            sentBytes += iRet;
         }
     }
     return sentBytes;
@@ -36,9 +36,15 @@ private:
     uint16_t _port;
     int _socketIndex;
     int8_t _lastServicedClient;
+    int acceptClient();
 public:
     WiFiServer(uint16_t);
     WiFiClient available(uint8_t* status = NULL);
+    //
+    //Only a client connected since the last call, or a false one; for
+    //servers that keep their own list of clients
+    //
+    WiFiClient accept();
     void begin();
     virtual size_t write(uint8_t);
     size_t write(const uint8_t *buffer, size_t size);
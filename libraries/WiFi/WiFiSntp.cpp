@@ -0,0 +1,268 @@
+/*
+ WiFiSntp.cpp - SNTP client keeping SysTime on UTC
+
+ This library is free software; you can redistribute it and/or
+ modify it under the terms of the GNU Lesser General Public
+ License as published by the Free Software Foundation; either
+ version 2.1 of the License, or (at your option) any later version.
+
+ This library is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ Lesser General Public License for more details.
+
+ You should have received a copy of the GNU Lesser General Public
+ License along with this library; if not, write to the Free Software
+ Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#include "WiFi.h"
+#include "WiFiSntp.h"
+
+#include <string.h>
+#include <time.h>
+
+//
+//NTP time is seconds since 1900 with a 32 bit binary fraction; this many
+//seconds separate 1900 from 1970
+//
+#define NTP_UNIX_OFFSET 2208988800UL
+
+static void toNtp(uint64_t us, uint8_t* p)
+{
+    uint64_t secs = us / 1000000 + NTP_UNIX_OFFSET;
+    uint32_t frac = (uint32_t)((((us % 1000000) << 32)) / 1000000);
+
+    p[0] = secs >> 24; p[1] = secs >> 16; p[2] = secs >> 8; p[3] = secs;
+    p[4] = frac >> 24; p[5] = frac >> 16; p[6] = frac >> 8; p[7] = frac;
+}
+
+static uint64_t fromNtp(const uint8_t* p)
+{
+    uint32_t secs = ((uint32_t)p[0] << 24) | ((uint32_t)p[1] << 16) | ((uint32_t)p[2] << 8) | p[3];
+    uint32_t frac = ((uint32_t)p[4] << 24) | ((uint32_t)p[5] << 16) | ((uint32_t)p[6] << 8) | p[7];
+    uint64_t unixSecs = secs - NTP_UNIX_OFFSET;
+
+    //
+    //from 2036 the seconds wrap into the next NTP era
+    //
+    if (secs < NTP_UNIX_OFFSET) {
+        unixSecs += 0x100000000ULL;
+    }
+    return unixSecs * 1000000 + (((uint64_t)frac * 1000000 + 0x80000000UL) >> 32);
+}
+
+WiFiSNTP::WiFiSNTP()
+{
+    _server[0] = 0;
+    _started = false;
+    _state = SNTP_IDLE;
+    _poll = SNTP_POLL_S * 1000UL;
+    _wait = 0;
+    _since = 0;
+    _t1 = 0;
+    _offset = 0;
+    _delay = 0;
+    _lastSync = 0;
+}
+
+bool WiFiSNTP::begin(const char* server, unsigned long pollSeconds)
+{
+    if (strlen(server) >= sizeof(_server)) {
+        return false;
+    }
+    strcpy(_server, server);
+    _poll = pollSeconds * 1000UL;
+    _ip = INADDR_NONE;
+    _state = SNTP_IDLE;
+    _wait = 0;
+    _since = millis();
+
+    if (!_started) {
+        if (!_udp.begin(SNTP_LOCAL_PORT)) {
+            return false;
+        }
+        _started = true;
+    }
+    return true;
+}
+
+void WiFiSNTP::end()
+{
+    if (_started) {
+        _udp.stop();
+        _started = false;
+    }
+}
+
+void WiFiSNTP::retry(unsigned long seconds)
+{
+    _state = SNTP_IDLE;
+    _wait = seconds * 1000UL;
+    _since = millis();
+}
+
+int WiFiSNTP::send()
+{
+    uint8_t packet[SNTP_PACKET_SIZE];
+
+    //
+    //version 4, client mode; the transmit timestamp is the only other field
+    //a client fills in, and the server echoes it as the originate timestamp
+    //
+    memset(packet, 0, sizeof(packet));
+    packet[0] = (4 << 3) | 3;
+
+    if (!_udp.beginPacket(_ip, SNTP_PORT)) {
+        return SNTP_NO_SERVER;
+    }
+    _t1 = SysTime.utcMicros();
+    toNtp(_t1, &packet[40]);
+    memcpy(_sent, &packet[40], sizeof(_sent));
+    _udp.write(packet, sizeof(packet));
+    if (!_udp.endPacket()) {
+        return SNTP_NO_SERVER;
+    }
+
+    _state = SNTP_WAITING;
+    _since = millis();
+    return 0;
+}
+
+int WiFiSNTP::receive()
+{
+    uint8_t packet[SNTP_PACKET_SIZE];
+    uint64_t t4;
+    int64_t t2, t3, rtt;
+
+    if (_udp.parsePacket() <= 0) {
+        return 0;
+    }
+    t4 = SysTime.utcMicros();
+    if (_udp.read(packet, sizeof(packet)) != SNTP_PACKET_SIZE ||
+        _udp.remotePort() != SNTP_PORT) {
+        return 0;       // not for us, keep waiting
+    }
+    if (memcmp(&packet[24], _sent, sizeof(_sent)) != 0) {
+        return 0;       // a late answer to an earlier request
+    }
+
+    //
+    //server mode, and a stratum 0 reply is a kiss-o'-death asking us to
+    //back off; leap indicator 3 means the server's clock isn't set
+    //
+    if ((packet[0] & 7) != 4 || (packet[0] >> 6) == 3) {
+        return SNTP_BAD_REPLY;
+    }
+    if (packet[1] == 0) {
+        return SNTP_NO_REPLY;
+    }
+
+    t2 = (int64_t)fromNtp(&packet[32]);
+    t3 = (int64_t)fromNtp(&packet[40]);
+    rtt = ((int64_t)t4 - (int64_t)_t1) - (t3 - t2);
+    if (rtt < 0 || rtt > SNTP_MAX_DELAY_US) {
+        return SNTP_BAD_REPLY;
+    }
+    _offset = ((t2 - (int64_t)_t1) + (t3 - (int64_t)t4)) / 2;
+    _delay = (uint32_t)rtt;
+    _lastSync = millis();
+    if (_lastSync == 0) {
+        _lastSync = 1;
+    }
+
+    //
+    //a step also sets the network processor's clock, which checks the
+    //dates of SSL certificates
+    //
+    if (SysTime.adjust(_offset) == SYSTIME_STEPPED) {
+        time_t now = SysTime.utc();
+        struct tm tm;
+
+        gmtime_r(&now, &tm);
+        WiFi.setDateTime(tm.tm_mon + 1, tm.tm_mday, tm.tm_year + 1900, tm.tm_hour, tm.tm_min, tm.tm_sec);
+    }
+    return 1;
+}
+
+int WiFiSNTP::update()
+{
+    int rc = 0;
+
+    if (!_started || WiFi.status() != WL_CONNECTED) {
+        return 0;
+    }
+
+    switch (_state) {
+    case SNTP_IDLE:
+        if (millis() - _since < _wait) {
+            break;
+        }
+        if (_ip == INADDR_NONE) {
+            _lookup = WiFi.resolve(_server);
+            if (!_lookup.valid()) {
+                retry(SNTP_RETRY_S);
+                return SNTP_NO_SERVER;
+            }
+            _state = SNTP_RESOLVING;
+            _since = millis();
+            break;
+        }
+        rc = send();
+        break;
+
+    case SNTP_RESOLVING:
+        rc = WiFi.lookupResult(_lookup, _ip);
+        if (rc == WIFI_DNS_PENDING) {
+            break;
+        }
+        if (rc != 1) {
+            _ip = INADDR_NONE;
+            rc = SNTP_NO_SERVER;
+            break;
+        }
+        rc = send();
+        break;
+
+    case SNTP_WAITING:
+        rc = receive();
+        if (rc == 0 && millis() - _since >= SNTP_TIMEOUT_MS) {
+            rc = SNTP_NO_REPLY;
+        }
+        break;
+    }
+
+    if (rc == 1) {
+        retry(_poll / 1000);
+    }
+    else if (rc < 0) {
+        //
+        //a pool name may give a better server next time
+        //
+        _ip = INADDR_NONE;
+        retry(SNTP_RETRY_S);
+    }
+    return rc;
+}
+
+bool WiFiSNTP::sync(unsigned long timeout)
+{
+    unsigned long start = millis();
+
+    if (_state == SNTP_IDLE) {
+        _wait = 0;
+    }
+    while (millis() - start < timeout) {
+        int rc = update();
+        if (rc == 1) {
+            return true;
+        }
+        if (rc < 0) {
+            _wait = 0;      // try again at once, while there is time
+        }
+        if (_state != SNTP_WAITING) {
+            delay(10);      // parsePacket() waits, the other states don't
+        }
+    }
+    return false;
+}
@@ -0,0 +1,91 @@
+/*
+ WiFiSntp.h - SNTP client keeping SysTime on UTC
+
+ This library is free software; you can redistribute it and/or
+ modify it under the terms of the GNU Lesser General Public
+ License as published by the Free Software Foundation; either
+ version 2.1 of the License, or (at your option) any later version.
+
+ This library is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ Lesser General Public License for more details.
+
+ You should have received a copy of the GNU Lesser General Public
+ License along with this library; if not, write to the Free Software
+ Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#ifndef wifisntp_h
+#define wifisntp_h
+
+#include "WiFi.h"
+#include <ti/runtime/wiring/SysTime.h>
+
+#define SNTP_PORT           123
+#define SNTP_LOCAL_PORT     2123
+#define SNTP_POLL_S         64      // between exchanges once the clock is set
+#define SNTP_RETRY_S        8       // after a lost reply or a failed lookup
+#define SNTP_TIMEOUT_MS     2000    // for a reply
+#define SNTP_MAX_DELAY_US   500000  // a reply that took longer says little about the time
+#define SNTP_PACKET_SIZE    48
+
+//
+//Status of update() besides 0 (nothing new) and 1 (SysTime adjusted)
+//
+#define SNTP_NO_REPLY       -1      // timed out, or refused with a kiss-o'-death
+#define SNTP_BAD_REPLY      -2      // not an answer to our request, or from an unsynchronised server
+#define SNTP_NO_SERVER      -3      // the lookup or the send failed
+
+//
+//Polls an NTP server and hands each offset it measures to SysTime.adjust(),
+//which steps the clock the first time and slews it after that.
+//
+//update() never blocks for more than about 10 ms: call it from loop(), and
+//it resolves the server in the background, sends a request when one is due
+//and takes the reply once it is there. sync() waits for one exchange.
+//
+class WiFiSNTP {
+public:
+    WiFiSNTP();
+
+    //
+    //server is copied; pollSeconds is the interval once the clock is set
+    //
+    bool begin(const char* server = "pool.ntp.org", unsigned long pollSeconds = SNTP_POLL_S);
+    void end();
+
+    int update();
+    //an exchange now, waiting up to timeout ms; true once SysTime was adjusted
+    bool sync(unsigned long timeout = 5000);
+
+    //from the last good exchange, microseconds
+    int64_t offset() { return _offset; }
+    uint32_t roundTrip() { return _delay; }
+    //millis() at the last good exchange, 0 before the first
+    unsigned long lastSync() { return _lastSync; }
+
+private:
+    enum { SNTP_IDLE, SNTP_RESOLVING, SNTP_WAITING };
+
+    int send();
+    int receive();
+    void retry(unsigned long seconds);
+
+    WiFiUDP _udp;
+    char _server[WIFI_DNS_HOST_MAX];
+    WiFiLookup _lookup;
+    IPAddress _ip;
+    bool _started;
+    uint8_t _state;
+    unsigned long _poll;        // ms
+    unsigned long _wait;        // ms from _since to the next exchange
+    unsigned long _since;       // millis() at the last state change
+    uint8_t _sent[8];           // transmit timestamp of the request, as the reply echoes it
+    uint64_t _t1;               // SysTime.utcMicros() when the request went out
+    int64_t _offset;
+    uint32_t _delay;
+    unsigned long _lastSync;
+};
+
+#endif
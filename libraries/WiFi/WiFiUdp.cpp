@@ -19,15 +19,19 @@
 
 #include "WiFi.h"
 #include "WiFiUdp.h"
+#include <ti/runtime/wiring/RtosTrace.h>
 
 //--tested, working--//
 WiFiUDP::WiFiUDP()
 {
     //
-    //fill the buffers with zeroes
+    //no buffers until there is a packet to build or read
     //
-    memset(rx_buf, 0, UDP_RX_PACKET_MAX_SIZE);
-    memset(tx_buf, 0, UDP_TX_PACKET_MAX_SIZE);
+    rx_buf = NULL;
+    tx_buf = NULL;
+    rx_size = 0;
+    tx_size = 0;
+    bufferSize = 0;
     rx_currentIndex = 0;
     rx_fillLevel = 0;
     tx_fillLevel = 0;
@@ -36,6 +40,23 @@ WiFiUDP::WiFiUDP()
     _socketIndex = NO_SOCKET_AVAIL;
 }
 
+WiFiUDP::~WiFiUDP()
+{
+    //
+    //give the buffers back, the socket is left as it is
+    //
+    NetBuffers.release(rx_buf);
+    NetBuffers.release(tx_buf);
+}
+
+void WiFiUDP::setBufferSize(size_t size)
+{
+    //
+    //takes effect the next time a buffer is taken from the pool
+    //
+    bufferSize = size;
+}
+
 //--tested, working--//
 uint8_t WiFiUDP::begin(uint16_t port)
 {
@@ -109,6 +130,9 @@ void WiFiUDP::stop()
     //close the socket and reset any important variables
     //
     flush();
+    NetBuffers.release(tx_buf);
+    tx_buf = NULL;
+    tx_fillLevel = 0;
     sl_Close(WiFiClass::_handleArray[_socketIndex]);
     WiFiClass::_handleArray[_socketIndex] = -1;
     WiFiClass::_portArray[_socketIndex] = -1;
@@ -153,9 +177,16 @@ int WiFiUDP::beginPacket(IPAddress ip, uint16_t port)
     _sendPort = port;
     
     //
-    //reset all tx buffer indicators
+    //take a tx buffer, or keep the one of a packet never sent, and reset
+    //all tx buffer indicators
     //
-    memset(tx_buf, 0, UDP_TX_PACKET_MAX_SIZE);
+    if (tx_buf == NULL) {
+        tx_size = bufferSize ? bufferSize : NetBuffers.blockSize();
+        tx_buf = (uint8_t*)NetBuffers.acquire(tx_size);
+        if (tx_buf == NULL) {
+            return 0;
+        }
+    }
     tx_fillLevel = 0;
     
     return 1;
@@ -168,7 +199,7 @@ int WiFiUDP::endPacket()
     //
     //only do the rest of this function if a socket actually exists
     //
-    if (_socketIndex == NO_SOCKET_AVAIL) {
+    if (_socketIndex == NO_SOCKET_AVAIL || tx_buf == NULL) {
         return 0;
     }
 
@@ -185,17 +216,18 @@ int WiFiUDP::endPacket()
     //use the simplelink library to send the tx buffer
     //
     int socketHandle = WiFiClass::_handleArray[_socketIndex];
+    RtosTrace.event(RTOSTRACE_SOCKET_BEGIN, "sl_SendTo", socketHandle);
     int iRet = sl_SendTo(socketHandle, tx_buf, tx_fillLevel, 0, (SlSockAddr_t*)&sendAddress, sizeof(SlSockAddrIn_t));
-    if (iRet < 0) {
-        return 0;
-    }
+    RtosTrace.event(RTOSTRACE_SOCKET_END, "sl_SendTo", iRet);
     
     //
-    //reset all tx buffer indicators
+    //give the tx buffer back and reset all tx buffer indicators, the
+    //packet is gone either way
     //
-    memset(tx_buf, 0, UDP_TX_PACKET_MAX_SIZE);
+    NetBuffers.release(tx_buf);
+    tx_buf = NULL;
     tx_fillLevel = 0;
-    return 1;
+    return iRet < 0 ? 0 : 1;
 }
 
 //--tested, working--//
@@ -219,12 +251,19 @@ size_t WiFiUDP::write(uint8_t byte)
 //--tested, working--//
 size_t WiFiUDP::write(const uint8_t *buffer, size_t size)
 {
+    //
+    //nothing to write into unless beginPacket() succeeded
+    //
+    if (tx_buf == NULL) {
+        return 0;
+    }
+
     //
     //it's possible that size is more than can fit in the tx_buffer
     //so check it and make it smaller if necessary
     //
-    if (tx_fillLevel + size > UDP_TX_PACKET_MAX_SIZE) {
-        size = UDP_TX_PACKET_MAX_SIZE - tx_fillLevel;
+    if (tx_fillLevel + size > tx_size) {
+        size = tx_size - tx_fillLevel;
     }
     
     //
@@ -250,37 +289,29 @@ int WiFiUDP::parsePacket()
         return 0;
     }
 
-    // TODO: sl_Select can't be called by separate threads EVEN if they
-    // reference different sockets, so it's necessary to serialize access to
-    // sl_Select().  One way is to
-    //     o create a "select mutex" in WiFiUDP(),
-    //     o "wrap" all calls to sl_Select with this mutex, and
-    //     o use a sl_Select timeout of zero (rather than 10000) so
-    //       sl_Select never blocks, and delays on one socket don't interfere
-    //       with another socket's operation
+    //
+    //whatever is left of the previous packet is dropped
+    //
+    flush();
 
     //
-    //the sl_select command blocks until something interesting happens or
-    //it times out (current timeout set for 10 ms, the minimum)
+    //wait up to 10 ms for a packet, sharing sl_Select() with the other
+    //sockets
     //
-    SlTimeval_t timeout;
-    timeout.tv_sec = 0;
-    timeout.tv_usec = 10000;  /* why not == 0 ? */
-    
     int socketHandle = WiFiClass::_handleArray[_socketIndex];
-    
-    SlFdSet_t readSocketHandles, errorSocketHandles;
-    SL_FD_ZERO(&readSocketHandles);
-    SL_FD_ZERO(&errorSocketHandles);
-    SL_FD_SET(socketHandle, &readSocketHandles);
-    SL_FD_SET(socketHandle, &errorSocketHandles);
-    
-    int iRet = sl_Select(socketHandle+1, &readSocketHandles, NULL, &errorSocketHandles, &timeout);
-    if (iRet <= 0) {
+    if (!WiFiClass::selectReadable(socketHandle, 0)) {
         return 0; /* do nothing if timeout expires or select fails */
     }
 
-    /* otherwise, iRet == 1, no point in calling SL_FD_ISSET() */
+    //
+    //a packet is waiting, so take a buffer for it. If the pool is out of
+    //buffers the packet stays queued for the next call
+    //
+    rx_size = bufferSize ? bufferSize : NetBuffers.blockSize();
+    rx_buf = (uint8_t*)NetBuffers.acquire(rx_size);
+    if (rx_buf == NULL) {
+        return 0;
+    }
 
     //
     //Since we've reached this point, the sl_select command has indicated
@@ -288,7 +319,9 @@ int WiFiUDP::parsePacket()
     //
     SlSockAddrIn_t  address = {0};
     int AddrSize = sizeof(address);
-    int bytes = sl_RecvFrom(socketHandle, rx_buf, UDP_RX_PACKET_MAX_SIZE, 0, (SlSockAddr_t*)&address, (SlSocklen_t*)&AddrSize);
+    RtosTrace.event(RTOSTRACE_SOCKET_BEGIN, "sl_RecvFrom", socketHandle);
+    int bytes = sl_RecvFrom(socketHandle, rx_buf, rx_size, 0, (SlSockAddr_t*)&address, (SlSocklen_t*)&AddrSize);
+    RtosTrace.event(RTOSTRACE_SOCKET_END, "sl_RecvFrom", bytes);
 
     //
     //store the sender's address (sl_HtonX reorders bits to processor order)
@@ -302,8 +335,8 @@ int WiFiUDP::parsePacket()
     //If an error occured, return 0, otherwise return the byte length of the packet
     //and reset the buffer index counter and fill level variables
     //
-    if (bytes < 0) {
-        rx_fillLevel = 0;
+    if (bytes <= 0) {
+        flush();
         return 0;
     } else {
         rx_currentIndex = 0;
@@ -323,9 +356,14 @@ int WiFiUDP::read()
     }
     
     //
-    //return the byte at the current index and increment that index
+    //return the byte at the current index and increment that index,
+    //giving the buffer back after the last byte
     //
-    return rx_buf[rx_currentIndex++];
+    int b = rx_buf[rx_currentIndex++];
+    if (rx_currentIndex >= rx_fillLevel) {
+        flush();
+    }
+    return b;
 }
 
 //--tested, working--//
@@ -344,6 +382,9 @@ int WiFiUDP::read(unsigned char* buffer, size_t size)
     }
     memcpy(buffer, &rx_buf[rx_currentIndex], len);
     rx_currentIndex += len;
+    if (rx_currentIndex >= rx_fillLevel) {
+        flush();
+    }
 
     return len;
 }
@@ -364,9 +405,11 @@ int WiFiUDP::peek()
 void WiFiUDP::flush()
 {
     //
-    //destroy the remaining data in the buffer and reset index and length variables
+    //drop the remaining data, give the buffer back and reset index and
+    //length variables
     //
-    memset(rx_buf, 0, UDP_RX_PACKET_MAX_SIZE);
+    NetBuffers.release(rx_buf);
+    rx_buf = NULL;
     rx_currentIndex = 0;
     rx_fillLevel = 0;
 }
@@ -22,12 +22,13 @@
 
 #include "WiFi.h"
 #include <ti/runtime/wiring/Stream.h>
+#include <ti/runtime/wiring/NetBuffers.h>
 
 //!!definitions from CC3000 library. Make sure these are right !!//
 #define MAX_SENDTO_SIZE 95
 #define MAX_RECVFROM_SIZE 95
-#define UDP_TX_PACKET_MAX_SIZE 255
-#define UDP_RX_PACKET_MAX_SIZE 255
+#define UDP_TX_PACKET_MAX_SIZE 255  // no longer used, see setBufferSize()
+#define UDP_RX_PACKET_MAX_SIZE 255  // no longer used, see setBufferSize()
 #define NO_SOCKET_AVAIL 255
 
 //
@@ -37,8 +38,11 @@
 class WiFiUDP : public Stream {
 private:
     uint8_t _socketIndex;  // socket # in WiFiClass
-    uint8_t rx_buf[UDP_RX_PACKET_MAX_SIZE];
-    uint8_t tx_buf[UDP_TX_PACKET_MAX_SIZE];
+    uint8_t* rx_buf;    // from the NetBuffers pool while a packet is unread
+    uint8_t* tx_buf;    // from the pool between beginPacket() and endPacket()
+    size_t rx_size;
+    size_t tx_size;
+    size_t bufferSize;  // setBufferSize(), 0 for a pool block
     unsigned int rx_currentIndex;   //for the read command, a pointer to the last read byte
     unsigned int rx_fillLevel;  //the number of bytes of new data in the buffer
     uint32_t _remoteIP; //maintained by parse method
@@ -46,9 +50,14 @@ private:
     unsigned int tx_fillLevel;
     uint32_t _sendIP; // used by all the write/send methods
     uint16_t _sendPort; //used by all the write/send methods
+
+    // not copyable: a copy would give the buffers back to the pool twice
+    WiFiUDP(const WiFiUDP&);
+    WiFiUDP& operator=(const WiFiUDP&);
     
 public:
     WiFiUDP();  // Constructor
+    ~WiFiUDP();
     uint8_t begin(uint16_t);	// initialize, start listening on specified port. Returns 1 if successful, 0 if there are no sockets available to use
     void stop();  // Finish with the UDP socket
     
@@ -87,6 +96,12 @@ public:
     int peek();
     void flush();	// Finish reading the current packet
     
+    // Size of the receive and transmit buffers, taken from the NetBuffers
+    // pool only while a packet is built or read. 0, the default, asks for a
+    // pool block; a larger size is taken from the heap. Packets longer than
+    // the receive buffer are truncated.
+    void setBufferSize(size_t size);
+
     // Return the IP address of the host who sent the current incoming packet
     IPAddress remoteIP();
     // Return the port of the host who sent the current incoming packet
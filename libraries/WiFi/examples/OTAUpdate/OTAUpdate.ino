@@ -0,0 +1,89 @@
+/* OTAUpdate.ino
+ *
+ * Downloads a file over HTTP into the Serial Flash and checks it against
+ * its SHA-256 digest before it replaces the previous copy.
+ *
+ * The file is written as it arrives, so images larger than the RAM of
+ * the board can be fetched. If the connection drops, the download
+ * carries on where it stopped. The old file is only replaced once the
+ * whole new one has arrived and its digest matches; until then a reset
+ * or a failed download leaves the old file untouched.
+ *
+ * Put the image on any web server and compute its digest with
+ *   sha256sum image.bin
+ *
+ * Complexity: medium
+ */
+
+#ifndef __CC3200R1M1RGC__
+// Do not include SPI for CC3200 LaunchPad
+#include <SPI.h>
+#endif
+#include <WiFi.h>
+#include <SLFS.h>
+#include <OTAUpdate.h>
+
+// your network name also called SSID
+char ssid[] = "energia";
+// your network password
+char password[] = "launchpad";
+
+char server[] = "192.168.1.10";
+char path[] = "/firmware/image.bin";
+char digest[] = "e3b0c44298fc1c149afbf4c8996fb92427ae41e4649b934ca495991b7852b855";
+char filename[] = "/storage/image.bin";
+
+WiFiClient client;
+OTAUpdate ota(client);
+
+void setup() {
+  Serial.begin(115200);
+
+  Serial.print("Attempting to connect to Network named: ");
+  Serial.println(ssid);
+  WiFi.begin(ssid, password);
+  while (WiFi.status() != WL_CONNECTED) {
+    Serial.print(".");
+    delay(300);
+  }
+  while (WiFi.localIP() == INADDR_NONE) {
+    Serial.print(".");
+    delay(300);
+  }
+  Serial.println("\nConnected");
+
+  SerFlash.begin();
+
+  Serial.print("Downloading ");
+  Serial.print(path);
+  Serial.print(" into ");
+  Serial.println(filename);
+
+  int rc = ota.update(server, 80, path, filename, digest);
+
+  Serial.print("Received ");
+  Serial.print(ota.received());
+  Serial.print(" of ");
+  Serial.print(ota.size());
+  Serial.println(" bytes");
+
+  switch (rc) {
+    case OTA_OK:
+      Serial.println("Image verified and stored");
+      break;
+    case OTA_ERROR_HTTP:
+      Serial.print("Server answered with status ");
+      Serial.println(ota.httpStatus());
+      break;
+    case OTA_ERROR_DIGEST:
+      Serial.println("Image does not match its digest, previous file kept");
+      break;
+    default:
+      Serial.print("Update failed with error ");
+      Serial.println(rc);
+      break;
+  }
+}
+
+void loop() {
+}
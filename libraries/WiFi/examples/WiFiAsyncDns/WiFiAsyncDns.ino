@@ -0,0 +1,89 @@
+/* WiFiAsyncDns.ino
+ *
+ * Resolves the names of four servers at once, in the background, and
+ * connects to each as soon as its address is known.
+ *
+ * WiFi.resolve() returns at once; the lookups overlap with each other
+ * and with whatever the sketch does meanwhile. client.connect() takes
+ * the lookup and waits only for what is left of it. The time for all
+ * four is printed next to the time the same lookups take one by one
+ * with WiFi.hostByName().
+ *
+ * Complexity: medium
+ */
+
+#ifndef __CC3200R1M1RGC__
+// Do not include SPI for CC3200 LaunchPad
+#include <SPI.h>
+#endif
+#include <WiFi.h>
+
+// your network name also called SSID
+char ssid[] = "energia";
+// your network password
+char password[] = "launchpad";
+
+#define SERVERS 4
+
+const char *servers[SERVERS] = {
+  "www.energia.nu", "www.ti.com", "api-m2x.att.com", "pubsub.pubnub.com"
+};
+
+// called from a DNS task, keep it short
+void resolved(WiFiLookup lookup, int status, IPAddress ip, void *arg) {
+  Serial.print("  resolved ");
+  Serial.print((const char *)arg);
+  Serial.print(": ");
+  if (status == 1) {
+    Serial.println(ip);
+  } else {
+    Serial.print("error ");
+    Serial.println(status);
+  }
+}
+
+void setup() {
+  Serial.begin(115200);
+
+  Serial.print("Attempting to connect to Network named: ");
+  Serial.println(ssid);
+  WiFi.begin(ssid, password);
+  while (WiFi.status() != WL_CONNECTED || WiFi.localIP() == INADDR_NONE) {
+    Serial.print(".");
+    delay(300);
+  }
+  Serial.println("\nConnected");
+}
+
+void loop() {
+  WiFiLookup lookups[SERVERS];
+  WiFiClient client;
+  IPAddress ip;
+
+  // one after the other
+  unsigned long start = millis();
+  for (int i = 0; i < SERVERS; i++) {
+    WiFi.hostByName((char *)servers[i], ip);
+  }
+  Serial.print("hostByName() x 4: ");
+  Serial.print(millis() - start);
+  Serial.println(" ms");
+
+  // all at once
+  start = millis();
+  for (int i = 0; i < SERVERS; i++) {
+    lookups[i] = WiFi.resolve(servers[i], resolved, (void *)servers[i]);
+  }
+  for (int i = 0; i < SERVERS; i++) {
+    if (client.connect(lookups[i], 80)) {
+      Serial.print("  connected to ");
+      Serial.println(servers[i]);
+      client.stop();
+    }
+  }
+  Serial.print("resolve() and connect() x 4: ");
+  Serial.print(millis() - start);
+  Serial.println(" ms");
+
+  delay(10000);
+}
@@ -0,0 +1,104 @@
+/* WiFiBufferStats.ino
+ *
+ * Sizes the network buffer pool for the sketch and shows how it is used.
+ *
+ * WiFiClient, WiFiUDP, PubSubClient and aJson take their buffers from
+ * one pool, NetBuffers, and only while they hold data. The sketch asks
+ * for four 512 byte blocks instead of the default eight of 256, makes
+ * the client's receive buffer a whole block, then fetches a page and
+ * prints the pool statistics while the data is unread and again once
+ * it has all been read: the idle socket holds no buffer.
+ *
+ * Complexity: low
+ */
+
+#ifndef __CC3200R1M1RGC__
+// Do not include SPI for CC3200 LaunchPad
+#include <SPI.h>
+#endif
+#include <WiFi.h>
+
+// your network name also called SSID
+char ssid[] = "energia";
+// your network password
+char password[] = "launchpad";
+
+char server[] = "energia.nu";
+
+void printStats(const char *when) {
+  NetBufferStats stats;
+  NetBuffers.stats(stats);
+
+  Serial.print(when);
+  Serial.print(": ");
+  Serial.print(stats.inUse);
+  Serial.print(" of ");
+  Serial.print(stats.blocks);
+  Serial.print(" x ");
+  Serial.print(stats.blockSize);
+  Serial.print(" bytes in use, peak ");
+  Serial.print(stats.peak);
+  Serial.print(", ");
+  Serial.print(stats.heapInUse);
+  Serial.print(" from the heap, ");
+  Serial.print(stats.acquired);
+  Serial.print(" taken, ");
+  Serial.print(stats.failures);
+  Serial.println(" refused");
+}
+
+void setup() {
+  Serial.begin(115200);
+
+  // before anything takes a buffer, the pool can't be resized later
+  if (!NetBuffers.begin(512, 4)) {
+    Serial.println("No memory for the buffer pool");
+  }
+
+  Serial.print("Attempting to connect to Network named: ");
+  Serial.println(ssid);
+  WiFi.begin(ssid, password);
+  while (WiFi.status() != WL_CONNECTED || WiFi.localIP() == INADDR_NONE) {
+    Serial.print(".");
+    delay(300);
+  }
+  Serial.println("\nConnected");
+  printStats("idle");
+}
+
+void loop() {
+  WiFiClient client;
+  unsigned long bytes = 0;
+
+  client.setBufferSize(512);
+  if (!client.connect(server, 80)) {
+    Serial.println("connection failed");
+    delay(10000);
+    return;
+  }
+  client.println("GET /hello.html HTTP/1.1");
+  client.print("Host: ");
+  client.println(server);
+  client.println("Connection: close");
+  client.println();
+
+  while (!client.available() && client.connected()) {
+    delay(10);
+  }
+  printStats("data waiting");
+
+  while (client.connected()) {
+    while (client.available()) {
+      client.read();
+      bytes++;
+    }
+  }
+  client.stop();
+
+  Serial.print(bytes);
+  Serial.println(" bytes read");
+  printStats("all read");
+
+  NetBuffers.resetPeak();
+  delay(10000);
+}
@@ -0,0 +1,66 @@
+/* WiFiEarlyStart.ino
+ *
+ * Boots the network processor in the background while setup() does
+ * other work, then prints how long each boot phase took.
+ *
+ * WiFi.initAsync() returns at once. The network processor boots while
+ * the rest of setup() runs; WiFi.begin() only waits for whatever part
+ * of the boot is left.
+ *
+ * Complexity: low
+ */
+
+#ifndef __CC3200R1M1RGC__
+// Do not include SPI for CC3200 LaunchPad
+#include <SPI.h>
+#endif
+#include <WiFi.h>
+
+// your network name also called SSID
+char ssid[] = "energia";
+// your network password
+char password[] = "launchpad";
+
+const char *phases[WIFI_BOOT_PHASES] = {
+  "start", "driver open", "NWP started", "station role", "ready"
+};
+
+void setup() {
+  unsigned long setupStart = micros();
+
+  // start booting the network processor first
+  WiFi.initAsync();
+
+  Serial.begin(115200);
+
+  // stands in for sensor and display initialization
+  delay(200);
+  unsigned long setupDone = micros();
+
+  Serial.print("Attempting to connect to Network named: ");
+  Serial.println(ssid);
+  WiFi.begin(ssid, password);
+  while (WiFi.status() != WL_CONNECTED) {
+    Serial.print(".");
+    delay(300);
+  }
+  Serial.println("\nConnected");
+
+  Serial.print("setup() work took ");
+  Serial.print((setupDone - setupStart) / 1000);
+  Serial.println(" ms");
+
+  for (int i = 1; i < WIFI_BOOT_PHASES; i++) {
+    Serial.print(phases[i]);
+    Serial.print(" after ");
+    Serial.print((WiFi.bootTime(i) - WiFi.bootTime(WIFI_BOOT_START)) / 1000);
+    Serial.println(" ms");
+  }
+  Serial.print("WiFi.begin() waited ");
+  Serial.print(WiFi.bootTime(WIFI_BOOT_READY) > setupDone ?
+               (WiFi.bootTime(WIFI_BOOT_READY) - setupDone) / 1000 : 0);
+  Serial.println(" ms for the boot");
+}
+
+void loop() {
+}
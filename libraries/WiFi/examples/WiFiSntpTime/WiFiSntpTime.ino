@@ -0,0 +1,97 @@
+/* WiFiSntpTime.ino
+ *
+ * Keeps SysTime on UTC with an SNTP server and stamps batches of analog
+ * samples with it.
+ *
+ * The first reply steps the clock, later ones are slewed in and teach
+ * SysTime how fast or slow the crystal runs, so that the time stays
+ * good between the polls. SysTime.utcMicros() costs a few cycles, cheap
+ * enough to stamp every sample; micros() is the monotonic counterpart
+ * for measuring intervals. The sketch prints each batch's first stamp,
+ * the sample period it saw and what the last exchange measured.
+ *
+ * Complexity: medium
+ */
+
+#ifndef __CC3200R1M1RGC__
+// Do not include SPI for CC3200 LaunchPad
+#include <SPI.h>
+#endif
+#include <WiFi.h>
+#include <WiFiSntp.h>
+
+// your network name also called SSID
+char ssid[] = "energia";
+// your network password
+char password[] = "launchpad";
+
+#define SAMPLES 64
+
+WiFiSNTP sntp;
+
+uint16_t samples[SAMPLES];
+uint64_t stamps[SAMPLES];
+
+void printUtc(uint64_t us) {
+  uint32_t secs = us / 1000000;
+  uint32_t fraction = us % 1000000;
+
+  Serial.print((secs % 86400L) / 3600);
+  Serial.print(':');
+  if ((secs % 3600) / 60 < 10) Serial.print('0');
+  Serial.print((secs % 3600) / 60);
+  Serial.print(':');
+  if (secs % 60 < 10) Serial.print('0');
+  Serial.print(secs % 60);
+  Serial.print('.');
+  for (uint32_t digit = 100000; digit > 1 && fraction < digit; digit /= 10) {
+    Serial.print('0');
+  }
+  Serial.print(fraction);
+}
+
+void setup() {
+  Serial.begin(115200);
+
+  Serial.print("Attempting to connect to Network named: ");
+  Serial.println(ssid);
+  WiFi.begin(ssid, password);
+  while (WiFi.status() != WL_CONNECTED || WiFi.localIP() == INADDR_NONE) {
+    Serial.print(".");
+    delay(300);
+  }
+  Serial.println("\nConnected");
+
+  sntp.begin("pool.ntp.org");
+  while (!sntp.sync()) {
+    Serial.println("no answer from the time server yet");
+  }
+}
+
+void loop() {
+  // keeps polling the server in the background of the sketch's work
+  sntp.update();
+
+  for (int i = 0; i < SAMPLES; i++) {
+    stamps[i] = SysTime.utcMicros();
+    samples[i] = analogRead(A0);
+    delay(2);
+  }
+
+  SysTimeStats stats;
+  SysTime.stats(stats);
+
+  Serial.print("batch at ");
+  printUtc(stamps[0]);
+  Serial.print(" UTC, ");
+  Serial.print((uint32_t)(stamps[SAMPLES - 1] - stamps[0]) / (SAMPLES - 1));
+  Serial.print(" us per sample, offset ");
+  Serial.print((long)sntp.offset());
+  Serial.print(" us, round trip ");
+  Serial.print(sntp.roundTrip());
+  Serial.print(" us, crystal correction ");
+  Serial.print(stats.freqPpb);
+  Serial.println(" ppb");
+
+  delay(1000);
+}
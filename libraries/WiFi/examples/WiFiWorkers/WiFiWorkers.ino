@@ -0,0 +1,119 @@
+/*
+  WiFiWorkers
+
+  Hands the blocking calls, joining the network and fetching a page,
+  to the core's worker tasks, so loop() keeps blinking the LED and
+  reading the serial port meanwhile. Type c to cancel the fetch: a
+  queued one is dropped, a running one stops at its next read.
+
+  Every 5 seconds the workers' queue depth and latencies are printed.
+*/
+
+#ifndef __CC3200R1M1RGC__
+// Do not include SPI for CC3200 LaunchPad
+#include <SPI.h>
+#endif
+#include <WiFi.h>
+#include <ti/runtime/wiring/WorkerPool.h>
+
+// your network name also called SSID
+char ssid[] = "energia";
+// your network password
+char password[] = "supersecret";
+
+char server[] = "energia.nu";
+
+WorkerJob joining;
+WorkerJob fetching;
+volatile long pageBytes = 0;
+unsigned long lastReport = 0;
+bool ledOn = false;
+
+// runs in a worker: WiFi.begin() blocks until the network is joined
+int join(void *arg) {
+  WiFi.begin(ssid, password);
+  while (WiFi.localIP() == INADDR_NONE) {
+    delay(300);
+  }
+  return WiFi.status();
+}
+
+// runs in a worker: connects, sends the request and counts the reply
+int fetch(void *arg) {
+  WiFiClient client;
+  unsigned long start = millis();
+  long count = 0;
+
+  if (!client.connect(server, 80)) {
+    return -1;
+  }
+  client.println("GET / HTTP/1.1");
+  client.print("Host: ");
+  client.println(server);
+  client.println("Connection: close");
+  client.println();
+
+  while ((client.connected() || client.available()) && millis() - start < 10000) {
+    if (Workers.cancelling()) {
+      break;
+    }
+    if (client.read() >= 0) {
+      count++;
+    }
+  }
+  client.stop();
+  return count;
+}
+
+// called from the worker once the fetch has finished
+void fetched(WorkerJob job, int status, int result, void *arg) {
+  pageBytes = status == WORKER_DONE ? result : -1;
+}
+
+void setup() {
+  Serial.begin(115200);
+  pinMode(RED_LED, OUTPUT);
+
+  Serial.print("Joining ");
+  Serial.println(ssid);
+  joining = Workers.submit(join, NULL, WORKER_URGENT);
+}
+
+void loop() {
+  int result;
+
+  // the loop never blocks on the network
+  ledOn = !ledOn;
+  digitalWrite(RED_LED, ledOn);
+  delay(100);
+
+  if (joining.valid() && Workers.status(joining, &result) == WORKER_DONE) {
+    Serial.print("Joined, IP address ");
+    Serial.println(WiFi.localIP());
+    joining = WorkerJob();
+    fetching = Workers.submit(fetch, NULL, WORKER_BULK, fetched);
+  }
+
+  // the last fetch has finished, start the next one
+  if (pageBytes != 0) {
+    if (pageBytes > 0) {
+      Serial.print("Fetched ");
+      Serial.print(pageBytes);
+      Serial.println(" bytes");
+    }
+    else {
+      Serial.println("Fetch failed or cancelled");
+    }
+    pageBytes = 0;
+    fetching = Workers.submit(fetch, NULL, WORKER_BULK, fetched);
+  }
+
+  if (Serial.available() && Serial.read() == 'c') {
+    Serial.println(Workers.cancel(fetching) ? "Cancelled before it ran" : "Asked to stop");
+  }
+
+  if (millis() - lastReport >= 5000) {
+    lastReport = millis();
+    Workers.report(Serial);
+  }
+}
@@ -0,0 +1,512 @@
+/*
+ ota_host.cpp - checks OTAUpdate against a scripted HTTP server on a host
+
+ Runs OTAUpdate, HttpResponse and SLFS against a local server that
+ answers each connection as a script says: the whole image, part of it
+ and then a dropped connection, a 206 for a Range request, or an answer
+ that must be refused. WiFiClient is a stand-in over a host socket; the
+ file system and the hash engine are in ota_host_sl.cpp. From the
+ repository root:
+
+   W=cores/cc3200emt/ti/runtime/wiring L=libraries/WiFi
+   c++ -w -I. -Icores/cc3200emt -I$W -I$W/cc3200 -Isystem -Isystem/inc \
+       -Isystem/driverlib -I$L -DBOARD_CC3200_LAUNCHXL \
+       -Dxdc_target_types__=gnu/targets/arm/std.h -Dxdc_target_name__=M4F \
+       -Dxdc__nolocalstring=1 -DARDUINO=101 -D_SYS_SELECT_H -pthread \
+       -o ota_host $L/extras/ota_host.cpp $L/extras/ota_host_sl.cpp \
+       $L/OTAUpdate.cpp $L/HttpResponse.cpp $L/SLFS.cpp $W/PString.cpp \
+       $W/Print.cpp $W/PrintD.cpp $W/Stream.cpp $W/WString.cpp $W/itoa.c
+   ./ota_host
+
+ _SYS_SELECT_H keeps the host's select() out of the way of the one the
+ SimpleLink headers declare. delay() moves millis() on instead of
+ sleeping, so retries and timeouts cost no time.
+ */
+
+/* SLFS.h takes it from simplelink.h, which this file can't include */
+typedef signed long _i32;
+
+#include "OTAUpdate.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+
+#define IMAGE_FILE  "/ota/image.bin"
+#define IMAGE_SIZE  5000
+#define OLD_SIZE    3000
+#define CUT         2500        // body bytes before a dropped connection
+#define REPLIES     4
+
+/* in ota_host_sl.cpp */
+void flashErase(void);
+void flashPut(const char *name, const uint8_t *data, uint32_t len, uint32_t allocated);
+const uint8_t *flashGet(const char *name, uint32_t *len);
+void sha256(const uint8_t *data, size_t len, uint8_t *digest);
+
+static uint8_t image[IMAGE_SIZE];
+static uint8_t oldImage[OLD_SIZE];
+static char imageDigest[65];
+static int failures;
+
+extern "C" {
+
+static unsigned long skipped;
+
+unsigned long millis(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000 + ts.tv_nsec / 1000000 + skipped;
+}
+
+void delay(uint32_t milliseconds)
+{
+    skipped += milliseconds;
+    usleep(100);
+}
+
+}
+
+/*
+ * WiFiClient over a host socket; _socketIndex is the descriptor
+ */
+static uint8_t rx[1460];
+static boolean peerClosed;
+
+WiFiClient::WiFiClient()
+{
+    _socketIndex = -1;
+    rx_fillLevel = 0;
+    rx_currentIndex = 0;
+}
+
+WiFiClient::~WiFiClient()
+{
+    stop();
+}
+
+int WiFiClient::connect(IPAddress ip, uint16_t port)
+{
+    return 0;
+}
+
+int WiFiClient::connect(const char *host, uint16_t port)
+{
+    struct sockaddr_in addr;
+    int fd;
+
+    stop();
+    fd = socket(AF_INET, SOCK_STREAM, 0);
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(port);
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    if (::connect(fd, (struct sockaddr *)&addr, sizeof(addr)) != 0) {
+        close(fd);
+        return 0;
+    }
+    _socketIndex = fd;
+    return 1;
+}
+
+int WiFiClient::sslConnect(IPAddress ip, uint16_t port)
+{
+    return 0;
+}
+
+int WiFiClient::sslConnect(const char *host, uint16_t port)
+{
+    return 0;
+}
+
+size_t WiFiClient::write(uint8_t b)
+{
+    return write(&b, 1);
+}
+
+size_t WiFiClient::write(const uint8_t *buffer, size_t size)
+{
+    ssize_t sent;
+
+    if (_socketIndex < 0) {
+        return 0;
+    }
+    sent = send(_socketIndex, buffer, size, MSG_NOSIGNAL);
+    return sent < 0 ? 0 : sent;
+}
+
+/* OTAUpdate only receives: no space to hand out */
+int WiFiClient::writeBuffer(uint8_t **buffer)
+{
+    return -1;
+}
+
+void WiFiClient::commit(size_t size)
+{
+}
+
+int WiFiClient::available()
+{
+    ssize_t got;
+
+    if (_socketIndex < 0) {
+        return 0;
+    }
+    if (rx_currentIndex < rx_fillLevel) {
+        return rx_fillLevel - rx_currentIndex;
+    }
+    got = recv(_socketIndex, rx, sizeof(rx), MSG_DONTWAIT);
+    rx_currentIndex = 0;
+    rx_fillLevel = got > 0 ? got : 0;
+    if (got == 0) {
+        peerClosed = true;
+    }
+    return rx_fillLevel;
+}
+
+int WiFiClient::read()
+{
+    return available() ? rx[rx_currentIndex++] : -1;
+}
+
+int WiFiClient::read(uint8_t *buf, size_t size)
+{
+    int len = available();
+
+    if (len > (int)size) {
+        len = size;
+    }
+    memcpy(buf, rx + rx_currentIndex, len);
+    rx_currentIndex += len;
+    return len;
+}
+
+int WiFiClient::peek()
+{
+    return available() ? rx[rx_currentIndex] : -1;
+}
+
+int WiFiClient::peekBuffer(const uint8_t **buffer)
+{
+    int len = available();
+
+    *buffer = len ? rx + rx_currentIndex : NULL;
+    return len;
+}
+
+void WiFiClient::consume(size_t size)
+{
+    int len = rx_fillLevel - rx_currentIndex;
+
+    if (len <= 0) {
+        return;
+    }
+    if (size > (size_t)len) {
+        size = len;
+    }
+    rx_currentIndex += size;
+}
+
+void WiFiClient::flush()
+{
+    rx_currentIndex = rx_fillLevel;
+}
+
+void WiFiClient::stop()
+{
+    if (_socketIndex >= 0) {
+        close(_socketIndex);
+    }
+    _socketIndex = -1;
+    rx_fillLevel = 0;
+    rx_currentIndex = 0;
+    peerClosed = false;
+}
+
+uint8_t WiFiClient::connected()
+{
+    available();
+    return _socketIndex >= 0 && (!peerClosed || rx_currentIndex < rx_fillLevel);
+}
+
+WiFiClient::operator bool()
+{
+    return _socketIndex >= 0;
+}
+
+/*
+ * The server: one reply per connection, in the order of the script
+ */
+typedef struct {
+    int status;
+    long length;            // Content-Length, -1 for none
+    long from;              // first byte of the image sent
+    long cut;               // body bytes sent before the connection drops, -1 for all
+} Reply;
+
+static Reply script[REPLIES];
+static int replies;
+static char requests[REPLIES][256];
+static int listener;
+static uint16_t port;
+
+static void serve(int fd, const Reply *reply, char *request)
+{
+    char head[256];
+    size_t len = 0;
+    ssize_t got;
+    long body;
+
+    /* the request, up to the blank line */
+    while (len < 255 && (len < 4 || memcmp(request + len - 4, "\r\n\r\n", 4) != 0)) {
+        got = recv(fd, request + len, 255 - len, 0);
+        if (got <= 0) {
+            break;
+        }
+        len += got;
+    }
+    request[len] = 0;
+
+    body = reply->length >= 0 ? reply->length : IMAGE_SIZE - reply->from;
+    len = snprintf(head, sizeof(head), "HTTP/1.1 %d Scripted\r\n", reply->status);
+    if (reply->status == 206) {
+        len += snprintf(head + len, sizeof(head) - len, "Content-Range: bytes %ld-%ld/%d\r\n",
+                        reply->from, reply->from + body - 1, IMAGE_SIZE);
+    }
+    if (reply->length >= 0) {
+        len += snprintf(head + len, sizeof(head) - len, "Content-Length: %ld\r\n", reply->length);
+    }
+    len += snprintf(head + len, sizeof(head) - len, "Connection: close\r\n\r\n");
+    send(fd, head, len, MSG_NOSIGNAL);
+
+    if (reply->status == 200 || reply->status == 206) {
+        if (reply->cut >= 0 && reply->cut < body) {
+            body = reply->cut;
+        }
+        send(fd, image + reply->from, body, MSG_NOSIGNAL);
+    }
+    close(fd);
+}
+
+static void *server(void *arg)
+{
+    int i, fd;
+
+    for (i = 0; i < replies; i++) {
+        fd = accept(listener, NULL, NULL);
+        if (fd < 0) {
+            break;
+        }
+        serve(fd, &script[i], requests[i]);
+    }
+    return NULL;
+}
+
+static void startServer(void)
+{
+    struct sockaddr_in addr;
+    socklen_t len = sizeof(addr);
+
+    listener = socket(AF_INET, SOCK_STREAM, 0);
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    bind(listener, (struct sockaddr *)&addr, sizeof(addr));
+    listen(listener, REPLIES);
+    getsockname(listener, (struct sockaddr *)&addr, &len);
+    port = ntohs(addr.sin_port);
+}
+
+static void reply(int status, long length, long from, long cut)
+{
+    script[replies].status = status;
+    script[replies].length = length;
+    script[replies].from = from;
+    script[replies].cut = cut;
+    requests[replies][0] = 0;
+    replies++;
+}
+
+/*
+ * Runs an update against the replies scripted since the last one
+ */
+static int update(const char *digest, OTAUpdate **result)
+{
+    static WiFiClient client;
+    static OTAUpdate *ota;
+    pthread_t thread;
+    int rc;
+
+    delete ota;
+    ota = new OTAUpdate(client);
+    *result = ota;
+
+    startServer();
+    pthread_create(&thread, NULL, server, NULL);
+    rc = ota->update("localhost", port, "/image.bin", IMAGE_FILE, digest);
+
+    /* wakes the server if it still waits for a connection */
+    shutdown(listener, SHUT_RDWR);
+    pthread_join(thread, NULL);
+    close(listener);
+    replies = 0;
+    return rc;
+}
+
+static void expect(const char *what, bool ok)
+{
+    printf("%-56s %s\n", what, ok ? "ok" : "FAIL");
+    if (!ok) {
+        failures++;
+    }
+}
+
+static bool holds(const uint8_t *data, uint32_t size)
+{
+    uint32_t len;
+    const uint8_t *file = flashGet(IMAGE_FILE, &len);
+
+    return file != NULL && len == size && memcmp(file, data, size) == 0;
+}
+
+static void fresh(void)
+{
+    OTAUpdate *ota;
+
+    flashErase();
+    reply(200, IMAGE_SIZE, 0, -1);
+    expect("a new image is downloaded", update(imageDigest, &ota) == OTA_OK);
+    expect("...into a new file", holds(image, IMAGE_SIZE));
+    expect("...in one request without a Range", strstr(requests[0], "Range:") == NULL);
+}
+
+static void resume(void)
+{
+    OTAUpdate *ota;
+
+    flashPut(IMAGE_FILE, oldImage, OLD_SIZE, 8192);
+    reply(200, IMAGE_SIZE, 0, CUT);
+    reply(206, IMAGE_SIZE - 2048, 2048, -1);
+    expect("a dropped download resumes", update(imageDigest, &ota) == OTA_OK);
+    expect("...from the last whole block", strstr(requests[1], "Range: bytes=2048-\r\n") != NULL);
+    expect("...and replaces the old image", holds(image, IMAGE_SIZE));
+    expect("...with a 206", ota->httpStatus() == 206);
+}
+
+static void restart(void)
+{
+    OTAUpdate *ota;
+
+    flashPut(IMAGE_FILE, oldImage, OLD_SIZE, 8192);
+    reply(200, IMAGE_SIZE, 0, CUT);
+    reply(200, IMAGE_SIZE, 0, -1);
+    expect("a server ignoring Range restarts the download", update(imageDigest, &ota) == OTA_OK);
+    expect("...after asking for the rest", strstr(requests[1], "Range: bytes=2048-\r\n") != NULL);
+    expect("...and replaces the old image", holds(image, IMAGE_SIZE));
+}
+
+static void wrongRange(void)
+{
+    OTAUpdate *ota;
+
+    flashPut(IMAGE_FILE, oldImage, OLD_SIZE, 8192);
+    reply(200, IMAGE_SIZE, 0, CUT);
+    reply(206, IMAGE_SIZE - 1024, 1024, -1);
+    expect("a 206 from the wrong offset is refused", update(imageDigest, &ota) == OTA_ERROR_HTTP);
+    expect("...and the old image stays", holds(oldImage, OLD_SIZE));
+}
+
+static void lengthChange(void)
+{
+    OTAUpdate *ota;
+
+    flashPut(IMAGE_FILE, oldImage, OLD_SIZE, 8192);
+    reply(200, IMAGE_SIZE, 0, CUT);
+    reply(200, IMAGE_SIZE - 1000, 0, -1);
+    expect("an image that changes length is refused", update(imageDigest, &ota) == OTA_ERROR_SIZE);
+    expect("...and the old image stays", holds(oldImage, OLD_SIZE));
+}
+
+static void noLength(void)
+{
+    OTAUpdate *ota;
+    uint32_t len;
+
+    flashErase();
+    reply(200, -1, 0, -1);
+    expect("an image without Content-Length is refused", update(imageDigest, &ota) == OTA_ERROR_SIZE);
+    expect("...before a file is created", flashGet(IMAGE_FILE, &len) == NULL);
+}
+
+static void tooLarge(void)
+{
+    OTAUpdate *ota;
+
+    flashPut(IMAGE_FILE, oldImage, OLD_SIZE, 4096);
+    reply(200, IMAGE_SIZE, 0, -1);
+    expect("an image larger than the file is refused", update(imageDigest, &ota) == OTA_ERROR_SIZE);
+    expect("...and the old image stays", holds(oldImage, OLD_SIZE));
+}
+
+static void digestMismatch(void)
+{
+    OTAUpdate *ota;
+    char digest[65];
+
+    flashPut(IMAGE_FILE, oldImage, OLD_SIZE, 8192);
+    strcpy(digest, imageDigest);
+    digest[0] = digest[0] == '0' ? '1' : '0';
+    reply(200, IMAGE_SIZE, 0, -1);
+    expect("an image with another digest is refused", update(digest, &ota) == OTA_ERROR_DIGEST);
+    expect("...and the old image stays", holds(oldImage, OLD_SIZE));
+}
+
+static void notFound(void)
+{
+    OTAUpdate *ota;
+
+    flashPut(IMAGE_FILE, oldImage, OLD_SIZE, 8192);
+    reply(404, 0, 0, -1);
+    expect("a 404 is an HTTP error", update(imageDigest, &ota) == OTA_ERROR_HTTP);
+    expect("...with its status", ota->httpStatus() == 404);
+    expect("...and the old image stays", holds(oldImage, OLD_SIZE));
+}
+
+int main(void)
+{
+    uint8_t digest[32];
+    int i;
+
+    sha256((const uint8_t *)"abc", 3, digest);
+    expect("the stand-in hash engine computes SHA-256",
+           digest[0] == 0xba && digest[1] == 0x78 && digest[31] == 0xad);
+
+    srand(1);
+    for (i = 0; i < IMAGE_SIZE; i++) {
+        image[i] = rand();
+    }
+    memset(oldImage, 0x55, sizeof(oldImage));
+    sha256(image, IMAGE_SIZE, digest);
+    for (i = 0; i < 32; i++) {
+        sprintf(imageDigest + 2 * i, "%02x", digest[i]);
+    }
+
+    fresh();
+    resume();
+    restart();
+    wrongRange();
+    lengthChange();
+    noLength();
+    tooLarge();
+    digestMismatch();
+    notFound();
+
+    return (failures != 0);
+}
@@ -0,0 +1,434 @@
+/*
+ ota_host_sl.cpp - the SimpleLink file system and hash engine for ota_host
+
+ Stand-ins for what OTAUpdate and SLFS reach below the library: the
+ sl_Fs calls, backed by files in memory that keep fail-safe semantics
+ (an image written to a file only replaces the old one when it is
+ closed, an abort leaves the old one), and the SHA/MD5 engine, hashed
+ in software. The engine's status register is a page mapped at
+ SHAMD5_BASE, always ready. Built with ota_host.cpp, see there.
+
+ This library is free software; you can redistribute it and/or
+ modify it under the terms of the GNU Lesser General Public
+ License as published by the Free Software Foundation; either
+ version 2.1 of the License, or (at your option) any later version.
+
+ This library is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ Lesser General Public License for more details.
+
+ You should have received a copy of the GNU Lesser General Public
+ License along with this library; if not, write to the Free Software
+ Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+
+#include "WiFi.h"
+
+#include "inc/hw_memmap.h"
+#include "inc/hw_types.h"
+#include "inc/hw_shamd5.h"
+#include "driverlib/prcm.h"
+#include "driverlib/shamd5.h"
+
+#define FILES 4
+
+typedef struct {
+    char name[64];
+    boolean used;
+    boolean committed;      // has contents, from flashPut() or a close()
+    boolean open;
+    uint32_t allocated;
+    uint32_t len;
+    uint8_t *data;
+    uint32_t workLen;       // the contents being written while open
+    uint8_t *work;
+} FlashFile;
+
+static FlashFile files[FILES];
+
+static FlashFile *find(const _u8 *name)
+{
+    for (int i = 0; i < FILES; i++) {
+        if (files[i].used && strcmp(files[i].name, (const char *)name) == 0) {
+            return &files[i];
+        }
+    }
+    return NULL;
+}
+
+static FlashFile *handle(_i32 fileHandle)
+{
+    if (fileHandle < 1 || fileHandle > FILES || !files[fileHandle - 1].open) {
+        return NULL;
+    }
+    return &files[fileHandle - 1];
+}
+
+static void discard(FlashFile *f)
+{
+    free(f->data);
+    free(f->work);
+    memset(f, 0, sizeof(*f));
+}
+
+/* what the test sees and sets up */
+void flashErase(void)
+{
+    for (int i = 0; i < FILES; i++) {
+        discard(&files[i]);
+    }
+}
+
+void flashPut(const char *name, const uint8_t *data, uint32_t len, uint32_t allocated)
+{
+    FlashFile *f = find((const _u8 *)name);
+    int i;
+
+    for (i = 0; f == NULL && i < FILES; i++) {
+        if (!files[i].used) {
+            f = &files[i];
+        }
+    }
+    discard(f);
+    strncpy(f->name, name, sizeof(f->name) - 1);
+    f->used = true;
+    f->committed = true;
+    f->allocated = allocated;
+    f->len = len;
+    f->data = (uint8_t *)malloc(allocated);
+    memcpy(f->data, data, len);
+}
+
+const uint8_t *flashGet(const char *name, uint32_t *len)
+{
+    FlashFile *f = find((const _u8 *)name);
+
+    if (f == NULL || !f->committed) {
+        return NULL;
+    }
+    *len = f->len;
+    return f->data;
+}
+
+extern "C" {
+
+/* the granularity the driver picks: the smallest that holds the size in 255 units */
+static const uint32_t granularity[] = { 256, 1024, 4096, 16384, 65536 };
+
+_u32 _sl_GetCreateFsMode(_u32 maxSizeInBytes, _u32 accessFlags)
+{
+    _u32 gran, units = 0;
+
+    for (gran = 0; gran < _FS_MAX_MODE_SIZE_GRAN; gran++) {
+        units = (maxSizeInBytes + granularity[gran] - 1) / granularity[gran];
+        if (units <= MAX_MODE_SIZE) {
+            break;
+        }
+    }
+    return _FS_MODE(_FS_MODE_OPEN_CREATE, gran, units, accessFlags);
+}
+
+_i32 sl_FsOpen(const _u8 *pFileName, const _u32 AccessModeAndMaxSize, _u32 *pToken, _i32 *pFileHandle)
+{
+    _u32 access = (AccessModeAndMaxSize >> _FS_MODE_ACCESS_OFFSET) & _FS_MODE_ACCESS_MASK;
+    FlashFile *f = find(pFileName);
+    int i;
+
+    if (access == _FS_MODE_OPEN_CREATE) {
+        if (f != NULL) {
+            return SL_FS_ERR_FILE_MAX_SIZE_BIGGER_THAN_EXISTING_FILE;
+        }
+        for (i = 0; f == NULL && i < FILES; i++) {
+            if (!files[i].used) {
+                f = &files[i];
+            }
+        }
+        if (f == NULL) {
+            return SL_FS_ERR_NO_AVAILABLE_NV_INDEX;
+        }
+        strncpy(f->name, (const char *)pFileName, sizeof(f->name) - 1);
+        f->used = true;
+        f->allocated = (AccessModeAndMaxSize & _FS_MODE_OPEN_SIZE_MASK)
+            * granularity[(AccessModeAndMaxSize >> _FS_MODE_OPEN_SIZE_GRAN_OFFSET) & _FS_MODE_OPEN_SIZE_GRAN_MASK];
+    } else if (f == NULL || !f->committed) {
+        return SL_FS_ERR_FILE_NOT_EXISTS;
+    }
+    if (f->open) {
+        return SL_FS_ERR_INVALID_HANDLE;
+    }
+
+    f->open = true;
+    if (access != _FS_MODE_OPEN_READ) {
+        f->work = (uint8_t *)calloc(1, f->allocated);
+        f->workLen = 0;
+    }
+    *pFileHandle = f - files + 1;
+    return SL_FS_OK;
+}
+
+_i16 sl_FsClose(const _i32 FileHdl, const _u8 *pCeritificateFileName, const _u8 *pSignature, const _u32 SignatureLen)
+{
+    FlashFile *f = handle(FileHdl);
+
+    if (f == NULL) {
+        return SL_FS_ERR_INVALID_HANDLE;
+    }
+    f->open = false;
+    if (f->work == NULL) {
+        return SL_FS_OK;
+    }
+
+    if (pSignature != NULL && SignatureLen == 1 && pSignature[0] == 'A') {
+        /* aborted: the old contents stay, a new file goes */
+        free(f->work);
+        f->work = NULL;
+        if (!f->committed) {
+            discard(f);
+        }
+        return SL_FS_OK;
+    }
+
+    free(f->data);
+    f->data = f->work;
+    f->len = f->workLen;
+    f->work = NULL;
+    f->committed = true;
+    return SL_FS_OK;
+}
+
+_i32 sl_FsRead(const _i32 FileHdl, _u32 Offset, _u8 *pData, _u32 Len)
+{
+    FlashFile *f = handle(FileHdl);
+
+    if (f == NULL || f->work != NULL) {
+        return SL_FS_ERR_INVALID_HANDLE;
+    }
+    if (Offset >= f->len) {
+        return 0;
+    }
+    if (Len > f->len - Offset) {
+        Len = f->len - Offset;
+    }
+    memcpy(pData, f->data + Offset, Len);
+    return Len;
+}
+
+_i32 sl_FsWrite(const _i32 FileHdl, _u32 Offset, _u8 *pData, _u32 Len)
+{
+    FlashFile *f = handle(FileHdl);
+
+    if (f == NULL || f->work == NULL) {
+        return SL_FS_ERR_INVALID_HANDLE;
+    }
+    if (Offset >= f->allocated) {
+        return 0;
+    }
+    if (Len > f->allocated - Offset) {
+        Len = f->allocated - Offset;
+    }
+    memcpy(f->work + Offset, pData, Len);
+    if (Offset + Len > f->workLen) {
+        f->workLen = Offset + Len;
+    }
+    return Len;
+}
+
+_i16 sl_FsGetInfo(const _u8 *pFileName, const _u32 Token, SlFsFileInfo_t *pFsFileInfo)
+{
+    FlashFile *f = find(pFileName);
+
+    if (f == NULL) {
+        return SL_FS_ERR_FILE_NOT_EXISTS;
+    }
+    memset(pFsFileInfo, 0, sizeof(*pFsFileInfo));
+    pFsFileInfo->FileLen = f->len;
+    pFsFileInfo->AllocatedLen = f->allocated;
+    return SL_FS_OK;
+}
+
+_i16 sl_FsDel(const _u8 *pFileName, const _u32 Token)
+{
+    FlashFile *f = find(pFileName);
+
+    if (f == NULL || f->open) {
+        return SL_FS_ERR_FILE_NOT_EXISTS;
+    }
+    discard(f);
+    return SL_FS_OK;
+}
+
+}
+
+bool WiFiClass::init()
+{
+    return true;
+}
+
+/*
+ * SHA-256 (FIPS 180-4)
+ */
+typedef struct {
+    uint32_t state[8];
+    uint64_t bytes;
+    uint8_t block[64];
+} Sha256;
+
+static const uint32_t K[64] = {
+    0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
+    0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3, 0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174,
+    0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc, 0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+    0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967,
+    0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13, 0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
+    0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3, 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+    0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
+    0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208, 0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2
+};
+
+#define ROR(x, n) (((x) >> (n)) | ((x) << (32 - (n))))
+
+static void shaBlock(Sha256 *s, const uint8_t *p)
+{
+    uint32_t w[64], v[8], t1, t2;
+    int i;
+
+    for (i = 0; i < 16; i++) {
+        w[i] = (uint32_t)p[4 * i] << 24 | p[4 * i + 1] << 16 | p[4 * i + 2] << 8 | p[4 * i + 3];
+    }
+    for (; i < 64; i++) {
+        w[i] = w[i - 16] + (ROR(w[i - 15], 7) ^ ROR(w[i - 15], 18) ^ (w[i - 15] >> 3))
+            + w[i - 7] + (ROR(w[i - 2], 17) ^ ROR(w[i - 2], 19) ^ (w[i - 2] >> 10));
+    }
+    memcpy(v, s->state, sizeof(v));
+    for (i = 0; i < 64; i++) {
+        t1 = v[7] + (ROR(v[4], 6) ^ ROR(v[4], 11) ^ ROR(v[4], 25))
+            + ((v[4] & v[5]) ^ (~v[4] & v[6])) + K[i] + w[i];
+        t2 = (ROR(v[0], 2) ^ ROR(v[0], 13) ^ ROR(v[0], 22))
+            + ((v[0] & v[1]) ^ (v[0] & v[2]) ^ (v[1] & v[2]));
+        memmove(v + 1, v, 7 * sizeof(v[0]));
+        v[4] += t1;
+        v[0] = t1 + t2;
+    }
+    for (i = 0; i < 8; i++) {
+        s->state[i] += v[i];
+    }
+}
+
+static void shaBegin(Sha256 *s)
+{
+    static const uint32_t init[8] = {
+        0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a, 0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19
+    };
+
+    memcpy(s->state, init, sizeof(init));
+    s->bytes = 0;
+}
+
+static void shaUpdate(Sha256 *s, const uint8_t *data, size_t len)
+{
+    while (len > 0) {
+        size_t fill = s->bytes % 64, n = 64 - fill < len ? 64 - fill : len;
+
+        memcpy(s->block + fill, data, n);
+        s->bytes += n;
+        data += n;
+        len -= n;
+        if (s->bytes % 64 == 0) {
+            shaBlock(s, s->block);
+        }
+    }
+}
+
+static void shaEnd(Sha256 *s, uint8_t *digest)
+{
+    uint64_t bits = s->bytes * 8;
+    uint8_t pad = 0x80;
+    int i;
+
+    shaUpdate(s, &pad, 1);
+    pad = 0;
+    while (s->bytes % 64 != 56) {
+        shaUpdate(s, &pad, 1);
+    }
+    for (i = 7; i >= 0; i--) {
+        pad = bits >> (8 * i);
+        shaUpdate(s, &pad, 1);
+    }
+    for (i = 0; i < 32; i++) {
+        digest[i] = s->state[i / 4] >> (24 - 8 * (i % 4));
+    }
+}
+
+void sha256(const uint8_t *data, size_t len, uint8_t *digest)
+{
+    Sha256 s;
+
+    shaBegin(&s);
+    shaUpdate(&s, data, len);
+    shaEnd(&s, digest);
+}
+
+/*
+ * The hash engine: hashes the length set, of the 64 byte blocks written
+ */
+static Sha256 engine;
+static uint32_t engineLeft;
+
+static void engineRegisters(void)
+{
+    static boolean mapped;
+    void *page;
+
+    if (mapped) {
+        return;
+    }
+    page = mmap((void *)SHAMD5_BASE, 4096, PROT_READ | PROT_WRITE,
+                MAP_PRIVATE | MAP_ANONYMOUS | MAP_FIXED_NOREPLACE, -1, 0);
+    if (page != (void *)SHAMD5_BASE) {
+        fprintf(stderr, "cannot map the hash engine registers at 0x%x\n", SHAMD5_BASE);
+        exit(2);
+    }
+    HWREG(SHAMD5_BASE + SHAMD5_O_IRQSTATUS) = SHAMD5_INT_CONTEXT_READY | SHAMD5_INT_OUTPUT_READY;
+    mapped = true;
+}
+
+extern "C" {
+
+void PRCMPeripheralClkEnable(unsigned long ulPeripheral, unsigned long ulClkFlags)
+{
+    engineRegisters();
+}
+
+void PRCMPeripheralReset(unsigned long ulPeripheral)
+{
+}
+
+void SHAMD5ConfigSet(uint32_t ui32Base, uint32_t ui32Mode)
+{
+}
+
+void SHAMD5DataLengthSet(uint32_t ui32Base, uint32_t ui32Length)
+{
+    shaBegin(&engine);
+    engineLeft = ui32Length;
+}
+
+void SHAMD5DataWrite(uint32_t ui32Base, uint8_t *pui8Src)
+{
+    uint32_t n = engineLeft < 64 ? engineLeft : 64;
+
+    shaUpdate(&engine, pui8Src, n);
+    engineLeft -= n;
+}
+
+void SHAMD5ResultRead(uint32_t ui32Base, uint8_t *pui8Dest)
+{
+    shaEnd(&engine, pui8Dest);
+}
+
+}
@@ -0,0 +1,54 @@
+// Wire Slave Registers
+
+// Demonstrates use of the Wire library
+// Acts as an I2C/TWI slave device with a table of registers, the way
+// most sensors do. The master writes a register number, then reads or
+// writes the registers from there on:
+//   write 0x02          then read 4 bytes: the uptime in ms, LSB first
+//   write 0x00 0x01     sets the LED register
+// Reads are answered from the interrupt, without calling the sketch.
+
+// This example code is in the public domain.
+
+
+#include <Wire.h>
+
+#define REG_LED     0   // written by the master
+#define REG_COUNT   1   // number of writes seen
+#define REG_UPTIME  2   // 4 bytes, read-only
+#define REG_SIZE    6
+
+#define REG_WRITABLE 1  // registers below this one can be written
+
+volatile uint8_t registers[REG_SIZE];
+
+void setup()
+{
+  pinMode(RED_LED, OUTPUT);
+  Wire.setRegisterMap(registers, REG_SIZE, REG_WRITABLE);
+  Wire.onReceive(receiveEvent); // register event
+  Wire.begin(0x48);             // join i2c bus with address 0x48
+}
+
+void loop()
+{
+  unsigned long uptime = millis();
+
+  // a multi byte value must not change while the master reads it
+  noInterrupts();
+  registers[REG_UPTIME] = uptime;
+  registers[REG_UPTIME + 1] = uptime >> 8;
+  registers[REG_UPTIME + 2] = uptime >> 16;
+  registers[REG_UPTIME + 3] = uptime >> 24;
+  interrupts();
+
+  digitalWrite(RED_LED, registers[REG_LED] ? HIGH : LOW);
+  delay(10);
+}
+
+// function that executes whenever the master writes registers
+// this function is registered as an event, see setup()
+void receiveEvent(int howMany)
+{
+  registers[REG_COUNT]++;
+}
@@ -23,13 +23,13 @@
  */
 #include <stdlib.h>
 #include <string.h>
+#include <NetBuffers.h>
 #include "stringbuffer.h"
 
 //Default buffer size for strings
 #define BUFFER_SIZE 256
-//there is a static buffer allocated, which is used to decode strings to
-//strings cannot be longer than the buffer
-char global_buffer[BUFFER_SIZE];
+//strings are decoded into a buffer from the NetBuffers pool, given back
+//when the string is copied out; strings cannot be longer than the buffer
 
 string_buffer*
 stringBufferCreate(void)
@@ -39,8 +39,13 @@ stringBufferCreate(void)
     {
       return NULL;
     }
-  result->string = global_buffer;
-  memset((void*) global_buffer, 0, BUFFER_SIZE);
+  result->string = net_buffer_acquire(BUFFER_SIZE);
+  if (result->string == NULL)
+    {
+      free(result);
+      return NULL;
+    }
+  memset((void*) result->string, 0, BUFFER_SIZE);
   //unused - but will be usefull after realloc got fixd
   /*  if (result->string==NULL) {
    free(result);
@@ -87,6 +92,8 @@ stringBufferToString(string_buffer* buffer)
       != 0)
     {
       stringBufferAdd(0, buffer);
+      //a string that filled the buffer gives its last character to the 0
+      buffer->string[buffer->string_length - 1] = 0;
     }
   /*  char* string = realloc(result, buffer->string_length);
    if (string==NULL) {
@@ -96,11 +103,11 @@ stringBufferToString(string_buffer* buffer)
    free(buffer);
    return string;*/
   char* result = malloc(buffer->string_length * sizeof(char));
-  if (result == NULL)
+  if (result != NULL)
     {
-      return NULL;
+      strcpy(result, buffer->string);
     }
-  strcpy(result, global_buffer);
+  net_buffer_release(buffer->string);
   buffer->string = NULL;
   free(buffer);
   return result;
@@ -114,12 +121,7 @@ stringBufferFree(string_buffer* buffer)
       //hmm it was null before - whatever
       return;
     }
-  //this is not needed in this realloc free concept
-  /*
-   if (buffer->string!=NULL) {
-   free(buffer->string);
-   }
-   */
+  net_buffer_release(buffer->string);
   free(buffer);
 }
 
@@ -148,6 +148,8 @@ void Board_initGeneral(void)
 #include <ti/drivers/GPIO.h>
 #include <ti/drivers/gpio/GPIOCC3200.h>
 
+#include "pins_energia.h"
+
 /* GPIO configuration structure definitions */
 /* Place into subsections to allow the TI linker to remove items properly */
 #if defined(__TI_COMPILER_VERSION__)
@@ -157,44 +159,7 @@ void Board_initGeneral(void)
 #endif
 
 GPIO_PinConfig gpioPinConfigs[] = {
-    /* port_pin */
-    GPIOCC3200_EMPTY_PIN | GPIO_DO_NOT_CONFIG,  /*  0  - dummy */
-                          
-    /* pins 1-10 */
-    GPIOCC3200_EMPTY_PIN | GPIO_DO_NOT_CONFIG,  /*  1  - VDD */
-    GPIOCC3200_EMPTY_PIN | GPIO_DO_NOT_CONFIG,  /*  2  - GND */
-    GPIOCC3200_GPIO_12 | GPIO_DO_NOT_CONFIG,    /*  3  - GPIO_12 SCL */
-    GPIOCC3200_GPIO_13 | GPIO_DO_NOT_CONFIG,    /*  4  - GPIO_13 SDA */
-    GPIOCC3200_GPIO_08 | GPIO_DO_NOT_CONFIG,    /*  5  - GPIO_08 DP12 AUDIO FS */
-    GPIOCC3200_GPIO_30 | GPIO_DO_NOT_CONFIG,    /*  6  - GPIO_30 DP7 AUDIO CLK */
-    GPIOCC3200_GPIO_17 | GPIO_DO_NOT_CONFIG,    /*  7  - GPIO_17 DP11 CSN */
-    GPIOCC3200_GPIO_31 | GPIO_DO_NOT_CONFIG,    /*  8  - GPIO_31 DP6 */
-    GPIOCC3200_EMPTY_PIN | GPIO_DO_NOT_CONFIG,  /*  9  - VDD */
-    GPIOCC3200_GPIO_01 | GPIO_DO_NOT_CONFIG,    /*  10 - GPIO_01 DP5 UART TX */
-                          
-    /* pins 11-20 */
-    GPIOCC3200_GPIO_16 | GPIO_DO_NOT_CONFIG,    /*  11 - GPIO_16 DP10 MOSI */
-    GPIOCC3200_GPIO_02 | GPIO_DO_NOT_CONFIG,    /*  12 - GPIO_01 DP4 UART_RX */
-    GPIOCC3200_GPIO_15 | GPIO_DO_NOT_CONFIG,    /*  13 - GPIO_15 DP9 MISO */
-    GPIOCC3200_GPIO_25 | GPIO_DO_NOT_CONFIG,    /*  14 - GPIO_25 DP3 SOP2 */
-    GPIOCC3200_GPIO_14 | GPIO_DO_NOT_CONFIG,    /*  15 - GPIO_14 DP8 SCLK */
-    GPIOCC3200_GPIO_09 | GPIO_DO_NOT_CONFIG,    /*  16 - GPIO_09 DP2 */
-    GPIOCC3200_GPIO_05 | GPIO_DO_NOT_CONFIG,    /*  17 - GPIO_05 DP ID */
-    GPIOCC3200_GPIO_04 | GPIO_DO_NOT_CONFIG,    /*  18 - GPIO_04 DP1 BUTTON2 */
-    GPIOCC3200_EMPTY_PIN | GPIO_DO_NOT_CONFIG,  /*  19 - POWER GOOD */
-    GPIOCC3200_GPIO_10 | GPIO_DO_NOT_CONFIG,    /*  20 - GPIO_10 DP0/LED2 */
-                          
-    /* virtual pins 21-30 */
-    GPIOCC3200_GPIO_00 | GPIO_DO_NOT_CONFIG,    /*  21 - GPIO_00 AUDIO DI */
-    GPIOCC3200_GPIO_03 | GPIO_DO_NOT_CONFIG,    /*  22 - GPIO_03 BATTMON */
-    GPIOCC3200_GPIO_06 | GPIO_DO_NOT_CONFIG,    /*  23 - GPIO_06 BUZZER */
-    GPIOCC3200_GPIO_07 | GPIO_DO_NOT_CONFIG,    /*  24 - GPIO_07 REED */
-    GPIOCC3200_GPIO_11 | GPIO_DO_NOT_CONFIG,    /*  25 - GPIO_11 BUTTON1 */
-    GPIOCC3200_GPIO_22 | GPIO_DO_NOT_CONFIG,    /*  26 - GPIO_22 TMP RDY */
-    GPIOCC3200_GPIO_23 | GPIO_DO_NOT_CONFIG,    /*  27 - GPIO_23 TDI/LED1 */
-    GPIOCC3200_GPIO_24 | GPIO_DO_NOT_CONFIG,    /*  28 - GPIO_24 TDO/MPU INT */
-    GPIOCC3200_GPIO_28 | GPIO_DO_NOT_CONFIG,    /*  29 - GPIO_28 MIC PWR */
-    GPIOCC3200_GPIO_29 | GPIO_DO_NOT_CONFIG,    /*  30 - GPIO_29 JTAG TMS */
+    PIN_MAP(PIN_MAP_GPIO_CONFIG)
 };
 
 GPIO_CallbackFxn gpioCallbackFunctions[] = {
@@ -286,18 +251,11 @@ const I2C_Config I2C_config[] = {
 };
 
 /*
- *  ======== Board_openI2C ========
- *  Initialize the I2C driver.
+ *  ======== Board_initI2CPins ========
  *  Initialize the I2C port's pins.
- *  Open the I2C port.
  */
-I2C_Handle Board_openI2C(UInt i2cPortIndex, I2C_Params *i2cParams)
+Bool Board_initI2CPins(UInt i2cPortIndex)
 {
-    
-    /* Initialize the I2C driver */
-    /* By design, I2C_init() is idempotent */
-    I2C_init();
-    
     /* initialize the pins associated with the respective I2C */
     switch (i2cPortIndex) {
         case 0:
@@ -317,7 +275,28 @@ I2C_Handle Board_openI2C(UInt i2cPortIndex, I2C_Params *i2cParams)
             break;
 
         default:
-            return (NULL);
+            return (FALSE);
+    }
+
+    return (TRUE);
+}
+
+/*
+ *  ======== Board_openI2C ========
+ *  Initialize the I2C driver.
+ *  Initialize the I2C port's pins.
+ *  Open the I2C port.
+ */
+I2C_Handle Board_openI2C(UInt i2cPortIndex, I2C_Params *i2cParams)
+{
+    
+    /* Initialize the I2C driver */
+    /* By design, I2C_init() is idempotent */
+    I2C_init();
+    
+    /* initialize the pins associated with the respective I2C */
+    if (!Board_initI2CPins(i2cPortIndex)) {
+        return (NULL);
     }
 
     /* open the I2C */
@@ -78,76 +78,10 @@ uint8_t digital_pin_to_pin_function[] = {
 };
 
 const uint8_t digital_pin_to_timer[] = {
-    NOT_ON_TIMER,   /*  dummy */
-
-    NOT_ON_TIMER,   /*  1  - VDD */
-    NOT_ON_TIMER,   /*  2  - GND */
-    NOT_ON_TIMER,   /*  3  - GPIO_12 SCL */
-    NOT_ON_TIMER,   /*  4  - GPIO_13 SDA */
-    NOT_ON_TIMER,   /*  5  - GPIO_08 DP12 AUDIO FS */
-    NOT_ON_TIMER,   /*  6  - GPIO_30 DP7 AUDIO CLK */
-    NOT_ON_TIMER,   /*  7  - GPIO_17 DP11 CSN */
-    NOT_ON_TIMER,   /*  8  - GPIO_31 DP6 */
-    NOT_ON_TIMER,   /*  9  - VDD */
-    NOT_ON_TIMER,   /*  10 - GPIO_01 DP5 UART TX */
-
-    NOT_ON_TIMER,   /*  11 - GPIO_16 DP10 MOSI */
-    NOT_ON_TIMER,   /*  12 - GPIO_01 DP4 UART_RX */
-    NOT_ON_TIMER,   /*  13 - GPIO_15 DP9 MISO */
-    TIMERA1A,       /*  14 - GPIO_25 DP3 SOP2 */
-    NOT_ON_TIMER,   /*  15 - GPIO_14 DP8 SCLK */
-    TIMERA2B,       /*  16 - GPIO_09 DP2 */
-    NOT_ON_TIMER,   /*  17 - GPIO_05 DP ID */
-    NOT_ON_TIMER,   /*  18 - GPIO_04 DP1 BUTTON2 */
-    NOT_ON_TIMER,   /*  19 - POWER GOOD */
-    TIMERA3A,       /*  20 - GPIO_10 DP0/LED2 */
-
-    NOT_ON_TIMER,   /*  21 - GPIO_00 AUDIO DI */
-    NOT_ON_TIMER,   /*  22 - GPIO_03 BATTMON */
-    NOT_ON_TIMER,   /*  23 - GPIO_06 BUZZER */
-    NOT_ON_TIMER,   /*  24 - GPIO_07 REED */
-    TIMERA3B,       /*  25 - GPIO_11 BUTTON1 */
-    NOT_ON_TIMER,   /*  26 - GPIO_22 TMP RDY */
-    NOT_ON_TIMER,   /*  27 - GPIO_23 TDI/LED1 */
-    TIMERA0A,       /*  28 - GPIO_24 TDO/MPU INT */
-    NOT_ON_TIMER,   /*  29 - GPIO_28 MIC PWR */
-    NOT_ON_TIMER,   /*  30 - GPIO_29 JTAG TMS */
+    PIN_MAP(PIN_MAP_TIMER)
 };
 
 const uint16_t digital_pin_to_pin_num[] = {
-    NOT_A_PIN,  /*  dummy */
-    
-    NOT_A_PIN,  /*  1  - VDD */
-    NOT_A_PIN,  /*  2  - GND */
-    PIN_03,     /*  3  - GPIO_12 SCL */
-    PIN_04,     /*  4  - GPIO_13 SDA */
-    PIN_63,     /*  5  - GPIO_08 DP12 AUDIO FS */
-    PIN_53,     /*  6  - GPIO_30 DP7 AUDIO CLK */
-    PIN_08,     /*  7  - GPIO_17 DP11 CSN */
-    PIN_45,     /*  8  - GPIO_31 DP6 */
-    NOT_A_PIN,  /*  9  - VDD */
-    PIN_55,     /*  10 - GPIO_01 DP5 UART TX */
-
-    PIN_07,     /*  11 - GPIO_16 DP10 MOSI */
-    PIN_55,     /*  12 - GPIO_01 DP4 UART_RX */
-    PIN_06,     /*  13 - GPIO_15 DP9 MISO */
-    PIN_21,     /*  14 - GPIO_25 DP3 SOP2 */
-    PIN_05,     /*  15 - GPIO_14 DP8 SCLK */
-    PIN_64,     /*  16 - GPIO_09 DP2 */
-    PIN_60,     /*  17 - GPIO_05 DP ID */
-    PIN_59,     /*  18 - GPIO_04 DP1 BUTTON2 */
-    NOT_A_PIN,  /*  19 - POWER GOOD */
-    PIN_01,     /*  20 - GPIO_10 DP0/LED2 */
-
-    PIN_50,     /*  21 - GPIO_00 AUDIO DI */
-    PIN_58,     /*  22 - GPIO_03 BATTMON */
-    PIN_61,     /*  23 - GPIO_06 BUZZER */
-    PIN_62,     /*  24 - GPIO_07 REED */
-    PIN_02,     /*  25 - GPIO_11 BUTTON1 */
-    PIN_15,     /*  26 - GPIO_22 TMP RDY */
-    PIN_16,     /*  27 - GPIO_23 TDI/LED1 */
-    PIN_17,     /*  28 - GPIO_24 TDO/MPU INT */
-    PIN_18,     /*  29 - GPIO_28 MIC PWR */
-    PIN_20,     /*  30 - GPIO_29 JTAG TMS */
+    PIN_MAP(PIN_MAP_PIN_NUM)
 };
 
@@ -43,4 +43,44 @@ static const uint8_t YELLOW_LED = 0;
 static const uint8_t PUSH1 = 25;
 static const uint8_t PUSH2 = 18;
 
+/*
+ * Energia pin map, one X(package pin, GPIO port/bit, PWM timer) entry per
+ * Energia pin number. The pin tables in pins.c and Board_init.c and the
+ * compile time lookups in wiring_pins.h are all expanded from it.
+ */
+#define PIN_MAP(X) \
+    X(NOT_A_PIN, GPIOCC3200_EMPTY_PIN, NOT_ON_TIMER)  /* 0  - dummy */                 \
+    X(NOT_A_PIN, GPIOCC3200_EMPTY_PIN, NOT_ON_TIMER)  /* 1  - VDD */                   \
+    X(NOT_A_PIN, GPIOCC3200_EMPTY_PIN, NOT_ON_TIMER)  /* 2  - GND */                   \
+    X(PIN_03,    GPIOCC3200_GPIO_12,   NOT_ON_TIMER)  /* 3  - GPIO_12 SCL */           \
+    X(PIN_04,    GPIOCC3200_GPIO_13,   NOT_ON_TIMER)  /* 4  - GPIO_13 SDA */           \
+    X(PIN_63,    GPIOCC3200_GPIO_08,   NOT_ON_TIMER)  /* 5  - GPIO_08 DP12 AUDIO FS */ \
+    X(PIN_53,    GPIOCC3200_GPIO_30,   NOT_ON_TIMER)  /* 6  - GPIO_30 DP7 AUDIO CLK */ \
+    X(PIN_08,    GPIOCC3200_GPIO_17,   NOT_ON_TIMER)  /* 7  - GPIO_17 DP11 CSN */      \
+    X(PIN_45,    GPIOCC3200_GPIO_31,   NOT_ON_TIMER)  /* 8  - GPIO_31 DP6 */           \
+    X(NOT_A_PIN, GPIOCC3200_EMPTY_PIN, NOT_ON_TIMER)  /* 9  - VDD */                   \
+    X(PIN_55,    GPIOCC3200_GPIO_01,   NOT_ON_TIMER)  /* 10 - GPIO_01 DP5 UART TX */   \
+    X(PIN_07,    GPIOCC3200_GPIO_16,   NOT_ON_TIMER)  /* 11 - GPIO_16 DP10 MOSI */     \
+    X(PIN_55,    GPIOCC3200_GPIO_02,   NOT_ON_TIMER)  /* 12 - GPIO_01 DP4 UART_RX */   \
+    X(PIN_06,    GPIOCC3200_GPIO_15,   NOT_ON_TIMER)  /* 13 - GPIO_15 DP9 MISO */      \
+    X(PIN_21,    GPIOCC3200_GPIO_25,   TIMERA1A)      /* 14 - GPIO_25 DP3 SOP2 */      \
+    X(PIN_05,    GPIOCC3200_GPIO_14,   NOT_ON_TIMER)  /* 15 - GPIO_14 DP8 SCLK */      \
+    X(PIN_64,    GPIOCC3200_GPIO_09,   TIMERA2B)      /* 16 - GPIO_09 DP2 */           \
+    X(PIN_60,    GPIOCC3200_GPIO_05,   NOT_ON_TIMER)  /* 17 - GPIO_05 DP ID */         \
+    X(PIN_59,    GPIOCC3200_GPIO_04,   NOT_ON_TIMER)  /* 18 - GPIO_04 DP1 BUTTON2 */   \
+    X(NOT_A_PIN, GPIOCC3200_EMPTY_PIN, NOT_ON_TIMER)  /* 19 - POWER GOOD */            \
+    X(PIN_01,    GPIOCC3200_GPIO_10,   TIMERA3A)      /* 20 - GPIO_10 DP0/LED2 */      \
+    X(PIN_50,    GPIOCC3200_GPIO_00,   NOT_ON_TIMER)  /* 21 - GPIO_00 AUDIO DI */      \
+    X(PIN_58,    GPIOCC3200_GPIO_03,   NOT_ON_TIMER)  /* 22 - GPIO_03 BATTMON */       \
+    X(PIN_61,    GPIOCC3200_GPIO_06,   NOT_ON_TIMER)  /* 23 - GPIO_06 BUZZER */        \
+    X(PIN_62,    GPIOCC3200_GPIO_07,   NOT_ON_TIMER)  /* 24 - GPIO_07 REED */          \
+    X(PIN_02,    GPIOCC3200_GPIO_11,   TIMERA3B)      /* 25 - GPIO_11 BUTTON1 */       \
+    X(PIN_15,    GPIOCC3200_GPIO_22,   NOT_ON_TIMER)  /* 26 - GPIO_22 TMP RDY */       \
+    X(PIN_16,    GPIOCC3200_GPIO_23,   NOT_ON_TIMER)  /* 27 - GPIO_23 TDI/LED1 */      \
+    X(PIN_17,    GPIOCC3200_GPIO_24,   TIMERA0A)      /* 28 - GPIO_24 TDO/MPU INT */   \
+    X(PIN_18,    GPIOCC3200_GPIO_28,   NOT_ON_TIMER)  /* 29 - GPIO_28 MIC PWR */       \
+    X(PIN_20,    GPIOCC3200_GPIO_29,   NOT_ON_TIMER)  /* 30 - GPIO_29 JTAG TMS */
+
+#include <ti/runtime/wiring/cc3200/wiring_pins.h>
+
 #endif
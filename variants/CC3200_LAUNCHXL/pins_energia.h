@@ -56,4 +56,54 @@ static const uint8_t A1 = 2;
 static const uint8_t A2 = 6;
 static const uint8_t A3 = 24;
 
+/*
+ * Energia pin map, one X(package pin, GPIO port/bit, PWM timer) entry per
+ * Energia pin number. The pin tables in pins.c and Board_init.c and the
+ * compile time lookups in wiring_pins.h are all expanded from it.
+ */
+#define PIN_MAP(X) \
+    X(NOT_A_PIN, GPIOCC3200_EMPTY_PIN, NOT_ON_TIMER)  /* 0  - dummy */             \
+    X(NOT_A_PIN, GPIOCC3200_EMPTY_PIN, NOT_ON_TIMER)  /* 1  - 3.3V */              \
+    X(PIN_58,    GPIOCC3200_GPIO_03,   NOT_ON_TIMER)  /* 2  - GPIO_03 */           \
+    X(PIN_04,    GPIOCC3200_GPIO_13,   NOT_ON_TIMER)  /* 3  - GPIO_13 */           \
+    X(PIN_03,    GPIOCC3200_GPIO_12,   NOT_ON_TIMER)  /* 4  - GPIO_12 */           \
+    X(PIN_61,    GPIOCC3200_GPIO_06,   NOT_ON_TIMER)  /* 5  - GPIO_06 */           \
+    X(PIN_59,    GPIOCC3200_GPIO_04,   NOT_ON_TIMER)  /* 6  - GPIO_04 */           \
+    X(PIN_05,    GPIOCC3200_GPIO_14,   NOT_ON_TIMER)  /* 7  - GPIO_14 */           \
+    X(PIN_62,    GPIOCC3200_GPIO_07,   NOT_ON_TIMER)  /* 8  - GPIO_07 */           \
+    X(PIN_01,    GPIOCC3200_GPIO_10,   TIMERA3A)      /* 9  - GPIO_10 */           \
+    X(PIN_02,    GPIOCC3200_GPIO_11,   TIMERA3B)      /* 10 - GPIO_11 */           \
+    X(PIN_15,    GPIOCC3200_GPIO_22,   NOT_ON_TIMER)  /* 11 - GPIO_22 */           \
+    X(PIN_55,    GPIOCC3200_GPIO_01,   NOT_ON_TIMER)  /* 12 - GPIO_01 */           \
+    X(PIN_21,    GPIOCC3200_GPIO_25,   TIMERA1A)      /* 13 - GPIO_25 */           \
+    X(PIN_06,    GPIOCC3200_GPIO_15,   NOT_ON_TIMER)  /* 14 - GPIO_15 */           \
+    X(PIN_07,    GPIOCC3200_GPIO_16,   NOT_ON_TIMER)  /* 15 - GPIO_16 */           \
+    X(NOT_A_PIN, GPIOCC3200_EMPTY_PIN, NOT_ON_TIMER)  /* 16 - RESET */             \
+    X(PIN_45,    GPIOCC3200_GPIO_31,   NOT_ON_TIMER)  /* 17 - GPIO_31 */           \
+    X(PIN_08,    GPIOCC3200_GPIO_17,   NOT_ON_TIMER)  /* 18 - GPIO_17 */           \
+    X(PIN_18,    GPIOCC3200_GPIO_28,   NOT_ON_TIMER)  /* 19 - GPIO_28 JTAG_TCK */  \
+    X(NOT_A_PIN, GPIOCC3200_EMPTY_PIN, NOT_ON_TIMER)  /* 20 - GND */               \
+    X(NOT_A_PIN, GPIOCC3200_EMPTY_PIN, NOT_ON_TIMER)  /* 21 - 5V */                \
+    X(NOT_A_PIN, GPIOCC3200_EMPTY_PIN, NOT_ON_TIMER)  /* 22 - GND */               \
+    X(PIN_57,    GPIOCC3200_GPIO_02,   NOT_ON_TIMER)  /* 23 - GPIO_02 LP Detect */ \
+    X(PIN_60,    GPIOCC3200_GPIO_05,   NOT_ON_TIMER)  /* 24 - GPIO_05 */           \
+    X(PIN_58,    GPIOCC3200_GPIO_03,   NOT_ON_TIMER)  /* 25 - GPIO_03 */           \
+    X(PIN_59,    GPIOCC3200_GPIO_04,   NOT_ON_TIMER)  /* 26 - GPIO_04 */           \
+    X(PIN_63,    GPIOCC3200_GPIO_08,   NOT_ON_TIMER)  /* 27 - GPIO_08 */           \
+    X(PIN_53,    GPIOCC3200_GPIO_30,   NOT_ON_TIMER)  /* 28 - GPIO_30 */           \
+    X(PIN_64,    GPIOCC3200_GPIO_09,   TIMERA2B)      /* 29 - GPIO_09 */           \
+    X(PIN_50,    GPIOCC3200_GPIO_00,   NOT_ON_TIMER)  /* 30 - GPIO_00 */           \
+    X(PIN_17,    GPIOCC3200_GPIO_24,   TIMERA0A)      /* 31 - GPIO_24 JTAG_TDO */  \
+    X(PIN_16,    GPIOCC3200_GPIO_23,   NOT_ON_TIMER)  /* 32 - GPIO_23 JTAG_TDI */  \
+    X(PIN_60,    GPIOCC3200_GPIO_05,   NOT_ON_TIMER)  /* 33 - GPIO_05 */           \
+    X(PIN_62,    GPIOCC3200_GPIO_07,   NOT_ON_TIMER)  /* 34 - GPIO_07 */           \
+    X(PIN_18,    GPIOCC3200_GPIO_28,   NOT_ON_TIMER)  /* 35 - GPIO_28 JTAG_TCK */  \
+    X(PIN_21,    GPIOCC3200_GPIO_25,   TIMERA1A)      /* 36 - GPIO_25 */           \
+    X(PIN_64,    GPIOCC3200_GPIO_09,   TIMERA2B)      /* 37 - GPIO_09 */           \
+    X(PIN_17,    GPIOCC3200_GPIO_24,   TIMERA0A)      /* 38 - GPIO_24 JTAG_TDO */  \
+    X(PIN_01,    GPIOCC3200_GPIO_10,   TIMERA3A)      /* 39 - GPIO_10 */           \
+    X(PIN_02,    GPIOCC3200_GPIO_11,   TIMERA3B)      /* 40 - GPIO_11 */
+
+#include <ti/runtime/wiring/cc3200/wiring_pins.h>
+
 #endif
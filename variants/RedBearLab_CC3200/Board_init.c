@@ -148,6 +148,8 @@ void Board_initGeneral(void)
 #include <ti/drivers/GPIO.h>
 #include <ti/drivers/gpio/GPIOCC3200.h>
 
+#include "pins_energia.h"
+
 /* GPIO configuration structure definitions */
 /* Place into subsections to allow the TI linker to remove items properly */
 #if defined(__TI_COMPILER_VERSION__)
@@ -157,31 +159,7 @@ void Board_initGeneral(void)
 #endif
 
 GPIO_PinConfig gpioPinConfigs[] = {
-    GPIOCC3200_GPIO_02 | GPIO_DO_NOT_CONFIG,    // D0 - IO02
-    GPIOCC3200_GPIO_01 | GPIO_DO_NOT_CONFIG,    // D1 - IO01
-    GPIOCC3200_GPIO_06 | GPIO_DO_NOT_CONFIG,    // D2 - IO06
-    GPIOCC3200_GPIO_07 | GPIO_DO_NOT_CONFIG,    // D3 - IO07
-    GPIOCC3200_GPIO_08 | GPIO_DO_NOT_CONFIG,    // D4 - IO08
-    GPIOCC3200_GPIO_09 | GPIO_DO_NOT_CONFIG,    // D5 - IO09
-    GPIOCC3200_GPIO_24 | GPIO_DO_NOT_CONFIG,    // D6 - IO24
-    GPIOCC3200_GPIO_23 | GPIO_DO_NOT_CONFIG,    // D7 - IO23
-    GPIOCC3200_GPIO_13 | GPIO_DO_NOT_CONFIG,    // D8 - IO13
-    GPIOCC3200_GPIO_22 | GPIO_DO_NOT_CONFIG,    // D9 - IO22
-    GPIOCC3200_GPIO_17 | GPIO_DO_NOT_CONFIG,    // D10 - IO17
-    GPIOCC3200_GPIO_12 | GPIO_DO_NOT_CONFIG,    // D11 - IO12
-    GPIOCC3200_GPIO_29 | GPIO_DO_NOT_CONFIG,    // D12 - IO29
-    GPIOCC3200_GPIO_00 | GPIO_DO_NOT_CONFIG,    // D13 - IO00
-    GPIOCC3200_GPIO_11 | GPIO_DO_NOT_CONFIG,    // D14 - IO11
-    GPIOCC3200_GPIO_10 | GPIO_DO_NOT_CONFIG,    // D15 - IO10
-    GPIOCC3200_GPIO_02 | GPIO_DO_NOT_CONFIG,    // D16/A0 - IO02
-    GPIOCC3200_GPIO_05 | GPIO_DO_NOT_CONFIG,    // D17/A1 - IO05
-    GPIOCC3200_GPIO_04 | GPIO_DO_NOT_CONFIG,    // D18/A2 - IO04
-    GPIOCC3200_GPIO_03 | GPIO_DO_NOT_CONFIG,    // D19/A3 - IO03
-    GPIOCC3200_GPIO_30 | GPIO_DO_NOT_CONFIG,    // D20 - IO30
-    GPIOCC3200_GPIO_28 | GPIO_DO_NOT_CONFIG,    // D21 - IO28
-    GPIOCC3200_GPIO_16 | GPIO_DO_NOT_CONFIG,    // D22 - IO16
-    GPIOCC3200_GPIO_15 | GPIO_DO_NOT_CONFIG,    // D23 - IO15
-    GPIOCC3200_GPIO_14 | GPIO_DO_NOT_CONFIG,    // D24 - IO14 
+    PIN_MAP(PIN_MAP_GPIO_CONFIG)
 };
 
 GPIO_CallbackFxn gpioCallbackFunctions[] = {
@@ -260,18 +238,11 @@ const I2C_Config I2C_config[] = {
 };
 
 /*
- *  ======== Board_openI2C ========
- *  Initialize the I2C driver.
+ *  ======== Board_initI2CPins ========
  *  Initialize the I2C port's pins.
- *  Open the I2C port.
  */
-I2C_Handle Board_openI2C(UInt i2cPortIndex, I2C_Params *i2cParams)
+Bool Board_initI2CPins(UInt i2cPortIndex)
 {
-    
-    /* Initialize the I2C driver */
-    /* By design, I2C_init() is idempotent */
-    I2C_init();
-    
     /* initialize the pins associated with the respective I2C */
     switch (i2cPortIndex) {
         case 0:
@@ -291,7 +262,28 @@ I2C_Handle Board_openI2C(UInt i2cPortIndex, I2C_Params *i2cParams)
             break;
 
         default:
-            return (NULL);
+            return (FALSE);
+    }
+
+    return (TRUE);
+}
+
+/*
+ *  ======== Board_openI2C ========
+ *  Initialize the I2C driver.
+ *  Initialize the I2C port's pins.
+ *  Open the I2C port.
+ */
+I2C_Handle Board_openI2C(UInt i2cPortIndex, I2C_Params *i2cParams)
+{
+    
+    /* Initialize the I2C driver */
+    /* By design, I2C_init() is idempotent */
+    I2C_init();
+    
+    /* initialize the pins associated with the respective I2C */
+    if (!Board_initI2CPins(i2cPortIndex)) {
+        return (NULL);
     }
 
     /* open the I2C */
@@ -57,4 +57,39 @@ static const uint8_t A1 = 17;
 static const uint8_t A2 = 18;
 static const uint8_t A3 = 19;
 
+/*
+ * Energia pin map, one X(package pin, GPIO port/bit, PWM timer) entry per
+ * Energia pin number. The pin tables in pins.c and Board_init.c and the
+ * compile time lookups in wiring_pins.h are all expanded from it.
+ */
+#define PIN_MAP(X) \
+    X(PIN_57, GPIOCC3200_GPIO_02, NOT_ON_TIMER)  /* D0 - IO02 */     \
+    X(PIN_55, GPIOCC3200_GPIO_01, NOT_ON_TIMER)  /* D1 - IO01 */     \
+    X(PIN_61, GPIOCC3200_GPIO_06, NOT_ON_TIMER)  /* D2 - IO06 */     \
+    X(PIN_62, GPIOCC3200_GPIO_07, NOT_ON_TIMER)  /* D3 - IO07 */     \
+    X(PIN_08, GPIOCC3200_GPIO_17, NOT_ON_TIMER)  /* D4 - IO17 */     \
+    X(PIN_64, GPIOCC3200_GPIO_09, TIMERA2B)      /* D5 - IO09 */     \
+    X(PIN_17, GPIOCC3200_GPIO_24, TIMERA0A)      /* D6 - IO24 */     \
+    X(PIN_63, GPIOCC3200_GPIO_08, NOT_ON_TIMER)  /* D7 - IO08 */     \
+    X(PIN_16, GPIOCC3200_GPIO_23, NOT_ON_TIMER)  /* D8 - IO23 */     \
+    X(PIN_20, GPIOCC3200_GPIO_29, NOT_ON_TIMER)  /* D9 - IO29 */     \
+    X(PIN_03, GPIOCC3200_GPIO_12, NOT_ON_TIMER)  /* D10 - IO12 */    \
+    X(PIN_04, GPIOCC3200_GPIO_13, NOT_ON_TIMER)  /* D11 - IO13 */    \
+    X(PIN_15, GPIOCC3200_GPIO_22, NOT_ON_TIMER)  /* D12 - IO22 */    \
+    X(PIN_50, GPIOCC3200_GPIO_00, NOT_ON_TIMER)  /* D13 - IO00 */    \
+    X(PIN_02, GPIOCC3200_GPIO_11, TIMERA3B)      /* D14 - IO11 */    \
+    X(PIN_01, GPIOCC3200_GPIO_10, TIMERA3A)      /* D15 - IO10 */    \
+    X(PIN_57, GPIOCC3200_GPIO_02, NOT_ON_TIMER)  /* D16/A0 - IO02 */ \
+    X(PIN_60, GPIOCC3200_GPIO_05, NOT_ON_TIMER)  /* D17/A1 - IO05 */ \
+    X(PIN_59, GPIOCC3200_GPIO_04, NOT_ON_TIMER)  /* D18/A2 - IO04 */ \
+    X(PIN_58, GPIOCC3200_GPIO_03, NOT_ON_TIMER)  /* D19/A3 - IO03 */ \
+    X(PIN_53, GPIOCC3200_GPIO_30, NOT_ON_TIMER)  /* D20 - IO30 */    \
+    X(PIN_18, GPIOCC3200_GPIO_28, NOT_ON_TIMER)  /* D21 - IO28 */    \
+    X(PIN_07, GPIOCC3200_GPIO_16, NOT_ON_TIMER)  /* D22 - IO16 */    \
+    X(PIN_06, GPIOCC3200_GPIO_15, NOT_ON_TIMER)  /* D23 - IO15 */    \
+    X(PIN_05, GPIOCC3200_GPIO_14, NOT_ON_TIMER)  /* D24 - IO14 */    \
+    X(PIN_21, GPIOCC3200_GPIO_25, TIMERA1A)      /* D25 - IO25 */
+
+#include <ti/runtime/wiring/cc3200/wiring_pins.h>
+
 #endif
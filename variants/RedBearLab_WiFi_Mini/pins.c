@@ -69,58 +69,10 @@ uint8_t digital_pin_to_pin_function[] = {
 };
 
 const uint8_t digital_pin_to_timer[] = {
-    NOT_ON_TIMER,     // D0 - IO02
-    NOT_ON_TIMER,     // D1 - IO01
-    NOT_ON_TIMER,     // D2 - IO06
-    NOT_ON_TIMER,     // D3 - IO07
-    NOT_ON_TIMER,     // D4 - IO00    
-    TIMERA2B,         // D5 - IO09
-    TIMERA0A,         // D6 - IO24
-    NOT_ON_TIMER,     // D7 - IO28
-    NOT_ON_TIMER,     // D8 - IO29
-    NOT_ON_TIMER,     // D9 - IO23
-    NOT_ON_TIMER,     // D10 - IO22
-    NOT_ON_TIMER,     // D11 - IO13   
-    NOT_ON_TIMER,     // D12 - IO17
-    NOT_ON_TIMER,     // D13 - IO30  
-    TIMERA3B,         // D14 - IO11
-    TIMERA3A,         // D15 - IO10
-    NOT_ON_TIMER,     // D16/A0 - IO02
-    NOT_ON_TIMER,     // D17/A1 - IO05
-    NOT_ON_TIMER,     // D18/A2 - IO04
-    NOT_ON_TIMER,     // D19/A3 - IO03  
-    NOT_ON_TIMER,     // D20 - IO08
-    NOT_ON_TIMER,     // D21 - IO12
-    NOT_ON_TIMER,     // D22 - IO16
-    NOT_ON_TIMER,     // D23 - IO15
-    NOT_ON_TIMER,     // D24 - IO14 
+    PIN_MAP(PIN_MAP_TIMER)
 };
 
 const uint16_t digital_pin_to_pin_num[] = {
-    PIN_57,         // D0 - IO02
-    PIN_55,         // D1 - IO01
-    PIN_61,         // D2 - IO06
-    PIN_62,         // D3 - IO07
-    PIN_50,         // D4 - IO00
-    PIN_64,         // D5 - IO09
-    PIN_17,         // D6 - IO24
-    PIN_18,         // D7 - IO28
-    PIN_20,         // D8 - IO29
-    PIN_16,         // D9 - IO23
-    PIN_15,         // D10 - IO22
-    PIN_04,         // D11 - IO13
-    PIN_08,         // D12 - IO17
-    PIN_53,         // D13 - IO30
-    PIN_02,         // D14 - IO11
-    PIN_01,         // D15 - IO10
-    PIN_57,         // D16/A0 - IO02
-    PIN_60,         // D17/A1 - IO05
-    PIN_59,         // D18/A2 - IO04
-    PIN_58,         // D19/A3 - IO03    
-    PIN_63,         // D20 - IO08
-    PIN_03,         // D21 - IO12
-    PIN_07,         // D22 - IO16
-    PIN_06,         // D23 - IO15
-    PIN_05,         // D24 - IO14
+    PIN_MAP(PIN_MAP_PIN_NUM)
 };
 